@@ -0,0 +1,18 @@
+#ifndef _HARDWARE_ADDRESS_MAPPED_H
+#define _HARDWARE_ADDRESS_MAPPED_H
+
+#include "pico.h"
+
+/**
+ * Register access types for the simulated peripherals
+ * The register blocks are plain structs in host memory, so reads and writes have no side
+ * effects; the simulation updates them from its own threads.
+ */
+
+typedef volatile uint32_t io_rw_32;
+typedef const volatile uint32_t io_ro_32;
+typedef volatile uint32_t io_wo_32;
+typedef volatile uint16_t io_rw_16;
+typedef volatile uint8_t io_rw_8;
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef _HARDWARE_CLOCKS_H
+#define _HARDWARE_CLOCKS_H
+
+#include "pico.h"
+
+// Clock tree of the simulated board, fixed at the SDK defaults
+enum clock_num_rp2040 {
+    clk_gpout0 = 0,
+    clk_gpout1,
+    clk_gpout2,
+    clk_gpout3,
+    clk_ref,
+    clk_sys,
+    clk_peri,
+    clk_usb,
+    clk_adc,
+    clk_rtc,
+    CLK_COUNT
+};
+
+typedef enum clock_num_rp2040 clock_handle_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t clock_get_hz(clock_handle_t clock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
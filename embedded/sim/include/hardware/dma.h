@@ -0,0 +1,96 @@
+#ifndef _HARDWARE_DMA_H
+#define _HARDWARE_DMA_H
+
+#include "pico.h"
+#include "hardware/address_mapped.h"
+#include "hardware/regs/dreq.h"
+
+/**
+ * DMA channels for the host build, see sim/sim_dma.c
+ *
+ * A channel paced by a simulated peripheral (I2C TX, ADC FIFO) completes after the time
+ * the peripheral would take; anything else is copied at once. Completion raises
+ * DMA_IRQ_0 / DMA_IRQ_1 on the cores that have it enabled.
+ */
+
+enum dma_channel_transfer_size {
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2
+};
+
+// Same bit positions as the RP2040 CTRL register
+#define DMA_CH_CTRL_EN_BITS 0x00000001u
+#define DMA_CH_CTRL_DATA_SIZE_LSB 2
+#define DMA_CH_CTRL_DATA_SIZE_BITS 0x0000000cu
+#define DMA_CH_CTRL_INCR_READ_BITS 0x00000010u
+#define DMA_CH_CTRL_INCR_WRITE_BITS 0x00000020u
+#define DMA_CH_CTRL_TREQ_SEL_LSB 15
+#define DMA_CH_CTRL_TREQ_SEL_BITS 0x001f8000u
+
+typedef struct {
+    uint32_t ctrl;
+} dma_channel_config;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void dma_channel_claim(uint channel);
+void dma_channel_unclaim(uint channel);
+int dma_claim_unused_channel(bool required);
+
+static inline void channel_config_set_read_increment(dma_channel_config *c, bool incr)
+{
+    c->ctrl = incr ? (c->ctrl | DMA_CH_CTRL_INCR_READ_BITS) : (c->ctrl & ~DMA_CH_CTRL_INCR_READ_BITS);
+}
+
+static inline void channel_config_set_write_increment(dma_channel_config *c, bool incr)
+{
+    c->ctrl = incr ? (c->ctrl | DMA_CH_CTRL_INCR_WRITE_BITS) : (c->ctrl & ~DMA_CH_CTRL_INCR_WRITE_BITS);
+}
+
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq)
+{
+    c->ctrl = (c->ctrl & ~DMA_CH_CTRL_TREQ_SEL_BITS) | (dreq << DMA_CH_CTRL_TREQ_SEL_LSB);
+}
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size)
+{
+    c->ctrl = (c->ctrl & ~DMA_CH_CTRL_DATA_SIZE_BITS) | ((uint)size << DMA_CH_CTRL_DATA_SIZE_LSB);
+}
+
+static inline void channel_config_set_enable(dma_channel_config *c, bool enable)
+{
+    c->ctrl = enable ? (c->ctrl | DMA_CH_CTRL_EN_BITS) : (c->ctrl & ~DMA_CH_CTRL_EN_BITS);
+}
+
+static inline dma_channel_config dma_channel_get_default_config(uint channel)
+{
+    dma_channel_config c = {0};
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, DREQ_FORCE);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_enable(&c, true);
+    return c;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger);
+void dma_channel_start(uint channel);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_wait_for_finish_blocking(uint channel);
+void dma_channel_abort(uint channel);
+void dma_channel_set_irq0_enabled(uint channel, bool enabled);
+void dma_channel_set_irq1_enabled(uint channel, bool enabled);
+bool dma_channel_get_irq0_status(uint channel);
+bool dma_channel_get_irq1_status(uint channel);
+void dma_channel_acknowledge_irq0(uint channel);
+void dma_channel_acknowledge_irq1(uint channel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
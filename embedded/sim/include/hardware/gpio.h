@@ -0,0 +1,37 @@
+#ifndef _SIM_HARDWARE_GPIO_H
+#define _SIM_HARDWARE_GPIO_H
+
+#include "pico.h"
+#include_next "hardware/gpio.h"
+
+/**
+ * GPIO interrupts, which the SDK host platform leaves out, see sim/sim_gpio.c
+ *
+ * sim_gpio_press() delivers the falling edge of a button to ground on IO_IRQ_BANK0.
+ * The host gpio_set_irq_enabled() is a stub, so once a callback is installed every pin
+ * counts as enabled for falling edges.
+ */
+
+enum gpio_irq_level {
+    GPIO_IRQ_LEVEL_LOW = 0x1u,
+    GPIO_IRQ_LEVEL_HIGH = 0x2u,
+    GPIO_IRQ_EDGE_FALL = 0x4u,
+    GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t event_mask);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled);
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback);
+void gpio_set_irq_callback(gpio_irq_callback_t callback);
+void gpio_acknowledge_irq(uint gpio, uint32_t event_mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
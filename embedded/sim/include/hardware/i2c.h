@@ -0,0 +1,71 @@
+#ifndef _HARDWARE_I2C_H
+#define _HARDWARE_I2C_H
+
+#include "pico.h"
+#include "hardware/address_mapped.h"
+#include "hardware/regs/dreq.h"
+
+/**
+ * I2C controllers for the host build, see sim/sim_i2c.c
+ *
+ * Transfers go to the device models attached with sim_i2c_attach() and take the time
+ * the bytes would take on the bus at the configured baud rate. A missing device NACKs.
+ * Only the register fields the firmware touches are modelled; reads have no side effects,
+ * so TX_ABRT is cleared when the next transfer starts instead of by reading clr_tx_abrt.
+ */
+
+#define I2C_IC_DATA_CMD_STOP_BITS 0x00000200u
+#define I2C_IC_DATA_CMD_CMD_BITS 0x00000100u
+#define I2C_IC_DATA_CMD_DAT_BITS 0x000000ffu
+#define I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS 0x00000040u
+#define I2C_IC_STATUS_TFE_BITS 0x00000004u
+#define I2C_IC_STATUS_ACTIVITY_BITS 0x00000001u
+
+typedef struct {
+    io_rw_32 enable;
+    io_rw_32 tar;
+    io_rw_32 data_cmd;
+    io_ro_32 status;
+    io_ro_32 raw_intr_stat;
+    io_ro_32 clr_tx_abrt;
+    io_ro_32 txflr;
+} i2c_hw_t;
+
+typedef struct i2c_inst {
+    i2c_hw_t *hw;
+    bool restart_on_next;
+} i2c_inst_t;
+
+extern i2c_inst_t i2c0_inst;
+extern i2c_inst_t i2c1_inst;
+
+#define i2c0 (&i2c0_inst)
+#define i2c1 (&i2c1_inst)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+void i2c_deinit(i2c_inst_t *i2c);
+uint i2c_set_baudrate(i2c_inst_t *i2c, uint baudrate);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us);
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint timeout_us);
+
+static inline uint i2c_get_index(i2c_inst_t *i2c)
+{
+    return i2c == i2c1 ? 1 : 0;
+}
+
+static inline uint i2c_get_dreq(i2c_inst_t *i2c, bool is_tx)
+{
+    return DREQ_I2C0_TX + 2 * i2c_get_index(i2c) + (is_tx ? 0 : 1);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
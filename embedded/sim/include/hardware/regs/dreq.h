@@ -0,0 +1,12 @@
+#ifndef _HARDWARE_REGS_DREQ_H
+#define _HARDWARE_REGS_DREQ_H
+
+// RP2040 DMA request numbers for the simulated peripherals
+#define DREQ_I2C0_TX 32
+#define DREQ_I2C0_RX 33
+#define DREQ_I2C1_TX 34
+#define DREQ_I2C1_RX 35
+#define DREQ_ADC 36
+#define DREQ_FORCE 63
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef _PICO_ASYNC_CONTEXT_H
+#define _PICO_ASYNC_CONTEXT_H
+
+#include "pico.h"
+#include "pico/time.h"
+
+/**
+ * async_context for the simulator: the subset of the SDK API the firmware uses
+ *
+ * There is one background context, a thread that runs the workers one at a time with the
+ * context lock held, the way pico_cyw43_arch_threadsafe_background runs them from a low
+ * priority interrupt. The worker structs match the SDK ones.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct async_context async_context_t;
+
+typedef struct async_work_on_timeout {
+    struct async_work_on_timeout *next;
+    void (*do_work)(async_context_t *context, struct async_work_on_timeout *timeout);
+    absolute_time_t next_time;
+    void *user_data;
+} async_at_time_worker_t;
+
+typedef struct async_when_pending_worker {
+    struct async_when_pending_worker *next;
+    void (*do_work)(async_context_t *context, struct async_when_pending_worker *worker);
+    bool work_pending;
+    void *user_data;
+} async_when_pending_worker_t;
+
+void async_context_acquire_lock_blocking(async_context_t *context);
+void async_context_release_lock(async_context_t *context);
+
+bool async_context_add_at_time_worker(async_context_t *context, async_at_time_worker_t *worker);
+bool async_context_add_at_time_worker_at(async_context_t *context, async_at_time_worker_t *worker, absolute_time_t at);
+bool async_context_add_at_time_worker_in_ms(async_context_t *context, async_at_time_worker_t *worker, uint32_t ms);
+bool async_context_remove_at_time_worker(async_context_t *context, async_at_time_worker_t *worker);
+
+bool async_context_add_when_pending_worker(async_context_t *context, async_when_pending_worker_t *worker);
+bool async_context_remove_when_pending_worker(async_context_t *context, async_when_pending_worker_t *worker);
+
+// Safe from any thread, like the SDK's from any IRQ
+void async_context_set_work_pending(async_context_t *context, async_when_pending_worker_t *worker);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
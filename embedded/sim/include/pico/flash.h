@@ -0,0 +1,33 @@
+#ifndef _PICO_FLASH_H
+#define _PICO_FLASH_H
+
+#include "pico.h"
+
+/**
+ * Flash safe execution for the host build, see sim/sim_flash.c
+ * The callback runs between the enter and exit calls of the flash safety helper, as on the
+ * board. The default helper only masks the calling core's interrupts; firmware can provide
+ * its own get_flash_safety_helper() to park the other core.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    bool (*core_init_deinit)(bool init);
+    int (*enter_safe_zone_timeout_ms)(uint32_t timeout_ms);
+    int (*exit_safe_zone_timeout_ms)(uint32_t timeout_ms);
+} flash_safety_helper_t;
+
+flash_safety_helper_t *get_flash_safety_helper(void);
+
+bool flash_safe_execute_core_init(void);
+bool flash_safe_execute_core_deinit(void);
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
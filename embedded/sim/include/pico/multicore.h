@@ -0,0 +1,15 @@
+#ifndef _SIM_PICO_MULTICORE_H
+#define _SIM_PICO_MULTICORE_H
+
+#include "pico.h"
+#include "hardware/irq.h"
+#include_next "pico/multicore.h"
+
+/**
+ * Core1 runs on its own thread, the FIFOs raise SIO_IRQ_PROC0 / SIO_IRQ_PROC1 on the
+ * receiving core, see sim/sim_core.c
+ */
+
+#define SIO_FIFO_IRQ_NUM(core) (SIO_IRQ_PROC0 + (core))
+
+#endif
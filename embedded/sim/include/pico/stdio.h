@@ -0,0 +1,19 @@
+#ifndef _SIM_PICO_STDIO_H
+#define _SIM_PICO_STDIO_H
+
+#include "pico.h"
+#include_next "pico/stdio.h"
+
+// Raw writes go to stdout next to printf, like the USB CDC port they replace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int stdio_put_string(const char *s, int len, bool newline, bool cr_translation);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef _SIM_SIM_H
+#define _SIM_SIM_H
+
+#include "pico.h"
+#include "hardware/i2c.h"
+
+/**
+ * Simulated Pico W board for PICO_PLATFORM=host builds
+ *
+ * The firmware runs unmodified as a Linux process: core0 is the main thread, core1 a
+ * thread started by multicore_launch_core1(), and a timer thread stands in for the
+ * hardware alarms and peripheral timing. Devices hang off the simulated I2C buses and
+ * the ADC; sim_board.c wires them up the way config.h expects.
+ *
+ * Environment variables
+ *   SIM_SCRIPT       CSV of "seconds,temperature_c,humidity_pct,light_adc" rows, linearly
+ *                    interpolated and held after the last row; default is a daily cycle
+ *   SIM_DAY_S        length of the default daily cycle in seconds (86400)
+ *   SIM_RUN_S        exit after this many seconds and print the LCD and device counters
+ *   SIM_SPEED        runs the simulated clock this many times faster than real time (1)
+ *   SIM_FLASH_FILE   keeps the flash image across runs
+ *   SIM_FLASH_ERASE_MS  sector erase time in ms (45), 400 is the datasheet worst case
+ *   SIM_LCD_TRACE    0 stops printing the LCD to stderr whenever the glass changes
+ *   SIM_DHT20_CRC_FAULT_N  corrupts the CRC of every Nth DHT20 reading
+ *   SIM_UPLINK       host:port the Wi-Fi uplink posts to, the link stays down without it
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ********** Time and interrupts **********
+
+typedef void (*sim_event_fn)(void *ctx);
+
+// Runs fn(ctx) on the timer thread at time_us, returns a handle for sim_cancel()
+int sim_schedule_at(uint64_t time_us, sim_event_fn fn, void *ctx);
+void sim_cancel(int event);
+
+// Raises a peripheral interrupt on every core that has it enabled
+void sim_irq_raise(uint irq);
+
+// Waits until time_us on the calling core, taking its interrupts meanwhile if unmasked
+void sim_wait_until(uint64_t time_us);
+
+// Deterministic noise in [-amplitude, amplitude] for a key, usually a time and a stream id
+int32_t sim_noise(uint64_t key, int32_t amplitude);
+
+// ********** I2C devices **********
+
+typedef struct sim_i2c_device sim_i2c_device_t;
+
+/**
+ * A device model; both calls return the number of bytes taken or a negative value to NACK
+ * time_us is when the transfer ends on the bus. Calls for one bus are serialized.
+ */
+struct sim_i2c_device {
+    int (*write)(sim_i2c_device_t *dev, const uint8_t *src, size_t len, uint64_t time_us);
+    int (*read)(sim_i2c_device_t *dev, uint8_t *dst, size_t len, uint64_t time_us);
+};
+
+void sim_i2c_attach(i2c_inst_t *i2c, uint8_t addr, sim_i2c_device_t *dev);
+
+// Puts a device behind a channel of a TCA9548A mux at mux_addr, the mux is added on first use
+void sim_i2c_attach_muxed(i2c_inst_t *i2c, uint8_t mux_addr, uint8_t channel, uint8_t addr, sim_i2c_device_t *dev);
+
+// ********** Environment **********
+
+typedef struct {
+    float temperature_c;
+    float humidity_pct;
+    float light_adc;        // photoresistor divider in ADC counts, mains flicker included
+} sim_env_t;
+
+bool sim_env_load(const char *path);
+void sim_env_at(uint64_t time_us, sim_env_t *out);
+
+// ********** DHT20 **********
+
+typedef struct {
+    uint32_t triggers;
+    uint32_t reads;
+    uint32_t busy_reads;     // reads that found a conversion still running
+    uint32_t crc_faults;     // readings sent with a corrupted CRC
+} sim_dht20_stats_t;
+
+typedef struct sim_dht20 sim_dht20_t;
+
+// Sensor n reads the room n * 0.5 C warmer and n %RH drier, as if placed further up the enclosure
+sim_dht20_t *sim_dht20_create(uint id);
+sim_i2c_device_t *sim_dht20_device(sim_dht20_t *dht);
+void sim_dht20_get_stats(sim_dht20_t *dht, sim_dht20_stats_t *out);
+
+// ********** HD44780 LCD behind a PCF8574 backpack **********
+
+typedef struct {
+    uint32_t bytes;          // expander writes
+    uint32_t commands;
+    uint32_t chars;
+} sim_lcd_stats_t;
+
+typedef struct sim_lcd sim_lcd_t;
+
+sim_lcd_t *sim_lcd_create(uint8_t cols, uint8_t rows);
+sim_i2c_device_t *sim_lcd_device(sim_lcd_t *lcd);
+void sim_lcd_row(sim_lcd_t *lcd, uint8_t row, char *out);   // out holds cols + 1 chars
+bool sim_lcd_backlight(sim_lcd_t *lcd);
+void sim_lcd_get_stats(sim_lcd_t *lcd, sim_lcd_stats_t *out);
+void sim_lcd_set_trace(sim_lcd_t *lcd, bool on);
+
+// ********** ADC and GPIO **********
+
+typedef uint16_t (*sim_adc_source_fn)(uint64_t time_us);
+
+void sim_adc_connect(uint input, sim_adc_source_fn source);
+void sim_gpio_press(uint gpio);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,35 @@
+# -------------------------------------------------
+# Host simulation (PICO_PLATFORM=host)
+# -------------------------------------------------
+# Builds the firmware as a Linux program against the simulated board in this directory.
+# sim/include comes before the SDK headers so it can replace or extend the host ones.
+
+find_package(Threads REQUIRED)
+
+set(HUMIDITY_SENSOR_SIM_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+function(humidity_sensor_add_sim target)
+    target_sources(${target} PRIVATE
+        ${HUMIDITY_SENSOR_SIM_DIR}/sim_core.c
+        ${HUMIDITY_SENSOR_SIM_DIR}/sim_i2c.c
+        ${HUMIDITY_SENSOR_SIM_DIR}/sim_dma.c
+        ${HUMIDITY_SENSOR_SIM_DIR}/sim_adc.c
+        ${HUMIDITY_SENSOR_SIM_DIR}/sim_flash.c
+        ${HUMIDITY_SENSOR_SIM_DIR}/sim_gpio.c
+        ${HUMIDITY_SENSOR_SIM_DIR}/sim_env.c
+        ${HUMIDITY_SENSOR_SIM_DIR}/sim_dht20.c
+        ${HUMIDITY_SENSOR_SIM_DIR}/sim_lcd.c
+        ${HUMIDITY_SENSOR_SIM_DIR}/sim_board.c
+        ${HUMIDITY_SENSOR_SIM_DIR}/sim_async_context.c
+        ${HUMIDITY_SENSOR_SIM_DIR}/sim_net.c
+    )
+    target_include_directories(${target} BEFORE PRIVATE
+        ${HUMIDITY_SENSOR_SIM_DIR}/include
+    )
+    target_link_libraries(${target}
+        pico_stdlib
+        pico_multicore
+        Threads::Threads
+        m
+    )
+endfunction()
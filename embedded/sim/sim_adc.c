@@ -0,0 +1,131 @@
+/**
+ * Simulated ADC
+ *
+ * Inputs read whatever sim_adc_connect() attached, sampled at the time of the conversion,
+ * plus a few counts of conversion noise. Free-running captures through the FIFO are filled
+ * in by sim_dma.c once the DMA that reads them completes.
+ */
+
+#include "hardware/adc.h"
+#include "hardware/timer.h"
+
+#include "sim_internal.h"
+
+#define ADC_NOISE_COUNTS 6
+#define ADC_CONVERSION_US 2     // 96 cycles of the 48 MHz ADC clock
+
+adc_hw_t sim_adc_hw;
+
+static sim_adc_source_fn sources[NUM_ADC_CHANNELS];
+static uint selected_input;
+static float clkdiv;
+
+void sim_adc_connect(uint input, sim_adc_source_fn source)
+{
+    if (input < NUM_ADC_CHANNELS)
+        sources[input] = source;
+}
+
+/**
+ * One conversion of the selected input at time_us
+ */
+static uint16_t sample(uint64_t time_us)
+{
+    int32_t value = sources[selected_input] ? sources[selected_input](time_us) : 0;
+    value += sim_noise(time_us ^ 0xADC0000000000000ull, ADC_NOISE_COUNTS);
+    if (value < 0)
+        value = 0;
+    if (value > 4095)
+        value = 4095;
+    return (uint16_t)value;
+}
+
+/**
+ * Time between free-running conversions, the RP2040 never goes faster than 500 ksps
+ */
+static uint64_t sample_period_us(void)
+{
+    float period = (1.0f + clkdiv) / 48.0f;
+    return period < ADC_CONVERSION_US ? ADC_CONVERSION_US : (uint64_t)period;
+}
+
+bool sim_adc_is_fifo(const volatile void *addr)
+{
+    return addr == &sim_adc_hw.fifo;
+}
+
+uint64_t sim_adc_capture_us(uint count)
+{
+    return count * sample_period_us();
+}
+
+void sim_adc_capture(void *dst, uint count, uint size, bool incr, uint64_t start_us)
+{
+    uint64_t period = sample_period_us();
+    uint8_t *out = dst;
+
+    for (uint i = 0; i < count; i++)
+    {
+        uint16_t value = sample(start_us + (i + 1) * period);
+        if (size == 1)
+            *out = value >> 4;
+        else if (size == 2)
+            *(uint16_t *)out = value;
+        else
+            *(uint32_t *)out = value;
+        if (incr)
+            out += size;
+    }
+}
+
+void adc_init(void)
+{
+    sim_adc_hw.cs = 1;
+}
+
+void adc_gpio_init(uint gpio)
+{
+    // the pin is analogue only once the ADC owns it, nothing else to model
+}
+
+void adc_select_input(uint input)
+{
+    if (input < NUM_ADC_CHANNELS)
+        selected_input = input;
+}
+
+uint adc_get_selected_input(void)
+{
+    return selected_input;
+}
+
+void adc_set_temp_sensor_enabled(bool enable)
+{
+}
+
+uint16_t adc_read(void)
+{
+    uint64_t done = time_us_64() + ADC_CONVERSION_US;
+    sim_wait_until(done);
+    return sample(done);
+}
+
+void adc_run(bool run)
+{
+    sim_adc_hw.cs = run ? (sim_adc_hw.cs | 0x8) : (sim_adc_hw.cs & ~0x8u);
+}
+
+void adc_set_clkdiv(float div)
+{
+    clkdiv = div;
+}
+
+void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo, bool byte_shift)
+{
+    sim_adc_hw.fcs = (en ? 0x1 : 0) | (dreq_en ? 0x8 : 0);
+}
+
+void adc_fifo_drain(void)
+{
+    // captured samples go straight to memory, the FIFO is always empty
+}
@@ -0,0 +1,196 @@
+/**
+ * The background async_context: one thread runs the workers under a recursive lock
+ *
+ * Pending workers run first, then at-time workers whose time has come, earliest first.
+ * The thread sleeps on a condition variable until the next at-time worker is due or
+ * something sets work pending.
+ */
+
+#include <pthread.h>
+#include <time.h>
+
+#include "pico/async_context.h"
+
+#include "sim_internal.h"
+
+struct async_context {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    async_at_time_worker_t *at_time_list;
+    async_when_pending_worker_t *when_pending_list;
+    pthread_t thread;
+};
+
+static async_context_t background;
+static pthread_once_t background_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Runs one pending or due worker with the lock held, returns false if none was ready
+ */
+static bool run_one(async_context_t *context)
+{
+    for (async_when_pending_worker_t *w = context->when_pending_list; w; w = w->next)
+    {
+        if (w->work_pending)
+        {
+            w->work_pending = false;
+            w->do_work(context, w);
+            return true;
+        }
+    }
+
+    async_at_time_worker_t *first = context->at_time_list;
+    if (first && to_us_since_boot(first->next_time) <= time_us_64())
+    {
+        // removed before it runs, so the worker may add itself again
+        context->at_time_list = first->next;
+        first->do_work(context, first);
+        return true;
+    }
+    return false;
+}
+
+static void *context_thread(void *arg)
+{
+    async_context_t *context = arg;
+
+    pthread_mutex_lock(&context->lock);
+    while (true)
+    {
+        if (run_one(context))
+            continue;
+
+        if (!context->at_time_list)
+        {
+            pthread_cond_wait(&context->wake, &context->lock);
+            continue;
+        }
+        struct timespec until = sim_timespec(to_us_since_boot(context->at_time_list->next_time));
+        pthread_cond_timedwait(&context->wake, &context->lock, &until);
+    }
+    return NULL;
+}
+
+static void background_start(void)
+{
+    pthread_mutexattr_t mattr;
+    pthread_mutexattr_init(&mattr);
+    pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&background.lock, &mattr);
+
+    pthread_condattr_t cattr;
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+    pthread_cond_init(&background.wake, &cattr);
+
+    pthread_create(&background.thread, NULL, context_thread, &background);
+    pthread_detach(background.thread);
+}
+
+async_context_t *sim_async_context(void)
+{
+    pthread_once(&background_once, background_start);
+    return &background;
+}
+
+void async_context_acquire_lock_blocking(async_context_t *context)
+{
+    pthread_mutex_lock(&context->lock);
+}
+
+void async_context_release_lock(async_context_t *context)
+{
+    pthread_mutex_unlock(&context->lock);
+}
+
+bool async_context_add_at_time_worker(async_context_t *context, async_at_time_worker_t *worker)
+{
+    pthread_mutex_lock(&context->lock);
+    async_at_time_worker_t **at = &context->at_time_list;
+    for (async_at_time_worker_t *w = *at; w; w = w->next)
+    {
+        if (w == worker)
+        {
+            pthread_mutex_unlock(&context->lock);
+            return false;
+        }
+    }
+    while (*at && to_us_since_boot((*at)->next_time) <= to_us_since_boot(worker->next_time))
+        at = &(*at)->next;
+    worker->next = *at;
+    *at = worker;
+    pthread_cond_signal(&context->wake);
+    pthread_mutex_unlock(&context->lock);
+    return true;
+}
+
+bool async_context_add_at_time_worker_at(async_context_t *context, async_at_time_worker_t *worker, absolute_time_t at)
+{
+    worker->next_time = at;
+    return async_context_add_at_time_worker(context, worker);
+}
+
+bool async_context_add_at_time_worker_in_ms(async_context_t *context, async_at_time_worker_t *worker, uint32_t ms)
+{
+    return async_context_add_at_time_worker_at(context, worker, make_timeout_time_ms(ms));
+}
+
+bool async_context_remove_at_time_worker(async_context_t *context, async_at_time_worker_t *worker)
+{
+    bool found = false;
+    pthread_mutex_lock(&context->lock);
+    for (async_at_time_worker_t **at = &context->at_time_list; *at; at = &(*at)->next)
+    {
+        if (*at == worker)
+        {
+            *at = worker->next;
+            found = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&context->lock);
+    return found;
+}
+
+bool async_context_add_when_pending_worker(async_context_t *context, async_when_pending_worker_t *worker)
+{
+    pthread_mutex_lock(&context->lock);
+    for (async_when_pending_worker_t *w = context->when_pending_list; w; w = w->next)
+    {
+        if (w == worker)
+        {
+            pthread_mutex_unlock(&context->lock);
+            return false;
+        }
+    }
+    worker->next = context->when_pending_list;
+    context->when_pending_list = worker;
+    pthread_cond_signal(&context->wake);
+    pthread_mutex_unlock(&context->lock);
+    return true;
+}
+
+bool async_context_remove_when_pending_worker(async_context_t *context, async_when_pending_worker_t *worker)
+{
+    bool found = false;
+    pthread_mutex_lock(&context->lock);
+    for (async_when_pending_worker_t **at = &context->when_pending_list; *at; at = &(*at)->next)
+    {
+        if (*at == worker)
+        {
+            *at = worker->next;
+            found = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&context->lock);
+    return found;
+}
+
+void async_context_set_work_pending(async_context_t *context, async_when_pending_worker_t *worker)
+{
+    pthread_mutex_lock(&context->lock);
+    worker->work_pending = true;
+    pthread_cond_signal(&context->wake);
+    pthread_mutex_unlock(&context->lock);
+}
@@ -0,0 +1,142 @@
+/**
+ * The simulated board: devices wired the way config.h describes the real one
+ *
+ * Keys on stdin stand in for the buttons: 1, 2 and 3 press BUTTON_1..3 and q quits.
+ * With SIM_RUN_S set the run ends by itself and prints the final glass and device counters.
+ */
+
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "hardware/timer.h"
+
+#include "config.h"
+#include "sim_internal.h"
+
+#define DHT20_I2C_ADDR 0x38
+#define DHT20_NO_MUX 0
+#define LCD_COLS 16
+#define LCD_ROWS 2
+
+// Same table the firmware reads, so the board always has the sensors config.h expects
+static const struct {
+    i2c_inst_t *i2c;
+    uint8_t mux_addr;
+    uint8_t mux_channel;
+} Dht20_Wiring[] = { DHT20_SENSORS };
+
+#define NUM_DHT20 count_of(Dht20_Wiring)
+
+static sim_dht20_t *dht20[NUM_DHT20];
+static sim_lcd_t *lcd;
+
+static uint16_t photoresistor(uint64_t time_us)
+{
+    sim_env_t env;
+    sim_env_at(time_us, &env);
+    return env.light_adc < 0 ? 0 : env.light_adc > 4095 ? 4095 : (uint16_t)env.light_adc;
+}
+
+/**
+ * Prints the glass and the device counters and ends the process
+ */
+static void finish(void *ctx)
+{
+    char row[LCD_COLS + 1];
+    sim_dht20_stats_t dht;
+    sim_lcd_stats_t glass;
+
+    sim_lcd_get_stats(lcd, &glass);
+
+    fprintf(stderr, "--- %.3f s ---\n", time_us_64() / 1e6);
+    for (uint8_t r = 0; r < LCD_ROWS; r++)
+    {
+        sim_lcd_row(lcd, r, row);
+        fprintf(stderr, "|%s|\n", row);
+    }
+    for (uint i = 0; i < NUM_DHT20; i++)
+    {
+        sim_dht20_get_stats(dht20[i], &dht);
+        fprintf(stderr, "dht20 %u: %u triggers, %u reads, %u busy, %u crc faults\n",
+                i, dht.triggers, dht.reads, dht.busy_reads, dht.crc_faults);
+    }
+    fprintf(stderr, "lcd:   %u expander bytes, %u commands, %u chars, backlight %s\n",
+            glass.bytes, glass.commands, glass.chars, sim_lcd_backlight(lcd) ? "on" : "off");
+    sim_net_stats_t net;
+    if (sim_net_get_stats(&net))
+        fprintf(stderr, "uplink: %u requests, %u failed, %llu bytes\n",
+                net.requests, net.failures, (unsigned long long)net.bytes);
+
+    fflush(stdout);
+    exit(0);
+}
+
+static void *key_thread(void *arg)
+{
+    struct pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+    char key;
+
+    while (poll(&pfd, 1, -1) >= 0)
+    {
+        ssize_t got = read(STDIN_FILENO, &key, 1);
+        if (got == 0)
+            break;                          // EOF, keep running without keys
+        if (got < 0)
+            continue;                       // the SDK leaves stdin non-blocking
+
+        switch (key)
+        {
+        case '1':
+            sim_gpio_press(BUTTON_1);
+            break;
+        case '2':
+            sim_gpio_press(BUTTON_2);
+            break;
+        case '3':
+            sim_gpio_press(BUTTON_3);
+            break;
+        case 'q':
+            finish(NULL);
+            break;
+        }
+    }
+    return NULL;
+}
+
+static void __attribute__((constructor(110))) sim_board_init(void)
+{
+    const char *script = getenv("SIM_SCRIPT");
+    if (script && *script && !sim_env_load(script))
+    {
+        fprintf(stderr, "sim: could not read %s\n", script);
+        exit(1);
+    }
+
+    for (uint i = 0; i < NUM_DHT20; i++)
+    {
+        dht20[i] = sim_dht20_create(i);
+        if (Dht20_Wiring[i].mux_addr == DHT20_NO_MUX)
+            sim_i2c_attach(Dht20_Wiring[i].i2c, DHT20_I2C_ADDR, sim_dht20_device(dht20[i]));
+        else
+            sim_i2c_attach_muxed(Dht20_Wiring[i].i2c, Dht20_Wiring[i].mux_addr, Dht20_Wiring[i].mux_channel,
+                                 DHT20_I2C_ADDR, sim_dht20_device(dht20[i]));
+    }
+
+    lcd = sim_lcd_create(LCD_COLS, LCD_ROWS);
+    const char *trace = getenv("SIM_LCD_TRACE");
+    sim_lcd_set_trace(lcd, !(trace && trace[0] == '0'));
+    sim_i2c_attach(LCD_I2C_PORT, LCD_I2C_ADDR, sim_lcd_device(lcd));
+
+    sim_adc_connect(PHOTORES_GPIO_PIN - 26, photoresistor);
+
+    const char *run_s = getenv("SIM_RUN_S");
+    if (run_s && atof(run_s) > 0)
+        sim_schedule_at((uint64_t)(atof(run_s) * 1e6), finish, NULL);
+
+    pthread_t thread;
+    if (!pthread_create(&thread, NULL, key_thread, NULL))
+        pthread_detach(thread);
+}
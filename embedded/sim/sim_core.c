@@ -0,0 +1,855 @@
+/**
+ * Simulated RP2040 cores, interrupts, spin locks, FIFOs and timer for the host build
+ *
+ * Core0 is the process main thread and core1 the thread started by
+ * multicore_launch_core1(). Each core has a pending and an enabled interrupt mask; a core
+ * runs its handlers on its own thread whenever it is unmasked and reaches restore_interrupts(),
+ * __wfi(), __wfe(), tight_loop_contents() or a busy wait, which is where the firmware waits.
+ * A timer thread stands in for the four hardware alarms behind the SDK alarm pool and runs
+ * the events the peripherals schedule.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "pico.h"
+#include "pico/time.h"
+#include "pico/time_adapter.h"
+#include "pico/multicore.h"
+#include "pico/stdio.h"
+#include "pico/bootrom.h"
+#include "hardware/sync.h"
+#include "hardware/irq.h"
+#include "hardware/clocks.h"
+#include "hardware/timer.h"
+
+#include "sim_internal.h"
+
+#define SIM_FIFO_DEPTH 8
+#define SIM_MAX_EVENTS 64
+
+typedef struct {
+    uint32_t pending;              // raised and not yet taken
+    uint32_t enabled;
+    bool event;                    // WFE event latch
+    pthread_cond_t wake;
+    uint32_t fifo[SIM_FIFO_DEPTH]; // words sent to this core
+    uint fifo_head;
+    uint fifo_count;
+} sim_core_t;
+
+typedef struct {
+    bool active;
+    uint64_t time_us;
+    sim_event_fn fn;
+    void *ctx;
+} sim_event_t;
+
+struct _spin_lock_t {
+    atomic_bool locked;
+};
+
+static pthread_mutex_t core_mutex = PTHREAD_MUTEX_INITIALIZER;   // everything below except the spin locks
+static sim_core_t cores[NUM_CORES];
+
+// The vector table is shared by both cores, like the RP2040 default
+static irq_handler_t exclusive_handlers[NUM_IRQS];
+static irq_handler_t shared_handlers[NUM_IRQS][PICO_MAX_SHARED_IRQ_HANDLERS];
+static uint8_t shared_order[NUM_IRQS][PICO_MAX_SHARED_IRQ_HANDLERS];
+static uint8_t shared_count[NUM_IRQS];
+static uint8_t irq_priority[NUM_IRQS];
+
+static sim_event_t events[SIM_MAX_EVENTS];
+static uint64_t alarm_target[NUM_ALARMS];
+static bool alarm_armed[NUM_ALARMS];
+static uint8_t alarms_claimed;
+static pthread_cond_t timer_wake;
+
+static struct _spin_lock_t spin_locks[NUM_SPIN_LOCKS];
+static atomic_uint striped_spin_lock;
+
+static struct timespec start_time;      // CLOCK_MONOTONIC at boot, time_us_64() counts from here
+static uint64_t speed = 1;              // simulated us per real us, SIM_SPEED
+static void (*core1_entry)(void);
+static int timer_instance;              // alarm_pool_timer_t is opaque, any address will do
+
+static __thread uint this_core;
+static __thread bool primask;
+static __thread int current_irq = -1;
+
+// ********** Time **********
+
+/**
+ * CLOCK_MONOTONIC deadline for a simulated time, rounded up so a wait never ends early
+ */
+struct timespec sim_timespec(uint64_t time_us)
+{
+    time_us = (time_us + speed - 1) / speed;
+    struct timespec ts = start_time;
+    ts.tv_sec += time_us / 1000000;
+    ts.tv_nsec += (time_us % 1000000) * 1000;
+    if (ts.tv_nsec >= 1000000000)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+/**
+ * Microseconds since the simulated boot
+ */
+uint64_t time_us_64(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t ns = (uint64_t)(ts.tv_sec - start_time.tv_sec) * 1000000000 + ts.tv_nsec - start_time.tv_nsec;
+    return ns * speed / 1000;
+}
+
+uint32_t time_us_32(void)
+{
+    return (uint32_t)time_us_64();
+}
+
+void busy_wait_until(absolute_time_t t)
+{
+    sim_wait_until(to_us_since_boot(t));
+}
+
+void busy_wait_us_32(uint32_t delay_us)
+{
+    sim_wait_until(time_us_64() + delay_us);
+}
+
+void busy_wait_us(uint64_t delay_us)
+{
+    sim_wait_until(time_us_64() + delay_us);
+}
+
+void busy_wait_ms(uint32_t delay_ms)
+{
+    sim_wait_until(time_us_64() + delay_ms * 1000ull);
+}
+
+uint32_t clock_get_hz(clock_handle_t clock)
+{
+    switch (clock)
+    {
+    case clk_sys:
+        return 125000000;
+    case clk_ref:
+        return 12000000;
+    case clk_rtc:
+        return 46875;
+    default:
+        return 48000000; // peri, usb and adc run from the USB PLL
+    }
+}
+
+// ********** Interrupts **********
+
+/**
+ * Marks irq pending on one core, core_mutex held
+ */
+static void raise_on_core(uint core, uint irq)
+{
+    cores[core].pending |= 1u << irq;
+    if (cores[core].enabled & (1u << irq))
+        pthread_cond_broadcast(&cores[core].wake);
+}
+
+/**
+ * Runs the handlers of one interrupt on the calling core
+ */
+static void run_handlers(uint irq)
+{
+    irq_handler_t handlers[PICO_MAX_SHARED_IRQ_HANDLERS];
+    uint count = 0;
+
+    pthread_mutex_lock(&core_mutex);
+    if (exclusive_handlers[irq])
+        handlers[count++] = exclusive_handlers[irq];
+    else
+    {
+        for (uint i = 0; i < shared_count[irq]; i++)
+            handlers[count++] = shared_handlers[irq][i];
+    }
+    pthread_mutex_unlock(&core_mutex);
+
+    if (!count)
+        panic("Unhandled IRQ %u on core %u", irq, this_core);
+
+    current_irq = irq;
+    for (uint i = 0; i < count; i++)
+        handlers[i]();
+    current_irq = -1;
+}
+
+/**
+ * Takes every pending and enabled interrupt of the calling core, lowest number first
+ * Does nothing while masked or already inside a handler
+ */
+static void take_interrupts(void)
+{
+    if (primask || current_irq >= 0)
+        return;
+
+    sim_core_t *core = &cores[this_core];
+    while (true)
+    {
+        pthread_mutex_lock(&core_mutex);
+        uint32_t ready = core->pending & core->enabled;
+        if (!ready)
+        {
+            pthread_mutex_unlock(&core_mutex);
+            return;
+        }
+        uint irq = __builtin_ctz(ready);
+        core->pending &= ~(1u << irq);
+        pthread_mutex_unlock(&core_mutex);
+
+        run_handlers(irq);
+    }
+}
+
+void sim_irq_raise(uint irq)
+{
+    pthread_mutex_lock(&core_mutex);
+    for (uint c = 0; c < NUM_CORES; c++)
+        raise_on_core(c, irq);
+    pthread_mutex_unlock(&core_mutex);
+}
+
+void sim_wait_until(uint64_t time_us)
+{
+    sim_core_t *core = &cores[this_core];
+    struct timespec until = sim_timespec(time_us);
+    bool can_take = !primask && current_irq < 0;
+
+    while (time_us_64() < time_us)
+    {
+        pthread_mutex_lock(&core_mutex);
+        if (!can_take || !(core->pending & core->enabled))
+            pthread_cond_timedwait(&core->wake, &core_mutex, &until);
+        pthread_mutex_unlock(&core_mutex);
+        take_interrupts();
+    }
+}
+
+void irq_set_enabled(uint num, bool enabled)
+{
+    irq_set_mask_enabled(1u << num, enabled);
+}
+
+bool irq_is_enabled(uint num)
+{
+    pthread_mutex_lock(&core_mutex);
+    bool enabled = cores[this_core].enabled & (1u << num);
+    pthread_mutex_unlock(&core_mutex);
+    return enabled;
+}
+
+/**
+ * Enabling clears the pending bits first, like the SDK does on the RP2040
+ */
+void irq_set_mask_enabled(uint32_t mask, bool enabled)
+{
+    pthread_mutex_lock(&core_mutex);
+    if (enabled)
+    {
+        cores[this_core].pending &= ~mask;
+        cores[this_core].enabled |= mask;
+    }
+    else
+        cores[this_core].enabled &= ~mask;
+    pthread_mutex_unlock(&core_mutex);
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler)
+{
+    pthread_mutex_lock(&core_mutex);
+    if (shared_count[num] || (exclusive_handlers[num] && exclusive_handlers[num] != handler))
+        panic("IRQ %u already has a handler", num);
+    exclusive_handlers[num] = handler;
+    pthread_mutex_unlock(&core_mutex);
+}
+
+irq_handler_t irq_get_exclusive_handler(uint num)
+{
+    return exclusive_handlers[num];
+}
+
+/**
+ * Higher order priorities run first, equal ones in the order they were added
+ */
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority)
+{
+    pthread_mutex_lock(&core_mutex);
+    uint count = shared_count[num];
+    if (exclusive_handlers[num] || count == PICO_MAX_SHARED_IRQ_HANDLERS)
+        panic("No room for a shared handler on IRQ %u", num);
+
+    uint at = count;
+    while (at > 0 && shared_order[num][at - 1] < order_priority)
+    {
+        shared_handlers[num][at] = shared_handlers[num][at - 1];
+        shared_order[num][at] = shared_order[num][at - 1];
+        at--;
+    }
+    shared_handlers[num][at] = handler;
+    shared_order[num][at] = order_priority;
+    shared_count[num] = count + 1;
+    pthread_mutex_unlock(&core_mutex);
+}
+
+void irq_remove_handler(uint num, irq_handler_t handler)
+{
+    pthread_mutex_lock(&core_mutex);
+    if (exclusive_handlers[num] == handler)
+        exclusive_handlers[num] = NULL;
+
+    uint kept = 0;
+    for (uint i = 0; i < shared_count[num]; i++)
+    {
+        if (shared_handlers[num][i] == handler)
+            continue;
+        shared_handlers[num][kept] = shared_handlers[num][i];
+        shared_order[num][kept] = shared_order[num][i];
+        kept++;
+    }
+    shared_count[num] = kept;
+    pthread_mutex_unlock(&core_mutex);
+}
+
+bool irq_has_shared_handler(uint num)
+{
+    return shared_count[num] != 0;
+}
+
+void irq_set_priority(uint num, uint8_t hardware_priority)
+{
+    irq_priority[num] = hardware_priority;
+}
+
+uint irq_get_priority(uint num)
+{
+    return irq_priority[num];
+}
+
+void irq_clear(uint int_num)
+{
+    pthread_mutex_lock(&core_mutex);
+    cores[this_core].pending &= ~(1u << int_num);
+    pthread_mutex_unlock(&core_mutex);
+}
+
+void irq_set_pending(uint num)
+{
+    pthread_mutex_lock(&core_mutex);
+    raise_on_core(this_core, num);
+    pthread_mutex_unlock(&core_mutex);
+    take_interrupts();
+}
+
+// ********** hardware_sync **********
+
+uint get_core_num(void)
+{
+    return this_core;
+}
+
+void tight_loop_contents(void)
+{
+    take_interrupts();
+    sched_yield();
+}
+
+uint32_t save_and_disable_interrupts(void)
+{
+    uint32_t status = primask;
+    primask = true;
+    return status;
+}
+
+void restore_interrupts(uint32_t status)
+{
+    primask = status;
+    take_interrupts();
+}
+
+void restore_interrupts_from_disabled(uint32_t status)
+{
+    restore_interrupts(status);
+}
+
+/**
+ * Sleeps until an enabled interrupt is pending, then takes it if unmasked
+ */
+void __wfi(void)
+{
+    sim_core_t *core = &cores[this_core];
+    pthread_mutex_lock(&core_mutex);
+    while (!(core->pending & core->enabled))
+        pthread_cond_wait(&core->wake, &core_mutex);
+    pthread_mutex_unlock(&core_mutex);
+    take_interrupts();
+}
+
+/**
+ * Consumes the event latch, sleeping until an event or an enabled interrupt if it is clear
+ */
+void __wfe(void)
+{
+    sim_core_t *core = &cores[this_core];
+    pthread_mutex_lock(&core_mutex);
+    while (!core->event && !(core->pending & core->enabled))
+        pthread_cond_wait(&core->wake, &core_mutex);
+    core->event = false;
+    pthread_mutex_unlock(&core_mutex);
+    take_interrupts();
+}
+
+void __sev(void)
+{
+    pthread_mutex_lock(&core_mutex);
+    for (uint c = 0; c < NUM_CORES; c++)
+    {
+        cores[c].event = true;
+        pthread_cond_broadcast(&cores[c].wake);
+    }
+    pthread_mutex_unlock(&core_mutex);
+}
+
+spin_lock_t *spin_lock_instance(uint lock_num)
+{
+    return &spin_locks[lock_num];
+}
+
+uint spin_lock_get_num(spin_lock_t *lock)
+{
+    return (uint)(lock - spin_locks);
+}
+
+uint spin_lock_num(spin_lock_t *lock)
+{
+    return spin_lock_get_num(lock);
+}
+
+void spin_lock_unsafe_blocking(spin_lock_t *lock)
+{
+    while (atomic_exchange_explicit(&lock->locked, true, memory_order_acquire))
+        sched_yield();
+}
+
+void spin_unlock_unsafe(spin_lock_t *lock)
+{
+    atomic_store_explicit(&lock->locked, false, memory_order_release);
+}
+
+uint32_t spin_lock_blocking(spin_lock_t *lock)
+{
+    uint32_t status = save_and_disable_interrupts();
+    spin_lock_unsafe_blocking(lock);
+    return status;
+}
+
+void spin_unlock(spin_lock_t *lock, uint32_t saved_irq)
+{
+    spin_unlock_unsafe(lock);
+    restore_interrupts(saved_irq);
+}
+
+bool is_spin_locked(const spin_lock_t *lock)
+{
+    return atomic_load(&((spin_lock_t *)lock)->locked);
+}
+
+spin_lock_t *spin_lock_init(uint lock_num)
+{
+    spin_lock_t *lock = spin_lock_instance(lock_num);
+    spin_unlock_unsafe(lock);
+    return lock;
+}
+
+void clear_spin_locks(void)
+{
+    for (uint i = 0; i < NUM_SPIN_LOCKS; i++)
+        spin_unlock_unsafe(&spin_locks[i]);
+}
+
+uint next_striped_spin_lock_num(void)
+{
+    uint span = PICO_SPINLOCK_ID_STRIPED_LAST - PICO_SPINLOCK_ID_STRIPED_FIRST + 1;
+    return PICO_SPINLOCK_ID_STRIPED_FIRST + atomic_fetch_add(&striped_spin_lock, 1) % span;
+}
+
+// ********** Multicore **********
+
+static void *core1_thread(void *arg)
+{
+    this_core = 1;
+    core1_entry();
+    return NULL;
+}
+
+void multicore_launch_core1(void (*entry)(void))
+{
+    pthread_t thread;
+    core1_entry = entry;
+    if (pthread_create(&thread, NULL, core1_thread, NULL))
+        panic("Could not start core1");
+    pthread_detach(thread);
+}
+
+void multicore_launch_core1_with_stack(void (*entry)(void), uint32_t *stack_bottom, size_t stack_size_bytes)
+{
+    multicore_launch_core1(entry);
+}
+
+bool multicore_fifo_rvalid(void)
+{
+    pthread_mutex_lock(&core_mutex);
+    bool valid = cores[this_core].fifo_count != 0;
+    pthread_mutex_unlock(&core_mutex);
+    return valid;
+}
+
+bool multicore_fifo_wready(void)
+{
+    pthread_mutex_lock(&core_mutex);
+    bool ready = cores[this_core ^ 1].fifo_count < SIM_FIFO_DEPTH;
+    pthread_mutex_unlock(&core_mutex);
+    return ready;
+}
+
+/**
+ * Pushes a word to the other core and raises its FIFO interrupt, false if the FIFO is full
+ */
+static bool fifo_try_push(uint32_t data)
+{
+    uint other = this_core ^ 1;
+    sim_core_t *core = &cores[other];
+
+    pthread_mutex_lock(&core_mutex);
+    bool pushed = core->fifo_count < SIM_FIFO_DEPTH;
+    if (pushed)
+    {
+        core->fifo[(core->fifo_head + core->fifo_count++) % SIM_FIFO_DEPTH] = data;
+        raise_on_core(other, SIO_FIFO_IRQ_NUM(other));
+    }
+    pthread_mutex_unlock(&core_mutex);
+    if (pushed)
+        __sev();
+    return pushed;
+}
+
+static bool fifo_try_pop(uint32_t *out)
+{
+    sim_core_t *core = &cores[this_core];
+
+    pthread_mutex_lock(&core_mutex);
+    bool popped = core->fifo_count != 0;
+    if (popped)
+    {
+        *out = core->fifo[core->fifo_head];
+        core->fifo_head = (core->fifo_head + 1) % SIM_FIFO_DEPTH;
+        core->fifo_count--;
+    }
+    pthread_mutex_unlock(&core_mutex);
+    if (popped)
+        __sev();
+    return popped;
+}
+
+void multicore_fifo_push_blocking(uint32_t data)
+{
+    while (!fifo_try_push(data))
+        __wfe();
+}
+
+bool multicore_fifo_push_timeout_us(uint32_t data, uint64_t timeout_us)
+{
+    uint64_t until = time_us_64() + timeout_us;
+    while (!fifo_try_push(data))
+    {
+        if (time_us_64() >= until)
+            return false;
+        tight_loop_contents();
+    }
+    return true;
+}
+
+uint32_t multicore_fifo_pop_blocking(void)
+{
+    uint32_t data;
+    while (!fifo_try_pop(&data))
+        __wfe();
+    return data;
+}
+
+bool multicore_fifo_pop_timeout_us(uint64_t timeout_us, uint32_t *out)
+{
+    uint64_t until = time_us_64() + timeout_us;
+    while (!fifo_try_pop(out))
+    {
+        if (time_us_64() >= until)
+            return false;
+        tight_loop_contents();
+    }
+    return true;
+}
+
+void multicore_fifo_drain(void)
+{
+    pthread_mutex_lock(&core_mutex);
+    cores[this_core].fifo_count = 0;
+    pthread_mutex_unlock(&core_mutex);
+}
+
+void multicore_fifo_clear_irq(void)
+{
+    // the sticky ROE / WOF flags are not modelled
+}
+
+uint32_t multicore_fifo_get_status(void)
+{
+    pthread_mutex_lock(&core_mutex);
+    uint32_t status = (cores[this_core].fifo_count ? 1u : 0u) |
+                      (cores[this_core ^ 1].fifo_count < SIM_FIFO_DEPTH ? 2u : 0u);
+    pthread_mutex_unlock(&core_mutex);
+    return status;
+}
+
+// ********** Timer thread **********
+
+int sim_schedule_at(uint64_t time_us, sim_event_fn fn, void *ctx)
+{
+    pthread_mutex_lock(&core_mutex);
+    for (int i = 0; i < SIM_MAX_EVENTS; i++)
+    {
+        if (events[i].active)
+            continue;
+        events[i] = (sim_event_t){true, time_us, fn, ctx};
+        pthread_cond_signal(&timer_wake);
+        pthread_mutex_unlock(&core_mutex);
+        return i + 1;
+    }
+    pthread_mutex_unlock(&core_mutex);
+    panic("Out of simulator events");
+}
+
+void sim_cancel(int event)
+{
+    if (event <= 0)
+        return;
+    pthread_mutex_lock(&core_mutex);
+    events[event - 1].active = false;
+    pthread_mutex_unlock(&core_mutex);
+}
+
+/**
+ * Fires due alarms and events, then sleeps until the next one is due or something new is armed
+ * Events run without the core lock so they can raise interrupts and schedule more events
+ */
+static void *timer_thread(void *arg)
+{
+    pthread_mutex_lock(&core_mutex);
+    while (true)
+    {
+        uint64_t now = time_us_64();
+        uint64_t next = UINT64_MAX;
+        int due = -1;
+
+        for (uint a = 0; a < NUM_ALARMS; a++)
+        {
+            if (!alarm_armed[a])
+                continue;
+            if (alarm_target[a] <= now)
+            {
+                alarm_armed[a] = false;
+                for (uint c = 0; c < NUM_CORES; c++)
+                    raise_on_core(c, TIMER_IRQ_0 + a);
+            }
+            else if (alarm_target[a] < next)
+                next = alarm_target[a];
+        }
+
+        for (int i = 0; i < SIM_MAX_EVENTS; i++)
+        {
+            if (!events[i].active)
+                continue;
+            if (events[i].time_us <= now && (due < 0 || events[i].time_us < events[due].time_us))
+                due = i;
+            else if (events[i].time_us < next)
+                next = events[i].time_us;
+        }
+
+        if (due >= 0)
+        {
+            sim_event_t event = events[due];
+            events[due].active = false;
+            pthread_mutex_unlock(&core_mutex);
+            event.fn(event.ctx);
+            pthread_mutex_lock(&core_mutex);
+            continue;
+        }
+
+        if (next == UINT64_MAX)
+            pthread_cond_wait(&timer_wake, &core_mutex);
+        else
+        {
+            struct timespec until = sim_timespec(next);
+            pthread_cond_timedwait(&timer_wake, &core_mutex, &until);
+        }
+    }
+    return NULL;
+}
+
+// ********** Time adapter for the SDK alarm pool **********
+
+void ta_hardware_alarm_claim(alarm_pool_timer_t *timer, uint hardware_alarm_num)
+{
+    if (alarms_claimed & (1u << hardware_alarm_num))
+        panic("Hardware alarm %u already claimed", hardware_alarm_num);
+    alarms_claimed |= 1u << hardware_alarm_num;
+}
+
+int ta_hardware_alarm_claim_unused(alarm_pool_timer_t *timer, bool required)
+{
+    for (uint a = 0; a < NUM_ALARMS; a++)
+    {
+        if (!(alarms_claimed & (1u << a)))
+        {
+            alarms_claimed |= 1u << a;
+            return (int)a;
+        }
+    }
+    if (required)
+        panic("No free hardware alarm");
+    return -1;
+}
+
+/**
+ * Arms an alarm, a target already in the past fires straight away
+ */
+void ta_set_timeout(alarm_pool_timer_t *timer, uint hardware_alarm_num, int64_t target)
+{
+    pthread_mutex_lock(&core_mutex);
+    alarm_target[hardware_alarm_num] = (uint64_t)target;
+    alarm_armed[hardware_alarm_num] = true;
+    pthread_cond_signal(&timer_wake);
+    pthread_mutex_unlock(&core_mutex);
+}
+
+void ta_clear_irq(alarm_pool_timer_t *timer, uint hardware_alarm_num)
+{
+    irq_clear(TIMER_IRQ_0 + hardware_alarm_num);
+}
+
+void ta_clear_force_irq(alarm_pool_timer_t *timer, uint hardware_alarm_num)
+{
+    // a forced interrupt is a plain pending bit here, taking it already cleared it
+}
+
+void ta_force_irq(alarm_pool_timer_t *timer, uint hardware_alarm_num)
+{
+    sim_irq_raise(TIMER_IRQ_0 + hardware_alarm_num);
+}
+
+void ta_enable_irq_handler(alarm_pool_timer_t *timer, uint hardware_alarm_num, void (*irq_handler)(void))
+{
+    irq_set_exclusive_handler(TIMER_IRQ_0 + hardware_alarm_num, irq_handler);
+    irq_set_enabled(TIMER_IRQ_0 + hardware_alarm_num, true);
+}
+
+void ta_disable_irq_handler(alarm_pool_timer_t *timer, uint hardware_alarm_num, void (*irq_handler)(void))
+{
+    irq_set_enabled(TIMER_IRQ_0 + hardware_alarm_num, false);
+    irq_remove_handler(TIMER_IRQ_0 + hardware_alarm_num, irq_handler);
+}
+
+alarm_pool_timer_t *ta_from_current_irq(uint *alarm_num)
+{
+    *alarm_num = (uint)(current_irq - TIMER_IRQ_0);
+    return &timer_instance;
+}
+
+int ta_get_handler_hardware_alarm_num(void)
+{
+    return current_irq - TIMER_IRQ_0;
+}
+
+uint ta_timer_num(alarm_pool_timer_t *timer)
+{
+    return 0;
+}
+
+alarm_pool_timer_t *ta_timer_instance(uint instance_num)
+{
+    return &timer_instance;
+}
+
+alarm_pool_timer_t *ta_default_timer_instance(void)
+{
+    return &timer_instance;
+}
+
+// ********** Misc **********
+
+int stdio_put_string(const char *s, int len, bool newline, bool cr_translation)
+{
+    fwrite(s, 1, len, stdout);
+    if (newline)
+        fputs(cr_translation ? "\r\n" : "\n", stdout);
+    fflush(stdout);
+    return len;
+}
+
+void reset_usb_boot(uint32_t usb_activity_gpio_pin_mask, uint32_t disable_interface_mask)
+{
+    exit(0);
+}
+
+int32_t sim_noise(uint64_t key, int32_t amplitude)
+{
+    // splitmix64 finalizer
+    key += 0x9E3779B97F4A7C15ull;
+    key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ull;
+    key = (key ^ (key >> 27)) * 0x94D049BB133111EBull;
+    key ^= key >> 31;
+    if (amplitude <= 0)
+        return 0;
+    return (int32_t)(key % (2 * (uint64_t)amplitude + 1)) - amplitude;
+}
+
+/**
+ * Boot: runs before main() on what becomes core0
+ */
+static void __attribute__((constructor(101))) sim_core_init(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    const char *s = getenv("SIM_SPEED");
+    if (s && atoi(s) > 1)
+        speed = (uint64_t)atoi(s);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    for (uint c = 0; c < NUM_CORES; c++)
+        pthread_cond_init(&cores[c].wake, &attr);
+    pthread_cond_init(&timer_wake, &attr);
+    pthread_condattr_destroy(&attr);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, timer_thread, NULL))
+        panic("Could not start the timer thread");
+    pthread_detach(thread);
+
+    // the host runtime has no init hooks, start the default alarm pool here like the device runtime does
+    alarm_pool_init_default();
+}
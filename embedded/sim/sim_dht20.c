@@ -0,0 +1,135 @@
+/**
+ * Simulated DHT20 temperature / humidity sensor
+ *
+ * 0xAC 0x33 0x00 starts a conversion of 75 to 85 ms; reads before it ends return the busy
+ * bit with the previous data, like the part does. Results follow the simulated room with
+ * a little sensor noise and carry the CRC8 the datasheet describes.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_internal.h"
+
+#define DHT20_STATUS_CALIBRATED 0x18
+#define DHT20_STATUS_BUSY 0x80
+#define DHT20_CONVERSION_US 80000
+#define DHT20_CONVERSION_JITTER_US 5000
+
+struct sim_dht20 {
+    sim_i2c_device_t dev;       // first, the I2C callbacks get this pointer
+    uint64_t ready_us;          // end of the running conversion
+    uint8_t data[7];            // last finished reply: status, 5 data bytes, CRC
+    uint8_t next[7];            // reply of the running conversion
+    uint id;
+    uint32_t crc_fault_n;
+    sim_dht20_stats_t stats;
+};
+
+static uint8_t crc8(const uint8_t *data, int len)
+{
+    uint8_t crc = 0xFF;
+    for (int i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++)
+            crc = crc & 0x80 ? (crc << 1) ^ 0x31 : crc << 1;
+    }
+    return crc;
+}
+
+/**
+ * Converts the room at the end of the conversion into the 7 byte reply
+ */
+static void measure(sim_dht20_t *dht, uint64_t time_us)
+{
+    sim_env_t env;
+    sim_env_at(time_us, &env);
+
+    uint64_t key = time_us ^ ((uint64_t)dht->id << 48);
+    float humidity = env.humidity_pct - dht->id + sim_noise(key ^ 0xD420, 5) / 100.0f;
+    float temperature = env.temperature_c + 0.5f * dht->id + sim_noise(key ^ 0xD421, 3) / 100.0f;
+    if (humidity < 0)
+        humidity = 0;
+    if (humidity > 100)
+        humidity = 100;
+
+    uint32_t raw_h = (uint32_t)(humidity / 100.0f * (1 << 20) + 0.5f);
+    uint32_t raw_t = (uint32_t)((temperature + 50.0f) / 200.0f * (1 << 20) + 0.5f);
+    if (raw_h > 0xFFFFF)
+        raw_h = 0xFFFFF;
+    if (raw_t > 0xFFFFF)
+        raw_t = 0xFFFFF;
+
+    uint8_t *d = dht->next;
+    d[0] = DHT20_STATUS_CALIBRATED;
+    d[1] = raw_h >> 12;
+    d[2] = raw_h >> 4;
+    d[3] = (raw_h << 4) | (raw_t >> 16);
+    d[4] = raw_t >> 8;
+    d[5] = raw_t;
+    d[6] = crc8(d, 6);
+
+    if (dht->crc_fault_n && (dht->stats.triggers % dht->crc_fault_n) == 0)
+    {
+        d[6] ^= 0x5A;
+        dht->stats.crc_faults++;
+    }
+}
+
+static int dht20_write(sim_i2c_device_t *dev, const uint8_t *src, size_t len, uint64_t time_us)
+{
+    sim_dht20_t *dht = (sim_dht20_t *)dev;
+
+    if (len == 3 && src[0] == 0xAC)
+    {
+        dht->stats.triggers++;
+        dht->ready_us = time_us + DHT20_CONVERSION_US + sim_noise(time_us ^ 0xD422, DHT20_CONVERSION_JITTER_US);
+        measure(dht, dht->ready_us);
+    }
+    // calibration register writes (0x1B, 0x1C, 0x1E) and anything else are acknowledged
+    return (int)len;
+}
+
+static int dht20_read(sim_i2c_device_t *dev, uint8_t *dst, size_t len, uint64_t time_us)
+{
+    sim_dht20_t *dht = (sim_dht20_t *)dev;
+    bool busy = time_us < dht->ready_us;
+
+    dht->stats.reads++;
+    if (busy)
+        dht->stats.busy_reads++;
+
+    if (!busy)
+        memcpy(dht->data, dht->next, sizeof(dht->data));
+    for (size_t i = 0; i < len; i++)
+        dst[i] = i < sizeof(dht->data) ? dht->data[i] : 0xFF;
+    if (len)
+        dst[0] = DHT20_STATUS_CALIBRATED | (busy ? DHT20_STATUS_BUSY : 0);
+    return (int)len;
+}
+
+sim_dht20_t *sim_dht20_create(uint id)
+{
+    sim_dht20_t *dht = calloc(1, sizeof(*dht));
+    dht->id = id;
+    dht->dev.write = dht20_write;
+    dht->dev.read = dht20_read;
+    dht->data[0] = DHT20_STATUS_CALIBRATED;
+    dht->next[0] = DHT20_STATUS_CALIBRATED;
+
+    const char *n = getenv("SIM_DHT20_CRC_FAULT_N");
+    dht->crc_fault_n = n ? (uint32_t)atoi(n) : 0;
+    return dht;
+}
+
+sim_i2c_device_t *sim_dht20_device(sim_dht20_t *dht)
+{
+    return &dht->dev;
+}
+
+void sim_dht20_get_stats(sim_dht20_t *dht, sim_dht20_stats_t *out)
+{
+    *out = dht->stats;
+}
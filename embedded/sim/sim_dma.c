@@ -0,0 +1,218 @@
+/**
+ * Simulated DMA channels
+ *
+ * A channel writing an I2C data_cmd register or reading the ADC FIFO finishes when the
+ * peripheral would have paced it to the end; the timer thread then fills in the data,
+ * clears busy and raises the channel's DMA interrupt. Unpaced transfers copy at once.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/timer.h"
+
+#include "sim_internal.h"
+
+typedef struct {
+    bool claimed;
+    atomic_bool busy;
+    uint32_t ctrl;
+    volatile void *write_addr;
+    const volatile void *read_addr;
+    uint count;
+    bool irq0_enabled;
+    bool irq1_enabled;
+    atomic_bool irq0_status;
+    atomic_bool irq1_status;
+    uint64_t start_us;
+    uint generation;            // bumped by start and abort so a stale completion is ignored
+} sim_dma_channel_t;
+
+static sim_dma_channel_t channels[NUM_DMA_CHANNELS];
+static pthread_mutex_t dma_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline uint size_of(uint32_t ctrl)
+{
+    return 1u << ((ctrl & DMA_CH_CTRL_DATA_SIZE_BITS) >> DMA_CH_CTRL_DATA_SIZE_LSB);
+}
+
+void dma_channel_claim(uint channel)
+{
+    pthread_mutex_lock(&dma_mutex);
+    if (channels[channel].claimed)
+        panic("DMA channel %u already claimed", channel);
+    channels[channel].claimed = true;
+    pthread_mutex_unlock(&dma_mutex);
+}
+
+void dma_channel_unclaim(uint channel)
+{
+    pthread_mutex_lock(&dma_mutex);
+    channels[channel].claimed = false;
+    pthread_mutex_unlock(&dma_mutex);
+}
+
+int dma_claim_unused_channel(bool required)
+{
+    pthread_mutex_lock(&dma_mutex);
+    for (uint c = 0; c < NUM_DMA_CHANNELS; c++)
+    {
+        if (!channels[c].claimed)
+        {
+            channels[c].claimed = true;
+            pthread_mutex_unlock(&dma_mutex);
+            return (int)c;
+        }
+    }
+    pthread_mutex_unlock(&dma_mutex);
+    if (required)
+        panic("No DMA channels are available");
+    return -1;
+}
+
+/**
+ * Timer thread: the paced transfer has finished
+ */
+static void channel_done(void *ctx)
+{
+    uint channel = (uintptr_t)ctx & 0xFF;
+    uint generation = (uintptr_t)ctx >> 8;
+    sim_dma_channel_t *ch = &channels[channel];
+
+    pthread_mutex_lock(&dma_mutex);
+    if (!atomic_load(&ch->busy) || ch->generation != generation)
+    {
+        pthread_mutex_unlock(&dma_mutex);
+        return;
+    }
+    if (sim_adc_is_fifo(ch->read_addr))
+        sim_adc_capture((void *)ch->write_addr, ch->count, size_of(ch->ctrl),
+                        ch->ctrl & DMA_CH_CTRL_INCR_WRITE_BITS, ch->start_us);
+    bool irq0 = ch->irq0_enabled;
+    bool irq1 = ch->irq1_enabled;
+    if (irq0)
+        atomic_store(&ch->irq0_status, true);
+    if (irq1)
+        atomic_store(&ch->irq1_status, true);
+    atomic_store(&ch->busy, false);
+    pthread_mutex_unlock(&dma_mutex);
+
+    if (irq0)
+        sim_irq_raise(DMA_IRQ_0);
+    if (irq1)
+        sim_irq_raise(DMA_IRQ_1);
+}
+
+/**
+ * Copies an unpaced transfer straight away
+ */
+static void copy_now(sim_dma_channel_t *ch)
+{
+    uint size = size_of(ch->ctrl);
+    volatile uint8_t *dst = ch->write_addr;
+    const volatile uint8_t *src = ch->read_addr;
+
+    for (uint i = 0; i < ch->count; i++)
+    {
+        memcpy((void *)dst, (const void *)src, size);
+        if (ch->ctrl & DMA_CH_CTRL_INCR_WRITE_BITS)
+            dst += size;
+        if (ch->ctrl & DMA_CH_CTRL_INCR_READ_BITS)
+            src += size;
+    }
+}
+
+void dma_channel_start(uint channel)
+{
+    sim_dma_channel_t *ch = &channels[channel];
+    uint64_t now = time_us_64();
+    uint64_t done = now;
+
+    pthread_mutex_lock(&dma_mutex);
+    uint generation = ++ch->generation & 0xFFFFFF;
+    ch->generation = generation;
+    ch->start_us = now;
+
+    i2c_inst_t *i2c = sim_i2c_from_data_cmd(ch->write_addr);
+    if (i2c && size_of(ch->ctrl) == 2 && (ch->ctrl & DMA_CH_CTRL_INCR_READ_BITS))
+        done = sim_i2c_dma_tx(i2c, (const uint16_t *)ch->read_addr, ch->count, now);
+    else if (sim_adc_is_fifo(ch->read_addr))
+        done = now + sim_adc_capture_us(ch->count);
+    else
+        copy_now(ch);
+
+    atomic_store(&ch->busy, true);
+    if (done != UINT64_MAX)     // otherwise stalled on a NACK until aborted
+        sim_schedule_at(done, channel_done, (void *)(uintptr_t)(channel | generation << 8));
+    pthread_mutex_unlock(&dma_mutex);
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger)
+{
+    sim_dma_channel_t *ch = &channels[channel];
+
+    pthread_mutex_lock(&dma_mutex);
+    ch->ctrl = config->ctrl;
+    ch->write_addr = write_addr;
+    ch->read_addr = read_addr;
+    ch->count = transfer_count;
+    pthread_mutex_unlock(&dma_mutex);
+
+    if (trigger && (config->ctrl & DMA_CH_CTRL_EN_BITS))
+        dma_channel_start(channel);
+}
+
+bool dma_channel_is_busy(uint channel)
+{
+    return atomic_load(&channels[channel].busy);
+}
+
+void dma_channel_wait_for_finish_blocking(uint channel)
+{
+    while (dma_channel_is_busy(channel))
+        tight_loop_contents();
+}
+
+void dma_channel_abort(uint channel)
+{
+    sim_dma_channel_t *ch = &channels[channel];
+
+    pthread_mutex_lock(&dma_mutex);
+    ch->generation = (ch->generation + 1) & 0xFFFFFF;
+    atomic_store(&ch->busy, false);
+    pthread_mutex_unlock(&dma_mutex);
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled)
+{
+    channels[channel].irq0_enabled = enabled;
+}
+
+void dma_channel_set_irq1_enabled(uint channel, bool enabled)
+{
+    channels[channel].irq1_enabled = enabled;
+}
+
+bool dma_channel_get_irq0_status(uint channel)
+{
+    return atomic_load(&channels[channel].irq0_status);
+}
+
+bool dma_channel_get_irq1_status(uint channel)
+{
+    return atomic_load(&channels[channel].irq1_status);
+}
+
+void dma_channel_acknowledge_irq0(uint channel)
+{
+    atomic_store(&channels[channel].irq0_status, false);
+}
+
+void dma_channel_acknowledge_irq1(uint channel)
+{
+    atomic_store(&channels[channel].irq1_status, false);
+}
@@ -0,0 +1,108 @@
+/**
+ * Simulated room the board sits in
+ *
+ * Either a script of (seconds, temperature, humidity, light) rows, linearly interpolated and
+ * held after the last row, or a default day: the run starts at 08:00, the temperature peaks
+ * mid afternoon, humidity moves the other way and a lamp comes on in the evening. Light
+ * carries 100 Hz mains flicker so the photoresistor filter has something to reject.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim_internal.h"
+
+#define SIM_ENV_MAX_ROWS 4096
+#define SIM_PI 3.14159265f
+
+typedef struct {
+    float time_s;
+    sim_env_t env;
+} sim_env_row_t;
+
+static sim_env_row_t *rows;
+static uint row_count;
+
+static float day_s(void)
+{
+    static float day;
+    if (!day)
+    {
+        const char *s = getenv("SIM_DAY_S");
+        day = s && atof(s) > 0 ? atof(s) : 86400.0f;
+    }
+    return day;
+}
+
+/**
+ * Reads a script, lines starting with # and lines that do not parse are skipped
+ */
+bool sim_env_load(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return false;
+
+    rows = calloc(SIM_ENV_MAX_ROWS, sizeof(*rows));
+    row_count = 0;
+
+    char line[256];
+    while (row_count < SIM_ENV_MAX_ROWS && fgets(line, sizeof(line), f))
+    {
+        sim_env_row_t *r = &rows[row_count];
+        if (line[0] == '#')
+            continue;
+        if (sscanf(line, "%f,%f,%f,%f", &r->time_s, &r->env.temperature_c, &r->env.humidity_pct,
+                   &r->env.light_adc) == 4)
+            row_count++;
+    }
+    fclose(f);
+    return row_count > 0;
+}
+
+static void scripted(float t, sim_env_t *out)
+{
+    uint i = 0;
+    while (i + 1 < row_count && rows[i + 1].time_s <= t)
+        i++;
+
+    const sim_env_row_t *a = &rows[i];
+    if (i + 1 >= row_count || t <= a->time_s)
+    {
+        *out = a->env;
+        return;
+    }
+    const sim_env_row_t *b = &rows[i + 1];
+    float f = (t - a->time_s) / (b->time_s - a->time_s);
+    out->temperature_c = a->env.temperature_c + f * (b->env.temperature_c - a->env.temperature_c);
+    out->humidity_pct = a->env.humidity_pct + f * (b->env.humidity_pct - a->env.humidity_pct);
+    out->light_adc = a->env.light_adc + f * (b->env.light_adc - a->env.light_adc);
+}
+
+static void default_day(float t, sim_env_t *out)
+{
+    float hour = fmodf(8.0f + t / day_s() * 24.0f, 24.0f);
+
+    // warmest at 15:00, coldest at 03:00
+    float warmth = cosf((hour - 15.0f) / 24.0f * 2 * SIM_PI);
+    out->temperature_c = 21.0f + 3.0f * warmth;
+    out->humidity_pct = 50.0f - 12.0f * warmth;
+
+    // daylight from 06:00 to 20:00, a lamp from 18:00 to 23:00
+    float daylight = (hour > 6.0f && hour < 20.0f) ? sinf((hour - 6.0f) / 14.0f * SIM_PI) : 0.0f;
+    float lamp = (hour > 18.0f && hour < 23.0f) ? 900.0f : 0.0f;
+    out->light_adc = 150.0f + 2800.0f * daylight + lamp;
+}
+
+void sim_env_at(uint64_t time_us, sim_env_t *out)
+{
+    float t = time_us / 1e6f;
+    if (row_count)
+        scripted(t, out);
+    else
+        default_day(t, out);
+
+    // mains flicker on whatever light there is
+    out->light_adc *= 1.0f + 0.03f * sinf(2 * SIM_PI * 100.0f * (float)(time_us % 1000000) / 1e6f);
+}
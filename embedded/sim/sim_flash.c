@@ -0,0 +1,143 @@
+/**
+ * Simulated QSPI flash
+ *
+ * The whole flash is a RAM image at XIP_BASE, erased at boot or loaded from SIM_FLASH_FILE,
+ * which then receives every program and erase. No firmware lives in it, so the linker
+ * symbol marking the end of the binary points at its start. SIM_FLASH_ERASE_MS stretches a
+ * sector erase, up to the 400 ms datasheet worst case.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "pico/flash.h"
+#include "pico/error.h"
+
+#include "sim_internal.h"
+
+#define FLASH_PAGE_PROGRAM_US 400
+#define FLASH_SECTOR_ERASE_US 45000
+
+uint8_t sim_flash_image[PICO_FLASH_SIZE_BYTES] __attribute__((aligned(FLASH_SECTOR_SIZE)));
+
+__asm__(".globl __flash_binary_end\n.set __flash_binary_end, sim_flash_image");
+
+static int image_fd = -1;
+static uint64_t sector_erase_us = FLASH_SECTOR_ERASE_US;
+
+static void write_through(uint32_t offs, size_t count)
+{
+    if (image_fd >= 0 && pwrite(image_fd, sim_flash_image + offs, count, offs) != (ssize_t)count)
+        panic("Could not write the flash image");
+}
+
+static void check_range(uint32_t offs, size_t count, uint32_t align)
+{
+    if (offs % align || count % align || offs + count > PICO_FLASH_SIZE_BYTES)
+        panic("Bad flash range %08x + %zu", offs, count);
+}
+
+/**
+ * Programming can only clear bits
+ */
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count)
+{
+    check_range(flash_offs, count, FLASH_PAGE_SIZE);
+    sim_wait_until(time_us_64() + count / FLASH_PAGE_SIZE * FLASH_PAGE_PROGRAM_US);
+    for (size_t i = 0; i < count; i++)
+        sim_flash_image[flash_offs + i] &= data[i];
+    write_through(flash_offs, count);
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count)
+{
+    check_range(flash_offs, count, FLASH_SECTOR_SIZE);
+    sim_wait_until(time_us_64() + count / FLASH_SECTOR_SIZE * sector_erase_us);
+    memset(sim_flash_image + flash_offs, 0xFF, count);
+    write_through(flash_offs, count);
+}
+
+static uint32_t default_irq_status;
+
+static bool default_core_init_deinit(bool init)
+{
+    return true;
+}
+
+static int default_enter_safe_zone(uint32_t timeout_ms)
+{
+    default_irq_status = save_and_disable_interrupts();
+    return PICO_OK;
+}
+
+static int default_exit_safe_zone(uint32_t timeout_ms)
+{
+    restore_interrupts(default_irq_status);
+    return PICO_OK;
+}
+
+static flash_safety_helper_t default_helper = {
+    .core_init_deinit = default_core_init_deinit,
+    .enter_safe_zone_timeout_ms = default_enter_safe_zone,
+    .exit_safe_zone_timeout_ms = default_exit_safe_zone,
+};
+
+/**
+ * Weak like the SDK's, so the firmware's helper replaces it
+ */
+__attribute__((weak)) flash_safety_helper_t *get_flash_safety_helper(void)
+{
+    return &default_helper;
+}
+
+bool flash_safe_execute_core_init(void)
+{
+    return get_flash_safety_helper()->core_init_deinit(true);
+}
+
+bool flash_safe_execute_core_deinit(void)
+{
+    return get_flash_safety_helper()->core_init_deinit(false);
+}
+
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms)
+{
+    flash_safety_helper_t *helper = get_flash_safety_helper();
+    int rc = helper->enter_safe_zone_timeout_ms(enter_exit_timeout_ms);
+    if (rc != PICO_OK)
+        return rc;
+    func(param);
+    return helper->exit_safe_zone_timeout_ms(enter_exit_timeout_ms);
+}
+
+static void __attribute__((constructor(102))) sim_flash_init(void)
+{
+    memset(sim_flash_image, 0xFF, sizeof(sim_flash_image));
+
+    const char *erase_ms = getenv("SIM_FLASH_ERASE_MS");
+    if (erase_ms && *erase_ms)
+        sector_erase_us = strtoull(erase_ms, NULL, 10) * 1000;
+
+    const char *path = getenv("SIM_FLASH_FILE");
+    if (!path || !*path)
+        return;
+
+    image_fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (image_fd < 0)
+        panic("Could not open %s", path);
+
+    ssize_t got = pread(image_fd, sim_flash_image, sizeof(sim_flash_image), 0);
+    if (got < (ssize_t)sizeof(sim_flash_image))
+    {
+        // new or short file: whatever is missing reads as erased
+        if (got < 0)
+            got = 0;
+        memset(sim_flash_image + got, 0xFF, sizeof(sim_flash_image) - got);
+        write_through(0, sizeof(sim_flash_image));
+    }
+}
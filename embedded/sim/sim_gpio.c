@@ -0,0 +1,48 @@
+/**
+ * Simulated GPIO interrupts
+ *
+ * The host SDK keeps pin state but has no interrupts. A press latches a falling edge on the
+ * pin and raises IO_IRQ_BANK0; the handler hands every latched edge to the callback.
+ */
+
+#include <stdatomic.h>
+
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+#include "sim_internal.h"
+
+static gpio_irq_callback_t callback;
+static atomic_uint_least32_t fall_latched;      // one bit per pin
+
+static void gpio_irq_handler(void)
+{
+    uint32_t pins = atomic_exchange(&fall_latched, 0);
+    while (pins)
+    {
+        uint gpio = __builtin_ctz(pins);
+        pins &= pins - 1;
+        if (callback)
+            callback(gpio, GPIO_IRQ_EDGE_FALL);
+    }
+}
+
+void gpio_set_irq_callback(gpio_irq_callback_t cb)
+{
+    callback = cb;
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t cb)
+{
+    gpio_set_irq_enabled(gpio, event_mask, enabled);
+    gpio_set_irq_callback(cb);
+    if (irq_get_exclusive_handler(IO_IRQ_BANK0) != gpio_irq_handler)
+        irq_set_exclusive_handler(IO_IRQ_BANK0, gpio_irq_handler);
+    irq_set_enabled(IO_IRQ_BANK0, enabled);
+}
+
+void sim_gpio_press(uint gpio)
+{
+    atomic_fetch_or(&fall_latched, 1u << gpio);
+    sim_irq_raise(IO_IRQ_BANK0);
+}
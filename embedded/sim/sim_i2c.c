@@ -0,0 +1,292 @@
+/**
+ * Simulated I2C controllers
+ *
+ * Device models hang off a per-bus address table. A transfer takes the time its bytes need
+ * on the bus, address byte included, and reaches the device when it would end. Calls into
+ * the models of one bus are serialized by the bus lock, which is taken before the core lock.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hardware/i2c.h"
+#include "hardware/timer.h"
+#include "pico/error.h"
+
+#include "sim_internal.h"
+
+#define SIM_I2C_TX_FIFO 16      // words the controller holds before the DMA has to wait
+#define SIM_I2C_MAX_DMA 512
+#define SIM_I2C_MAX_MUXES 8
+#define SIM_I2C_MAX_MUXED 16    // devices behind one mux
+
+// Status registers are read-only to the firmware only
+#define HW_REG(reg) (*(io_rw_32 *)&(reg))
+
+/**
+ * TCA9548A: one control register whose bits connect the downstream channels
+ */
+typedef struct {
+    sim_i2c_device_t dev;       // first, the I2C callbacks get this pointer
+    uint8_t addr;
+    uint8_t mask;
+    uint count;
+    struct {
+        uint8_t channel;
+        uint8_t addr;
+        sim_i2c_device_t *dev;
+    } devices[SIM_I2C_MAX_MUXED];
+} sim_i2c_mux_t;
+
+typedef struct {
+    i2c_hw_t hw;
+    uint baudrate;
+    sim_i2c_device_t *devices[128];
+    sim_i2c_mux_t *muxes[SIM_I2C_MAX_MUXES];
+    pthread_mutex_t lock;
+    // DMA transfer in flight
+    uint8_t dma_addr;
+    uint8_t dma_bytes[SIM_I2C_MAX_DMA];
+    uint dma_len;
+} sim_i2c_bus_t;
+
+static sim_i2c_bus_t buses[2] = {
+    {.baudrate = 100000, .lock = PTHREAD_MUTEX_INITIALIZER},
+    {.baudrate = 100000, .lock = PTHREAD_MUTEX_INITIALIZER},
+};
+
+i2c_inst_t i2c0_inst = {&buses[0].hw, false};
+i2c_inst_t i2c1_inst = {&buses[1].hw, false};
+
+static inline sim_i2c_bus_t *bus_of(i2c_inst_t *i2c)
+{
+    return &buses[i2c_get_index(i2c)];
+}
+
+/**
+ * One byte plus its ACK on the bus, in microseconds
+ */
+static inline uint64_t byte_us(const sim_i2c_bus_t *bus)
+{
+    return (9000000 + bus->baudrate - 1) / bus->baudrate;
+}
+
+void sim_i2c_attach(i2c_inst_t *i2c, uint8_t addr, sim_i2c_device_t *dev)
+{
+    sim_i2c_bus_t *bus = bus_of(i2c);
+    pthread_mutex_lock(&bus->lock);
+    bus->devices[addr & 0x7F] = dev;
+    pthread_mutex_unlock(&bus->lock);
+}
+
+static int mux_write(sim_i2c_device_t *dev, const uint8_t *src, size_t len, uint64_t time_us)
+{
+    sim_i2c_mux_t *mux = (sim_i2c_mux_t *)dev;
+    if (len)
+        mux->mask = src[len - 1];
+    return (int)len;
+}
+
+static int mux_read(sim_i2c_device_t *dev, uint8_t *dst, size_t len, uint64_t time_us)
+{
+    sim_i2c_mux_t *mux = (sim_i2c_mux_t *)dev;
+    memset(dst, mux->mask, len);
+    return (int)len;
+}
+
+/**
+ * Puts a device behind a channel of a TCA9548A at mux_addr, adding the mux on first use
+ */
+void sim_i2c_attach_muxed(i2c_inst_t *i2c, uint8_t mux_addr, uint8_t channel, uint8_t addr, sim_i2c_device_t *dev)
+{
+    sim_i2c_bus_t *bus = bus_of(i2c);
+    sim_i2c_mux_t *mux = NULL;
+
+    pthread_mutex_lock(&bus->lock);
+    for (uint i = 0; i < SIM_I2C_MAX_MUXES && !mux; i++)
+    {
+        if (!bus->muxes[i])
+        {
+            mux = bus->muxes[i] = calloc(1, sizeof(*mux));
+            mux->dev.write = mux_write;
+            mux->dev.read = mux_read;
+            mux->addr = mux_addr & 0x7F;
+            bus->devices[mux->addr] = &mux->dev;
+        }
+        else if (bus->muxes[i]->addr == (mux_addr & 0x7F))
+            mux = bus->muxes[i];
+    }
+    if (!mux || mux->count == SIM_I2C_MAX_MUXED)
+        panic("No room for a device behind the mux at %02x", mux_addr);
+    mux->devices[mux->count].channel = channel & 7;
+    mux->devices[mux->count].addr = addr & 0x7F;
+    mux->devices[mux->count].dev = dev;
+    mux->count++;
+    pthread_mutex_unlock(&bus->lock);
+}
+
+/**
+ * The device that answers addr, direct ones first, then those behind open mux channels
+ * Called with the bus lock held
+ */
+static sim_i2c_device_t *find_device(sim_i2c_bus_t *bus, uint8_t addr)
+{
+    addr &= 0x7F;
+    if (bus->devices[addr])
+        return bus->devices[addr];
+
+    for (uint i = 0; i < SIM_I2C_MAX_MUXES && bus->muxes[i]; i++)
+    {
+        sim_i2c_mux_t *mux = bus->muxes[i];
+        for (uint d = 0; d < mux->count; d++)
+        {
+            if (mux->devices[d].addr == addr && (mux->mask & (1u << mux->devices[d].channel)))
+                return mux->devices[d].dev;
+        }
+    }
+    return NULL;
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate)
+{
+    i2c->hw->enable = 1;
+    HW_REG(i2c->hw->status) = I2C_IC_STATUS_TFE_BITS;
+    i2c->restart_on_next = false;
+    return i2c_set_baudrate(i2c, baudrate);
+}
+
+void i2c_deinit(i2c_inst_t *i2c)
+{
+    i2c->hw->enable = 0;
+}
+
+uint i2c_set_baudrate(i2c_inst_t *i2c, uint baudrate)
+{
+    if (!baudrate)
+        baudrate = 100000;
+    bus_of(i2c)->baudrate = baudrate;
+    return baudrate;
+}
+
+/**
+ * Runs one blocking transfer, the calling core waits out the bus time
+ * A NACKed address costs one byte; a timeout shorter than the transfer gives up at the deadline
+ */
+static int transfer(i2c_inst_t *i2c, uint8_t addr, uint8_t *buf, size_t len, bool read, uint64_t timeout_us)
+{
+    sim_i2c_bus_t *bus = bus_of(i2c);
+    uint64_t start = time_us_64();
+
+    HW_REG(i2c->hw->raw_intr_stat) &= ~I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS;
+
+    pthread_mutex_lock(&bus->lock);
+    sim_i2c_device_t *dev = find_device(bus, addr);
+    pthread_mutex_unlock(&bus->lock);
+
+    uint64_t end = start + (dev ? len + 1 : 1) * byte_us(bus);
+    if (end - start > timeout_us)
+    {
+        sim_wait_until(start + timeout_us);
+        return PICO_ERROR_TIMEOUT;
+    }
+    sim_wait_until(end);
+
+    if (!dev)
+        return PICO_ERROR_GENERIC;
+
+    pthread_mutex_lock(&bus->lock);
+    int ret = read ? dev->read(dev, buf, len, end) : dev->write(dev, buf, len, end);
+    pthread_mutex_unlock(&bus->lock);
+    return ret < 0 ? PICO_ERROR_GENERIC : (int)len;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop)
+{
+    return transfer(i2c, addr, (uint8_t *)src, len, false, UINT64_MAX);
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop)
+{
+    return transfer(i2c, addr, dst, len, true, UINT64_MAX);
+}
+
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us)
+{
+    return transfer(i2c, addr, (uint8_t *)src, len, false, timeout_us);
+}
+
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint timeout_us)
+{
+    return transfer(i2c, addr, dst, len, true, timeout_us);
+}
+
+i2c_inst_t *sim_i2c_from_data_cmd(const volatile void *addr)
+{
+    for (uint i = 0; i < 2; i++)
+    {
+        if (addr == &buses[i].hw.data_cmd)
+            return i ? i2c1 : i2c0;
+    }
+    return NULL;
+}
+
+/**
+ * Bus side end of a DMA transfer: the device gets the bytes and the FIFO reads empty again
+ */
+static void dma_tx_done(void *ctx)
+{
+    sim_i2c_bus_t *bus = ctx;
+
+    pthread_mutex_lock(&bus->lock);
+    sim_i2c_device_t *dev = find_device(bus, bus->dma_addr);
+    int ret = !dev ? -1 : dev->write(dev, bus->dma_bytes, bus->dma_len, time_us_64());
+    pthread_mutex_unlock(&bus->lock);
+
+    if (ret < 0)
+        HW_REG(bus->hw.raw_intr_stat) |= I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS;
+    HW_REG(bus->hw.status) = I2C_IC_STATUS_TFE_BITS;
+}
+
+static void dma_tx_nack(void *ctx)
+{
+    sim_i2c_bus_t *bus = ctx;
+    HW_REG(bus->hw.raw_intr_stat) |= I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS;
+    HW_REG(bus->hw.status) = I2C_IC_STATUS_TFE_BITS;
+}
+
+/**
+ * Starts a DMA paced write of data_cmd words to the target in tar
+ * Returns when the DMA would have pushed its last word into the TX FIFO, or UINT64_MAX on
+ * a NACK, where the DMA stalls until aborted like on the RP2040
+ */
+uint64_t sim_i2c_dma_tx(i2c_inst_t *i2c, const uint16_t *words, uint count, uint64_t start_us)
+{
+    sim_i2c_bus_t *bus = bus_of(i2c);
+
+    if (count > SIM_I2C_MAX_DMA)
+        panic("I2C DMA transfer of %u words", count);
+
+    HW_REG(i2c->hw->raw_intr_stat) &= ~I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS;
+    HW_REG(i2c->hw->status) = I2C_IC_STATUS_ACTIVITY_BITS;
+
+    pthread_mutex_lock(&bus->lock);
+    bus->dma_addr = i2c->hw->tar & 0x7F;
+    for (uint i = 0; i < count; i++)
+        bus->dma_bytes[i] = words[i] & I2C_IC_DATA_CMD_DAT_BITS;
+    bus->dma_len = count;
+    bool present = find_device(bus, bus->dma_addr) != NULL;
+    pthread_mutex_unlock(&bus->lock);
+
+    if (!present)
+    {
+        sim_schedule_at(start_us + byte_us(bus), dma_tx_nack, bus);
+        return UINT64_MAX;
+    }
+
+    uint64_t end = start_us + (count + 1) * byte_us(bus);
+    sim_schedule_at(end, dma_tx_done, bus);
+
+    uint64_t fifo_us = SIM_I2C_TX_FIFO * byte_us(bus);
+    return end - start_us > fifo_us ? end - fifo_us : start_us;
+}
@@ -0,0 +1,36 @@
+#ifndef _SIM_INTERNAL_H
+#define _SIM_INTERNAL_H
+
+#include <time.h>
+
+#include "sim/sim.h"
+
+// Hooks between the simulated peripherals, not for firmware use
+
+// sim_core.c
+struct timespec sim_timespec(uint64_t time_us);
+
+// sim_i2c.c
+i2c_inst_t *sim_i2c_from_data_cmd(const volatile void *addr);
+uint64_t sim_i2c_dma_tx(i2c_inst_t *i2c, const uint16_t *words, uint count, uint64_t start_us);
+
+// sim_adc.c
+bool sim_adc_is_fifo(const volatile void *addr);
+uint64_t sim_adc_capture_us(uint count);
+void sim_adc_capture(void *dst, uint count, uint size, bool incr, uint64_t start_us);
+
+// sim_async_context.c
+typedef struct async_context async_context_t;
+async_context_t *sim_async_context(void);
+
+// sim_net.c
+typedef struct {
+    uint32_t requests;
+    uint32_t failures;
+    uint64_t bytes;
+} sim_net_stats_t;
+
+// false when the uplink never started or SIM_UPLINK is not set
+bool sim_net_get_stats(sim_net_stats_t *out);
+
+#endif
@@ -0,0 +1,249 @@
+/**
+ * Simulated HD44780 character LCD behind a PCF8574 I2C backpack
+ *
+ * Every expander write sets P0 RS, P1 RW, P2 EN, P3 backlight and P4-P7 on D4-D7; the
+ * controller latches the data lines on the falling edge of EN. It powers up in 8-bit mode,
+ * where each latch is a whole command with the low nibble read as 0, until a function set
+ * selects the 4-bit interface. DDRAM wraps like a two line part, so the glass shows what
+ * a real module would, including the result of a bad cursor address.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hardware/timer.h"
+
+#include "sim_internal.h"
+
+#define PCF_RS 0x01
+#define PCF_EN 0x04
+#define PCF_BL 0x08
+
+#define LCD_DDRAM_SIZE 0x80
+#define LCD_TRACE_DELAY_US 20000    // let a frame finish before printing it
+
+static const uint8_t row_offsets[] = {0x00, 0x40, 0x14, 0x54};
+
+struct sim_lcd {
+    sim_i2c_device_t dev;           // first, the I2C callbacks get this pointer
+    pthread_mutex_t lock;
+    uint8_t cols;
+    uint8_t rows;
+    uint8_t pins;                   // last expander output
+    bool four_bit;
+    bool have_high;                 // first nibble of a 4-bit transfer latched
+    uint8_t high;
+    bool display_on;
+    bool increment;
+    bool cgram;                     // address counter points into CGRAM
+    uint8_t addr;
+    uint8_t ddram[LCD_DDRAM_SIZE];
+    uint8_t cgram_data[64];
+    bool trace;
+    bool trace_pending;
+    sim_lcd_stats_t stats;
+};
+
+/**
+ * Moves the address counter one step, DDRAM jumps between the two line halves
+ */
+static void step_addr(sim_lcd_t *lcd)
+{
+    if (lcd->cgram)
+    {
+        lcd->addr = (lcd->addr + (lcd->increment ? 1 : -1)) & 0x3F;
+        return;
+    }
+    if (lcd->increment)
+        lcd->addr = lcd->addr == 0x27 ? 0x40 : lcd->addr == 0x67 ? 0x00 : lcd->addr + 1;
+    else
+        lcd->addr = lcd->addr == 0x40 ? 0x27 : lcd->addr == 0x00 ? 0x67 : lcd->addr - 1;
+}
+
+static void command(sim_lcd_t *lcd, uint8_t cmd)
+{
+    lcd->stats.commands++;
+
+    if (cmd & 0x80)
+    {
+        lcd->cgram = false;
+        lcd->addr = cmd & 0x7F;
+    }
+    else if (cmd & 0x40)
+    {
+        lcd->cgram = true;
+        lcd->addr = cmd & 0x3F;
+    }
+    else if (cmd & 0x20)
+    {
+        // function set, only the interface width matters here
+        lcd->four_bit = !(cmd & 0x10);
+    }
+    else if (cmd & 0x10)
+    {
+        // cursor / display shift is not modelled, the firmware never shifts
+    }
+    else if (cmd & 0x08)
+        lcd->display_on = cmd & 0x04;
+    else if (cmd & 0x04)
+        lcd->increment = cmd & 0x02;
+    else if (cmd & 0x02)
+    {
+        lcd->cgram = false;
+        lcd->addr = 0;
+    }
+    else if (cmd & 0x01)
+    {
+        memset(lcd->ddram, ' ', sizeof(lcd->ddram));
+        lcd->cgram = false;
+        lcd->addr = 0;
+        lcd->increment = true;
+    }
+}
+
+static void data(sim_lcd_t *lcd, uint8_t value)
+{
+    lcd->stats.chars++;
+    if (lcd->cgram)
+        lcd->cgram_data[lcd->addr] = value;
+    else
+        lcd->ddram[lcd->addr % LCD_DDRAM_SIZE] = value;
+    step_addr(lcd);
+}
+
+/**
+ * Falling edge of EN: latch D4-D7
+ */
+static void latch(sim_lcd_t *lcd, uint8_t pins)
+{
+    uint8_t nibble = pins & 0xF0;
+    bool rs = pins & PCF_RS;
+
+    if (!lcd->four_bit)
+    {
+        if (rs)
+            data(lcd, nibble);
+        else
+            command(lcd, nibble);
+        return;
+    }
+    if (!lcd->have_high)
+    {
+        lcd->high = nibble;
+        lcd->have_high = true;
+        return;
+    }
+    lcd->have_high = false;
+    uint8_t value = lcd->high | (nibble >> 4);
+    if (rs)
+        data(lcd, value);
+    else
+        command(lcd, value);
+}
+
+static void format_row(sim_lcd_t *lcd, uint8_t row, char *out)
+{
+    for (uint8_t c = 0; c < lcd->cols; c++)
+    {
+        uint8_t ch = lcd->ddram[(row_offsets[row] + c) % LCD_DDRAM_SIZE];
+        out[c] = ch < 8 ? '#' : (ch >= 0x20 && ch < 0x7F) ? (char)ch : '?';   // CGRAM glyphs print as '#'
+    }
+    out[lcd->cols] = '\0';
+}
+
+static void print_trace(void *ctx)
+{
+    sim_lcd_t *lcd = ctx;
+    char line[128];
+    char row[41];
+
+    pthread_mutex_lock(&lcd->lock);
+    lcd->trace_pending = false;
+    int n = snprintf(line, sizeof(line), "[%10.3f] ", time_us_64() / 1e6);
+    for (uint8_t r = 0; r < lcd->rows; r++)
+    {
+        format_row(lcd, r, row);
+        n += snprintf(line + n, sizeof(line) - n, "|%s", row);
+    }
+    snprintf(line + n, sizeof(line) - n, "|%s\n", lcd->display_on ? "" : " (off)");
+    pthread_mutex_unlock(&lcd->lock);
+
+    fputs(line, stderr);
+}
+
+static int lcd_write(sim_i2c_device_t *dev, const uint8_t *src, size_t len, uint64_t time_us)
+{
+    sim_lcd_t *lcd = (sim_lcd_t *)dev;
+
+    pthread_mutex_lock(&lcd->lock);
+    uint8_t before[LCD_DDRAM_SIZE];
+    memcpy(before, lcd->ddram, sizeof(before));
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if ((lcd->pins & PCF_EN) && !(src[i] & PCF_EN))
+            latch(lcd, lcd->pins);
+        lcd->pins = src[i];
+    }
+    lcd->stats.bytes += len;
+
+    if (lcd->trace && !lcd->trace_pending && memcmp(before, lcd->ddram, sizeof(before)))
+    {
+        lcd->trace_pending = true;
+        sim_schedule_at(time_us + LCD_TRACE_DELAY_US, print_trace, lcd);
+    }
+    pthread_mutex_unlock(&lcd->lock);
+    return (int)len;
+}
+
+static int lcd_read(sim_i2c_device_t *dev, uint8_t *dst, size_t len, uint64_t time_us)
+{
+    sim_lcd_t *lcd = (sim_lcd_t *)dev;
+    memset(dst, lcd->pins, len);
+    return (int)len;
+}
+
+sim_lcd_t *sim_lcd_create(uint8_t cols, uint8_t rows)
+{
+    sim_lcd_t *lcd = calloc(1, sizeof(*lcd));
+    lcd->dev.write = lcd_write;
+    lcd->dev.read = lcd_read;
+    pthread_mutex_init(&lcd->lock, NULL);
+    lcd->cols = cols > 40 ? 40 : cols;
+    lcd->rows = rows > 4 ? 4 : rows;
+    lcd->increment = true;
+    lcd->trace = true;
+    memset(lcd->ddram, ' ', sizeof(lcd->ddram));
+    return lcd;
+}
+
+sim_i2c_device_t *sim_lcd_device(sim_lcd_t *lcd)
+{
+    return &lcd->dev;
+}
+
+void sim_lcd_row(sim_lcd_t *lcd, uint8_t row, char *out)
+{
+    pthread_mutex_lock(&lcd->lock);
+    format_row(lcd, row < lcd->rows ? row : 0, out);
+    pthread_mutex_unlock(&lcd->lock);
+}
+
+bool sim_lcd_backlight(sim_lcd_t *lcd)
+{
+    return lcd->pins & PCF_BL;
+}
+
+void sim_lcd_get_stats(sim_lcd_t *lcd, sim_lcd_stats_t *out)
+{
+    pthread_mutex_lock(&lcd->lock);
+    *out = lcd->stats;
+    pthread_mutex_unlock(&lcd->lock);
+}
+
+void sim_lcd_set_trace(sim_lcd_t *lcd, bool on)
+{
+    lcd->trace = on;
+}
@@ -0,0 +1,165 @@
+/**
+ * The uplink's network side over host sockets
+ *
+ * SIM_UPLINK=host:port points the uplink at a backend or tools/uplink_sink; without it
+ * the link never comes up and samples just queue, like a board out of Wi-Fi range.
+ * Each request runs on a thread of its own with blocking sockets, and completes through a
+ * worker on the background async_context, the same context the CYW43 would use.
+ */
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "network/uplink_net.h"
+
+#include "sim_internal.h"
+
+static char host[128];
+static char port[16];
+static async_context_t *context;
+
+static const uint8_t *request;
+static uint32_t request_len;
+static Uplink_Net_Done done;
+static bool in_flight;
+static bool result;
+static sim_net_stats_t stats;
+
+static void done_work(async_context_t *ctx, async_when_pending_worker_t *worker)
+{
+    Uplink_Net_Done cb = done;
+    in_flight = false;
+    done = NULL;
+    if (cb)
+        cb(result);
+}
+
+static async_when_pending_worker_t done_worker = {.do_work = done_work};
+
+/**
+ * Connects, sends the request and reads the status line, true for a 2xx
+ */
+static bool post(uint32_t *sent_out)
+{
+    struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM};
+    struct addrinfo *addrs;
+    if (getaddrinfo(host, port, &hints, &addrs))
+        return false;
+
+    int fd = -1;
+    for (struct addrinfo *a = addrs; a && fd < 0; a = a->ai_next)
+    {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0)
+            continue;
+        struct timeval tv = {UPLINK_TIMEOUT_MS / 1000, (UPLINK_TIMEOUT_MS % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        if (connect(fd, a->ai_addr, a->ai_addrlen))
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addrs);
+    if (fd < 0)
+        return false;
+
+    bool ok = false;
+    uint32_t sent = 0;
+    while (sent < request_len)
+    {
+        ssize_t n = send(fd, request + sent, request_len - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            break;
+        sent += n;
+    }
+    if (sent == request_len)
+    {
+        char status[13] = {0};
+        size_t got = 0;
+        ssize_t n;
+        while (got < 12 && (n = recv(fd, status + got, 12 - got, 0)) > 0)
+            got += n;
+        ok = got == 12 && strncmp(status, "HTTP/1.", 7) == 0 && status[9] == '2';
+    }
+    close(fd);
+
+    *sent_out = sent;
+    return ok;
+}
+
+static void *request_thread(void *arg)
+{
+    uint32_t sent = 0;
+    bool ok = post(&sent);
+
+    async_context_acquire_lock_blocking(context);
+    result = ok;
+    stats.requests++;
+    stats.bytes += sent;
+    if (!ok)
+        stats.failures++;
+    async_context_release_lock(context);
+    async_context_set_work_pending(context, &done_worker);
+    return NULL;
+}
+
+async_context_t *Uplink_Net_Init(void)
+{
+    const char *target = getenv("SIM_UPLINK");
+    const char *colon = target ? strrchr(target, ':') : NULL;
+    if (colon && colon != target && (size_t)(colon - target) < sizeof(host))
+    {
+        memcpy(host, target, colon - target);
+        snprintf(port, sizeof(port), "%s", colon + 1);
+    }
+
+    context = sim_async_context();
+    async_context_add_when_pending_worker(context, &done_worker);
+    return context;
+}
+
+bool Uplink_Net_Ready(void)
+{
+    return host[0] != '\0';
+}
+
+bool Uplink_Net_Send(const uint8_t *req, uint32_t len, Uplink_Net_Done cb)
+{
+    if (in_flight || !host[0])
+        return false;
+
+    request = req;
+    request_len = len;
+    done = cb;
+    in_flight = true;
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, request_thread, NULL))
+    {
+        in_flight = false;
+        done = NULL;
+        return false;
+    }
+    pthread_detach(thread);
+    return true;
+}
+
+bool sim_net_get_stats(sim_net_stats_t *out)
+{
+    if (!context)
+        return false;
+    async_context_acquire_lock_blocking(context);
+    *out = stats;
+    async_context_release_lock(context);
+    return host[0] != '\0';
+}
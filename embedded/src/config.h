@@ -10,9 +10,48 @@
 #define DEBUG 0
 #define PHOTO_NOISE_THR 15
 
+// Benchmarks - print timing results over stdio during Init
+#define LCD_BENCHMARK 0
+#define DHT20_BENCHMARK 0
+#define PHOTO_BENCHMARK 0
+#define HISTORY_BENCHMARK 0
+#define HISTORY_BENCHMARK_SAMPLES 172800 // synthetic trace length when the flash log is empty, 2 days at 1 Hz
+
+// Core1 sampling period
+#define SAMPLE_PERIOD_MS 1000
+
+// Binary telemetry over USB CDC, see data_flow/telemetry.h and tools/telemetry_decode.cpp
+#define TELEMETRY 1
+#define TELEMETRY_RING_BYTES 2048         // per core, power of two
+#define TELEMETRY_COUNTER_PERIOD_MS 5000
+#define TELEMETRY_STRESS_HZ 0             // >0 adds a core1 task resending the last sample at this rate to load test the link
+
+// Rolling 1 min / 1 h / 24 h statistics of sensor 0 on core1, see core1/rolling_stats.h
+#define STATS_EMA_SHIFT 4                 // EMA weight 1/16 per sample, about 16 s at 1 Hz
+#define STATS_TELEMETRY_PERIOD_MS 10000  // stats records for every channel and window, 0 for none
+
+// Wi-Fi uplink to the backend, see network/uplink.h
+// WIFI_SSID and WIFI_PASSWORD come from cmake (-DWIFI_SSID=... -DWIFI_PASSWORD=...), no SSID leaves the radio off
+#define UPLINK 1
+#ifndef UPLINK_HOST
+#define UPLINK_HOST "192.168.1.10"        // backend address, an IP literal
+#endif
+#ifndef UPLINK_PORT
+#define UPLINK_PORT 3001
+#endif
+#define UPLINK_DEVICE "humidity-sensor"   // ?device= on every request
+#define UPLINK_BATCH_SAMPLES 30           // samples per POST, a full batch goes out at once
+#define UPLINK_FLUSH_MS 30000             // a partial batch goes out after this long, and a failed one is retried
+#define UPLINK_QUEUE_SAMPLES 128          // samples held while the link is down, beyond that new ones are dropped
+#define UPLINK_TIMEOUT_MS 10000           // connect to response
+#define UPLINK_WIRE 1                     // 1 - compact binary batches (data_flow/wire.h), 0 - NDJSON, easier to read on the wire
+
 // System Interrupt Speed
 #define SYS_TIMER 20 // ms
 
+// Retry interval for an LCD frame parked behind a flush, about the time the TX FIFO takes to drain
+#define RENDER_RETRY_US 2000
+
 // ADC Conversion
 #define ADC_MAX 3200
 #define ADC_MIN 100
@@ -65,6 +104,15 @@ static const uint32_t Led_Pins[LED_LENGTH] = {
 #define SENSOR_I2C_SCL  5
 #define SENSOR_I2C_CHANNEL SENSOR_I2C_PORT
 
+// DHT20 sensors, one {I2C port, TCA9548A address or DHT20_NO_MUX, mux channel} per entry
+// All of them are triggered together and read after one conversion window. Sensor 0 drives
+// the display, the history and the flash log; every sensor is sent over telemetry.
+// e.g. two sensors behind a mux at 0x70: {SENSOR_I2C_PORT, 0x70, 0}, {SENSOR_I2C_PORT, 0x70, 1},
+// A sensor wired straight to a bus cannot share it with muxed ones, they all answer at 0x38
+// Sensors cannot go on the LCD bus either, dht20_init() rejects LCD_I2C_PORT
+#define DHT20_SENSORS \
+    {SENSOR_I2C_PORT, DHT20_NO_MUX, 0},
+
 
 // ===== ADC =====
 #define PHOTORESISTOR_ADC 26
@@ -74,6 +122,30 @@ static const uint32_t Led_Pins[LED_LENGTH] = {
 
 #define PHOTORES_GPIO_PIN 26
 
+// Photoresistor oversampling - one capture is PHOTO_OVERSAMPLE samples at PHOTO_SAMPLE_RATE_HZ,
+// 64 samples at 3200 Hz span 20 ms so mains flicker averages out
+#define PHOTO_OVERSAMPLE 64      // <= 256
+#define PHOTO_SAMPLE_RATE_HZ 3200
+#define PHOTO_FILTER_MEDIAN 0    // 1 - median of the capture, 0 - mean
+
+// Flash sample log - a ring of compressed 4 KB sectors at the end of flash, written by core1
+// 256 sectors is 1 MB, about 10 weeks at one sample per second with the steps below
+// Values are kept in steps of FLASH_LOG_CENTI_STEP centi-units and FLASH_LOG_ADC_STEP counts
+#define FLASH_LOG_SECTORS 256
+#define FLASH_LOG_INTERVAL 1     // log every Nth sample
+#define FLASH_LOG_CENTI_STEP 10  // 0.1 %RH / 0.1 C
+#define FLASH_LOG_ADC_STEP 4
+
+// Compressed RAM history on core1 - HISTORY_BLOCKS blocks of HISTORY_BLOCK_BYTES, under 64 KB
+// About 1.2 days at one sample per second over two days of the sim's default day, see
+// tools/history_bench.cpp; the sped up sim adds trigger jitter, which costs time bits
+// Values are kept within one step of HISTORY_CENTI_STEP centi-units and HISTORY_ADC_STEP counts
+#define HISTORY_BLOCKS 32
+#define HISTORY_BLOCK_BYTES 2000
+#define HISTORY_TIME_RES_MS 100
+#define HISTORY_CENTI_STEP 10    // 0.1 %RH / 0.1 C, finer than the DHT20 accuracy
+#define HISTORY_ADC_STEP 4
+
 // Scaling Factors
 #define HUMIDITY_MAX 100
 
@@ -1,105 +1,176 @@
 #include "core1.h"
+#include "scheduler.h"
+#include "rolling_stats.h"
+#include "../storage/history.h"
+#include "../storage/flash_log.h"
+#include "../data_flow/latency.h"
+#include "../data_flow/telemetry.h"
 
-#define CORE1_TIMER 1000
+#define SAMPLE_PERIOD_US (SAMPLE_PERIOD_MS * 1000)
 
-#define PHOTORES_GPIO_PIN 26 // this needs to be put into config.h
-
-// File Scope Datatypes
-typedef struct {
-    volatile uint32_t disabled_count;
-    uint32_t reset_value;
-    void (*flag_handler)(void); // call back when flag triggers
-} System_Flag;
-
-// System Flag Handling
-#define NUM_SYSTEM_FLAGS 1
-#define SYSTEM_RELOAD 1 // 1000 ms
+// the flash log erases between two samples, half a period after the first
+static_assert(SAMPLE_PERIOD_MS / 2 >= FLASH_LOG_ERASE_MAX_MS, "a sector erase must fit between samples");
 
 // Prototypes
-void Produce_Data(void);
+void Produce_Data(void *user_data);
+void Publish_Data(dht20_t *dht, int status, const DHT20_Reading *dht20_reading, void *user_data);
+void Flash_Log_Task(void *user_data);
 
 // Globals
-Payload_Data Sensor_Data; // for exchanging data to Core0
+Payload_Data Data_Buffer[DATA_BUFFER_SIZE];  // backing storage for the Core1 -> Core0 ring
+Ring_Buffer Data_Ring_Buffer = RING_BUFFER_INIT(Data_Buffer, DATA_BUFFER_SIZE);
+
+Task_Id Sample_Task; // periodic DHT20 + photoresistor sampling
+
+// DHT20 wiring from config.h, one handle per entry
+static const struct {
+    i2c_inst_t *i2c;
+    uint8_t mux_addr;
+    uint8_t mux_channel;
+} Sensor_Wiring[] = { DHT20_SENSORS };
 
-// Core_1 System Flag Array
-System_Flag Core_1_Flags[NUM_SYSTEM_FLAGS] = {
- {0, SYSTEM_RELOAD, Produce_Data}, // Sample Data Flag
-};
+#define NUM_SENSORS count_of(Sensor_Wiring)
+
+static dht20_t Sensors[NUM_SENSORS];
+static Photo_Reading Last_Photo; // taken with sensor 0, shared by the others of the same round
+
+#if TELEMETRY_STRESS_HZ
+static Payload_Data Stress_Sample; // last published sample, resent by Stress_Telemetry()
+#endif
 
 /**
- * Samples data, packs it into the global payload struct
- * Sends data to core0, blocks until data acknowledgement is received
+ * Initializes every DHT20 in DHT20_SENSORS, their buses must already be set up
+ * Returns the number of sensors that did not answer
  */
-void Produce_Data(void){
-    // Write to Global
-    Payload_Data *data= &Sensor_Data;
-
-    // Take Measurement from DHT20 sensor (temperature & humidity)  
-    DHT20_Reading dht20_reading;        
-    int dht20_valid = !take_measurement(&dht20_reading);      // invert validity boolean because take_measurement returns 0 for success, 1 for error
-    data->DHT20_Data = dht20_reading;   
-    data->DHT20_Data_Valid = dht20_valid;
+int Sensors_Init(void){
+    int failed = 0;
+    for (uint i = 0; i < NUM_SENSORS; i++)
+        failed += dht20_init(&Sensors[i], Sensor_Wiring[i].i2c, Sensor_Wiring[i].mux_addr, Sensor_Wiring[i].mux_channel);
+    return failed;
+}
+
+/**
+ * DHT20 completion callback, packs the reading and a photoresistor sample into a payload
+ * Sensor 0 goes to the history and on the ring for core0, every sensor goes to telemetry
+ * Never waits on core0, a full ring drops the new sample and is counted in Data_Ring_Buffer.dropped
+ */
+void Publish_Data(dht20_t *dht, int status, const DHT20_Reading *dht20_reading, void *user_data){
+    Payload_Data sample;
+    Payload_Data *data = &sample;
+    uint sensor = dht - Sensors;
+
+    // Stage stamps, the trigger and data ready times come from the driver
+    uint64_t trigger_us, ready_us;
+    dht20_last_stamps(dht, &trigger_us, &ready_us);
+    data->time_stamp = trigger_us;
+    data->stage_us[STAGE_TRIGGER] = (uint32_t)trigger_us;
+    data->stage_us[STAGE_DATA_READY] = (uint32_t)ready_us;
+
+    // Temperature & humidity from the finished DHT20 conversion
+    data->DHT20_Data = *dht20_reading;
+    data->DHT20_Data_Valid = !status;      // invert validity boolean because the driver reports 0 for success, 1 for error
+    data->DHT20_Sensor = sensor;
   
-    // Take Measurement from photoresistor
-    data->ADC_Data = Get_Photo_Resistor_Data(PHOTORES_GPIO_PIN);
+    // Filtered photoresistor value from the last DMA capture, one capture per round
+    if (sensor == 0)
+        Photoresistor_Collect(&Last_Photo);
+    data->ADC_Data = Last_Photo.value;
+    data->ADC_Variance = Last_Photo.variance;
   
     // Logic Checking Here
 
-    // If Data is Valid
-    multicore_fifo_push_blocking((uint32_t) data);
-    bool response = multicore_fifo_pop_blocking(); // block until the packet is read, not used for anything yet
+    if (sensor == 0){
+        // Compressed local history, kept even if core0 falls behind
+        History_Append(data->time_stamp, data);
+
+        // Staged in RAM, Flash_Log_Task() writes it out between samples
+        Flash_Log_Append(data);
+
+        // Rolling windows, core0 and telemetry read the published summary
+        Rolling_Stats_Add(data);
+
+        // Queue for Core0, then ring the doorbell if the FIFO has room
+        // Core0 drains the whole ring on every wake, so a skipped doorbell loses nothing
+        Latency_Stamp(data, STAGE_ENQUEUE);
+        if (Ring_Buffer_Push(&Data_Ring_Buffer, data) && multicore_fifo_wready())
+            multicore_fifo_push_blocking(DATA_DOORBELL);
+    }
+
+    #if TELEMETRY
+        Telemetry_Sample(data);
+    #endif
+    #if TELEMETRY_STRESS_HZ
+        if (sensor == 0)
+            Stress_Sample = *data;
+    #endif
 }
 
+#if TELEMETRY_STRESS_HZ
 /**
- * Iterates through Core_1_Flag structs on timer execution; decrements value until 0
+ * Resends the last sample with a fresh time stamp, and wakes core0 to drain telemetry
+ * Only used to check the USB link sustains TELEMETRY_STRESS_HZ
  */
-bool Core_1_Timer_Callback(struct repeating_timer *t){
-    // protect critical section
-    uint32_t status = save_and_disable_interrupts();
-    
-    // Decrement Flag
-    for(System_Flag *flg = Core_1_Flags; flg < Core_1_Flags + NUM_SYSTEM_FLAGS ; flg++){
-        if(flg->disabled_count){
-            flg->disabled_count--;
-        }
-    }
-    restore_interrupts(status); // advance head to show it has new data
-    return true;
+void Stress_Telemetry(void *user_data){
+    Stress_Sample.time_stamp = time_us_64();
+    Telemetry_Sample(&Stress_Sample);
+    if (multicore_fifo_wready())
+        multicore_fifo_push_blocking(DATA_DOORBELL);
 }
+#endif
 
+#if TELEMETRY && STATS_TELEMETRY_PERIOD_MS
 /**
- * Iterates through Core_1_Flags and runs processes if valid
- * If System flag is 0, function pointer in System_Flag Array is executed
+ * Sends the latest rolling stats summary over telemetry
  */
-void System_Flag_Logic(void){  
-    for(System_Flag *flg = Core_1_Flags; flg < Core_1_Flags + NUM_SYSTEM_FLAGS; flg++){
-        // protected section
-        uint32_t status = save_and_disable_interrupts();
-        uint32_t flag_timer_local = flg->disabled_count; // save  locally
-        restore_interrupts(status);
-
-        // Flag Logic
-        if (flag_timer_local == 0){
-            flg->flag_handler();
-            // Protected section
-            uint32_t status = save_and_disable_interrupts();
-            flg->disabled_count = flg->reset_value;
-            restore_interrupts(status);
-        }
-    }
+void Stats_Telemetry(void *user_data){
+    Stats_Summary summary;
+    if (Rolling_Stats_Get(&summary))
+        Telemetry_Stats(&summary);
+}
+#endif
+
+/**
+ * Programs and erases the flash log half a sample period after each sample, so the stall
+ * falls between DHT20 conversions instead of on one
+ */
+void Flash_Log_Task(void *user_data){
+    Flash_Log_Service();
+}
+
+/**
+ * Triggers every DHT20 back to back, Publish_Data() runs as each one completes
+ * The conversions overlap, so a round costs one conversion time whatever the sensor count
+ * Core1 keeps servicing its other tasks while the sensors convert
+ */
+void Produce_Data(void *user_data){
+    for (uint i = 0; i < NUM_SENSORS; i++)
+        dht20_start_measurement(&Sensors[i], Publish_Data, NULL);
 }
 
 /**
  * Core1 process called from Core0
+ * Runs due tasks, advances the DHT20 state machine, then sleeps until the next deadline
+ * or until an alarm wakes the core
  */
 void Core_1_Entry(void){
 
-    // Core 1 Timer
-    struct repeating_timer timer;
-    add_repeating_timer_ms(CORE1_TIMER, Core_1_Timer_Callback, NULL, & timer);
+    History_Init();
+    Rolling_Stats_Init();
+    Scheduler_Init();
+    Sample_Task = Scheduler_Add_Periodic(Produce_Data, NULL, SAMPLE_PERIOD_US, 0);
+    Scheduler_Add_Periodic(Flash_Log_Task, NULL, SAMPLE_PERIOD_US, SAMPLE_PERIOD_US / 2);
+    #if TELEMETRY && STATS_TELEMETRY_PERIOD_MS
+        Scheduler_Add_Periodic(Stats_Telemetry, NULL, STATS_TELEMETRY_PERIOD_MS * 1000, STATS_TELEMETRY_PERIOD_MS * 1000);
+    #endif
+    #if TELEMETRY_STRESS_HZ
+        Scheduler_Add_Periodic(Stress_Telemetry, NULL, 1000000 / TELEMETRY_STRESS_HZ, 0);
+    #endif
 
     while (true){
-        // handle the flag here
-        System_Flag_Logic();
+        Scheduler_Run_Due();
+        // advance any in-flight DHT20 conversions
+        for (uint i = 0; i < NUM_SENSORS; i++)
+            dht20_service(&Sensors[i]);
+        Scheduler_Sleep();
     }
 }
\ No newline at end of file
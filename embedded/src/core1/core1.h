@@ -12,23 +12,22 @@
 
 
 // User Modules
+#include "../config.h"
 #include "../data_flow/data_flow.h"
+#include "../data_flow/ring_buffer.h"
 #include "../hardware/photores.h"
 #include "../hardware/dht20_sensor.h"
 
-// Global data types
-typedef struct {
-    volatile uint16_t head;
-    volatile uint16_t tail;
-    Payload_Data *buffer;
-} Ring_Buffer;
-
 // Main Process
 void Core_1_Entry(void);
+int Sensors_Init(void);
 
 // Defines
 #define DATA_BUFFER_SIZE 100
 
+// Doorbell word pushed through the multicore FIFO to wake Core0, the data itself goes through the ring
+#define DATA_DOORBELL 0xD0
+
 // Shared Variables
 extern Payload_Data Data_Buffer[DATA_BUFFER_SIZE];
 extern Ring_Buffer Data_Ring_Buffer;
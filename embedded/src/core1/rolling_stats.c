@@ -0,0 +1,286 @@
+#include "rolling_stats.h"
+
+// Standard Library
+#include <string.h>
+
+// Pico SDK
+#include "hardware/sync.h"
+
+#define STATS_MAX_BUCKETS 60
+
+// File Scope Datatypes
+typedef struct {
+    uint64_t sum_squares;
+    int32_t sum;
+    uint32_t id;          // start time / bucket length
+    uint16_t count;
+    int16_t min;
+    int16_t max;
+} Stats_Bucket;
+
+// Monotonic deque of bucket extremes, oldest at head
+typedef struct {
+    struct {
+        uint32_t id;
+        int16_t value;
+    } entry[STATS_MAX_BUCKETS];
+    uint8_t head;
+    uint8_t len;
+} Stats_Deque;
+
+typedef struct {
+    Stats_Bucket open;                      // bucket filling now
+    Stats_Bucket closed[STATS_MAX_BUCKETS]; // ring, oldest at head
+    uint8_t head;
+    uint8_t len;
+    Stats_Deque min_q;                      // increasing values
+    Stats_Deque max_q;                      // decreasing values
+    uint32_t count;                         // totals over the closed buckets
+    int64_t sum;
+    uint64_t sum_squares;
+} Stats_Ring;
+
+typedef struct {
+    bool seeded;
+    int32_t ema_x256;
+    Stats_Ring ring[NUM_STATS_WINDOWS];
+} Stats_Channel_State;
+
+static const struct {
+    uint32_t bucket_ms;
+    uint8_t buckets;
+} Window_Shape[NUM_STATS_WINDOWS] = {
+    [STATS_WINDOW_1M]  = {1000, 60},
+    [STATS_WINDOW_1H]  = {60 * 1000, 60},
+    [STATS_WINDOW_24H] = {30 * 60 * 1000, 48},
+};
+
+static_assert(30 * 60 * 1000 / SAMPLE_PERIOD_MS <= UINT16_MAX, "bucket sample count must fit 16 bits");
+
+// Globals
+static Stats_Channel_State Channels[NUM_STATS_CHANNELS];
+static Stats_Summary Working;                // built on core1
+static Stats_Summary Published;              // copy read by Rolling_Stats_Get()
+static volatile uint32_t Published_Sequence; // odd while Published is being written
+
+/**
+ * Appends to the back of a deque after dropping the entries the new value makes irrelevant
+ * keep_min selects the min deque, otherwise the max deque
+ */
+static void Deque_Push(Stats_Deque *q, int16_t value, uint32_t id, bool keep_min){
+    while (q->len){
+        int16_t back = q->entry[(q->head + q->len - 1) % STATS_MAX_BUCKETS].value;
+        if (keep_min ? back < value : back > value)
+            break;
+        q->len--;
+    }
+    uint8_t at = (q->head + q->len) % STATS_MAX_BUCKETS;
+    q->entry[at].id = id;
+    q->entry[at].value = value;
+    q->len++;
+}
+
+/**
+ * Drops entries from the front that belong to buckets up to and including id
+ */
+static void Deque_Expire(Stats_Deque *q, uint32_t id){
+    while (q->len && (int32_t)(q->entry[q->head].id - id) <= 0){
+        q->head = (q->head + 1) % STATS_MAX_BUCKETS;
+        q->len--;
+    }
+}
+
+/**
+ * Moves the open bucket into the closed ring and the running totals
+ */
+static void Close_Bucket(Stats_Ring *r){
+    const Stats_Bucket *b = &r->open;
+    if (!b->count)
+        return;
+
+    r->closed[(r->head + r->len) % STATS_MAX_BUCKETS] = *b;
+    r->len++;
+    r->count += b->count;
+    r->sum += b->sum;
+    r->sum_squares += b->sum_squares;
+    Deque_Push(&r->min_q, b->min, b->id, true);
+    Deque_Push(&r->max_q, b->max, b->id, false);
+}
+
+/**
+ * Subtracts the closed buckets that fall out of a window starting at bucket id open_id
+ */
+static void Evict(Stats_Ring *r, uint32_t open_id, uint8_t buckets){
+    while (r->len && open_id - r->closed[r->head].id >= buckets){
+        const Stats_Bucket *b = &r->closed[r->head];
+        r->count -= b->count;
+        r->sum -= b->sum;
+        r->sum_squares -= b->sum_squares;
+        Deque_Expire(&r->min_q, b->id);
+        Deque_Expire(&r->max_q, b->id);
+        r->head = (r->head + 1) % STATS_MAX_BUCKETS;
+        r->len--;
+    }
+}
+
+/**
+ * Adds one value to a window, closing and evicting buckets as time moves on
+ */
+static void Ring_Add(Stats_Ring *r, uint32_t id, uint8_t buckets, int16_t value){
+    Stats_Bucket *b = &r->open;
+    if (b->count && b->id != id){
+        Close_Bucket(r);
+        b->count = 0;
+    }
+    if (!b->count){
+        b->id = id;
+        b->sum = 0;
+        b->sum_squares = 0;
+        b->min = value;
+        b->max = value;
+        Evict(r, id, buckets);
+    }
+
+    b->count++;
+    b->sum += value;
+    b->sum_squares += (uint64_t)((int32_t)value * value);
+    if (value < b->min)
+        b->min = value;
+    if (value > b->max)
+        b->max = value;
+}
+
+/**
+ * Divides and rounds half away from zero, d > 0
+ */
+static inline int64_t Div_Round(int64_t n, int64_t d){
+    return (n >= 0) ? (n + d / 2) / d : -((-n + d / 2) / d);
+}
+
+static uint32_t Isqrt(uint64_t v){
+    uint64_t root = 0;
+    uint64_t bit = 1ull << 62;
+    while (bit > v)
+        bit >>= 2;
+    while (bit){
+        if (v >= root + bit){
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+            root >>= 1;
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+/**
+ * Fills out from the running totals, the deque fronts and the open bucket
+ */
+static void Ring_Summary(const Stats_Ring *r, uint32_t bucket_ms, Stats_Window *out){
+    const Stats_Bucket *open = &r->open;
+    int64_t count = r->count + open->count;
+    out->count = (uint32_t)count;
+    if (!count)
+        return;
+
+    int64_t sum = r->sum + open->sum;
+    uint64_t sum_squares = r->sum_squares + open->sum_squares;
+
+    int16_t min = open->count ? open->min : INT16_MAX;
+    int16_t max = open->count ? open->max : INT16_MIN;
+    if (r->min_q.len && r->min_q.entry[r->min_q.head].value < min)
+        min = r->min_q.entry[r->min_q.head].value;
+    if (r->max_q.len && r->max_q.entry[r->max_q.head].value > max)
+        max = r->max_q.entry[r->max_q.head].value;
+    out->min = min;
+    out->max = max;
+    out->mean = (int16_t)Div_Round(sum, count);
+
+    // squared deviations around the truncated mean m, then the fraction sum - count * m is
+    // taken back out, so nothing larger than the deviations is ever squared
+    int64_t m = sum / count;
+    int64_t rest = sum - count * m;
+    int64_t deviations = (int64_t)sum_squares - 2 * m * sum + count * m * m - rest * rest / count;
+    out->stddev = deviations > 0 ? (uint16_t)Isqrt((uint64_t)Div_Round(deviations, count)) : 0;
+
+    // slope between the oldest and the newest bucket means
+    const Stats_Bucket *oldest = r->len ? &r->closed[r->head] : open;
+    const Stats_Bucket *newest = open->count ? open : &r->closed[(r->head + r->len - 1) % STATS_MAX_BUCKETS];
+    out->rate_per_h = 0;
+    if (newest != oldest){
+        int64_t change = (int64_t)newest->sum * oldest->count - (int64_t)oldest->sum * newest->count;
+        int64_t span = (int64_t)newest->count * oldest->count * (newest->id - oldest->id) * bucket_ms;
+        int64_t rate = Div_Round(change * 3600000, span);
+        out->rate_per_h = rate > INT32_MAX ? INT32_MAX : rate < INT32_MIN ? INT32_MIN : (int32_t)rate;
+    }
+}
+
+/**
+ * Updates one channel with a new value at time_ms and refreshes its part of the summary
+ */
+static void Channel_Add(Stats_Channel channel, uint32_t time_ms, int16_t value){
+    Stats_Channel_State *c = &Channels[channel];
+
+    if (!c->seeded){
+        c->ema_x256 = value * 256;
+        c->seeded = true;
+    }
+    else
+        c->ema_x256 += (value * 256 - c->ema_x256) >> STATS_EMA_SHIFT;
+    Working.latest[channel] = value;
+    Working.ema[channel] = (int16_t)(c->ema_x256 / 256);
+
+    for (int w = 0; w < NUM_STATS_WINDOWS; w++){
+        uint32_t bucket_ms = Window_Shape[w].bucket_ms;
+        Ring_Add(&c->ring[w], time_ms / bucket_ms, Window_Shape[w].buckets, value);
+        Ring_Summary(&c->ring[w], bucket_ms, &Working.window[channel][w]);
+    }
+}
+
+/**
+ * Clears every window, call once on Core1 before the first sample
+ */
+void Rolling_Stats_Init(void){
+    memset(Channels, 0, sizeof(Channels));
+    memset(&Working, 0, sizeof(Working));
+    Published_Sequence = 0;
+}
+
+/**
+ * Adds a sample to every channel and publishes the new summary, Core1 only
+ * Humidity and temperature skip samples whose DHT20 reading failed, light always counts
+ */
+void Rolling_Stats_Add(const Payload_Data *sample){
+    uint32_t time_ms = (uint32_t)(sample->time_stamp / 1000);
+
+    if (sample->DHT20_Data_Valid){
+        Channel_Add(STATS_HUMIDITY, time_ms, (int16_t)sample->DHT20_Data.humidity_centi);
+        Channel_Add(STATS_TEMPERATURE, time_ms, sample->DHT20_Data.temperature_centi_c);
+    }
+    Channel_Add(STATS_LIGHT, time_ms, (int16_t)sample->ADC_Data);
+    Working.time_ms = time_ms;
+
+    // sequence lock, readers retry if they saw an odd or changed sequence
+    Published_Sequence++;
+    __mem_fence_release();
+    Published = Working;
+    __mem_fence_release();
+    Published_Sequence++;
+}
+
+/**
+ * Copies the latest summary, from either core
+ * Returns false before the first sample
+ */
+bool Rolling_Stats_Get(Stats_Summary *out){
+    uint32_t sequence;
+    do {
+        sequence = Published_Sequence;
+        __mem_fence_acquire();
+        *out = Published;
+        __mem_fence_acquire();
+    } while ((sequence & 1) || sequence != Published_Sequence);
+
+    return sequence != 0;
+}
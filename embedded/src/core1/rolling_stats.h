@@ -0,0 +1,61 @@
+#ifndef __ROLLING_STATS_H__
+#define __ROLLING_STATS_H__
+
+// Standard Library
+#include <stdint.h>
+#include <stdbool.h>
+
+// User Modules
+#include "../config.h"
+#include "../data_flow/data_flow.h"
+
+/**
+ * Rolling statistics over the samples of sensor 0, updated on Core1 in O(1) per sample
+ *
+ * Each window is a ring of time buckets: 60 x 1 s, 60 x 1 min and 48 x 30 min. A bucket
+ * keeps count, sum, sum of squares, min and max; the window keeps running totals over its
+ * buckets and a monotonic deque each for min and max, so a bucket leaving the window is
+ * subtracted and popped, never rescanned. The window is the bucket filling now plus the
+ * ones before it, so the 1 h window covers 59 to 60 minutes.
+ *
+ * The values are integers, so the sums are exact and samples leave the window without the
+ * drift a floating point Welford removal would build up.
+ * Core0 and the telemetry read a copy with Rolling_Stats_Get(), nothing is recomputed there:
+ * core0's Refresh_Data() takes one with every sample for the 24 h range screen.
+ */
+
+typedef enum {
+    STATS_HUMIDITY,       // centi-%RH
+    STATS_TEMPERATURE,    // centi-degrees Celsius
+    STATS_LIGHT,          // filtered ADC counts
+    NUM_STATS_CHANNELS
+} Stats_Channel;
+
+typedef enum {
+    STATS_WINDOW_1M,
+    STATS_WINDOW_1H,
+    STATS_WINDOW_24H,
+    NUM_STATS_WINDOWS
+} Stats_Window_Id;
+
+typedef struct {
+    uint32_t count;          // samples in the window, 0 leaves the rest undefined
+    int16_t min;
+    int16_t max;
+    int16_t mean;            // rounded to nearest
+    uint16_t stddev;         // population standard deviation
+    int32_t rate_per_h;      // newest bucket mean minus oldest, per hour
+} Stats_Window;
+
+typedef struct {
+    uint32_t time_ms;                        // sample the summary includes, 0 before the first one
+    int16_t latest[NUM_STATS_CHANNELS];
+    int16_t ema[NUM_STATS_CHANNELS];         // weight 2^-STATS_EMA_SHIFT per sample
+    Stats_Window window[NUM_STATS_CHANNELS][NUM_STATS_WINDOWS];
+} Stats_Summary;
+
+void Rolling_Stats_Init(void);
+void Rolling_Stats_Add(const Payload_Data *sample);
+bool Rolling_Stats_Get(Stats_Summary *out);
+
+#endif
@@ -0,0 +1,139 @@
+#include "scheduler.h"
+
+// Pico SDK
+#include "pico/time.h"
+#include "hardware/sync.h"
+
+// File Scope Datatypes
+typedef struct {
+    Task_Handler handler;
+    void *user_data;
+    uint32_t period_us;   // 0 for one shot tasks
+    uint64_t deadline_us; // absolute, microseconds since boot
+    Task_Stats stats;
+} Task;
+
+// Globals
+PHEAP_DEFINE_STATIC(Task_Heap, SCHEDULER_MAX_TASKS);
+static Task Tasks[SCHEDULER_MAX_TASKS + 1]; // indexed by heap node id, which starts at 1
+
+/**
+ * Heap ordering, earliest deadline first
+ */
+static bool Deadline_Before(void *user_data, pheap_node_id_t a, pheap_node_id_t b){
+    return Tasks[a].deadline_us < Tasks[b].deadline_us;
+}
+
+/**
+ * Sets up the task heap, call once before adding tasks
+ */
+void Scheduler_Init(void){
+    ph_post_alloc_init(&Task_Heap, SCHEDULER_MAX_TASKS, Deadline_Before, NULL);
+}
+
+/**
+ * Allocates a task and inserts it into the heap
+ * Returns 0 if all task slots are in use
+ */
+static Task_Id Add_Task(Task_Handler handler, void *user_data, uint32_t period_us, uint32_t delay_us){
+    Task_Id id = ph_new_node(&Task_Heap);
+    if (!id)
+        return 0;
+
+    Task *task = &Tasks[id];
+    task->handler = handler;
+    task->user_data = user_data;
+    task->period_us = period_us;
+    task->deadline_us = time_us_64() + delay_us;
+    task->stats = (Task_Stats){0};
+
+    ph_insert_node(&Task_Heap, id);
+    return id;
+}
+
+/**
+ * Runs handler every period_us, first after first_delay_us
+ */
+Task_Id Scheduler_Add_Periodic(Task_Handler handler, void *user_data, uint32_t period_us, uint32_t first_delay_us){
+    if (period_us == 0)
+        return 0;
+    return Add_Task(handler, user_data, period_us, first_delay_us);
+}
+
+/**
+ * Runs handler once after delay_us, the task slot is released before the handler runs
+ */
+Task_Id Scheduler_Add_One_Shot(Task_Handler handler, void *user_data, uint32_t delay_us){
+    return Add_Task(handler, user_data, 0, delay_us);
+}
+
+/**
+ * Removes a task that has not run yet (one shot) or stops a periodic task
+ */
+void Scheduler_Cancel(Task_Id id){
+    if (id && ph_contains_node(&Task_Heap, id))
+        ph_remove_and_free_node(&Task_Heap, id);
+}
+
+/**
+ * Runs every task whose deadline has passed, earliest first
+ */
+void Scheduler_Run_Due(void){
+    while (true){
+        Task_Id id = ph_peek_head(&Task_Heap);
+        if (!id)
+            return;
+
+        Task *task = &Tasks[id];
+        uint64_t now = time_us_64();
+        if (task->deadline_us > now)
+            return;
+
+        ph_remove_head(&Task_Heap, false);
+
+        // Jitter statistics
+        uint32_t lateness = (uint32_t)(now - task->deadline_us);
+        task->stats.runs++;
+        task->stats.total_lateness_us += lateness;
+        if (lateness > task->stats.max_lateness_us)
+            task->stats.max_lateness_us = lateness;
+
+        Task_Handler handler = task->handler;
+        void *user_data = task->user_data;
+
+        if (task->period_us){
+            // re-arm before running so the handler may cancel itself
+            task->deadline_us += task->period_us;
+            if (task->deadline_us <= now){
+                // every period boundary at or before now is a run that will not happen
+                task->stats.overruns += (uint32_t)((now - task->deadline_us) / task->period_us) + 1;
+                task->deadline_us = now + task->period_us;
+            }
+            ph_insert_node(&Task_Heap, id);
+        } else {
+            ph_free_node(&Task_Heap, id);
+        }
+
+        handler(user_data);
+    }
+}
+
+/**
+ * Sleeps until the next deadline or until any event (interrupt or __sev from an alarm
+ * or the other core) wakes the core, whichever comes first
+ */
+void Scheduler_Sleep(void){
+    Task_Id id = ph_peek_head(&Task_Heap);
+    if (!id){
+        __wfe();
+        return;
+    }
+    best_effort_wfe_or_timeout(from_us_since_boot(Tasks[id].deadline_us));
+}
+
+/**
+ * Returns the run and jitter statistics of a task
+ */
+const Task_Stats *Scheduler_Get_Stats(Task_Id id){
+    return &Tasks[id].stats;
+}
@@ -0,0 +1,37 @@
+#ifndef __SCHEDULER_H__
+#define __SCHEDULER_H__
+
+// Standard Library
+#include <stdint.h>
+#include <stdbool.h>
+
+// Pico SDK
+#include "pico/util/pheap.h"
+
+// Defines
+#define SCHEDULER_MAX_TASKS 16
+
+/**
+ * Deadline scheduler for Core1
+ * Tasks are kept in a pairing heap ordered by deadline; periodic tasks are re-armed
+ * from their previous deadline so they do not drift. Only call from Core1.
+ */
+typedef void (*Task_Handler)(void *user_data);
+typedef pheap_node_id_t Task_Id; // 0 is never a valid task
+
+typedef struct {
+    uint32_t runs;
+    uint32_t overruns;          // periods skipped because the task ran more than a period late
+    uint32_t max_lateness_us;   // worst start time after the deadline
+    uint64_t total_lateness_us; // for the mean start jitter
+} Task_Stats;
+
+void Scheduler_Init(void);
+Task_Id Scheduler_Add_Periodic(Task_Handler handler, void *user_data, uint32_t period_us, uint32_t first_delay_us);
+Task_Id Scheduler_Add_One_Shot(Task_Handler handler, void *user_data, uint32_t delay_us);
+void Scheduler_Cancel(Task_Id id);
+void Scheduler_Run_Due(void);
+void Scheduler_Sleep(void);
+const Task_Stats *Scheduler_Get_Stats(Task_Id id);
+
+#endif
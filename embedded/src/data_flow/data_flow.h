@@ -3,21 +3,59 @@
 
 #include <stdint.h>
 #include "pico/multicore.h"
+#include "wire.h"
 
 // DHT20_Reading struct to contain temp & humidity measurements for a single data point
+// Values are fixed point, floats and Fahrenheit are only derived where they are displayed
 typedef struct {
-  float humidity;
-  float temperature_c;
-  float temperature_f;
+  uint32_t raw_humidity;        // 20-bit count from the sensor
+  uint32_t raw_temperature;     // 20-bit count from the sensor
+  uint16_t humidity_centi;      // centi-%RH, 4123 = 41.23 %
+  int16_t temperature_centi_c;  // centi-degrees Celsius, 2250 = 22.50 °C
 } DHT20_Reading;
 
+/**
+ * Converts centi-degrees Celsius to centi-degrees Fahrenheit, rounded to nearest
+ */
+static inline int32_t Centi_C_To_Centi_F(int32_t centi_c) {
+  int32_t scaled = centi_c * 9;
+  return (scaled >= 0 ? (scaled + 2) / 5 : (scaled - 2) / 5) + 3200;
+}
+
+// Pipeline stages a sample is stamped at, from the I2C trigger to the LCD flush
+typedef enum {
+  STAGE_TRIGGER,       // DHT20 trigger sent (core1)
+  STAGE_DATA_READY,    // DHT20 data read back (core1)
+  STAGE_ENQUEUE,       // pushed on the ring (core1)
+  STAGE_DEQUEUE,       // popped in Refresh_Data (core0)
+  STAGE_RENDER_START,  // LCD flush of the frame started (core0)
+  STAGE_FLUSH_DONE,    // LCD flush DMA finished (core0)
+  NUM_STAGES
+} Latency_Stage;
+
 // Payload Data Struct for exchanging data between Core0 and Core1
 typedef struct {
-    volatile uint64_t time_stamp;
+    volatile uint64_t time_stamp;   // time_us_64() of the DHT20 trigger
+    volatile uint32_t stage_us[NUM_STAGES]; // low 32 bits of time_us_64() per stage, differences survive the wrap
     volatile uint16_t ADC_Data; // this only has 12 bits of precision, we lose 4 bits
+    volatile uint32_t ADC_Variance; // spread of the oversampled capture behind ADC_Data, counts squared
     volatile DHT20_Reading DHT20_Data;   //  store temp & humidity sensor data
     volatile int DHT20_Data_Valid;     
+    volatile uint8_t DHT20_Sensor;       // index into DHT20_SENSORS, 0 is the one on the display
 } Payload_Data;
 
+/**
+ * The wire form of a sample, see wire.h
+ */
+static inline Wire_Sample Payload_Wire_Sample(const Payload_Data *sample) {
+  return (Wire_Sample){
+    .t_ms = (uint32_t)(sample->time_stamp / 1000),
+    .humidity_centi = sample->DHT20_Data.humidity_centi,
+    .temperature_centi_c = sample->DHT20_Data.temperature_centi_c,
+    .adc = sample->ADC_Data,
+    .status = (uint8_t)((sample->DHT20_Data_Valid ? WIRE_STATUS_OK : 0) | sample->DHT20_Sensor << 1),
+  };
+}
+
 #endif
 
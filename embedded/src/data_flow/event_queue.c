@@ -0,0 +1,100 @@
+#include "event_queue.h"
+
+// Pico SDK
+#include "pico/time.h"
+#include "hardware/sync.h"
+
+/**
+ * Event queue for the Core0 main loop
+ * Events of the same kind coalesce while pending, e.g. several doorbells from Core1
+ * before the main loop runs are one EVENT_DATA, since one drain of the ring handles them all.
+ * Delivery order follows posting order.
+ */
+
+#define EVENT_QUEUE_SIZE NUM_EVENTS // one slot per kind is enough once duplicates coalesce
+
+static Event Queue[EVENT_QUEUE_SIZE];
+static uint8_t Queue_Head = 0;
+static uint8_t Queue_Count = 0;
+static uint32_t Pending_Mask = 0;
+
+// Idle accounting
+static uint64_t Idle_Us = 0;
+static uint64_t Window_Start_Us = 0;
+static uint64_t Window_Idle_Us = 0;
+
+/**
+ * Queues an event, safe to call from interrupt handlers on Core0
+ */
+void Event_Post(Event event)
+{
+    uint32_t status = save_and_disable_interrupts();
+    if (!(Pending_Mask & (1u << event)))
+    {
+        Pending_Mask |= 1u << event;
+        Queue[(Queue_Head + Queue_Count) % EVENT_QUEUE_SIZE] = event;
+        Queue_Count++;
+    }
+    restore_interrupts(status);
+}
+
+/**
+ * Returns true if an event is waiting
+ */
+bool Event_Pending(void)
+{
+    return Queue_Count != 0;
+}
+
+/**
+ * Sleeps until an event is queued and returns it
+ * Interrupts are masked while checking the queue so a post cannot slip in between the
+ * check and the sleep; __wfi still wakes on the pending interrupt, which then runs
+ * once interrupts are restored
+ */
+Event Event_Wait(void)
+{
+    while (true)
+    {
+        uint32_t status = save_and_disable_interrupts();
+        if (Queue_Count)
+        {
+            Event event = Queue[Queue_Head];
+            Queue_Head = (Queue_Head + 1) % EVENT_QUEUE_SIZE;
+            Queue_Count--;
+            Pending_Mask &= ~(1u << event);
+            restore_interrupts(status);
+            return event;
+        }
+
+        uint64_t sleep_start = time_us_64();
+        __wfi();
+        Idle_Us += time_us_64() - sleep_start;
+        restore_interrupts(status);
+    }
+}
+
+/**
+ * Total time Core0 has spent asleep waiting for events
+ */
+uint64_t Event_Idle_Us(void)
+{
+    return Idle_Us;
+}
+
+/**
+ * Core0 duty cycle in permille since the previous call
+ */
+uint32_t Event_Busy_Permille(void)
+{
+    uint64_t now = time_us_64();
+    uint64_t elapsed = now - Window_Start_Us;
+    uint64_t idle = Idle_Us - Window_Idle_Us;
+
+    Window_Start_Us = now;
+    Window_Idle_Us = Idle_Us;
+
+    if (elapsed == 0 || idle > elapsed)
+        return 0;
+    return (uint32_t)(((elapsed - idle) * 1000) / elapsed);
+}
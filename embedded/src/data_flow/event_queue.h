@@ -0,0 +1,28 @@
+#ifndef __EVENT_QUEUE_H__
+#define __EVENT_QUEUE_H__
+
+// Standard Library
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Events that wake the Core0 state machine
+ * Posted from interrupt handlers on Core0, consumed by the main loop
+ */
+typedef enum {
+    EVENT_NONE = 0,
+    EVENT_DATA,     // Core1 queued samples on the ring (FIFO doorbell)
+    EVENT_BUTTON,   // debounced button press
+    EVENT_RENDER,   // render deadline, a parked LCD frame can be retried
+    NUM_EVENTS
+} Event;
+
+void Event_Post(Event event);
+Event Event_Wait(void);
+bool Event_Pending(void);
+
+// Idle accounting
+uint64_t Event_Idle_Us(void);
+uint32_t Event_Busy_Permille(void);
+
+#endif
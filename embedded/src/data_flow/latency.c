@@ -0,0 +1,150 @@
+#include "latency.h"
+
+// Standard Library
+#include <string.h>
+
+// Pico SDK
+#include "pico/time.h"
+#include "hardware/sync.h"
+
+/**
+ * Histograms are only written on Core0: the sample spans when Refresh_Data() dequeues,
+ * the render spans from the main loop and the LCD flush interrupt. Queries copy with
+ * interrupts masked so a histogram is never read half updated.
+ */
+
+typedef struct {
+    bool valid;
+    uint32_t stage_us[NUM_STAGES];
+} Frame_Stamps;
+
+static Latency_Histogram Histograms[NUM_LATENCY_SPANS];
+static Frame_Stamps Tagged;          // stamps of the frame waiting to be flushed
+static Frame_Stamps In_Flight;       // stamps of the frame on the bus
+static uint32_t Last_Tagged_Trigger; // a sample is measured on its first render only
+
+/**
+ * Adds one latency to a span's histogram
+ */
+static void Record(Latency_Span span, uint32_t us)
+{
+    Latency_Histogram *h = &Histograms[span];
+    uint32_t bucket = us ? 31 - __builtin_clz(us) : 0;
+    if (bucket >= LATENCY_BUCKETS)
+        bucket = LATENCY_BUCKETS - 1;
+
+    h->buckets[bucket]++;
+    h->count++;
+    h->total_us += us;
+    if (us > h->max_us)
+        h->max_us = us;
+}
+
+/**
+ * Stamps a sample with the current time for one stage
+ */
+void Latency_Stamp(Payload_Data *sample, Latency_Stage stage)
+{
+    sample->stage_us[stage] = time_us_32();
+}
+
+/**
+ * Records the core1 and queue spans of a sample, call right after stamping the dequeue
+ */
+void Latency_Record_Sample(const Payload_Data *sample)
+{
+    const volatile uint32_t *t = sample->stage_us;
+    Record(LATENCY_CONVERT, t[STAGE_DATA_READY] - t[STAGE_TRIGGER]);
+    Record(LATENCY_PUBLISH, t[STAGE_ENQUEUE] - t[STAGE_DATA_READY]);
+    Record(LATENCY_QUEUE, t[STAGE_DEQUEUE] - t[STAGE_ENQUEUE]);
+}
+
+/**
+ * Associates the frame being drawn with the sample it shows, NULL for frames without one
+ * A sample drawn again, e.g. on a screen change, is not measured a second time
+ */
+void Latency_Tag_Frame(const Payload_Data *sample)
+{
+    if (!sample || sample->stage_us[STAGE_TRIGGER] == Last_Tagged_Trigger)
+    {
+        Tagged.valid = false;
+        return;
+    }
+
+    for (int i = 0; i < NUM_STAGES; i++)
+        Tagged.stage_us[i] = sample->stage_us[i];
+    Tagged.valid = true;
+    Last_Tagged_Trigger = sample->stage_us[STAGE_TRIGGER];
+}
+
+/**
+ * The tagged frame is going out on the bus
+ */
+void Latency_Render_Start(void)
+{
+    uint32_t status = save_and_disable_interrupts();
+    In_Flight = Tagged;
+    Tagged.valid = false;
+    if (In_Flight.valid)
+    {
+        In_Flight.stage_us[STAGE_RENDER_START] = time_us_32();
+        Record(LATENCY_RENDER_WAIT, In_Flight.stage_us[STAGE_RENDER_START] - In_Flight.stage_us[STAGE_DEQUEUE]);
+    }
+    restore_interrupts(status);
+}
+
+/**
+ * The frame's bytes have been handed to the I2C block, called from the flush interrupt
+ * or directly when the frame did not change the glass
+ */
+void Latency_Flush_Done(void)
+{
+    if (!In_Flight.valid)
+        return;
+    In_Flight.valid = false;
+
+    uint32_t *t = In_Flight.stage_us;
+    t[STAGE_FLUSH_DONE] = time_us_32();
+    Record(LATENCY_FLUSH, t[STAGE_FLUSH_DONE] - t[STAGE_RENDER_START]);
+    Record(LATENCY_END_TO_END, t[STAGE_FLUSH_DONE] - t[STAGE_TRIGGER]);
+}
+
+/**
+ * Copies out a span's histogram
+ */
+void Latency_Get(Latency_Span span, Latency_Histogram *out)
+{
+    uint32_t status = save_and_disable_interrupts();
+    *out = Histograms[span];
+    restore_interrupts(status);
+}
+
+/**
+ * Returns the upper edge of the bucket holding the given percentile, in permille
+ * Bucket resolution is a factor of 2, so this is an upper bound on the true value
+ */
+uint32_t Latency_Percentile_Us(const Latency_Histogram *h, uint32_t permille)
+{
+    if (!h->count)
+        return 0;
+
+    uint64_t rank = ((uint64_t)h->count * permille + 999) / 1000;
+    uint32_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS - 1; i++)
+    {
+        seen += h->buckets[i];
+        if (seen >= rank)
+            return (2u << i) - 1;
+    }
+    return h->max_us;
+}
+
+/**
+ * Clears every histogram, e.g. before measuring a change
+ */
+void Latency_Reset(void)
+{
+    uint32_t status = save_and_disable_interrupts();
+    memset(Histograms, 0, sizeof(Histograms));
+    restore_interrupts(status);
+}
@@ -0,0 +1,50 @@
+#ifndef __LATENCY_H__
+#define __LATENCY_H__
+
+// Standard Library
+#include <stdint.h>
+#include <stdbool.h>
+
+// User Modules
+#include "data_flow.h"
+
+/**
+ * Per-stage latency of a sample from the DHT20 trigger to the LCD flush
+ * Each span between two stages accumulates into a fixed log2 bucket histogram,
+ * bucket i counts latencies in [2^i, 2^(i+1)) us, bucket 0 also holds 0 us and the
+ * last bucket everything above
+ */
+
+#define LATENCY_BUCKETS 22 // last bucket starts at 2^21 us, about 2 s
+
+typedef enum {
+    LATENCY_CONVERT,      // trigger -> data ready, DHT20 conversion and polling
+    LATENCY_PUBLISH,      // data ready -> enqueue, core1 packing the payload
+    LATENCY_QUEUE,        // enqueue -> dequeue, doorbell and core0 wake up
+    LATENCY_RENDER_WAIT,  // dequeue -> render start, state machine and a parked frame
+    LATENCY_FLUSH,        // render start -> flush done, I2C DMA transfer
+    LATENCY_END_TO_END,   // trigger -> flush done
+    NUM_LATENCY_SPANS
+} Latency_Span;
+
+typedef struct {
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t buckets[LATENCY_BUCKETS];
+} Latency_Histogram;
+
+void Latency_Stamp(Payload_Data *sample, Latency_Stage stage);
+void Latency_Record_Sample(const Payload_Data *sample);
+
+// LCD frame tracking, only frames showing a new sample are measured past the dequeue
+void Latency_Tag_Frame(const Payload_Data *sample);
+void Latency_Render_Start(void);
+void Latency_Flush_Done(void);
+
+// Queries
+void Latency_Get(Latency_Span span, Latency_Histogram *out);
+uint32_t Latency_Percentile_Us(const Latency_Histogram *h, uint32_t permille);
+void Latency_Reset(void);
+
+#endif
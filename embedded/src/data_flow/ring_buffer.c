@@ -0,0 +1,93 @@
+#include "ring_buffer.h"
+
+// Pico SDK
+#include "hardware/sync.h"
+
+/**
+ * Lock-free SPSC ring used to hand samples from Core1 to Core0.
+ * The producer publishes a slot by writing head after the payload, the consumer
+ * releases a slot by writing tail after copying the payload out. The fences keep
+ * the payload and index accesses from being reordered across the two cores.
+ */
+
+/**
+ * Returns the index following idx, wrapping at the end of the storage
+ */
+static inline uint16_t next_index(const Ring_Buffer *rb, uint16_t idx)
+{
+    idx++;
+    return (idx == rb->size) ? 0 : idx;
+}
+
+/**
+ * Points the ring at its backing storage and marks it empty
+ * Must be called before the other core starts using the ring
+ */
+void Ring_Buffer_Init(Ring_Buffer *rb, Payload_Data *storage, uint16_t size)
+{
+    rb->head = 0;
+    rb->tail = 0;
+    rb->buffer = storage;
+    rb->size = size;
+    rb->dropped = 0;
+    __mem_fence_release();
+}
+
+/**
+ * Copies item into the ring (producer side only)
+ * Returns false and counts a drop if the ring is full; queued samples are never overwritten
+ */
+bool Ring_Buffer_Push(Ring_Buffer *rb, const Payload_Data *item)
+{
+    uint16_t head = rb->head;
+    uint16_t next = next_index(rb, head);
+
+    if (next == rb->tail) {
+        rb->dropped++;
+        return false;
+    }
+    __mem_fence_acquire(); // consumer is done reading the slot before we overwrite it
+
+    rb->buffer[head] = *item;
+
+    __mem_fence_release(); // payload is visible before the new head
+    rb->head = next;
+    return true;
+}
+
+/**
+ * Copies the oldest item out of the ring (consumer side only)
+ * Returns false if the ring is empty
+ */
+bool Ring_Buffer_Pop(Ring_Buffer *rb, Payload_Data *item)
+{
+    uint16_t tail = rb->tail;
+
+    if (tail == rb->head)
+        return false;
+    __mem_fence_acquire(); // payload is read after we observed the head
+
+    *item = rb->buffer[tail];
+
+    __mem_fence_release(); // payload is copied out before the slot is released
+    rb->tail = next_index(rb, tail);
+    return true;
+}
+
+/**
+ * Returns true if there is nothing to pop
+ */
+bool Ring_Buffer_Empty(const Ring_Buffer *rb)
+{
+    return rb->head == rb->tail;
+}
+
+/**
+ * Returns the number of queued items, a snapshot that may be stale by the time it is used
+ */
+uint16_t Ring_Buffer_Count(const Ring_Buffer *rb)
+{
+    uint16_t head = rb->head;
+    uint16_t tail = rb->tail;
+    return (head >= tail) ? head - tail : rb->size - tail + head;
+}
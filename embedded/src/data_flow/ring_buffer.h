@@ -0,0 +1,32 @@
+#ifndef __RING_BUFFER_H__
+#define __RING_BUFFER_H__
+
+// Standard Library
+#include <stdint.h>
+#include <stdbool.h>
+
+// User Modules
+#include "data_flow.h"
+
+/**
+ * Single producer / single consumer ring of Payload_Data
+ * Core1 is the only writer of head, Core0 is the only writer of tail
+ * One slot is always left empty so head == tail means empty
+ */
+typedef struct {
+    volatile uint16_t head;      // next slot to write, owned by producer
+    volatile uint16_t tail;      // next slot to read, owned by consumer
+    Payload_Data *buffer;
+    uint16_t size;
+    volatile uint32_t dropped;   // samples refused because the ring was full
+} Ring_Buffer;
+
+#define RING_BUFFER_INIT(storage, length) { 0, 0, (storage), (length), 0 }
+
+void Ring_Buffer_Init(Ring_Buffer *rb, Payload_Data *storage, uint16_t size);
+bool Ring_Buffer_Push(Ring_Buffer *rb, const Payload_Data *item);
+bool Ring_Buffer_Pop(Ring_Buffer *rb, Payload_Data *item);
+bool Ring_Buffer_Empty(const Ring_Buffer *rb);
+uint16_t Ring_Buffer_Count(const Ring_Buffer *rb);
+
+#endif
@@ -0,0 +1,244 @@
+#include "telemetry.h"
+
+// Pico SDK
+#include "pico/stdio.h"
+#include "pico/time.h"
+#include "pico/platform.h"
+#include "hardware/sync.h"
+
+#define TELEMETRY_MAX_RECORD 48                                         // largest record plus CRC
+#define TELEMETRY_MAX_FRAME (TELEMETRY_MAX_RECORD + TELEMETRY_MAX_RECORD / 254 + 2) // COBS + delimiter
+
+static_assert((TELEMETRY_RING_BYTES & (TELEMETRY_RING_BYTES - 1)) == 0, "ring size must be a power of two");
+
+/**
+ * Single producer / single consumer byte ring, one per core
+ * head and tail run freely and are masked on access, so head - tail is the fill level
+ */
+typedef struct {
+    volatile uint32_t head;      // written by the producing core
+    volatile uint32_t tail;      // written by core0 as it drains
+    volatile uint32_t dropped;
+    uint16_t sequence;
+    uint8_t buf[TELEMETRY_RING_BYTES];
+} Telemetry_Ring;
+
+static Telemetry_Ring Rings[2];
+
+// CRC-16/CCITT-FALSE, a nibble at a time
+static const uint16_t Crc_Table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+static uint16_t Crc16(const uint8_t *data, uint32_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        crc = (crc << 4) ^ Crc_Table[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (crc << 4) ^ Crc_Table[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
+
+/**
+ * COBS encodes len bytes into out and appends the 0x00 delimiter, returns the frame length
+ */
+static uint32_t Cobs_Encode(const uint8_t *in, uint32_t len, uint8_t *out)
+{
+    uint32_t code_at = 0;
+    uint32_t o = 1;
+    uint8_t code = 1;
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        if (in[i])
+        {
+            out[o++] = in[i];
+            code++;
+        }
+        if (!in[i] || code == 0xFF)
+        {
+            out[code_at] = code;
+            code_at = o++;
+            code = 1;
+        }
+    }
+    out[code_at] = code;
+    out[o++] = 0x00;
+    return o;
+}
+
+static inline uint8_t *Put_U16(uint8_t *p, uint16_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    return p + 2;
+}
+
+static inline uint8_t *Put_U32(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+    return p + 4;
+}
+
+/**
+ * Starts a record in rec: header byte, sequence number and time, returns the write pointer
+ */
+static uint8_t *Begin_Record(uint8_t *rec, Telemetry_Type type, uint32_t time_ms)
+{
+    uint core = get_core_num();
+    rec[0] = (uint8_t)type | (core << 7);
+    uint8_t *p = Put_U16(rec + 1, Rings[core].sequence++);
+    return Put_U32(p, time_ms);
+}
+
+/**
+ * Adds the CRC, frames the record and copies it into the calling core's ring
+ * A frame that does not fit is dropped whole and counted
+ */
+static void Commit_Record(uint8_t *rec, uint8_t *end)
+{
+    Telemetry_Ring *ring = &Rings[get_core_num()];
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+
+    end = Put_U16(end, Crc16(rec, end - rec));
+    uint32_t len = Cobs_Encode(rec, end - rec, frame);
+
+    uint32_t head = ring->head;
+    if (TELEMETRY_RING_BYTES - (head - ring->tail) < len)
+    {
+        ring->dropped++;
+        return;
+    }
+    __mem_fence_acquire(); // core0 is done reading the space before we overwrite it
+
+    for (uint32_t i = 0; i < len; i++)
+        ring->buf[(head + i) & (TELEMETRY_RING_BYTES - 1)] = frame[i];
+
+    __mem_fence_release(); // frame bytes are visible before the new head
+    ring->head = head + len;
+}
+
+/**
+ * Records a sample, call from the core that produced it
+ */
+void Telemetry_Sample(const Payload_Data *sample)
+{
+    uint8_t rec[TELEMETRY_MAX_RECORD];
+    uint8_t *p = Begin_Record(rec, TELEMETRY_SAMPLE, (uint32_t)(sample->time_stamp / 1000));
+    p = Put_U16(p, sample->DHT20_Data.humidity_centi);
+    p = Put_U16(p, (uint16_t)sample->DHT20_Data.temperature_centi_c);
+    p = Put_U16(p, sample->ADC_Data);
+    *p++ = sample->DHT20_Data_Valid ? 1 : 0;
+    *p++ = sample->DHT20_Sensor;
+    Commit_Record(rec, p);
+}
+
+/**
+ * Records a main loop event and the state it ran in, core0 main loop only
+ */
+void Telemetry_Event(uint8_t event, uint8_t state)
+{
+    uint8_t rec[TELEMETRY_MAX_RECORD];
+    uint8_t *p = Begin_Record(rec, TELEMETRY_EVENT, to_ms_since_boot(get_absolute_time()));
+    *p++ = event;
+    *p++ = state;
+    Commit_Record(rec, p);
+}
+
+/**
+ * Records a snapshot of the health counters, core0 main loop only
+ */
+void Telemetry_Counters(const Telemetry_Counter_Data *counters)
+{
+    uint8_t rec[TELEMETRY_MAX_RECORD];
+    uint8_t *p = Begin_Record(rec, TELEMETRY_COUNTERS, to_ms_since_boot(get_absolute_time()));
+    p = Put_U32(p, counters->ring_dropped);
+    p = Put_U32(p, counters->telemetry_dropped);
+    p = Put_U32(p, counters->idle_ms);
+    p = Put_U32(p, counters->e2e_p99_us);
+    p = Put_U32(p, counters->flash_errors);
+    p = Put_U32(p, counters->uplink_dropped);
+    p = Put_U32(p, counters->uplink_failures);
+    p = Put_U32(p, counters->uplink_batches);
+    Commit_Record(rec, p);
+}
+
+/**
+ * Records one stats record per channel and window of a rolling stats summary
+ * Windows without samples yet are skipped
+ */
+void Telemetry_Stats(const Stats_Summary *summary)
+{
+    for (int c = 0; c < NUM_STATS_CHANNELS; c++)
+    {
+        for (int w = 0; w < NUM_STATS_WINDOWS; w++)
+        {
+            const Stats_Window *win = &summary->window[c][w];
+            if (!win->count)
+                continue;
+
+            uint8_t rec[TELEMETRY_MAX_RECORD];
+            uint8_t *p = Begin_Record(rec, TELEMETRY_STATS, summary->time_ms);
+            *p++ = c;
+            *p++ = w;
+            p = Put_U32(p, win->count);
+            p = Put_U16(p, (uint16_t)win->min);
+            p = Put_U16(p, (uint16_t)win->max);
+            p = Put_U16(p, (uint16_t)win->mean);
+            p = Put_U16(p, win->stddev);
+            p = Put_U16(p, (uint16_t)summary->ema[c]);
+            p = Put_U32(p, (uint32_t)win->rate_per_h);
+            Commit_Record(rec, p);
+        }
+    }
+}
+
+/**
+ * Writes the complete frames of one ring to stdio, up to and including the last delimiter
+ */
+static void Drain(Telemetry_Ring *ring)
+{
+    uint32_t tail = ring->tail;
+    uint32_t head = ring->head;
+    if (head == tail)
+        return;
+    __mem_fence_acquire(); // frame bytes are read after we observed the head
+
+    // producers only publish whole frames, so everything up to head ends on a delimiter
+    uint32_t start = tail & (TELEMETRY_RING_BYTES - 1);
+    uint32_t len = head - tail;
+    uint32_t first = TELEMETRY_RING_BYTES - start;
+    if (first > len)
+        first = len;
+
+    stdio_put_string((const char *)&ring->buf[start], first, false, false);
+    if (len > first)
+        stdio_put_string((const char *)ring->buf, len - first, false, false);
+
+    __mem_fence_release(); // bytes are sent before the space is released
+    ring->tail = head;
+}
+
+/**
+ * Sends queued frames from both cores, call from the core0 main loop
+ * stdio may block briefly while the USB buffer is full; with no host attached it returns at once
+ */
+void Telemetry_Service(void)
+{
+    Drain(&Rings[0]);
+    Drain(&Rings[1]);
+}
+
+/**
+ * Frames dropped because a ring was full, both cores
+ */
+uint32_t Telemetry_Dropped(void)
+{
+    return Rings[0].dropped + Rings[1].dropped;
+}
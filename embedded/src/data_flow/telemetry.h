@@ -0,0 +1,53 @@
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+// Standard Library
+#include <stdint.h>
+#include <stdbool.h>
+
+// User Modules
+#include "../config.h"
+#include "data_flow.h"
+#include "../core1/rolling_stats.h"
+
+/**
+ * Binary telemetry over USB CDC
+ *
+ * Records are packed little endian, followed by a CRC-16/CCITT-FALSE of the record,
+ * COBS encoded and terminated by a 0x00 byte. Each core writes into its own lock-free
+ * byte ring, so recording a sample costs a few dozen stores and never formats text.
+ * Core0 drains both rings to USB from the main loop, whole frames at a time.
+ *
+ * Record header byte: bits 0-6 type, bit 7 the core that wrote it, then a 16-bit
+ * sequence number per core so the host can count lost frames.
+ * Text from printf shares the port and costs the frame it lands next to, which the host
+ * counts as a decode error, so keep DEBUG off while capturing.
+ */
+
+typedef enum {
+    TELEMETRY_SAMPLE = 1,    // u32 time_ms, u16 humidity_centi, i16 temperature_centi_c, u16 adc, u8 valid, u8 sensor
+    TELEMETRY_EVENT = 2,     // u32 time_ms, u8 event, u8 state
+    TELEMETRY_COUNTERS = 3,  // u32 time_ms, then the Telemetry_Counter_Data fields in order
+    TELEMETRY_STATS = 4,     // u32 time_ms, u8 channel, u8 window, u32 count, i16 min, i16 max, i16 mean,
+                             // u16 stddev, i16 ema, i32 rate_per_h, see core1/rolling_stats.h
+} Telemetry_Type;
+
+typedef struct {
+    uint32_t ring_dropped;       // samples refused by the core1 -> core0 ring
+    uint32_t telemetry_dropped;  // frames refused by the telemetry rings
+    uint32_t idle_ms;            // core0 time asleep since boot
+    uint32_t e2e_p99_us;         // trigger to glass latency, bucket upper bound
+    uint32_t flash_errors;       // failed flash log programs / erases
+    uint32_t uplink_dropped;     // samples refused by the full uplink queue
+    uint32_t uplink_failures;    // uplink posts that failed or timed out
+    uint32_t uplink_batches;     // uplink batches the backend acknowledged
+} Telemetry_Counter_Data;
+
+void Telemetry_Sample(const Payload_Data *sample);
+void Telemetry_Event(uint8_t event, uint8_t state);
+void Telemetry_Counters(const Telemetry_Counter_Data *counters);
+void Telemetry_Stats(const Stats_Summary *summary);
+void Telemetry_Service(void);
+uint32_t Telemetry_Dropped(void);
+
+#endif
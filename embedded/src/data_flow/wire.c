@@ -0,0 +1,132 @@
+#include "wire.h"
+
+static const Wire_Sample No_Sample = {0, 0, 0, 0, 0}; // what the first record is relative to
+
+static inline uint32_t Zigzag(int32_t v){
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t Unzigzag(uint32_t v){
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static inline uint32_t Put_Varint(uint8_t *out, uint32_t v){
+    uint32_t n = 0;
+    while (v >= 0x80){
+        out[n++] = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+/**
+ * Reads a varint at *pos, returns false if it runs past end or does not fit 32 bits
+ */
+static bool Get_Varint(const uint8_t *buf, uint32_t end, uint32_t *pos, uint32_t *v){
+    uint32_t value = 0;
+    for (uint32_t shift = 0; shift < 35; shift += 7){
+        if (*pos >= end)
+            return false;
+        uint8_t b = buf[(*pos)++];
+        if (shift == 28 && b > 0x0F)
+            return false; // more than 32 bits
+        value |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)){
+            *v = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Starts a batch in buf, fields is a Wire_Field mask and must hold WIRE_REQUIRED
+ * Returns false if the mask is not valid or buf cannot hold the header
+ */
+bool Wire_Begin(Wire_Encoder *enc, uint8_t *buf, uint32_t cap, uint8_t fields, uint32_t period_ms){
+    if ((fields & WIRE_REQUIRED) != WIRE_REQUIRED || (fields & ~WIRE_ALL) || cap < WIRE_HEADER_MAX)
+        return false;
+
+    enc->buf = buf;
+    enc->cap = cap;
+    enc->period_ms = period_ms;
+    enc->count = 0;
+    enc->fields = fields;
+    enc->prev = No_Sample;
+    buf[0] = WIRE_VERSION;
+    buf[1] = fields;
+    buf[2] = buf[3] = 0; // count, filled in by Wire_End()
+    enc->len = 4 + Put_Varint(buf + 4, period_ms);
+    return true;
+}
+
+/**
+ * Appends a sample, returns false once the buffer or the u16 count is full
+ */
+bool Wire_Add(Wire_Encoder *enc, const Wire_Sample *sample){
+    if (enc->cap - enc->len < WIRE_RECORD_MAX || enc->count == UINT16_MAX)
+        return false;
+
+    uint8_t *out = enc->buf + enc->len;
+    uint32_t n = 0;
+    n += Put_Varint(out + n, Zigzag((int32_t)(sample->t_ms - enc->prev.t_ms - enc->period_ms)));
+    n += Put_Varint(out + n, Zigzag((int32_t)sample->humidity_centi - enc->prev.humidity_centi));
+    n += Put_Varint(out + n, Zigzag((int32_t)sample->temperature_centi_c - enc->prev.temperature_centi_c));
+    if (enc->fields & WIRE_ADC)
+        n += Put_Varint(out + n, Zigzag((int32_t)sample->adc - enc->prev.adc));
+    if (enc->fields & WIRE_STATUS)
+        n += Put_Varint(out + n, Zigzag((int32_t)sample->status - enc->prev.status));
+
+    enc->len += n;
+    enc->count++;
+    enc->prev = *sample;
+    return true;
+}
+
+/**
+ * Writes the count into the header, returns the batch length in bytes
+ */
+uint32_t Wire_End(Wire_Encoder *enc){
+    enc->buf[2] = (uint8_t)enc->count;
+    enc->buf[3] = (uint8_t)(enc->count >> 8);
+    return enc->len;
+}
+
+/**
+ * Decodes a batch into out, for the host tools and for checking the encoder
+ * Returns the number of samples, or -1 if the batch is malformed, uses fields this decoder
+ * does not know, or holds more than max samples
+ */
+int32_t Wire_Decode(const uint8_t *buf, uint32_t len, Wire_Sample *out, uint32_t max){
+    if (len < 5 || buf[0] != WIRE_VERSION)
+        return -1;
+    uint8_t fields = buf[1];
+    if ((fields & WIRE_REQUIRED) != WIRE_REQUIRED || (fields & ~WIRE_ALL))
+        return -1;
+    uint32_t count = buf[2] | (uint32_t)buf[3] << 8;
+    if (count > max)
+        return -1;
+
+    uint32_t pos = 4;
+    uint32_t period_ms;
+    if (!Get_Varint(buf, len, &pos, &period_ms))
+        return -1;
+
+    Wire_Sample prev = No_Sample;
+    for (uint32_t i = 0; i < count; i++){
+        uint32_t d[5] = {0, 0, 0, 0, 0};
+        for (uint32_t f = 0; f < 5; f++)
+            if ((fields & (1 << f)) && !Get_Varint(buf, len, &pos, &d[f]))
+                return -1;
+
+        Wire_Sample s;
+        s.t_ms = prev.t_ms + period_ms + (uint32_t)Unzigzag(d[0]);
+        s.humidity_centi = (uint16_t)(prev.humidity_centi + Unzigzag(d[1]));
+        s.temperature_centi_c = (int16_t)(prev.temperature_centi_c + Unzigzag(d[2]));
+        s.adc = (uint16_t)(prev.adc + Unzigzag(d[3]));
+        s.status = fields & WIRE_STATUS ? (uint8_t)(prev.status + Unzigzag(d[4])) : WIRE_STATUS_OK;
+        out[i] = prev = s;
+    }
+    return pos == len ? (int32_t)count : -1;
+}
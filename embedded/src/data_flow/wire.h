@@ -0,0 +1,90 @@
+#ifndef __WIRE_H__
+#define __WIRE_H__
+
+// Standard Library
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Compact binary sample batches, the format shared by the firmware, the backend and the tools
+ *
+ * A batch is a fixed header followed by records. Every field is an integer in the units the
+ * firmware already keeps, so no floats cross the wire:
+ *
+ *   u8     version (WIRE_VERSION)
+ *   u8     fields, a Wire_Field bitmask of what each record carries
+ *   u16    count, little endian
+ *   varint period_ms, the nominal time between samples
+ *   count records, one varint per field present, in Wire_Field order
+ *
+ * Each record field is the zigzag encoded difference from the same field of the previous
+ * record (all zero before the first), and t is further offset by period_ms, so a sample
+ * taken on schedule with readings that barely moved costs about a byte per field. Varints
+ * are LEB128, at most 5 bytes. Differences are taken modulo 2^32, so t wraps cleanly.
+ *
+ *   field   schema                                   default when absent
+ *   t       u32 device ms since boot                 required
+ *   h       u16 centi-%RH, 0..10000                  required
+ *   tc      i16 centi-degrees C, -4000..8500         required
+ *   adc     u16 photoresistor counts, 0..4095        0
+ *   status  u8 bit 0 reading ok, bits 1-7 sensor     1 (ok, sensor 0)
+ *
+ * Bits 5-7 of the fields byte are for fields added later; a decoder that does not know one
+ * must refuse the batch rather than misread the records. Version 1 is the fixed 12-byte
+ * record layout the backend also accepts. embedded/tools/wire_golden.txt holds the vectors
+ * this encoder and the backend's decoder are both checked against.
+ */
+
+#define WIRE_VERSION 2
+#define WIRE_HEADER_MAX 9   // version, fields, count, 5-byte period
+#define WIRE_RECORD_MAX 25  // 5 fields, 5 bytes each
+
+typedef enum {
+    WIRE_T = 1 << 0,
+    WIRE_H = 1 << 1,
+    WIRE_TC = 1 << 2,
+    WIRE_ADC = 1 << 3,
+    WIRE_STATUS = 1 << 4,
+} Wire_Field;
+
+#define WIRE_REQUIRED (WIRE_T | WIRE_H | WIRE_TC)
+#define WIRE_ALL (WIRE_T | WIRE_H | WIRE_TC | WIRE_ADC | WIRE_STATUS)
+
+typedef struct {
+    uint32_t t_ms;
+    uint16_t humidity_centi;
+    int16_t temperature_centi_c;
+    uint16_t adc;
+    uint8_t status;  // WIRE_STATUS_OK | sensor << 1
+} Wire_Sample;
+
+#define WIRE_STATUS_OK 1
+
+/**
+ * Encoder state for one batch, written into a caller's buffer, no allocation
+ */
+typedef struct {
+    uint8_t *buf;
+    uint32_t cap;
+    uint32_t len;
+    uint32_t period_ms;
+    uint16_t count;
+    uint8_t fields;
+    Wire_Sample prev;
+} Wire_Encoder;
+
+bool Wire_Begin(Wire_Encoder *enc, uint8_t *buf, uint32_t cap, uint8_t fields, uint32_t period_ms);
+bool Wire_Add(Wire_Encoder *enc, const Wire_Sample *sample);
+uint32_t Wire_End(Wire_Encoder *enc);
+
+int32_t Wire_Decode(const uint8_t *buf, uint32_t len, Wire_Sample *out, uint32_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,12 +1,12 @@
 #include "dht20_sensor.h"
 
+#include <string.h>
+
 // Debug Options
 #define DEBUG_SENSOR 0              // whether to print sensor readings 
 #define DEBUG_SENSOR_VERBOSE 0  // whether to print raw data readings etc.
 
 
-i2c_inst_t *i2c_channel;
-
 #define HARDWARE_ADDR 0x38                            // sensor address 
 #define READY_STATUS 0x18                             // sensor sends this when ready to take a measurement
 static const uint8_t TRIGGER_MEASUREMENT[3] = { 0xAC, 0x33, 0x00 };   // has two byte parameter 0x33 and 0x00
@@ -17,26 +17,75 @@ static const uint8_t TRIGGER_MEASUREMENT[3] = { 0xAC, 0x33, 0x00 };   // has two
 #define RESET_REGISTER_2 0x1C
 #define RESET_REGISTER_3 0x1E
 
+// timing constants taken from the datasheet
+#define DHT20_TRIGGER_GAP_MS 10     // wait before sending 0xAC
+#define DHT20_CONVERSION_MS 80      // measurement time after 0xAC
+#define DHT20_POLL_RETRY_MS 10      // re-check interval if the sensor is still busy
+
+// TCA9548A mux - writing a byte to the mux selects the channels whose bits are set
+#define MUX_CHANNELS 8
+
 // CRC constants - CRC8 check polynomial is CRC [7:0] = 1+X4+X5+X8, which is 0x31;
 #define INITIAL_CRC_VAL 0xFF
 #define CRC_POLYNOMIAL 0x31
 
+/**
+  * Mux state of each I2C controller, so back to back transfers to the same sensor
+  * do not reselect the channel. Only one mux channel is open per bus at a time, which
+  * keeps sensors sharing the 0x38 address behind different muxes apart.
+  */
+static struct {
+  uint8_t mux_addr;       // mux with an open channel, or DHT20_NO_MUX
+  uint8_t mux_mask;
+} Bus_Mux[2];
+
+/**
+  * Routes the bus to the sensor, opening its mux channel and closing any other one.
+  *
+  * Returns 0 if successful, or 1 if a mux did not acknowledge.
+  */
+static int select_sensor(dht20_t *dht){
+  uint bus = i2c_get_index(dht->i2c);
+  uint8_t mask = dht->mux_addr == DHT20_NO_MUX ? 0 : 1u << dht->mux_channel;
+
+  if (Bus_Mux[bus].mux_addr == dht->mux_addr && Bus_Mux[bus].mux_mask == mask)
+    return 0;
+
+  // close the channel some other sensor left open on a different mux
+  if (Bus_Mux[bus].mux_addr != DHT20_NO_MUX && Bus_Mux[bus].mux_addr != dht->mux_addr){
+    uint8_t none = 0;
+    if (i2c_write_blocking(dht->i2c, Bus_Mux[bus].mux_addr, &none, 1, 0) < 1)
+      return 1;
+    Bus_Mux[bus].mux_addr = DHT20_NO_MUX;
+    Bus_Mux[bus].mux_mask = 0;
+  }
+
+  if (dht->mux_addr != DHT20_NO_MUX){
+    if (i2c_write_blocking(dht->i2c, dht->mux_addr, &mask, 1, 0) < 1)
+      return 1;
+    Bus_Mux[bus].mux_addr = dht->mux_addr;
+    Bus_Mux[bus].mux_mask = mask;
+  }
+  return 0;
+}
+
 /**
   * If the sensor returns anything other than 0x18 when reading the status register, 
   * this function will perform the calibration/reset routine on the provided register. 
   *
+  * @param dht                The sensor to calibrate, already selected on its bus
   * @param register_address   The specific register to be calibrated/reset.
   *
   * Returns 0 if successful, or 1 if there were any errors.
   */
-int reset_sensor_register(uint8_t register_address){
+static int reset_sensor_register(dht20_t *dht, uint8_t register_address){
 
   uint8_t register_data[REGISTER_LENGTH];
   uint8_t calibration_data[REGISTER_LENGTH] = {register_address, 0x00, 0x00};
 
 
   // send calibration data to register being calibrated
-  int bytes_written = i2c_write_blocking(i2c_channel, HARDWARE_ADDR, calibration_data, REGISTER_LENGTH, 0);
+  int bytes_written = i2c_write_blocking(dht->i2c, HARDWARE_ADDR, calibration_data, REGISTER_LENGTH, 0);
   if (bytes_written < 0)
     return 1;
   
@@ -44,7 +93,7 @@ int reset_sensor_register(uint8_t register_address){
   sleep_ms(5);
 
   // read 3 bytes from register. first byte will be ignored/overwritten before data is sent back
-  int bytes_read = i2c_read_blocking(i2c_channel, HARDWARE_ADDR, register_data, REGISTER_LENGTH, 0);
+  int bytes_read = i2c_read_blocking(dht->i2c, HARDWARE_ADDR, register_data, REGISTER_LENGTH, 0);
   if (bytes_read < 0)
     return 1;
   
@@ -53,7 +102,7 @@ int reset_sensor_register(uint8_t register_address){
 
   // we need to OR 0x80 and the address of the register, and then send it back with the 2nd & 3rd bytes we just recieved per vendor example
   register_data[0] = register_address | 0x80;
-  bytes_written = i2c_write_blocking(i2c_channel, HARDWARE_ADDR, register_data, REGISTER_LENGTH, 0);
+  bytes_written = i2c_write_blocking(dht->i2c, HARDWARE_ADDR, register_data, REGISTER_LENGTH, 0);
   if (bytes_written < 0)
     return 1;
   
@@ -62,42 +111,68 @@ int reset_sensor_register(uint8_t register_address){
 }
 
 /**
-  * Performs the initial I2C setup of the DHT20 sensor and reads the ready status
-  * of the DHT20 sensor. If the DHT20 sensor does not return 0x18 to indicate that it
-  * is ready, this function will call the reset_sensor_register() function in order to
-  * re-calibrate it.
-  *
-  * @param sensor_sda_pin   The GPIO pin number of the SDA pin used by this sensor
-  * @param sensor_scl_pin   The GPIO pin number of the SCL pin used by this sensor
+  * Sets up an I2C controller and its pins for DHT20 sensors and waits out their power up.
+  * Call once per bus before dht20_init(). Sensors cannot sit on the LCD bus, see dht20_init().
   *
-  * Returns 0 if successful, or 1 if there were any errors.
+  * @param i2c              The I2C controller the sensors hang off
+  * @param sda_pin          The GPIO pin number of the SDA pin used by this bus
+  * @param scl_pin          The GPIO pin number of the SCL pin used by this bus
   */
-int setup_sensor(uint sensor_sda_pin, uint sensor_scl_pin, i2c_inst_t *channel){
-
-  i2c_channel = channel;
+void dht20_bus_init(i2c_inst_t *i2c, uint sda_pin, uint scl_pin){
 
-  bool sensor_ready = false;
-  
   #if DEBUG_SENSOR
   sleep_ms(5000);   // sleep long enough to catch logging
-  printf("initializing humidity sensor...\r\n");
+  printf("initializing humidity sensor bus...\r\n");
   #endif
 
   // most devices clock at either 100 or 400 kHertz. SDK says controller does
   // not support high speed mode (though other sources on the internet indicate
   // that it does) - setting to 400 kHz, but if we have issues, bump back down to 100 kHz 
-  i2c_init(i2c_channel, 400000);
+  i2c_init(i2c, 400000);
 
   // define sda & scl pins to function as i2c
-  gpio_set_function(sensor_sda_pin, GPIO_FUNC_I2C);
-  gpio_set_function(sensor_scl_pin, GPIO_FUNC_I2C);
+  gpio_set_function(sda_pin, GPIO_FUNC_I2C);
+  gpio_set_function(scl_pin, GPIO_FUNC_I2C);
 
   // configure pins high
-  gpio_pull_up(sensor_sda_pin);
-  gpio_pull_up(sensor_scl_pin);
+  gpio_pull_up(sda_pin);
+  gpio_pull_up(scl_pin);
 
   // sleep at minimum 100ms per datasheet
   sleep_ms(100);
+}
+
+/**
+  * Binds a sensor handle to its bus position and reads the ready status of the DHT20.
+  * If the DHT20 sensor does not return 0x18 to indicate that it is ready, this function
+  * will call reset_sensor_register() in order to re-calibrate it.
+  *
+  * @param dht              The handle to initialize
+  * @param i2c              The I2C controller, set up by dht20_bus_init(); not LCD_I2C_PORT
+  * @param mux_addr         Address of the TCA9548A the sensor sits behind, or DHT20_NO_MUX
+  * @param mux_channel      The mux channel, ignored without a mux
+  *
+  * Returns 0 if successful, or 1 if there were any errors, a sensor on the LCD bus included.
+  */
+int dht20_init(dht20_t *dht, i2c_inst_t *i2c, uint8_t mux_addr, uint8_t mux_channel){
+
+  memset(dht, 0, sizeof(*dht));
+
+  // core0 flushes the LCD by DMA and reprograms the target address with nothing arbitrating
+  // against core1's transfers, so the LCD bus carries no sensors; the handle keeps no bus
+  // and never starts a measurement
+  if (i2c == LCD_I2C_PORT)
+    return 1;
+
+  dht->i2c = i2c;
+  dht->mux_addr = mux_addr;
+  dht->mux_channel = mux_channel % MUX_CHANNELS;
+  dht->state = DHT20_IDLE;
+
+  bool sensor_ready = false;
+
+  if (select_sensor(dht))
+    return 1;
 
   #if DEBUG_SENSOR_VERBOSE
   printf("getting status of register...\r\n");
@@ -107,7 +182,7 @@ int setup_sensor(uint sensor_sda_pin, uint sensor_scl_pin, i2c_inst_t *channel){
   // is just a 7-bit 0x38 (sensor's address) plus a read bit of '1' tacked onto
   // the end - meaning we just need to do a read on the sensor
   uint8_t response = 0;
-  int bytes_read = i2c_read_blocking(i2c_channel, HARDWARE_ADDR, &response, 1, 0);
+  int bytes_read = i2c_read_blocking(dht->i2c, HARDWARE_ADDR, &response, 1, 0);
 
   #if DEBUG_SENSOR_VERBOSE
   printf("response is: %x\r\n", response);
@@ -123,12 +198,15 @@ int setup_sensor(uint sensor_sda_pin, uint sensor_scl_pin, i2c_inst_t *channel){
     sensor_ready = true;
   } else{
     // per datasheet, to calibrate, we must initialize the 0x1B, 0x1C, and 0x1E registers.
-    reset_sensor_register(RESET_REGISTER_1);  // defines 0x1B
-    reset_sensor_register(RESET_REGISTER_2);  // defines 0x1C
-    reset_sensor_register(RESET_REGISTER_3);  // defines 0x1E
+    reset_sensor_register(dht, RESET_REGISTER_1);  // defines 0x1B
+    reset_sensor_register(dht, RESET_REGISTER_2);  // defines 0x1C
+    reset_sensor_register(dht, RESET_REGISTER_3);  // defines 0x1E
     sensor_ready = true;
   }
  
+  // datasheet asks for 10ms between the status read and the first trigger
+  dht->next_trigger_time = make_timeout_time_ms(DHT20_TRIGGER_GAP_MS);
+
   #if DEBUG_SENSOR 
   if (sensor_ready) {
     printf("DHT20 sensor initialized\r\n");
@@ -183,93 +261,322 @@ uint8_t calculate_crc8(uint8_t *data, int num_bytes){
 
 
 /**
-  * Sends a message to the DHT20 sensor instructing it to take a measurement. The
-  * DHT20 sensor takes a humidity & temperature measurement which is read by this
-  * function, validated against its CRC, and then converted into human readable data. 
+  * Converts raw 20-bit sensor counts into fixed point values using integer math only.
+  * Datasheet formulas are RH = raw / 2^20 * 100 and T = raw / 2^20 * 200 - 50; the
+  * scale factors reduce to 10000 / 2^20 = 625 / 2^16 and 20000 / 2^20 = 1250 / 2^16,
+  * which keeps every product inside 32 bits. Results are rounded to nearest.
   *
+  * @param  raw_humidity         20-bit humidity count
+  * @param  raw_temp             20-bit temperature count
   * @param  current_measurement  The struct that is passed in to store the readings
-  *
-  * Returns 0 if successful, or 1 if there were any errors.
   */
-int take_measurement(DHT20_Reading * current_measurement){
-
-  uint8_t raw_data[8];
-
-  // first, wait 10ms to send 0xAC
-  sleep_ms(10);
-
-  // send the command to trigger measurement
-  int bytes_written = i2c_write_blocking(i2c_channel, HARDWARE_ADDR, TRIGGER_MEASUREMENT, 3, 0);
-  if (bytes_written < 1)
-    return 1;
-  
-  // initialize status byte so that we will always wait the recommended 80ms before a reading.
-  raw_data[0] = 0xFF;
-  
-  // Per datasheet, Bit[7] = 0 when the sensor has completed its reading
-  while (raw_data[0] >> 7) {
- 
-    // wait 80 ms for the sensor to take the measurement, per datasheet
-    sleep_ms(80);
-
-    // read the status word to see if measurement has completed
-    int bytes_read = i2c_read_blocking(i2c_channel, HARDWARE_ADDR, raw_data, 1, 0);
-    if (bytes_read < 1)
-      return 1;
-  }
+void dht20_convert_raw(uint32_t raw_humidity, uint32_t raw_temp, DHT20_Reading *current_measurement){
+  current_measurement->raw_humidity = raw_humidity;
+  current_measurement->raw_temperature = raw_temp;
+  current_measurement->humidity_centi = (uint16_t)((raw_humidity * 625u + (1u << 15)) >> 16);
+  current_measurement->temperature_centi_c = (int16_t)((int32_t)((raw_temp * 1250u + (1u << 15)) >> 16) - 5000);
+}
 
-  // read 6 bytes of data + 1 byte CRC
-  int bytes_read = i2c_read_blocking(i2c_channel, HARDWARE_ADDR, &raw_data[1], 7, 0);
-  if (bytes_read < 1)
-    return 1;
-  
+/**
+  * Converts the 7 bytes read back from the sensor (status, 5 data bytes, CRC) 
+  * into human readable data after validating them against their CRC.
+  *
+  * @param  raw_data             The status byte followed by the data and CRC bytes
+  * @param  current_measurement  The struct that is passed in to store the readings
+  *
+  * Returns 0 if successful, or 1 if the CRC did not match.
+  */
+static int convert_measurement(uint8_t *raw_data, DHT20_Reading *current_measurement){
 
   #if DEBUG_SENSOR_VERBOSE
-  printf("raw data: %x %x %x %x %x %x [CRC: %x]\r\n", raw_data[1], raw_data[2], raw_data[3], raw_data[4], raw_data[5], raw_data[6], raw_data[7]);
+  printf("raw data: %x %x %x %x %x %x [CRC: %x]\r\n", raw_data[0], raw_data[1], raw_data[2], raw_data[3], raw_data[4], raw_data[5], raw_data[6]);
   #endif
 
   // validate data via CRC and exit function with an error if data isn't valid
-  uint8_t calculated_crc = calculate_crc8(&raw_data[1], 6);
+  uint8_t calculated_crc = calculate_crc8(raw_data, 6);
 
   #if DEBUG_SENSOR_VERBOSE
   printf("the calculated CRC is: %x\r\n", calculated_crc);
   #endif
 
-  if (raw_data[7] != calculated_crc)
+  if (raw_data[6] != calculated_crc)
     return 1;
   
 
   // make a copy of the byte to be split in half so bitwise operations don't mess with data
-  uint8_t half_byte = raw_data[4];
+  uint8_t half_byte = raw_data[3];
   half_byte = half_byte << 4;
   half_byte = half_byte >> 4;
 
   // get raw humidity
   uint32_t raw_humidity = 0;
-  raw_humidity += raw_data[2] << 12;
-  raw_humidity += raw_data[3] << 4;
-  raw_humidity += raw_data[4] >> 4;
+  raw_humidity += raw_data[1] << 12;
+  raw_humidity += raw_data[2] << 4;
+  raw_humidity += raw_data[3] >> 4;
 
   // get raw temperature
   uint32_t raw_temp = 0;
   raw_temp += half_byte << 16;  
-  raw_temp += raw_data[5] << 8; 
-  raw_temp += raw_data[6];
+  raw_temp += raw_data[4] << 8; 
+  raw_temp += raw_data[5];
 
   #if DEBUG_SENSOR_VERBOSE 
   printf("raw humidity: %" PRIu32 "\r\n", raw_humidity); 
   printf("raw temp: %" PRIu32 "\r\n", raw_temp); 
   #endif
 
-  // formulas for humidity & temperature taken from datasheet 
-  float denominator = pow(2, 20);
-  current_measurement->humidity = (raw_humidity / denominator) * 100;
-  current_measurement->temperature_c = (raw_temp / denominator ) * 200 - 50;
-  current_measurement->temperature_f = (current_measurement->temperature_c * 1.8) + 32;
+  dht20_convert_raw(raw_humidity, raw_temp, current_measurement);
 
   #if DEBUG_SENSOR
-  printf("HUMIDITY: %f %%\tTEMP: %f °C (%f °F)\r\n", current_measurement->humidity, current_measurement->temperature_c, current_measurement->temperature_f);
+  printf("HUMIDITY: %u centi-%%\tTEMP: %d centi-°C\r\n", current_measurement->humidity_centi, current_measurement->temperature_centi_c);
   #endif
 
   return 0;
 }
+
+// ********** Asynchronous measurement **********
+//
+// IDLE -> WAIT_TRIGGER -> CONVERTING -> READY -> IDLE
+// The alarms only move the state forward and wake the core; every I2C transfer
+// happens in dht20_service() so no bus traffic runs in interrupt context.
+// Each sensor has its own state machine, so a caller that starts every sensor and then
+// services them all pays one conversion time for the lot, not one per sensor.
+
+/**
+  * Alarm callback, advances the state machine out of a wait state and wakes the core
+  * so that dht20_service() can do the bus work outside of interrupt context.
+  */
+static int64_t measurement_alarm_callback(alarm_id_t id, void *user_data){
+  dht20_t *dht = user_data;
+  if (dht->state == DHT20_WAIT_TRIGGER)
+    dht->state = DHT20_TRIGGER;
+  else if (dht->state == DHT20_CONVERTING)
+    dht->state = DHT20_READY;
+  __sev();
+  return 0; // one shot
+}
+
+/**
+  * Finishes the current measurement and reports it through the completion callback.
+  */
+static void finish_measurement(dht20_t *dht, int status){
+  dht->last_busy_us = dht->busy_us_accumulator;
+  dht->busy_us_accumulator = 0;
+  dht->next_trigger_time = make_timeout_time_ms(DHT20_TRIGGER_GAP_MS);
+  dht->state = DHT20_IDLE;
+  if (dht->callback)
+    dht->callback(dht, status, &dht->reading, dht->user_data);
+}
+
+/**
+  * Sends the trigger command and arms the conversion alarm.
+  */
+static void send_trigger(dht20_t *dht){
+  absolute_time_t start = get_absolute_time();
+  dht->trigger_time_us = to_us_since_boot(start);
+  int bytes_written = -1;
+  if (!select_sensor(dht))
+    bytes_written = i2c_write_blocking(dht->i2c, HARDWARE_ADDR, TRIGGER_MEASUREMENT, 3, 0);
+  dht->busy_us_accumulator += absolute_time_diff_us(start, get_absolute_time());
+
+  if (bytes_written < 1){
+    finish_measurement(dht, 1);
+    return;
+  }
+
+  dht->state = DHT20_CONVERTING;
+  if (add_alarm_in_ms(DHT20_CONVERSION_MS, measurement_alarm_callback, dht, true) < 0)
+    finish_measurement(dht, 1);
+}
+
+/**
+  * Reads status, data and CRC in a single transfer. If the sensor is still busy
+  * the conversion alarm is re-armed instead of spinning on the status byte.
+  */
+static void read_measurement(dht20_t *dht){
+  uint8_t raw_data[7];
+
+  absolute_time_t start = get_absolute_time();
+  int bytes_read = -1;
+  if (!select_sensor(dht))
+    bytes_read = i2c_read_blocking(dht->i2c, HARDWARE_ADDR, raw_data, 7, 0);
+  absolute_time_t end = get_absolute_time();
+  dht->busy_us_accumulator += absolute_time_diff_us(start, end);
+  dht->ready_time_us = to_us_since_boot(end);
+
+  if (bytes_read < 1){
+    finish_measurement(dht, 1);
+    return;
+  }
+
+  // Per datasheet, Bit[7] = 0 when the sensor has completed its reading
+  if (raw_data[0] >> 7){
+    dht->state = DHT20_CONVERTING;
+    if (add_alarm_in_ms(DHT20_POLL_RETRY_MS, measurement_alarm_callback, dht, true) < 0)
+      finish_measurement(dht, 1);
+    return;
+  }
+
+  finish_measurement(dht, convert_measurement(raw_data, &dht->reading));
+}
+
+/**
+  * Starts an asynchronous measurement. The trigger is sent once the 10ms gap
+  * required by the datasheet has passed and the result is read 80ms later by
+  * dht20_service(), which then calls the completion callback.
+  *
+  * @param  dht        The sensor to measure
+  * @param  callback   Called from dht20_service() with 0 and the reading on success, or 1 on error
+  * @param  user_data  Passed through to the callback
+  *
+  * Returns 0 if the measurement was started, or 1 if one is already in progress or
+  * dht20_init() rejected the sensor.
+  */
+int dht20_start_measurement(dht20_t *dht, dht20_callback_t callback, void *user_data){
+  if (dht->state != DHT20_IDLE || !dht->i2c)
+    return 1;
+
+  dht->callback = callback;
+  dht->user_data = user_data;
+
+  int64_t wait_us = absolute_time_diff_us(get_absolute_time(), dht->next_trigger_time);
+  if (wait_us > 0){
+    dht->state = DHT20_WAIT_TRIGGER;
+    if (add_alarm_in_us(wait_us, measurement_alarm_callback, dht, true) < 0){
+      dht->state = DHT20_IDLE;
+      return 1;
+    }
+  } else {
+    send_trigger(dht);
+  }
+  return 0;
+}
+
+/**
+  * Advances the measurement state machine of one sensor. Call from the main loop of the
+  * core that started the measurement; it returns immediately if there is nothing to do.
+  */
+void dht20_service(dht20_t *dht){
+  switch (dht->state){
+    case DHT20_TRIGGER:
+      send_trigger(dht);
+      break;
+    case DHT20_READY:
+      read_measurement(dht);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+  * Returns true while a measurement is in progress.
+  */
+bool dht20_busy(const dht20_t *dht){
+  return dht->state != DHT20_IDLE;
+}
+
+/**
+  * Returns the time in microseconds the last completed measurement spent on the I2C bus.
+  */
+uint32_t dht20_last_busy_us(const dht20_t *dht){
+  return dht->last_busy_us;
+}
+
+/**
+  * Returns when the last measurement was triggered and when its data was read, in
+  * microseconds since boot. Valid inside the completion callback.
+  */
+void dht20_last_stamps(const dht20_t *dht, uint64_t *trigger_us, uint64_t *ready_us){
+  *trigger_us = dht->trigger_time_us;
+  *ready_us = dht->ready_time_us;
+}
+
+typedef struct {
+  DHT20_Reading *reading;
+  volatile int status;
+} blocking_result_t;
+
+static void blocking_callback(dht20_t *dht, int status, const DHT20_Reading *reading, void *user_data){
+  blocking_result_t *result = user_data;
+  *result->reading = *reading;
+  result->status = status;
+}
+
+/**
+  * Blocking measurement kept for callers that have nothing else to do while the 
+  * sensor converts. Built on the asynchronous state machine.
+  *
+  * @param  dht                  The sensor to measure
+  * @param  current_measurement  The struct that is passed in to store the readings
+  *
+  * Returns 0 if successful, or 1 if there were any errors.
+  */
+int dht20_take_measurement(dht20_t *dht, DHT20_Reading *current_measurement){
+
+  blocking_result_t result = { current_measurement, 1 };
+  if (dht20_start_measurement(dht, blocking_callback, &result))
+    return 1;
+
+  while (dht20_busy(dht)){
+    __wfe();
+    dht20_service(dht);
+  }
+
+  return result.status;
+}
+
+#if DHT20_BENCHMARK
+/**
+  * Checks the fixed point conversion over every 20-bit count against an exact double
+  * precision reference (it must agree bit for bit), counts the codes where the previous
+  * float path rounds differently, and prints the average cycles per conversion of each.
+  */
+void dht20_benchmark(void){
+  const uint32_t codes = 1u << 20;
+  uint32_t fixed_mismatches = 0;
+  uint32_t float_mismatches = 0;
+  volatile float sink_f = 0;
+  volatile int32_t sink_i = 0;
+  DHT20_Reading reading;
+
+  for (uint32_t raw = 0; raw < codes; raw++){
+    dht20_convert_raw(raw, raw, &reading);
+
+    // doubles hold raw * 20000 exactly, so this is the correctly rounded result
+    int32_t exact_humidity = (int32_t)floor(raw * 10000.0 / codes + 0.5);
+    int32_t exact_temperature = (int32_t)floor(raw * 20000.0 / codes + 0.5) - 5000;
+    if (exact_humidity != reading.humidity_centi || exact_temperature != reading.temperature_centi_c)
+      fixed_mismatches++;
+
+    float denominator = pow(2, 20);
+    float humidity = (raw / denominator) * 100;
+    float temperature_c = (raw / denominator) * 200 - 50;
+    if ((int32_t)floorf(humidity * 100 + 0.5f) != exact_humidity || (int32_t)floorf(temperature_c * 100 + 0.5f) != exact_temperature)
+      float_mismatches++;
+  }
+
+  const uint32_t runs = 10000;
+  uint64_t start = time_us_64();
+  for (uint32_t raw = 0; raw < runs; raw++){
+    float denominator = pow(2, 20);
+    sink_f = ((raw * 97) / denominator) * 100;
+    sink_f = ((raw * 97) / denominator) * 200 - 50;
+  }
+  uint64_t float_us = time_us_64() - start;
+
+  start = time_us_64();
+  for (uint32_t raw = 0; raw < runs; raw++){
+    dht20_convert_raw(raw * 97, raw * 97, &reading);
+    sink_i = reading.temperature_centi_c;
+  }
+  uint64_t fixed_us = time_us_64() - start;
+  (void)sink_f;
+  (void)sink_i;
+
+  uint32_t mhz = clock_get_hz(clk_sys) / 1000000;
+  printf("DHT20 convert: float %llu cycles, fixed %llu cycles\r\n", float_us * mhz / runs, fixed_us * mhz / runs);
+  printf("DHT20 convert: fixed differs from exact on %lu/%lu codes, float on %lu\r\n",
+         (unsigned long)fixed_mismatches, (unsigned long)codes, (unsigned long)float_mismatches);
+}
+#endif
@@ -1,21 +1,79 @@
+#ifndef __DHT20_SENSOR_H__
+#define __DHT20_SENSOR_H__
+
 // Standard Libraries
 #include <stdint.h>
 #include <stdio.h>
 #include <inttypes.h>
 #include <math.h>
+#include "hardware/clocks.h"
+
+#include "../config.h"
 
 // Pico SDK
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "hardware/sync.h"
 
 #include "../data_flow/data_flow.h"
 
 // Structure definition moved to data_flow.h to avoid cyclical dependencies
 
-int setup_sensor(uint sensor_sda_pin, uint sensor_scl_pin, i2c_inst_t *channel);
+#define DHT20_NO_MUX 0   // mux_addr of a sensor wired straight to the bus
+
+typedef struct dht20 dht20_t;
+
+// Completion callback for asynchronous measurements, status is 0 on success or 1 on error
+typedef void (*dht20_callback_t)(dht20_t *dht, int status, const DHT20_Reading *reading, void *user_data);
+
+typedef enum {
+  DHT20_IDLE,
+  DHT20_WAIT_TRIGGER,   // waiting out the 10ms gap before sending 0xAC
+  DHT20_TRIGGER,        // gap elapsed, trigger command can be sent
+  DHT20_CONVERTING,     // trigger sent, waiting for the 80ms conversion
+  DHT20_READY,          // conversion time elapsed, status/data can be read
+} dht20_state_t;
+
+/**
+  * One DHT20, either wired to an I2C bus directly or behind one channel of a TCA9548A mux.
+  * Every sensor runs its own measurement state machine, so several can convert at once.
+  */
+struct dht20 {
+  i2c_inst_t *i2c;
+  uint8_t mux_addr;                     // TCA9548A address, or DHT20_NO_MUX
+  uint8_t mux_channel;                  // 0 - 7
+
+  volatile dht20_state_t state;
+  absolute_time_t next_trigger_time;    // earliest time the next 0xAC may be sent
+  dht20_callback_t callback;
+  void *user_data;
+  DHT20_Reading reading;
+  uint32_t last_busy_us;                // time spent on the bus for the last sample
+  uint32_t busy_us_accumulator;
+  uint64_t trigger_time_us;             // when the last trigger went out
+  uint64_t ready_time_us;               // when its data was read back
+};
+
+void dht20_bus_init(i2c_inst_t *i2c, uint sda_pin, uint scl_pin);
 
-int reset_sensor_register(uint8_t register_address);
+int dht20_init(dht20_t *dht, i2c_inst_t *i2c, uint8_t mux_addr, uint8_t mux_channel);
 
-int take_measurement(DHT20_Reading *current_measurement);
+int dht20_take_measurement(dht20_t *dht, DHT20_Reading *current_measurement);
+
+int dht20_start_measurement(dht20_t *dht, dht20_callback_t callback, void *user_data);
+
+void dht20_service(dht20_t *dht);
+
+bool dht20_busy(const dht20_t *dht);
+
+uint32_t dht20_last_busy_us(const dht20_t *dht);
+
+void dht20_last_stamps(const dht20_t *dht, uint64_t *trigger_us, uint64_t *ready_us);
 
 uint8_t calculate_crc8(uint8_t *data, int num_bytes);
+
+void dht20_convert_raw(uint32_t raw_humidity, uint32_t raw_temp, DHT20_Reading *current_measurement);
+
+void dht20_benchmark(void);
+
+#endif
@@ -1,6 +1,8 @@
 #include "hardware/lcd_i2c.h"
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
 #include <string.h>
 
 /**
@@ -13,17 +15,32 @@
 #define PIN_EN 0x04
 #define PIN_BL 0x08
 
+#define LCD_BYTES_PER_CHAR 6  // 2 nibbles x (data, EN high, EN low)
+#define LCD_BURST_CHARS 20    // longest run packed into one transaction
+
+static const uint8_t row_offsets[] = {0x00, 0x40, 0x14, 0x54};
+
 /**
  * Returns the backlight control bit based on the current backlight state
  */
 static inline uint8_t bl_mask(const lcd_i2c_t *lcd) { return lcd->backlight ? PIN_BL : 0; }
 
+/**
+ * Blocking write to the LCD, waits for any asynchronous flush to leave the bus first
+ */
+static void lcd_write(lcd_i2c_t *lcd, const uint8_t *buf, size_t len)
+{
+    while (lcd_i2c_flush_busy(lcd))
+        tight_loop_contents();
+    i2c_write_blocking((i2c_inst_t *)lcd->i2c, lcd->addr, buf, len, false);
+}
+
 /**
  * Sends a single byte to the LCD over the configured I2C bus
  */
 static void i2c_write_byte(lcd_i2c_t *lcd, uint8_t v)
 {
-    i2c_write_blocking((i2c_inst_t *)lcd->i2c, lcd->addr, &v, 1, false);
+    lcd_write(lcd, &v, 1);
 }
 
 /**
@@ -42,17 +59,56 @@ static void pulse_enable(lcd_i2c_t *lcd, uint8_t data)
  */
 static void write4(lcd_i2c_t *lcd, uint8_t nibble, uint8_t rs)
 {
+    // blocking writes bypass the shadow framebuffer, the next frame is redrawn in full
+    lcd->shadow_valid = false;
+    lcd->cursor_valid = false;
+
     uint8_t data = (nibble & 0xF0) | bl_mask(lcd) | (rs ? PIN_RS : 0);
     i2c_write_byte(lcd, data);
     pulse_enable(lcd, data);
 }
 
+/**
+ * Appends the three expander bytes for one nibble (data, EN high, EN low) to buf
+ * The EN pulse width and the gap between nibbles come from the I2C byte time, which
+ * is well above the HD44780 minimums at 100 kHz and 400 kHz
+ */
+static uint8_t *pack_nibble(const lcd_i2c_t *lcd, uint8_t *buf, uint8_t nibble, uint8_t rs)
+{
+    uint8_t data = (nibble & 0xF0) | bl_mask(lcd) | (rs ? PIN_RS : 0);
+    *buf++ = data;
+    *buf++ = data | PIN_EN;
+    *buf++ = data & ~PIN_EN;
+    return buf;
+}
+
+/**
+ * Appends both nibbles of an 8-bit value to buf
+ */
+static uint8_t *pack_byte(const lcd_i2c_t *lcd, uint8_t *buf, uint8_t value, uint8_t rs)
+{
+    buf = pack_nibble(lcd, buf, value & 0xF0, rs);
+    return pack_nibble(lcd, buf, (value << 4) & 0xF0, rs);
+}
+
 /**
  * Sends a 8-bit value to the LCD using two 4-bit transfers
  * RS selects whether this is a command (0) or data (1)
+ * In burst mode both nibbles go out as a single 6 byte I2C transaction
  */
 static void lcd_send(lcd_i2c_t *lcd, uint8_t value, uint8_t rs)
 {
+    if (lcd->burst)
+    {
+        lcd->shadow_valid = false;
+        lcd->cursor_valid = false;
+
+        uint8_t buf[LCD_BYTES_PER_CHAR];
+        pack_byte(lcd, buf, value, rs);
+        lcd_write(lcd, buf, sizeof(buf));
+        sleep_us(50);
+        return;
+    }
     write4(lcd, value & 0xF0, rs);
     write4(lcd, (value << 4) & 0xF0, rs);
 }
@@ -98,6 +154,14 @@ void lcd_i2c_init(lcd_i2c_t *lcd, void *i2c_inst, uint8_t addr, uint8_t cols, ui
     lcd->cols = cols;
     lcd->rows = rows;
     lcd->backlight = true;
+    lcd->burst = true;
+    lcd->tx_len = 0;
+    lcd->flushing = false;
+    lcd->flush_callback = NULL;
+    lcd->dma_chan = dma_claim_unused_channel(true);
+    lcd->shadow_valid = false;
+    lcd->cursor_valid = false;
+    memset(&lcd->stats, 0, sizeof(lcd->stats));
 
     sleep_ms(50);
 
@@ -149,7 +213,6 @@ void lcd_i2c_home(lcd_i2c_t *lcd)
  */
 void lcd_i2c_set_cursor(lcd_i2c_t *lcd, uint8_t col, uint8_t row)
 {
-    static const uint8_t row_offsets[] = {0x00, 0x40, 0x14, 0x54};
     if (row >= lcd->rows)
         row = 0;
     lcd_cmd(lcd, 0x80 | (col + row_offsets[row]));
@@ -165,11 +228,38 @@ void lcd_i2c_write_char(lcd_i2c_t *lcd, char c)
 
 /**
  * Writes a string starting at the current cursor position
+ * In burst mode runs of up to LCD_BURST_CHARS characters are packed into one I2C transaction
  */
 void lcd_i2c_write_str(lcd_i2c_t *lcd, const char *s)
 {
+    if (!lcd->burst)
+    {
+        while (*s)
+            lcd_data(lcd, (uint8_t)*s++);
+        return;
+    }
+
+    lcd->shadow_valid = false;
+    lcd->cursor_valid = false;
+
+    uint8_t buf[LCD_BURST_CHARS * LCD_BYTES_PER_CHAR];
     while (*s)
-        lcd_data(lcd, (uint8_t)*s++);
+    {
+        uint8_t *p = buf;
+        for (int n = 0; n < LCD_BURST_CHARS && *s; n++)
+            p = pack_byte(lcd, p, (uint8_t)*s++, 1);
+        lcd_write(lcd, buf, p - buf);
+    }
+    sleep_us(50);
+}
+
+/**
+ * Selects between one I2C transaction per expander byte (off) and packed
+ * multi-byte transactions (on)
+ */
+void lcd_i2c_set_burst(lcd_i2c_t *lcd, bool on)
+{
+    lcd->burst = on;
 }
 
 /**
@@ -198,4 +288,229 @@ void lcd_create_char( lcd_i2c_t *lcd, uint8_t location, uint8_t *charmap){
     lcd_cmd(lcd, 0x40 | (location << 3));
     for (int i=0; i<8;i++)
         lcd_i2c_write_char(lcd, charmap[i]);
-}
\ No newline at end of file
+}
+
+// ********** Asynchronous flush **********
+//
+// Frames are built with lcd_i2c_queue_*() into lcd->tx_buf, then lcd_i2c_flush_async()
+// converts them to IC_DATA_CMD words and lets a DMA channel feed the I2C TX FIFO.
+// Only one LCD can be flushing at a time; it is tracked for the DMA interrupt.
+
+static lcd_i2c_t *flushing_lcd;
+
+/**
+ * DMA completion handler, runs once the last word has been moved into the I2C TX FIFO
+ */
+static void lcd_dma_irq_handler(void)
+{
+    lcd_i2c_t *lcd = flushing_lcd;
+    if (!lcd || !dma_channel_get_irq0_status(lcd->dma_chan))
+        return;
+
+    dma_channel_acknowledge_irq0(lcd->dma_chan);
+    lcd->flushing = false;
+    if (lcd->flush_callback)
+        lcd->flush_callback(lcd->flush_user_data);
+}
+
+/**
+ * Discards any queued but unflushed bytes
+ */
+void lcd_i2c_begin_frame(lcd_i2c_t *lcd)
+{
+    lcd->tx_len = 0;
+}
+
+/**
+ * Appends an 8-bit value to the frame, returns false if it does not fit
+ */
+static bool queue_byte(lcd_i2c_t *lcd, uint8_t value, uint8_t rs)
+{
+    if (lcd->tx_len + LCD_BYTES_PER_CHAR > LCD_TX_BUF_LEN)
+        return false;
+    pack_byte(lcd, lcd->tx_buf + lcd->tx_len, value, rs);
+    lcd->tx_len += LCD_BYTES_PER_CHAR;
+    return true;
+}
+
+/**
+ * Queues a cursor move to the given column and row
+ */
+bool lcd_i2c_queue_cursor(lcd_i2c_t *lcd, uint8_t col, uint8_t row)
+{
+    if (row >= lcd->rows)
+        row = 0;
+    return queue_byte(lcd, 0x80 | (col + row_offsets[row]), 0);
+}
+
+/**
+ * Queues a string at the current cursor position
+ */
+bool lcd_i2c_queue_str(lcd_i2c_t *lcd, const char *s)
+{
+    while (*s)
+    {
+        if (!queue_byte(lcd, (uint8_t)*s++, 1))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Queues only the cells of frame that differ from the shadow of the glass
+ * frame holds rows * cols characters, row by row, without terminators
+ * Changed cells are grouped into runs; a single unchanged cell between two runs is
+ * rewritten because it costs the same as the cursor command that would skip it
+ *
+ * Returns true if anything was queued
+ */
+bool lcd_i2c_queue_frame(lcd_i2c_t *lcd, const char *frame)
+{
+    uint16_t start_len = lcd->tx_len;
+    uint32_t cells = 0;
+
+    for (uint8_t row = 0; row < lcd->rows; row++)
+    {
+        const char *line = frame + row * lcd->cols;
+        char *glass = lcd->shadow[row];
+
+        uint8_t col = 0;
+        while (col < lcd->cols)
+        {
+            if (lcd->shadow_valid && line[col] == glass[col])
+            {
+                col++;
+                continue;
+            }
+
+            // extend the run over changed cells and single-cell gaps
+            uint8_t end = col + 1;
+            while (end < lcd->cols)
+            {
+                if (!lcd->shadow_valid || line[end] != glass[end])
+                    end++;
+                else if (end + 1 < lcd->cols && line[end + 1] != glass[end + 1])
+                    end += 2;
+                else
+                    break;
+            }
+
+            uint8_t addr = col + row_offsets[row];
+            if (!lcd->cursor_valid || lcd->cursor_addr != addr)
+            {
+                if (!queue_byte(lcd, 0x80 | addr, 0))
+                    goto overflow;
+            }
+            for (uint8_t c = col; c < end; c++)
+            {
+                if (!queue_byte(lcd, (uint8_t)line[c], 1))
+                    goto overflow;
+                glass[c] = line[c];
+            }
+            lcd->cursor_addr = addr + (end - col);
+            lcd->cursor_valid = true;
+            cells += end - col;
+            col = end;
+        }
+    }
+    lcd->shadow_valid = true;
+
+    uint32_t sent = lcd->tx_len - start_len;
+    uint32_t full = (uint32_t)lcd->rows * (lcd->cols + 1) * LCD_BYTES_PER_CHAR;
+    lcd->stats.frames++;
+    lcd->stats.cells_written += cells;
+    lcd->stats.bytes_sent += sent;
+    lcd->stats.bytes_saved += (full > sent) ? full - sent : 0;
+    return sent > 0;
+
+overflow:
+    // partially queued frame, redraw everything next time
+    lcd->shadow_valid = false;
+    lcd->cursor_valid = false;
+    return lcd->tx_len > start_len;
+}
+
+/**
+ * Returns the shadow framebuffer counters
+ */
+const lcd_i2c_stats_t *lcd_i2c_get_stats(const lcd_i2c_t *lcd)
+{
+    return &lcd->stats;
+}
+
+/**
+ * Starts sending the queued frame through DMA and returns immediately
+ * The callback runs in interrupt context once the whole frame is in the I2C TX FIFO,
+ * lcd_i2c_flush_busy() stays true until the FIFO has drained onto the bus
+ *
+ * @param lcd       Pointer to lcd_i2c_t
+ * @param callback  Optional completion callback
+ * @param user_data Passed through to the callback
+ *
+ * Returns false if a flush is already in flight or the frame is empty
+ */
+bool lcd_i2c_flush_async(lcd_i2c_t *lcd, void (*callback)(void *), void *user_data)
+{
+    if (lcd->tx_len == 0 || lcd_i2c_flush_busy(lcd))
+        return false;
+
+    i2c_inst_t *i2c = (i2c_inst_t *)lcd->i2c;
+
+    // Low byte is the data, the last word also carries STOP
+    for (uint16_t i = 0; i < lcd->tx_len; i++)
+        lcd->dma_buf[i] = lcd->tx_buf[i];
+    lcd->dma_buf[lcd->tx_len - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    // Target address can only change while the block is disabled
+    i2c->hw->enable = 0;
+    i2c->hw->tar = lcd->addr;
+    i2c->hw->enable = 1;
+
+    if (flushing_lcd != lcd)
+    {
+        if (!flushing_lcd)
+        {
+            irq_add_shared_handler(DMA_IRQ_0, lcd_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+            irq_set_enabled(DMA_IRQ_0, true);
+        }
+        flushing_lcd = lcd;
+        dma_channel_set_irq0_enabled(lcd->dma_chan, true);
+    }
+
+    lcd->flush_callback = callback;
+    lcd->flush_user_data = user_data;
+    lcd->flushing = true;
+
+    dma_channel_config c = dma_channel_get_default_config(lcd->dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(i2c, true));
+    dma_channel_configure(lcd->dma_chan, &c, &i2c->hw->data_cmd, lcd->dma_buf, lcd->tx_len, true);
+
+    lcd->tx_len = 0;
+    return true;
+}
+
+/**
+ * Returns true while a flush is in flight, including bytes still in the I2C TX FIFO
+ * A NACK from the backpack aborts the flush and clears the abort so the bus can be reused
+ */
+bool lcd_i2c_flush_busy(lcd_i2c_t *lcd)
+{
+    i2c_inst_t *i2c = (i2c_inst_t *)lcd->i2c;
+
+    if (i2c->hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS)
+    {
+        dma_channel_abort(lcd->dma_chan);
+        (void)i2c->hw->clr_tx_abrt;
+        lcd->flushing = false;
+        lcd->shadow_valid = false; // glass content is unknown after a partial frame
+        lcd->cursor_valid = false;
+        return false;
+    }
+
+    if (lcd->flushing || dma_channel_is_busy(lcd->dma_chan))
+        return true;
+    return !(i2c->hw->status & I2C_IC_STATUS_TFE_BITS) || (i2c->hw->status & I2C_IC_STATUS_ACTIVITY_BITS);
+}
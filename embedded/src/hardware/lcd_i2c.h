@@ -2,6 +2,21 @@
 #include <stdint.h>
 #include <stdbool.h>
 #define LCD_CHAR_DEGREE 1
+#define LCD_MAX_COLS 20
+#define LCD_MAX_ROWS 4
+#define LCD_TX_BUF_LEN 512 // expander bytes per asynchronous frame, 6 per character or command, fits a full 20x4 redraw
+
+/**
+ * Counters for the shadow framebuffer, bytes_saved is measured against redrawing
+ * every cell with one cursor command per row
+ */
+typedef struct
+{
+    uint32_t frames;
+    uint32_t cells_written;
+    uint32_t bytes_sent;
+    uint32_t bytes_saved;
+} lcd_i2c_stats_t;
 
 /**
  * LCD context used by the I2C driver
@@ -12,16 +27,42 @@ typedef struct
     void *i2c; 
     uint8_t addr;
     bool backlight;
+    bool burst; // pack each character (or run of characters) into a single I2C write
     uint8_t cols;
     uint8_t rows;
+
+    // asynchronous flush state
+    uint8_t tx_buf[LCD_TX_BUF_LEN];   // queued expander bytes
+    uint16_t tx_len;
+    uint16_t dma_buf[LCD_TX_BUF_LEN]; // tx_buf as IC_DATA_CMD words for the DMA channel
+    int dma_chan;
+    volatile bool flushing;
+    void (*flush_callback)(void *user_data);
+    void *flush_user_data;
+
+    // shadow of what is currently on the glass, used to send only changed cells
+    char shadow[LCD_MAX_ROWS][LCD_MAX_COLS];
+    bool shadow_valid;
+    uint8_t cursor_addr; // DDRAM address the next character lands on
+    bool cursor_valid;
+    lcd_i2c_stats_t stats;
 } lcd_i2c_t;
 
 void lcd_i2c_init(lcd_i2c_t *lcd, void *i2c_inst, uint8_t addr, uint8_t cols, uint8_t rows);
 void lcd_i2c_set_backlight(lcd_i2c_t *lcd, bool on);
+void lcd_i2c_set_burst(lcd_i2c_t *lcd, bool on);
 void lcd_i2c_clear(lcd_i2c_t *lcd);
 void lcd_i2c_home(lcd_i2c_t *lcd);
 void lcd_i2c_set_cursor(lcd_i2c_t *lcd, uint8_t col, uint8_t row);
 void lcd_i2c_write_str(lcd_i2c_t *lcd, const char *s);
 void lcd_i2c_write_char(lcd_i2c_t *lcd, char c);
 void lcd_create_char( lcd_i2c_t *lcd, uint8_t location, uint8_t *charmap);
-extern uint8_t degree_symbol[8];
\ No newline at end of file
+extern uint8_t degree_symbol[8];
+
+void lcd_i2c_begin_frame(lcd_i2c_t *lcd);
+bool lcd_i2c_queue_cursor(lcd_i2c_t *lcd, uint8_t col, uint8_t row);
+bool lcd_i2c_queue_str(lcd_i2c_t *lcd, const char *s);
+bool lcd_i2c_queue_frame(lcd_i2c_t *lcd, const char *frame);
+const lcd_i2c_stats_t *lcd_i2c_get_stats(const lcd_i2c_t *lcd);
+bool lcd_i2c_flush_async(lcd_i2c_t *lcd, void (*callback)(void *), void *user_data);
+bool lcd_i2c_flush_busy(lcd_i2c_t *lcd);
\ No newline at end of file
@@ -1,38 +1,137 @@
 #include "photores.h"
+#include "photores_filter.h"
 
-#define ADC_MAX 29
-#define ADC_MIN 26
+#define ADC_GPIO_MAX 29
+#define ADC_GPIO_MIN 26
 #define ADC_OFFSET 26 // pins 26 - 29 are ADC pins on the pico
 // ADC 0 - gpio 26
 // ADC 1 - gpio 27
 // ADC 2 - gpio 28
 // ADC 3 - gpio 29
 
+#define ADC_CLOCK_HZ 48000000 // ADC runs from the 48 MHz USB PLL, one conversion is 96 cycles
+
+// File scope globals
+static uint16_t Capture_Buffer[PHOTO_OVERSAMPLE];   // filled by DMA from the ADC FIFO
+static int Capture_Dma_Chan = -1;
+static Photo_Reading Last_Reading;                   // result of the last completed capture
+
 /**
  * Initializes photoresistor pin for ADC sampling
+ * Sets up the ADC FIFO and a DMA channel for free-running capture and starts the first one
  */
 void Photoresistor_Init(uint gpio_pin){
     // Initialize hardware
     adc_init();
     adc_gpio_init(gpio_pin);
     adc_select_input(gpio_pin - ADC_OFFSET);
+
+    // FIFO on, DREQ at 1 sample, no error bit, keep all 12 bits
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_set_clkdiv((float)ADC_CLOCK_HZ / PHOTO_SAMPLE_RATE_HZ - 1);
+
+    Capture_Dma_Chan = dma_claim_unused_channel(true);
+    Photoresistor_Start_Capture();
+}
+
+/**
+ * Starts a capture of PHOTO_OVERSAMPLE samples, the ADC paces the DMA so the CPU is not involved
+ */
+void Photoresistor_Start_Capture(void){
+    adc_run(false);
+    adc_fifo_drain();
+
+    dma_channel_config c = dma_channel_get_default_config(Capture_Dma_Chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_dreq(&c, DREQ_ADC);
+    dma_channel_configure(Capture_Dma_Chan, &c, Capture_Buffer, &adc_hw->fifo, PHOTO_OVERSAMPLE, true);
+
+    adc_run(true);
+}
+
+/**
+ * Decimates the last completed capture into out and starts the next one
+ * Returns false (and the previous result) if the capture is still in progress
+ */
+bool Photoresistor_Collect(Photo_Reading *out){
+    if (Capture_Dma_Chan < 0 || dma_channel_is_busy(Capture_Dma_Chan)){
+        *out = Last_Reading;
+        return false;
+    }
+    adc_run(false);
+
+    uint32_t variance;
+    uint16_t mean;
+    Photo_Filter_Mean(Capture_Buffer, PHOTO_OVERSAMPLE, &mean, &variance);
+#if PHOTO_FILTER_MEDIAN
+    uint16_t scratch[PHOTO_OVERSAMPLE];
+    Last_Reading.value = Photo_Filter_Median(Capture_Buffer, PHOTO_OVERSAMPLE, scratch);
+#else
+    Last_Reading.value = mean;
+#endif
+    Last_Reading.variance = variance;
+
+    Photoresistor_Start_Capture();
+    *out = Last_Reading;
+    return true;
 }
 
 /**
  * Takes gpio pin as input
- * returns the current ADC reading for that pin
+ * returns the filtered ADC reading for that pin
  */
 uint16_t Get_Photo_Resistor_Data(uint gpio_pin){
 
     // Validate input
-    if (gpio_pin < ADC_MIN || gpio_pin > ADC_MAX)
+    if (gpio_pin < ADC_GPIO_MIN || gpio_pin > ADC_GPIO_MAX)
         return 0;
 
-    // Select pin if needed
+    // Select pin if needed, the next capture will use it
     uint current_input = adc_get_selected_input();
     if(current_input != gpio_pin - ADC_OFFSET)
         adc_select_input(gpio_pin - ADC_OFFSET);
 
-    // Return read of photoresistor
-    return adc_read();
-}
\ No newline at end of file
+    Photo_Reading reading;
+    Photoresistor_Collect(&reading);
+    return reading.value;
+}
+
+#if PHOTO_BENCHMARK
+/**
+ * Times the decimation kernels on a synthetic noisy block and prints cycles per block
+ */
+void Photoresistor_Benchmark(void){
+    uint16_t samples[PHOTO_OVERSAMPLE];
+    uint16_t scratch[PHOTO_OVERSAMPLE];
+    uint32_t seed = 12345;
+    for (int i = 0; i < PHOTO_OVERSAMPLE; i++){
+        seed = seed * 1664525u + 1013904223u;
+        samples[i] = 2000 + ((seed >> 24) & 0x3F) - 32;
+    }
+
+    const uint32_t runs = 1000;
+    volatile uint32_t sink = 0;
+    uint16_t mean;
+    uint32_t variance;
+
+    uint64_t start = time_us_64();
+    for (uint32_t i = 0; i < runs; i++){
+        Photo_Filter_Mean(samples, PHOTO_OVERSAMPLE, &mean, &variance);
+        sink += mean + variance;
+    }
+    uint64_t mean_us = time_us_64() - start;
+
+    start = time_us_64();
+    for (uint32_t i = 0; i < runs; i++)
+        sink += Photo_Filter_Median(samples, PHOTO_OVERSAMPLE, scratch);
+    uint64_t median_us = time_us_64() - start;
+    (void)sink;
+
+    uint32_t mhz = clock_get_hz(clk_sys) / 1000000;
+    printf("Photo filter (%d samples): mean+variance %llu cycles, median %llu cycles\r\n",
+           PHOTO_OVERSAMPLE, mean_us * mhz / runs, median_us * mhz / runs);
+    printf("Photo filter: mean %u variance %lu\r\n", mean, (unsigned long)variance);
+}
+#endif
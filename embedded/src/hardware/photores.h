@@ -3,20 +3,46 @@
 
 // Standard Library
 #include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
 
 // Pico SDK
 #include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/clocks.h"
+
+#include "../config.h"
+
+/**
+ * Filtered photoresistor reading from one oversampled capture
+ */
+typedef struct {
+    uint16_t value;     // decimated ADC counts (mean or median, see PHOTO_FILTER_MEDIAN)
+    uint32_t variance;  // population variance of the capture (divided by N) in counts squared
+} Photo_Reading;
 
 /**
  * Initializes ADC pin for ADC sampling
  */
 void Photoresistor_Init(uint gpio_pin);
 
+/**
+ * Starts a DMA driven capture of PHOTO_OVERSAMPLE samples
+ */
+void Photoresistor_Start_Capture(void);
+
+/**
+ * Decimates the last capture and starts the next one
+ * returns false if the capture was still running (out holds the previous result)
+ */
+bool Photoresistor_Collect(Photo_Reading *out);
 
 /**
  * Takes gpio pin as input
- * returns the current ADC reading for that pin
+ * returns the filtered ADC reading for that pin
  */
 uint16_t Get_Photo_Resistor_Data(uint gpio_pin);
 
-#endif
\ No newline at end of file
+void Photoresistor_Benchmark(void);
+
+#endif
@@ -0,0 +1,49 @@
+#include "photores_filter.h"
+
+/**
+ * Mean and population variance of n samples using integer sums only
+ * variance = (n * sum(x^2) - sum(x)^2) / n^2, rounded to nearest
+ */
+void Photo_Filter_Mean(const uint16_t *samples, uint32_t n, uint16_t *mean, uint32_t *variance){
+    if (n == 0){
+        *mean = 0;
+        *variance = 0;
+        return;
+    }
+
+    uint32_t sum = 0;
+    uint32_t sum_sq = 0;
+    for (uint32_t i = 0; i < n; i++){
+        uint32_t x = samples[i] & 0x0FFF; // 12-bit result, upper bits are the error flag when enabled
+        sum += x;
+        sum_sq += x * x;
+    }
+
+    uint64_t n_sq = (uint64_t)n * n;
+    uint64_t spread = (uint64_t)n * sum_sq - (uint64_t)sum * sum;
+    *mean = (uint16_t)((sum + n / 2) / n);
+    *variance = (uint32_t)((spread + n_sq / 2) / n_sq);
+}
+
+/**
+ * Median of n samples with an insertion sort into scratch
+ * n is a small block size (tens of samples), where this beats a selection algorithm
+ */
+uint16_t Photo_Filter_Median(const uint16_t *samples, uint32_t n, uint16_t *scratch){
+    if (n == 0)
+        return 0;
+
+    for (uint32_t i = 0; i < n; i++){
+        uint16_t x = samples[i] & 0x0FFF;
+        uint32_t j = i;
+        while (j > 0 && scratch[j - 1] > x){
+            scratch[j] = scratch[j - 1];
+            j--;
+        }
+        scratch[j] = x;
+    }
+
+    if (n & 1)
+        return scratch[n / 2];
+    return (uint16_t)((scratch[n / 2 - 1] + scratch[n / 2] + 1) / 2);
+}
@@ -0,0 +1,23 @@
+#ifndef __PHOTORES_FILTER_H_
+#define __PHOTORES_FILTER_H_
+
+// Standard Library
+#include <stdint.h>
+
+/**
+ * Decimation kernels for a block of raw 12-bit ADC samples
+ * Pure C with no SDK dependencies so they can be benchmarked anywhere
+ */
+
+/**
+ * Mean and population variance of n samples, in ADC counts and counts squared
+ * n must be <= 256 so the sum of squares fits in 32 bits
+ */
+void Photo_Filter_Mean(const uint16_t *samples, uint32_t n, uint16_t *mean, uint32_t *variance);
+
+/**
+ * Median of n samples, scratch must hold n values; samples are left untouched
+ */
+uint16_t Photo_Filter_Median(const uint16_t *samples, uint32_t n, uint16_t *scratch);
+
+#endif
@@ -11,6 +11,10 @@
 #include "pico/multicore.h"
 #include "hardware/gpio.h"
 #include "hardware/sync.h"
+#include "hardware/irq.h"
+#if LIB_PICO_STDIO_USB
+#include "tusb.h"
+#endif
 
 // User Modules
 #include "hardware/buttons.h"
@@ -18,7 +22,14 @@
 #include "hardware/photores.h"
 #include "hardware/dht20_sensor.h"
 #include "data_flow/data_flow.h" // data types shared between main and core1
+#include "data_flow/event_queue.h"
+#include "data_flow/latency.h"
+#include "data_flow/telemetry.h"
 #include "core1/core1.h"
+#include "core1/rolling_stats.h"
+#include "storage/flash_log.h"
+#include "storage/history.h"
+#include "network/uplink.h"
 #include "ui/lcd_screens.h"
 #include "ui/led_ui.h"
 
@@ -36,6 +47,10 @@ bool system_timer_callback(struct repeating_timer *);
 void Clear_Button_Flags(void);
 bool ADC_New(void);
 bool DHT20_New(void);
+void FIFO_Handler(void);
+void Arm_Render_Deadline(void);
+void Send_Counters(void);
+bool Core0_Quiet(void);
 
 // ********** State Machine **********
 
@@ -47,6 +62,7 @@ typedef enum
   Normal_F,
   Normal_C,
   Photores,
+  Stats_24h,
 } State;
 
 // Function Prototypes
@@ -55,6 +71,7 @@ State Loading_State(void);
 State Normal_F_State(void);
 State Normal_C_State(void);
 State Photores_State(void);
+State Stats_24h_State(void);
 
 typedef State (*stateHandler)(void); // function pointer
 
@@ -63,7 +80,8 @@ stateHandler StateTable[] = {
     Loading_State,
     Normal_F_State,
     Normal_C_State,
-    Photores_State};
+    Photores_State,
+    Stats_24h_State};
 
 State Get_Corresponding_Screen(State *screens);
 
@@ -72,17 +90,57 @@ volatile Payload_Data Sensor_Data_Copy;
 volatile Payload_Data Sensor_Data_Copy_Old;
 volatile bool Data_Ready_Flag = false;
 volatile bool Force_Render_Flag = false;
+Stats_Summary Stats_Copy;        // rolling windows published by core1 with the newest sample
+bool Stats_Ready = false;        // Stats_Copy holds at least one sample
 
 /*********** Main **********/
+/**
+ * Runs the state machine once per event and sleeps in between
+ * A state change runs the new state right away so it can render on entry
+ */
 int main(void)
 {
   State current = Init;
   while (1)
   {
-    current = StateTable[current]();
+    State next = StateTable[current]();
+    ui_lcd_service(); // start any frame that was waiting on the previous LCD flush
+    if (ui_lcd_busy())
+      Arm_Render_Deadline();
+    #if TELEMETRY
+      Telemetry_Service();
+    #endif
+
+    if (next != current)
+    {
+      current = next;
+      continue;
+    }
+    Flash_Log_Set_Quiet(Core0_Quiet()); // a flash log erase parks core0 only while this holds
+    Event event = Event_Wait();
+    Flash_Log_Set_Quiet(false);
+    #if TELEMETRY
+      Telemetry_Event(event, current);
+    #endif
   }
 }
 
+/**
+ * True when nothing on core0 is mid transfer: no LCD flush, no uplink post and no telemetry
+ * waiting in the USB buffer
+ */
+bool Core0_Quiet(void)
+{
+  bool quiet = !ui_lcd_busy();
+  #if UPLINK
+    quiet = quiet && !Uplink_Busy();
+  #endif
+  #if LIB_PICO_STDIO_USB
+    quiet = quiet && tud_cdc_write_available() == CFG_TUD_CDC_TX_BUFSIZE;
+  #endif
+  return quiet;
+}
+
 /*********** Initial State **********/
 State Init_State(void)
 {
@@ -109,6 +167,30 @@ State Init_State(void)
     printf("Current State is: Init\r\n");
   #endif
 
+  #if LCD_BENCHMARK
+    ui_lcd_benchmark();
+  #endif
+
+  #if DHT20_BENCHMARK
+    dht20_benchmark();
+  #endif
+
+  #if PHOTO_BENCHMARK
+    Photoresistor_Benchmark();
+  #endif
+
+  // Flash log, before core1 starts so recovery reads the region undisturbed
+  if (!Flash_Log_Init())
+  {
+  #if DEBUG
+      printf("ERROR: FLASH LOG REGION OVERLAPS FIRMWARE\r\n");
+  #endif
+  }
+
+  #if HISTORY_BENCHMARK
+    History_Benchmark(); // replays the flash log when it holds samples
+  #endif
+
   // System Timer
   static struct repeating_timer timer;
   add_repeating_timer_ms(SYS_TIMER, system_timer_callback, NULL, &timer);
@@ -120,11 +202,28 @@ State Init_State(void)
   Button_Init(Button_Array, NUM_BUTTONS);
   GPIO_Interrupt_Init(GPIO_Handler);
 
+  // Core1 doorbells wake Core0 through the FIFO interrupt
+  multicore_fifo_drain();
+  multicore_fifo_clear_irq();
+  irq_set_exclusive_handler(SIO_FIFO_IRQ_NUM(0), FIFO_Handler);
+  irq_set_enabled(SIO_FIFO_IRQ_NUM(0), true);
+
   // LED Array
   LED_Array_Init(Led_Pins, LED_LENGTH);
 
-  // initialize dht20_sensor
-  if (setup_sensor(SENSOR_I2C_SDA, SENSOR_I2C_SCL, SENSOR_I2C_CHANNEL))
+  // Wi-Fi uplink, joins in the background and never holds up sampling
+  #if UPLINK
+    if (!Uplink_Init())
+    {
+    #if DEBUG
+        printf("UPLINK DISABLED: NO WI-FI\r\n");
+    #endif
+    }
+  #endif
+
+  // initialize the DHT20 sensors, their bus is their own
+  dht20_bus_init(SENSOR_I2C_CHANNEL, SENSOR_I2C_SDA, SENSOR_I2C_SCL);
+  if (Sensors_Init())
   {
   // TODO: error handling here
   #if DEBUG
@@ -145,8 +244,9 @@ State Loading_State(void)
     sleep_ms(2000);
   #endif
 
-  while (!Data_Ready_Flag) // Spin until a packet is received
-    Refresh_Data();
+  Refresh_Data();
+  if (!Data_Ready_Flag) // Stay here until the first packet is received
+    return Loading;
 
   Force_Render_Flag = true;
   return Normal_F;
@@ -164,12 +264,12 @@ State Normal_F_State(void)
   if ((Data_Ready_Flag && DHT20_New()) || Force_Render_Flag)
   {
     #if DEBUG
-        printf("DHT20 Sensor Data Validity: %d\tTemp (F) is: %f\r\n", Sensor_Data_Copy.DHT20_Data_Valid, Sensor_Data_Copy.DHT20_Data.temperature_f);
+        printf("DHT20 Sensor Data Validity: %d\tTemp (centi-F) is: %ld\r\n", Sensor_Data_Copy.DHT20_Data_Valid, (long)Centi_C_To_Centi_F(Sensor_Data_Copy.DHT20_Data.temperature_centi_c));
     #endif
     // Display LCD Data
     ui_show_dht20_f((const Payload_Data *)&Sensor_Data_Copy);
     // Display LED Data
-    Display_Humidity_LED(Sensor_Data_Copy.DHT20_Data.humidity);
+    Display_Humidity_LED(Sensor_Data_Copy.DHT20_Data.humidity_centi);
     Sensor_Data_Copy_Old = Sensor_Data_Copy;
     Data_Ready_Flag = false;
     Force_Render_Flag = false;
@@ -208,7 +308,7 @@ State Normal_C_State(void)
     // Display LCD Data
     ui_show_dht20_c((const Payload_Data *)&Sensor_Data_Copy);
     // Display LED Data
-    Display_Humidity_LED(Sensor_Data_Copy.DHT20_Data.humidity);
+    Display_Humidity_LED(Sensor_Data_Copy.DHT20_Data.humidity_centi);
     Sensor_Data_Copy_Old = Sensor_Data_Copy;
     Data_Ready_Flag = false;
     Force_Render_Flag = false;
@@ -247,7 +347,7 @@ State Photores_State(void)
     // Display LCD Data
     ui_show_photores((const Payload_Data *)&Sensor_Data_Copy);
     // Display LED Data
-    Display_Humidity_LED(Sensor_Data_Copy.DHT20_Data.humidity);
+    Display_Humidity_LED(Sensor_Data_Copy.DHT20_Data.humidity_centi);
     Sensor_Data_Copy_Old = Sensor_Data_Copy;
     Data_Ready_Flag = false;
     Force_Render_Flag = false;
@@ -261,6 +361,45 @@ State Photores_State(void)
       Photores,
       Normal_F,
       Normal_F,
+      Stats_24h,
+  };
+  State return_val = Get_Corresponding_Screen(return_vals);
+
+  Clear_Button_Flags();
+  if (return_val != return_vals[0])
+    Force_Render_Flag = true; // allow next state to render on entry
+
+  return return_val;
+}
+
+/*********** 24 h Range **********/
+State Stats_24h_State(void)
+{
+  #if DEBUG
+    printf("Current State is: Stats_24h\r\n");
+    sleep_ms(2000);
+  #endif
+  Refresh_Data();
+
+  if (Data_Ready_Flag || Force_Render_Flag)
+  {
+    // Display LCD Data, the 24 h window from core1's rolling stats
+    ui_show_stats(Stats_Ready ? &Stats_Copy : NULL, STATS_WINDOW_24H);
+    // Display LED Data
+    Display_Humidity_LED(Sensor_Data_Copy.DHT20_Data.humidity_centi);
+    Sensor_Data_Copy_Old = Sensor_Data_Copy;
+    Data_Ready_Flag = false;
+    Force_Render_Flag = false;
+  }
+
+  // [0] - default
+  // [1] - button 0
+  // [2] - button 1
+  // [3] - button 2
+  State return_vals[NUM_BUTTONS + 1] = {
+      Stats_24h,
+      Normal_F,
+      Normal_F,
       Photores,
   };
   State return_val = Get_Corresponding_Screen(return_vals);
@@ -305,32 +444,122 @@ void GPIO_Handler(uint gpio, uint32_t event_mask)
     {                                         // if this button is the pin that's been pressed and it's not disabled
       btn->flag = true;                       // set flag to true, pressed
       btn->disabled_count = btn->reset_value; // resetd disabled counter
+      Event_Post(EVENT_BUTTON);               // wake the state machine
     }
   }
 }
 
 /**
- * Sends packet acknowledgement to Core1
+ * Drains the Core1 ring and sets Data_Ready_Flag letting other states know to read Sensor_Data
+ * Every queued sample is consumed, the newest one is kept for display
  */
-void Ack_Successful(void)
+void Refresh_Data(void)
 {
-  multicore_fifo_push_blocking(true);
+  Payload_Data sample;
+  bool received = false;
+  while (Ring_Buffer_Pop(&Data_Ring_Buffer, &sample))
+  {
+    Latency_Stamp(&sample, STAGE_DEQUEUE);
+    Latency_Record_Sample(&sample);
+    #if UPLINK
+      Uplink_Enqueue(&sample);
+    #endif
+    received = true;
+  }
+
+  if (!received)
+    return;
+
+  #if TELEMETRY
+    Send_Counters();
+  #endif
+
+  Sensor_Data_Copy = sample; // keep the newest sample
+  Stats_Ready = Rolling_Stats_Get(&Stats_Copy); // and the windows it completed, as core1 built them
+  Data_Ready_Flag = true;    // set Data_Ready_Flag indicating we have new data to display
+
+  #if DEBUG
+    printf("Core0 busy: %lu permille\r\n", (unsigned long)Event_Busy_Permille());
+    Latency_Histogram e2e;
+    Latency_Get(LATENCY_END_TO_END, &e2e);
+    printf("Trigger to glass: p50 <= %lu us, p99 <= %lu us, max %lu us\r\n",
+           (unsigned long)Latency_Percentile_Us(&e2e, 500), (unsigned long)Latency_Percentile_Us(&e2e, 990),
+           (unsigned long)e2e.max_us);
+  #endif
 }
 
 /**
- * Sets Data_Ready_Flag letting other states know to read Sensor_Data
- *
+ * Sends the health counters over telemetry every TELEMETRY_COUNTER_PERIOD_MS
  */
-void Refresh_Data(void)
+void Send_Counters(void)
 {
-  bool data_ready = multicore_fifo_rvalid();
-  if (!data_ready)
+  static absolute_time_t next_send;
+  if (absolute_time_diff_us(get_absolute_time(), next_send) > 0)
     return;
+  next_send = make_timeout_time_ms(TELEMETRY_COUNTER_PERIOD_MS);
+
+  Latency_Histogram e2e;
+  Latency_Get(LATENCY_END_TO_END, &e2e);
+
+  Uplink_Stats uplink = {0};
+  #if UPLINK
+    Uplink_Get_Stats(&uplink);
+  #endif
+
+  Telemetry_Counter_Data counters = {
+      .ring_dropped = Data_Ring_Buffer.dropped,
+      .telemetry_dropped = Telemetry_Dropped(),
+      .idle_ms = (uint32_t)(Event_Idle_Us() / 1000),
+      .e2e_p99_us = Latency_Percentile_Us(&e2e, 990),
+      .flash_errors = Flash_Log_Errors(),
+      .uplink_dropped = uplink.dropped,
+      .uplink_failures = uplink.failures,
+      .uplink_batches = uplink.batches,
+  };
+  Telemetry_Counters(&counters);
+}
+
+/**
+ * FIFO interrupt for Core1 doorbells
+ * Data doorbells carry no data, they only wake Core0 to drain the ring
+ * FLASH_LOG_PARK holds Core0 in RAM while Core1 writes the flash log
+ */
+void FIFO_Handler(void)
+{
+  bool data = false;
+  while (multicore_fifo_rvalid())
+  {
+    if (multicore_fifo_pop_blocking() == FLASH_LOG_PARK)
+      Flash_Log_Park();
+    else
+      data = true;
+  }
+  multicore_fifo_clear_irq();
+  if (data)
+    Event_Post(EVENT_DATA);
+}
+
+/**
+ * Render deadline alarm, retries a parked LCD frame once the bus should be free
+ */
+int64_t Render_Deadline_Callback(alarm_id_t id, void *user_data)
+{
+  *(volatile bool *)user_data = false;
+  Event_Post(EVENT_RENDER);
+  return 0;
+}
 
-  Payload_Data *ptr = (Payload_Data *)multicore_fifo_pop_blocking(); // get pointer to data from Core1
-  Sensor_Data_Copy = *ptr;                                           // copy data from Core1
-  Ack_Successful();                                                  // let Core 0 continue
-  Data_Ready_Flag = true;                                            // set Data_Ready_Flag indicating we have new data to display
+/**
+ * Arms the render deadline unless it is already pending
+ */
+void Arm_Render_Deadline(void)
+{
+  static volatile bool armed = false;
+  if (armed)
+    return;
+  armed = true;
+  if (add_alarm_in_us(RENDER_RETRY_US, Render_Deadline_Callback, (void *)&armed, true) < 0)
+    armed = false;
 }
 
 /**
@@ -365,22 +594,25 @@ void Clear_Button_Flags(void)
 }
 
 bool ADC_New(void){
-  if(Sensor_Data_Copy.ADC_Data != Sensor_Data_Copy_Old.ADC_Data)
+  // ignore changes within the photoresistor noise band
+  int32_t delta = (int32_t)Sensor_Data_Copy.ADC_Data - (int32_t)Sensor_Data_Copy_Old.ADC_Data;
+  if(delta > PHOTO_NOISE_THR || delta < -PHOTO_NOISE_THR)
     return true;
   return false;
 }
 
 bool DHT20_New(void){
-  uint32_t hum_new = (uint32_t)(Sensor_Data_Copy.DHT20_Data.humidity * 10);
-  uint32_t hum_old = (uint32_t)(Sensor_Data_Copy_Old.DHT20_Data.humidity * 10);
+  // compare at the 0.1 resolution shown on screen
+  int32_t hum_new = Sensor_Data_Copy.DHT20_Data.humidity_centi / 10;
+  int32_t hum_old = Sensor_Data_Copy_Old.DHT20_Data.humidity_centi / 10;
 
-  uint32_t temp_c_new = (uint32_t)(Sensor_Data_Copy.DHT20_Data.temperature_c * 10);
-  uint32_t temp_c_old = (uint32_t)(Sensor_Data_Copy_Old.DHT20_Data.temperature_c * 10);
+  int32_t temp_c_new = Sensor_Data_Copy.DHT20_Data.temperature_centi_c / 10;
+  int32_t temp_c_old = Sensor_Data_Copy_Old.DHT20_Data.temperature_centi_c / 10;
 
-  uint32_t temp_f_new = (uint32_t)(Sensor_Data_Copy.DHT20_Data.temperature_f * 10);
-  uint32_t temp_f_old = (uint32_t)(Sensor_Data_Copy_Old.DHT20_Data.temperature_f * 10);
+  int32_t temp_f_new = Centi_C_To_Centi_F(Sensor_Data_Copy.DHT20_Data.temperature_centi_c) / 10;
+  int32_t temp_f_old = Centi_C_To_Centi_F(Sensor_Data_Copy_Old.DHT20_Data.temperature_centi_c) / 10;
 
   if (hum_new != hum_old || temp_c_new != temp_c_old || temp_f_new != temp_f_old)
       return true;
   return false;
-}
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "uplink.h"
+#include "uplink_net.h"
+
+// Standard Library
+#include <stdio.h>
+#include <string.h>
+
+// Pico SDK
+#include "pico/time.h"
+
+// User Modules
+#include "../data_flow/ring_buffer.h"
+
+#define UPLINK_HEADER_MAX 192   // request line and headers
+#define UPLINK_LINE_MAX 64      // longest NDJSON line, every field at its widest
+
+static_assert(UPLINK_BATCH_SAMPLES < UPLINK_QUEUE_SAMPLES, "the queue must hold a whole batch");
+
+// Globals
+static async_context_t *Context;
+static Payload_Data Queue_Storage[UPLINK_QUEUE_SAMPLES];
+static Ring_Buffer Queue = RING_BUFFER_INIT(Queue_Storage, UPLINK_QUEUE_SAMPLES);
+static Uplink_Stats Stats;
+
+// The batch being sent, or kept after a failure; the body is written after the header room
+// and the header right in front of it, so the request goes out as one contiguous buffer
+static uint8_t Request[UPLINK_HEADER_MAX + UPLINK_BATCH_SAMPLES * UPLINK_LINE_MAX];
+static const uint8_t *Batch;
+static uint32_t Batch_Len;
+static uint32_t Batch_Samples;  // 0 when no batch is held
+static bool In_Flight;
+static bool Retrying;           // the held batch failed, only the flush timer resends it
+
+static void Send_Work(async_context_t *context, async_when_pending_worker_t *worker);
+static void Flush_Work(async_context_t *context, async_at_time_worker_t *worker);
+
+static async_when_pending_worker_t Send_Worker = {.do_work = Send_Work};
+static async_at_time_worker_t Flush_Worker = {.do_work = Flush_Work};
+
+/**
+ * Pops up to UPLINK_BATCH_SAMPLES samples into body, returns how many, 0 if the queue was empty
+ */
+#if UPLINK_WIRE
+#define UPLINK_CONTENT_TYPE "application/octet-stream"
+
+static_assert(WIRE_HEADER_MAX + UPLINK_BATCH_SAMPLES * WIRE_RECORD_MAX <= UPLINK_BATCH_SAMPLES * UPLINK_LINE_MAX,
+              "a wire batch must fit the body");
+
+static uint32_t Encode_Batch(uint8_t *body, uint32_t *len){
+    Wire_Encoder enc;
+    Payload_Data sample;
+
+    Wire_Begin(&enc, body, UPLINK_BATCH_SAMPLES * UPLINK_LINE_MAX, WIRE_ALL, SAMPLE_PERIOD_MS);
+    while (enc.count < UPLINK_BATCH_SAMPLES && Ring_Buffer_Pop(&Queue, &sample)){
+        Wire_Sample wire = Payload_Wire_Sample(&sample);
+        Wire_Add(&enc, &wire);
+    }
+    *len = Wire_End(&enc);
+    return enc.count;
+}
+#else
+#define UPLINK_CONTENT_TYPE "application/x-ndjson"
+
+static uint32_t Encode_Batch(uint8_t *body, uint32_t *len){
+    uint32_t count = 0;
+    Payload_Data sample;
+
+    *len = 0;
+    while (count < UPLINK_BATCH_SAMPLES && Ring_Buffer_Pop(&Queue, &sample)){
+        *len += snprintf((char *)body + *len, UPLINK_LINE_MAX, "{\"t\":%lu,\"h\":%u,\"tc\":%d,\"adc\":%u,\"ok\":%d}\n",
+                         (unsigned long)(sample.time_stamp / 1000), sample.DHT20_Data.humidity_centi,
+                         sample.DHT20_Data.temperature_centi_c, sample.ADC_Data, sample.DHT20_Data_Valid ? 1 : 0);
+        count++;
+    }
+    return count;
+}
+#endif
+
+/**
+ * Builds the next request in Request from the queue
+ * Returns false if the queue was empty
+ */
+static bool Build_Batch(void){
+    uint8_t *body = Request + UPLINK_HEADER_MAX;
+    uint32_t len;
+    uint32_t count = Encode_Batch(body, &len);
+    if (!count)
+        return false;
+
+    char header[UPLINK_HEADER_MAX];
+    int header_len = snprintf(header, sizeof(header),
+                              "POST /ingest?device=" UPLINK_DEVICE " HTTP/1.1\r\n"
+                              "Host: " UPLINK_HOST "\r\n"
+                              "Content-Type: " UPLINK_CONTENT_TYPE "\r\n"
+                              "Content-Length: %lu\r\n"
+                              "Connection: close\r\n\r\n",
+                              (unsigned long)len);
+
+    Batch = body - header_len;
+    memcpy((uint8_t *)Batch, header, header_len);
+    Batch_Len = header_len + len;
+    Batch_Samples = count;
+    return true;
+}
+
+static void Batch_Done(bool ok){
+    In_Flight = false;
+    Retrying = !ok;
+    if (!ok){
+        Stats.failures++; // kept, the next flush resends it
+        return;
+    }
+
+    Stats.batches++;
+    Stats.samples_sent += Batch_Samples;
+    Stats.last_batch_ms = to_ms_since_boot(get_absolute_time());
+    Batch_Samples = 0;
+    if (Ring_Buffer_Count(&Queue) >= UPLINK_BATCH_SAMPLES)
+        async_context_set_work_pending(Context, &Send_Worker);
+}
+
+/**
+ * Sends the held batch, or a new one from the queue, unless a request is already out
+ */
+static void Send_Batch(void){
+    if (In_Flight || !Uplink_Net_Ready())
+        return;
+    if (!Batch_Samples && !Build_Batch())
+        return;
+
+    In_Flight = Uplink_Net_Send(Batch, Batch_Len, Batch_Done);
+    if (!In_Flight){
+        Stats.failures++;
+        Retrying = true;
+    }
+}
+
+static void Send_Work(async_context_t *context, async_when_pending_worker_t *worker){
+    if (!Retrying)
+        Send_Batch();
+}
+
+static void Flush_Work(async_context_t *context, async_at_time_worker_t *worker){
+    Send_Batch();
+    async_context_add_at_time_worker_in_ms(context, worker, UPLINK_FLUSH_MS);
+}
+
+/**
+ * Starts the Wi-Fi join and the flush timer, call once from core0
+ * Returns false if the network could not be brought up, Uplink_Enqueue() then does nothing
+ */
+bool Uplink_Init(void){
+    Context = Uplink_Net_Init();
+    if (!Context)
+        return false;
+
+    async_context_add_when_pending_worker(Context, &Send_Worker);
+    async_context_add_at_time_worker_in_ms(Context, &Flush_Worker, UPLINK_FLUSH_MS);
+    return true;
+}
+
+/**
+ * Queues a sample for the next batch, core0 only, never blocks
+ * A full batch wakes the sender right away
+ */
+void Uplink_Enqueue(const Payload_Data *sample){
+    if (!Context)
+        return;
+
+    if (Ring_Buffer_Push(&Queue, sample))
+        Stats.queued++;
+    if (Ring_Buffer_Count(&Queue) >= UPLINK_BATCH_SAMPLES)
+        async_context_set_work_pending(Context, &Send_Worker);
+}
+
+/**
+ * Copies the counters, from core0
+ */
+void Uplink_Get_Stats(Uplink_Stats *stats){
+    if (Context)
+        async_context_acquire_lock_blocking(Context);
+    *stats = Stats;
+    stats->dropped = Queue.dropped;
+    if (Context)
+        async_context_release_lock(Context);
+}
+
+/**
+ * True while a batch is on the air, from core0
+ */
+bool Uplink_Busy(void){
+    return In_Flight;
+}
@@ -0,0 +1,41 @@
+#ifndef __UPLINK_H__
+#define __UPLINK_H__
+
+// Standard Library
+#include <stdint.h>
+#include <stdbool.h>
+
+// User Modules
+#include "../config.h"
+#include "../data_flow/data_flow.h"
+
+/**
+ * Batched uplink of samples to the backend over Wi-Fi
+ *
+ * Core0 queues every sample it drains from core1; the queue is a Ring_Buffer, so queuing
+ * never waits on the network. Workers on the network async_context take up to
+ * UPLINK_BATCH_SAMPLES samples at a time and POST them to /ingest as one binary batch
+ * (data_flow/wire.h), about 5 bytes a sample, or with UPLINK_WIRE 0 as NDJSON, one line per
+ * sample: {"t":ms,"h":centi_pct,"tc":centi_c,"adc":counts,"ok":0|1}. A batch goes out as
+ * soon as it is full, and whatever is queued goes out every UPLINK_FLUSH_MS, so the radio
+ * wakes once per batch rather than once per sample.
+ *
+ * A batch that fails is kept and resent on the next flush; samples keep queuing behind it
+ * until the queue is full.
+ */
+
+typedef struct {
+    uint32_t queued;          // samples accepted by Uplink_Enqueue()
+    uint32_t dropped;         // samples refused by a full queue
+    uint32_t batches;         // batches the backend acknowledged
+    uint32_t samples_sent;
+    uint32_t failures;        // posts that failed or timed out
+    uint32_t last_batch_ms;   // time the last batch was acknowledged
+} Uplink_Stats;
+
+bool Uplink_Init(void);
+void Uplink_Enqueue(const Payload_Data *sample);
+void Uplink_Get_Stats(Uplink_Stats *stats);
+bool Uplink_Busy(void);
+
+#endif
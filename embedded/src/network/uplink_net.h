@@ -0,0 +1,29 @@
+#ifndef __UPLINK_NET_H__
+#define __UPLINK_NET_H__
+
+// Standard Library
+#include <stdint.h>
+#include <stdbool.h>
+
+// Pico SDK
+#include "pico/async_context.h"
+
+/**
+ * Network side of the uplink: the Wi-Fi link and one HTTP request at a time
+ * uplink_net_lwip.c drives the CYW43 and lwIP on the board, the simulator provides a
+ * socket version. Everything but Uplink_Net_Init() runs on the returned context.
+ */
+
+// Called once the response status line arrived (ok for 2xx) or the request failed
+typedef void (*Uplink_Net_Done)(bool ok);
+
+// Starts joining the network, returns the context the uplink workers run on or NULL
+async_context_t *Uplink_Net_Init(void);
+
+// True while the link is up with an address, restarts the join after a drop
+bool Uplink_Net_Ready(void);
+
+// Sends a complete request to UPLINK_HOST:UPLINK_PORT, request must stay valid until done
+bool Uplink_Net_Send(const uint8_t *request, uint32_t len, Uplink_Net_Done done);
+
+#endif
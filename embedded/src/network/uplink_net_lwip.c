@@ -0,0 +1,175 @@
+#include "uplink_net.h"
+
+// Standard Library
+#include <string.h>
+
+// Pico SDK
+#include "pico/cyw43_arch.h"
+#include "lwip/tcp.h"
+#include "lwip/ip_addr.h"
+
+// User Modules
+#include "../config.h"
+
+#ifndef WIFI_SSID
+#define WIFI_SSID ""
+#endif
+#ifndef WIFI_PASSWORD
+#define WIFI_PASSWORD ""
+#endif
+
+/**
+ * One plain TCP connection per batch on the lwIP raw API, all of it on the CYW43
+ * background async_context. The request is written straight from the caller's buffer as
+ * the send window opens, and the connection is closed once the status line is in.
+ */
+
+// Globals
+static struct tcp_pcb *Pcb;
+static const uint8_t *Request;
+static uint32_t Request_Len;
+static uint32_t Written;
+static Uplink_Net_Done Done;
+
+static void Timeout_Work(async_context_t *context, async_at_time_worker_t *worker);
+static async_at_time_worker_t Timeout_Worker = {.do_work = Timeout_Work};
+
+/**
+ * Ends the request, closing or resetting the connection unless lwIP already freed it
+ * Callbacks that pass abort must return ERR_ABRT to lwIP
+ */
+static void Finish(bool ok, bool abort){
+    async_context_remove_at_time_worker(cyw43_arch_async_context(), &Timeout_Worker);
+    if (Pcb){
+        tcp_sent(Pcb, NULL);
+        tcp_recv(Pcb, NULL);
+        tcp_err(Pcb, NULL);
+        if (abort || tcp_close(Pcb) != ERR_OK)
+            tcp_abort(Pcb);
+        Pcb = NULL;
+    }
+    Uplink_Net_Done done = Done;
+    Done = NULL;
+    if (done)
+        done(ok);
+}
+
+/**
+ * Queues as much of the request as the send buffer takes
+ */
+static err_t Write_More(struct tcp_pcb *pcb){
+    uint32_t room = tcp_sndbuf(pcb);
+    uint32_t len = Request_Len - Written;
+    if (len > room)
+        len = room;
+    if (!len)
+        return ERR_OK;
+
+    // no copy, the uplink keeps the request until Done runs
+    err_t err = tcp_write(pcb, Request + Written, len, 0);
+    if (err == ERR_OK){
+        Written += len;
+        err = tcp_output(pcb);
+    }
+    return err;
+}
+
+static err_t On_Sent(void *arg, struct tcp_pcb *pcb, u16_t len){
+    return Write_More(pcb);
+}
+
+static err_t On_Connected(void *arg, struct tcp_pcb *pcb, err_t err){
+    if (err != ERR_OK || Write_More(pcb) != ERR_OK){
+        Finish(false, true);
+        return ERR_ABRT;
+    }
+    return ERR_OK;
+}
+
+/**
+ * Waits for the status line, anything after it is not needed
+ */
+static err_t On_Recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err){
+    if (!p){
+        Finish(false, false); // closed before a response
+        return ERR_OK;
+    }
+
+    char status[12] = {0};
+    pbuf_copy_partial(p, status, sizeof(status) - 1, 0);
+    tcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+
+    // "HTTP/1.1 2xx", the rest of the response is not needed
+    Finish(strncmp(status, "HTTP/1.", 7) == 0 && status[9] == '2', true);
+    return ERR_ABRT;
+}
+
+/**
+ * lwIP has already freed the pcb when this runs
+ */
+static void On_Err(void *arg, err_t err){
+    Pcb = NULL;
+    Finish(false, false);
+}
+
+static void Timeout_Work(async_context_t *context, async_at_time_worker_t *worker){
+    Finish(false, true);
+}
+
+/**
+ * Brings up the CYW43 in station mode and starts the join in the background
+ * Power save stays on, the radio sleeps between batches
+ */
+async_context_t *Uplink_Net_Init(void){
+    if (!WIFI_SSID[0] || cyw43_arch_init())
+        return NULL;
+
+    cyw43_arch_enable_sta_mode();
+    cyw43_wifi_pm(&cyw43_state, CYW43_DEFAULT_PM);
+    if (cyw43_arch_wifi_connect_async(WIFI_SSID, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK))
+        return NULL;
+    return cyw43_arch_async_context();
+}
+
+/**
+ * True once associated with an address, a dropped or failed join is started again
+ */
+bool Uplink_Net_Ready(void){
+    int status = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+    if (status == CYW43_LINK_DOWN || status < 0)
+        cyw43_arch_wifi_connect_async(WIFI_SSID, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK);
+    return status == CYW43_LINK_UP;
+}
+
+/**
+ * Opens a connection to the backend and sends request, done runs exactly once
+ * Returns false without calling done if the connection could not be started
+ */
+bool Uplink_Net_Send(const uint8_t *request, uint32_t len, Uplink_Net_Done done){
+    ip_addr_t addr;
+    if (Pcb || !ipaddr_aton(UPLINK_HOST, &addr))
+        return false;
+
+    Pcb = tcp_new_ip_type(IP_GET_TYPE(&addr));
+    if (!Pcb)
+        return false;
+
+    Request = request;
+    Request_Len = len;
+    Written = 0;
+    Done = done;
+    tcp_sent(Pcb, On_Sent);
+    tcp_recv(Pcb, On_Recv);
+    tcp_err(Pcb, On_Err);
+
+    if (tcp_connect(Pcb, &addr, UPLINK_PORT, On_Connected) != ERR_OK){
+        tcp_err(Pcb, NULL);
+        tcp_abort(Pcb);
+        Pcb = NULL;
+        Done = NULL;
+        return false;
+    }
+    async_context_add_at_time_worker_in_ms(cyw43_arch_async_context(), &Timeout_Worker, UPLINK_TIMEOUT_MS);
+    return true;
+}
@@ -0,0 +1,447 @@
+#include "flash_log.h"
+
+// Standard Library
+#include <string.h>
+
+// Pico SDK
+#include "pico/flash.h"
+#include "pico/multicore.h"
+#include "pico/time.h"
+#include "pico/error.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+
+// Region layout
+#define LOG_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_LOG_SECTORS * FLASH_SECTOR_SIZE)
+#define PAGES_PER_SECTOR (FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE)
+#define PAGE_BITS (FLASH_PAGE_SIZE * 8)
+#define PAGE_UNWRITTEN 0xFFFF                // sample count of a page still erased
+
+#define FLASH_LOG_MAGIC 0x484C4F47u          // "HLOG"
+#define FLASH_LOG_LOCKOUT_TIMEOUT_MS 100     // time allowed for core0 to park in RAM
+
+// File Scope Datatypes
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;     // increments for every sector opened, the newest sector has the highest
+    uint32_t base_time_s;  // seconds since boot of the first sample
+    uint16_t boot;
+    uint16_t check;        // ~(sequence ^ boot), rejects a header torn by power loss
+    int16_t humidity;      // first sample in stored units, the stream holds the rest
+    int16_t temperature;
+    int16_t adc;
+    uint16_t reserved;
+} Flash_Log_Header;
+
+static_assert(sizeof(Flash_Log_Header) == 24, "header layout is stored in flash");
+static_assert(LOG_OFFSET % FLASH_SECTOR_SIZE == 0, "region must be sector aligned");
+static_assert((sizeof(Flash_Log_Header) + 2) * 8 + CODEC_MAX_SAMPLE_BITS <= PAGE_BITS, "a page must hold a sample");
+
+typedef struct {
+    uint32_t offset;
+    const uint8_t *data;
+} Flash_Op;
+
+// Core0 parking, see Flash_Log_Park()
+enum {
+    PARK_IDLE,
+    PARK_REQUESTED,  // Core1 sent FLASH_LOG_PARK and waits
+    PARK_PARKED,     // Core0 spins in RAM until Core1 sets PARK_IDLE
+};
+
+// Globals
+static bool Log_Enabled = false;
+static uint32_t Head_Sector;        // sector currently being filled
+static bool Head_Open = false;      // a sector is opened by the first sample of every boot
+static uint32_t Head_Page;          // page being staged, PAGES_PER_SECTOR once the sector is full
+static uint32_t Next_Sequence;
+static uint16_t Boot;
+static uint32_t Decimate = 0;
+static int32_t Erase_Pending = -1;  // sector to erase ahead of the head, -1 if none
+static uint8_t Page_Buf[FLASH_PAGE_SIZE];
+static uint32_t Stage_Bit;          // next free bit of Page_Buf
+static uint16_t Stage_Count;        // samples coded in Page_Buf
+static bool Page_Full = false;      // Page_Buf cannot take another sample, waiting to be programmed
+static Codec_State Prev;            // last logged sample, in stored units
+static bool Have_Prev = false;
+static uint32_t Write_Errors = 0;
+static volatile bool Core0_Quiet = false; // see Flash_Log_Set_Quiet()
+
+static volatile uint8_t Park_State = PARK_IDLE;
+static spin_lock_t *Park_Lock;
+static uint32_t Park_Irq;           // Core1 interrupt state across a flash operation
+
+/**
+ * Returns the memory mapped address of a sector in the log region
+ */
+static inline const uint8_t *Sector_Ptr(uint32_t sector){
+    return (const uint8_t *)(uintptr_t)(XIP_BASE + LOG_OFFSET + sector * FLASH_SECTOR_SIZE);
+}
+
+/**
+ * Byte offset of the sample count in a page, the stream follows it
+ */
+static inline uint32_t Count_Offset(uint32_t page){
+    return page ? 0 : sizeof(Flash_Log_Header);
+}
+
+/**
+ * Returns true if the sector starts with a valid header
+ */
+static bool Header_Valid(const Flash_Log_Header *h){
+    return h->magic == FLASH_LOG_MAGIC && h->check == (uint16_t)~(h->sequence ^ h->boot);
+}
+
+/**
+ * Returns true if every byte of the sector reads back as erased
+ */
+static bool Sector_Erased(uint32_t sector){
+    const uint32_t *word = (const uint32_t *)Sector_Ptr(sector);
+    for (uint32_t i = 0; i < FLASH_SECTOR_SIZE / sizeof(uint32_t); i++){
+        if (word[i] != 0xFFFFFFFFu)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * flash_safe_execute() entry on Core1: masks interrupts, then parks Core0 through its FIFO
+ * interrupt. The SDK's multicore lockout would need Core0's FIFO interrupt to itself, and
+ * Core0 already takes it for the sample doorbells
+ */
+static int Park_Enter(uint32_t timeout_ms){
+    Park_Irq = save_and_disable_interrupts();
+    // Core0 only writes the flash before Core1 runs, there is nothing to park
+    if (get_core_num() == 0)
+        return PICO_OK;
+
+    absolute_time_t until = make_timeout_time_ms(timeout_ms);
+    Park_State = PARK_REQUESTED;
+    if (multicore_fifo_push_timeout_us(FLASH_LOG_PARK, (uint64_t)timeout_ms * 1000)){
+        while (Park_State != PARK_PARKED && absolute_time_diff_us(get_absolute_time(), until) > 0)
+            tight_loop_contents();
+    }
+
+    // withdraw the request unless Core0 took it meanwhile, it then finds nothing to do
+    uint32_t save = spin_lock_blocking(Park_Lock);
+    bool parked = Park_State == PARK_PARKED;
+    if (!parked)
+        Park_State = PARK_IDLE;
+    spin_unlock(Park_Lock, save);
+
+    if (!parked){
+        restore_interrupts(Park_Irq);
+        return PICO_ERROR_TIMEOUT;
+    }
+    return PICO_OK;
+}
+
+static int Park_Exit(uint32_t timeout_ms){
+    Park_State = PARK_IDLE; // releases Core0
+    __sev();
+    restore_interrupts(Park_Irq);
+    return PICO_OK;
+}
+
+static bool Park_Core_Init(bool init){
+    return true; // Core0 parks from its own FIFO handler, nothing to install
+}
+
+static flash_safety_helper_t Park_Helper = {
+    .core_init_deinit = Park_Core_Init,
+    .enter_safe_zone_timeout_ms = Park_Enter,
+    .exit_safe_zone_timeout_ms = Park_Exit,
+};
+
+/**
+ * Replaces the SDK's flash_safe_execute() helper, only the log writes the flash
+ */
+flash_safety_helper_t *get_flash_safety_helper(void){
+    return &Park_Helper;
+}
+
+/**
+ * Parks Core0 in RAM with interrupts masked while Core1 programs or erases the flash
+ * Called by Core0's FIFO handler when it pops FLASH_LOG_PARK, returns once Core1 is done
+ */
+void __not_in_flash_func(Flash_Log_Park)(void){
+    uint32_t save = spin_lock_blocking(Park_Lock);
+    bool parked = Park_State == PARK_REQUESTED;
+    if (parked)
+        Park_State = PARK_PARKED;
+    spin_unlock_unsafe(Park_Lock);
+
+    while (parked && Park_State == PARK_PARKED)
+        tight_loop_contents();
+    restore_interrupts(save);
+}
+
+// flash_safe_execute callbacks, run with Core0 parked in RAM and interrupts disabled
+static void Do_Program(void *param){
+    Flash_Op *op = (Flash_Op *)param;
+    flash_range_program(op->offset, op->data, FLASH_PAGE_SIZE);
+}
+
+static void Do_Erase(void *param){
+    Flash_Op *op = (Flash_Op *)param;
+    flash_range_erase(op->offset, FLASH_SECTOR_SIZE);
+}
+
+/**
+ * Erases one sector, stalls for one sector erase time
+ */
+static void Erase_Sector(uint32_t sector){
+    Flash_Op op = { LOG_OFFSET + sector * FLASH_SECTOR_SIZE, NULL };
+    if (flash_safe_execute(Do_Erase, &op, FLASH_LOG_LOCKOUT_TIMEOUT_MS) != PICO_OK)
+        Write_Errors++;
+}
+
+/**
+ * Starts staging a page, its sample count goes in front of the stream once it is programmed
+ */
+static void Stage_Page(uint32_t page){
+    Head_Page = page;
+    Stage_Bit = (Count_Offset(page) + 2) * 8;
+    Stage_Count = 0;
+    Page_Full = false;
+}
+
+/**
+ * Programs the staged page into the head sector and stages the next one
+ */
+static void Program_Page(void){
+    uint32_t count_at = Count_Offset(Head_Page);
+    Page_Buf[count_at] = (uint8_t)Stage_Count;
+    Page_Buf[count_at + 1] = (uint8_t)(Stage_Count >> 8);
+
+    Flash_Op op = { LOG_OFFSET + Head_Sector * FLASH_SECTOR_SIZE + Head_Page * FLASH_PAGE_SIZE, Page_Buf };
+    if (flash_safe_execute(Do_Program, &op, FLASH_LOG_LOCKOUT_TIMEOUT_MS) != PICO_OK)
+        Write_Errors++;
+
+    memset(Page_Buf, 0, sizeof(Page_Buf));
+    Stage_Page(Head_Page + 1);
+}
+
+/**
+ * Moves the head to the next sector and stages its header, holding the first sample
+ * The sector is normally erased already by Flash_Log_Service(); if Core0 never went quiet
+ * during the hours the last sector took to fill, it is erased here regardless
+ */
+static void Open_Sector(int32_t time_s, int32_t humidity, int32_t temperature, int32_t adc){
+    uint32_t sector = (Head_Sector + 1) % FLASH_LOG_SECTORS;
+    if (!Sector_Erased(sector))
+        Erase_Sector(sector);
+
+    Head_Sector = sector;
+    Head_Open = true;
+
+    Flash_Log_Header header = {
+        .magic = FLASH_LOG_MAGIC,
+        .sequence = Next_Sequence,
+        .base_time_s = (uint32_t)time_s,
+        .boot = Boot,
+        .check = (uint16_t)~(Next_Sequence ^ Boot),
+        .humidity = (int16_t)humidity,
+        .temperature = (int16_t)temperature,
+        .adc = (int16_t)adc,
+        .reserved = 0xFFFF,
+    };
+    Next_Sequence++;
+    memset(Page_Buf, 0, sizeof(Page_Buf));
+    memcpy(Page_Buf, &header, sizeof(header));
+    Stage_Page(0);
+    Codec_Start(&Prev, time_s, humidity, temperature, adc);
+
+    // keep the following sector ready so the next open does not stall on an erase
+    Erase_Pending = (sector + 1) % FLASH_LOG_SECTORS;
+}
+
+/**
+ * Finds the newest sector from the sector headers, O(sectors), and erases the sector the
+ * first sample will open. Runs on Core0 before Core1 starts
+ * Returns false if the region overlaps the firmware image, logging stays disabled
+ */
+bool Flash_Log_Init(void){
+    Park_Lock = spin_lock_init(spin_lock_claim_unused(true));
+
+    extern char __flash_binary_end;
+    if ((uintptr_t)&__flash_binary_end - XIP_BASE > LOG_OFFSET)
+        return false;
+
+    uint32_t max_sequence = 0;
+    uint16_t max_boot = 0;
+    int32_t newest = -1;
+
+    for (uint32_t s = 0; s < FLASH_LOG_SECTORS; s++){
+        const Flash_Log_Header *h = (const Flash_Log_Header *)Sector_Ptr(s);
+        if (!Header_Valid(h))
+            continue;
+        if (newest < 0 || h->sequence > max_sequence){
+            max_sequence = h->sequence;
+            newest = s;
+        }
+        if (h->boot > max_boot)
+            max_boot = h->boot;
+    }
+
+    // every boot starts a fresh sector after the newest one, so its time base is its own
+    Head_Sector = (newest < 0) ? FLASH_LOG_SECTORS - 1 : (uint32_t)newest;
+    Head_Open = false;
+    Have_Prev = false;
+    Next_Sequence = max_sequence + 1;
+    Boot = max_boot + 1;
+    Erase_Pending = (Head_Sector + 1) % FLASH_LOG_SECTORS;
+
+    // Core1 is not running yet, so this erase parks nothing
+    uint32_t sector = (uint32_t)Erase_Pending;
+    Erase_Pending = -1;
+    if (!Sector_Erased(sector))
+        Erase_Sector(sector);
+
+    Log_Enabled = true;
+    return true;
+}
+
+/**
+ * Stages one sample, every FLASH_LOG_INTERVAL calls (Core1, right after the sample)
+ * Touches the flash only if Flash_Log_Service() fell behind
+ */
+void Flash_Log_Append(const Payload_Data *sample){
+    if (!Log_Enabled || !sample->DHT20_Data_Valid)
+        return;
+    if (++Decimate < FLASH_LOG_INTERVAL)
+        return;
+    Decimate = 0;
+
+    int32_t time_s = (int32_t)(sample->time_stamp / 1000000);
+    int32_t humidity = sample->DHT20_Data.humidity_centi;
+    int32_t temperature = sample->DHT20_Data.temperature_centi_c;
+    int32_t adc = sample->ADC_Data;
+    if (Have_Prev){
+        humidity = Codec_Deadband(humidity, FLASH_LOG_CENTI_STEP, Prev.humidity);
+        temperature = Codec_Deadband(temperature, FLASH_LOG_CENTI_STEP, Prev.temperature);
+        adc = Codec_Deadband(adc, FLASH_LOG_ADC_STEP, Prev.adc);
+    } else {
+        humidity = Codec_Quantize(humidity, FLASH_LOG_CENTI_STEP);
+        temperature = Codec_Quantize(temperature, FLASH_LOG_CENTI_STEP);
+        adc = Codec_Quantize(adc, FLASH_LOG_ADC_STEP);
+        Have_Prev = true;
+    }
+
+    if (Page_Full)
+        Program_Page();
+    if (!Head_Open || Head_Page == PAGES_PER_SECTOR){
+        Open_Sector(time_s, humidity, temperature, adc);
+        return;
+    }
+
+    Codec_Put_Sample(Page_Buf, &Stage_Bit, &Prev, time_s, humidity, temperature, adc);
+    Stage_Count++;
+    if (Stage_Bit + CODEC_MAX_SAMPLE_BITS > PAGE_BITS)
+        Page_Full = true;
+}
+
+/**
+ * Programs a full staged page, and erases the sector ahead of the head if it is not blank
+ * and Core0 is quiet; otherwise the erase waits for a later period
+ * Core1 runs it half a sample period after each sample, see core1.c
+ */
+void Flash_Log_Service(void){
+    if (!Log_Enabled)
+        return;
+
+    if (Page_Full)
+        Program_Page();
+
+    if (Erase_Pending >= 0 && Core0_Quiet){
+        uint32_t sector = (uint32_t)Erase_Pending;
+        Erase_Pending = -1;
+        if (!Sector_Erased(sector))
+            Erase_Sector(sector);
+    }
+}
+
+/**
+ * Core0 reports whether it may be parked for a sector erase: set right before it sleeps
+ * with no USB, Wi-Fi or LCD transfer outstanding, cleared as it wakes
+ */
+void Flash_Log_Set_Quiet(bool quiet){
+    Core0_Quiet = quiet;
+}
+
+/**
+ * Number of failed program or erase operations since boot
+ */
+uint32_t Flash_Log_Errors(void){
+    return Write_Errors;
+}
+
+/**
+ * Positions the iterator on the oldest sector, the one after the head
+ */
+void Flash_Log_Iter_Begin(Flash_Log_Iter *it){
+    it->sector = (Head_Sector + 1) % FLASH_LOG_SECTORS;
+    it->sectors_left = FLASH_LOG_SECTORS;
+    it->page = 0;
+    it->left = 0;
+    it->bit = 0;
+    it->boot = 0;
+}
+
+/**
+ * Returns the next programmed sample, oldest first
+ * Samples still staged in RAM are not visible until their page is programmed
+ */
+bool Flash_Log_Iter_Next(Flash_Log_Iter *it, Flash_Log_Sample *out){
+    while (it->sectors_left){
+        const uint8_t *base = Sector_Ptr(it->sector);
+        const Flash_Log_Header *h = (const Flash_Log_Header *)base;
+        bool found = false;
+
+        if (it->page == 0 && it->bit == 0){
+            // the header programs with the first page, so a header without it is torn
+            uint32_t count_at = Count_Offset(0);
+            if (Header_Valid(h) && (base[count_at] | base[count_at + 1] << 8) != PAGE_UNWRITTEN){
+                it->boot = h->boot;
+                Codec_Start(&it->prev, (int32_t)h->base_time_s, h->humidity, h->temperature, h->adc);
+                it->left = base[count_at] | base[count_at + 1] << 8;
+                it->bit = (count_at + 2) * 8;
+                found = true;
+            } else {
+                it->page = PAGES_PER_SECTOR; // blank or torn sector
+            }
+        } else if (it->left){
+            Codec_Get_Sample(base + it->page * FLASH_PAGE_SIZE, &it->bit, &it->prev);
+            it->left--;
+            found = true;
+        } else if (++it->page < PAGES_PER_SECTOR){
+            const uint8_t *page = base + it->page * FLASH_PAGE_SIZE;
+            uint32_t count = page[0] | page[1] << 8;
+            // pages are programmed in order, so the first erased page ends the sector
+            if (count == PAGE_UNWRITTEN)
+                it->page = PAGES_PER_SECTOR;
+            else {
+                it->left = count;
+                it->bit = 16;
+            }
+        }
+
+        if (found){
+            out->boot = it->boot;
+            out->time_s = (uint32_t)it->prev.time;
+            out->humidity_centi = (uint16_t)(it->prev.humidity * FLASH_LOG_CENTI_STEP);
+            out->temperature_centi_c = (int16_t)(it->prev.temperature * FLASH_LOG_CENTI_STEP);
+            out->adc = (uint16_t)(it->prev.adc * FLASH_LOG_ADC_STEP);
+            return true;
+        }
+
+        if (it->page >= PAGES_PER_SECTOR){
+            it->sector = (it->sector + 1) % FLASH_LOG_SECTORS;
+            it->page = 0;
+            it->left = 0;
+            it->bit = 0;
+            it->sectors_left--;
+        }
+    }
+    return false;
+}
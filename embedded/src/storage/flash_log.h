@@ -0,0 +1,78 @@
+#ifndef __FLASH_LOG_H__
+#define __FLASH_LOG_H__
+
+// Standard Library
+#include <stdint.h>
+#include <stdbool.h>
+
+// User Modules
+#include "../config.h"
+#include "../data_flow/data_flow.h"
+#include "sample_codec.h"
+
+/**
+ * Append-only sample log in a reserved region at the end of flash, written by Core1
+ *
+ * The region is a ring of 4 KB sectors used strictly in order, so every sector sees
+ * the same number of erases. Each sector starts with a header carrying a sequence number
+ * and the sector's first sample; the rest follow as a compressed bit stream (see
+ * sample_codec.h), and every page starts with the number of samples coded in it.
+ * Recovery only reads the sector headers, and every boot opens a fresh sector.
+ *
+ * Values are kept in steps of FLASH_LOG_CENTI_STEP / FLASH_LOG_ADC_STEP with a dead band,
+ * times in whole seconds, and samples with an invalid DHT20 reading are left out. A page
+ * is staged in RAM until it is full, so a power loss drops at most one page of samples.
+ *
+ * Core1 stages a sample right after taking it and programs and erases from
+ * Flash_Log_Service(), half a sample period later, so the flash stalls fall between DHT20
+ * conversions and the sampling core is never parked. Core0 runs from flash too, so it is
+ * parked in RAM with its interrupts masked for each flash operation, through its FIFO
+ * interrupt, see Flash_Log_Park():
+ *
+ *   page program  once every few hundred samples, at most FLASH_LOG_PROGRAM_MAX_MS
+ *   sector erase  once every sector, hours apart, at most FLASH_LOG_ERASE_MAX_MS (45 ms
+ *                 typical). Only started while Core0 sleeps with no USB, Wi-Fi or LCD
+ *                 transfer outstanding, see Flash_Log_Set_Quiet()
+ *
+ * Nothing is lost to the Core0 blackout, only delayed: the CYW43 raises a level interrupt
+ * that is still asserted when Core0 unmasks, and keeps its frames meanwhile; USB hosts NAK
+ * and retry a silent CDC endpoint; the uplink allows UPLINK_TIMEOUT_MS per post; buttons
+ * and LCD DMA completion stay pending. The host sim can stretch erases to the worst case
+ * with SIM_FLASH_ERASE_MS, and CI runs the uplink that way.
+ */
+
+#define FLASH_LOG_PARK 0xF1A5u      // FIFO word Core1 sends to park Core0 for a flash operation
+#define FLASH_LOG_PROGRAM_MAX_MS 3  // worst case page program, W25Q16JV datasheet tPP max
+#define FLASH_LOG_ERASE_MAX_MS 400  // worst case sector erase, W25Q16JV datasheet tSE max,
+                                    // also the longest Core0 goes without interrupts
+
+// Sample as returned by the iterator, with the time base resolved
+typedef struct {
+    uint16_t boot;    // boot counter, times of different boots are unrelated
+    uint32_t time_s;  // seconds since that boot
+    uint16_t humidity_centi;
+    int16_t temperature_centi_c;
+    uint16_t adc;
+} Flash_Log_Sample;
+
+typedef struct {
+    uint32_t sector;      // index into the region
+    uint32_t sectors_left;
+    uint32_t page;        // page of the sector, past the last one once the sector is done
+    uint32_t left;        // samples still to decode from the page
+    uint32_t bit;         // position in the page
+    uint16_t boot;
+    Codec_State prev;     // previous sample, in stored units
+} Flash_Log_Iter;
+
+bool Flash_Log_Init(void);
+void Flash_Log_Append(const Payload_Data *sample);
+void Flash_Log_Service(void);
+void Flash_Log_Park(void);
+void Flash_Log_Set_Quiet(bool quiet);
+uint32_t Flash_Log_Errors(void);
+
+void Flash_Log_Iter_Begin(Flash_Log_Iter *it);
+bool Flash_Log_Iter_Next(Flash_Log_Iter *it, Flash_Log_Sample *out);
+
+#endif
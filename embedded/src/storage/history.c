@@ -0,0 +1,329 @@
+#include "history.h"
+
+// Standard Library
+#include <stddef.h>
+#include <string.h>
+
+#if HISTORY_BENCHMARK
+#include <stdio.h>
+#include "pico/time.h"
+#include "flash_log.h"
+#endif
+
+// File Scope Datatypes
+typedef struct {
+    uint32_t first_time;      // stored units, HISTORY_TIME_RES_MS each
+    uint32_t last_time;       // lets range reads skip whole blocks
+    int16_t first_humidity;   // first sample is kept verbatim, the stream holds the rest
+    int16_t first_temperature;
+    int16_t first_adc;
+    uint16_t count;
+    uint16_t bits;            // bits used in data
+    uint8_t data[HISTORY_BLOCK_BYTES];
+} History_Block;
+
+static_assert(HISTORY_BLOCK_BYTES * 8 <= UINT16_MAX, "block bit count must fit 16 bits");
+static_assert(HISTORY_BLOCKS * sizeof(History_Block) <= 64 * 1024, "history must stay under 64 KB");
+
+// Globals
+static History_Block Blocks[HISTORY_BLOCKS];
+static uint16_t Oldest;     // ring index of the oldest block
+static uint16_t Used;       // blocks holding samples
+static uint32_t Evicted;
+
+static Codec_State Prev;    // encoder state, the last sample of the newest block
+
+/**
+ * Drops every sample, must run before the first append
+ */
+void History_Init(void){
+    Oldest = 0;
+    Used = 0;
+    Evicted = 0;
+}
+
+/**
+ * Starts a new block with this sample stored verbatim, evicting the oldest block if needed
+ */
+static void Open_Block(int32_t time, int32_t humidity, int32_t temperature, int32_t adc){
+    if (Used == HISTORY_BLOCKS){
+        Evicted += Blocks[Oldest].count;
+        Oldest = (Oldest + 1) % HISTORY_BLOCKS;
+        Used--;
+    }
+    History_Block *b = &Blocks[(Oldest + Used) % HISTORY_BLOCKS];
+    Used++;
+
+    memset(b->data, 0, sizeof(b->data));
+    b->first_time = (uint32_t)time;
+    b->last_time = (uint32_t)time;
+    b->first_humidity = (int16_t)humidity;
+    b->first_temperature = (int16_t)temperature;
+    b->first_adc = (int16_t)adc;
+    b->count = 1;
+    b->bits = 0;
+
+    Codec_Start(&Prev, time, humidity, temperature, adc);
+}
+
+/**
+ * Compresses one sample into the newest block
+ * Samples with an invalid DHT20 reading are not kept
+ */
+void History_Append(uint64_t time_us, const Payload_Data *sample){
+    if (!sample->DHT20_Data_Valid)
+        return;
+
+    int32_t time = (int32_t)((time_us / 1000 + HISTORY_TIME_RES_MS / 2) / HISTORY_TIME_RES_MS);
+    History_Block *head = Used ? &Blocks[(Oldest + Used - 1) % HISTORY_BLOCKS] : NULL;
+
+    // dead band against the last kept sample, sensor noise then mostly costs one bit
+    int32_t humidity, temperature, adc;
+    if (head){
+        humidity = Codec_Deadband(sample->DHT20_Data.humidity_centi, HISTORY_CENTI_STEP, Prev.humidity);
+        temperature = Codec_Deadband(sample->DHT20_Data.temperature_centi_c, HISTORY_CENTI_STEP, Prev.temperature);
+        adc = Codec_Deadband(sample->ADC_Data, HISTORY_ADC_STEP, Prev.adc);
+    } else {
+        humidity = Codec_Quantize(sample->DHT20_Data.humidity_centi, HISTORY_CENTI_STEP);
+        temperature = Codec_Quantize(sample->DHT20_Data.temperature_centi_c, HISTORY_CENTI_STEP);
+        adc = Codec_Quantize(sample->ADC_Data, HISTORY_ADC_STEP);
+    }
+
+    if (!head || head->bits + CODEC_MAX_SAMPLE_BITS > HISTORY_BLOCK_BYTES * 8 || head->count == UINT16_MAX){
+        Open_Block(time, humidity, temperature, adc);
+    } else {
+        uint32_t bits = head->bits;
+        Codec_Put_Sample(head->data, &bits, &Prev, time, humidity, temperature, adc);
+        head->bits = (uint16_t)bits;
+        head->count++;
+        head->last_time = (uint32_t)time;
+    }
+}
+
+/**
+ * Reports the space held and the compression ratio against storing raw Payload_Data
+ */
+void History_Get_Stats(History_Stats *stats){
+    uint32_t samples = 0;
+    uint32_t bytes = 0;
+    for (uint16_t i = 0; i < Used; i++){
+        const History_Block *b = &Blocks[(Oldest + i) % HISTORY_BLOCKS];
+        samples += b->count;
+        bytes += offsetof(History_Block, data) + (b->bits + 7) / 8;
+    }
+    stats->samples = samples;
+    stats->evicted = Evicted;
+    stats->bytes = bytes;
+    stats->raw_bytes = samples * sizeof(Payload_Data);
+    stats->ratio_x100 = bytes ? (uint32_t)((uint64_t)stats->raw_bytes * 100 / bytes) : 0;
+}
+
+/**
+ * Starts a read of the samples with from_ms <= time_ms <= to_ms
+ * Run the whole read inside one Core1 task, an append can evict the block being read
+ */
+void History_Iter_Begin(History_Iter *it, uint64_t from_ms, uint64_t to_ms){
+    it->from_ms = from_ms;
+    it->to_ms = to_ms;
+    it->block = 0;
+    it->index = 0;
+    it->bit = 0;
+}
+
+/**
+ * Decodes the next sample in range, returns false once the range or the history ends
+ */
+bool History_Iter_Next(History_Iter *it, History_Sample *out){
+    while (it->block < Used){
+        const History_Block *b = &Blocks[(Oldest + it->block) % HISTORY_BLOCKS];
+
+        if (it->index == 0){
+            // whole block before the range, skip it without decoding
+            if ((uint64_t)b->last_time * HISTORY_TIME_RES_MS < it->from_ms){
+                it->block++;
+                continue;
+            }
+            Codec_Start(&it->prev, (int32_t)b->first_time, b->first_humidity, b->first_temperature, b->first_adc);
+            it->bit = 0;
+        } else if (it->index >= b->count){
+            it->block++;
+            it->index = 0;
+            continue;
+        } else {
+            Codec_Get_Sample(b->data, &it->bit, &it->prev);
+        }
+        it->index++;
+
+        uint64_t time_ms = (uint64_t)(uint32_t)it->prev.time * HISTORY_TIME_RES_MS;
+        if (time_ms < it->from_ms)
+            continue;
+        if (time_ms > it->to_ms){
+            it->block = Used;
+            return false;
+        }
+
+        out->time_ms = time_ms;
+        out->humidity_centi = (uint16_t)(it->prev.humidity * HISTORY_CENTI_STEP);
+        out->temperature_centi_c = (int16_t)(it->prev.temperature * HISTORY_CENTI_STEP);
+        out->adc = (uint16_t)(it->prev.adc * HISTORY_ADC_STEP);
+        return true;
+    }
+    return false;
+}
+
+#if HISTORY_BENCHMARK
+// Benchmark trace, replayed from the flash log when it holds samples, synthetic otherwise
+static bool Trace_From_Flash;
+static Flash_Log_Iter Trace_Flash;
+static uint32_t Trace_Index;
+static uint32_t Trace_Seed;
+static uint64_t Trace_Time_us;
+static uint32_t Trace_Last_s;
+static uint16_t Trace_Last_Boot;
+
+static void Trace_Reset(void){
+    Flash_Log_Iter_Begin(&Trace_Flash);
+    Trace_Index = 0;
+    Trace_Seed = 12345;
+    Trace_Time_us = 0;
+    Trace_Last_Boot = 0;
+}
+
+/**
+ * Returns the benchmark trace one sample at a time
+ * The synthetic trace is 1 Hz with a few ms of jitter, a daily triangle wave on humidity
+ * and temperature with sensor noise, and a day / night light level
+ */
+static bool Trace_Next(uint64_t *time_us, Payload_Data *sample){
+    memset(sample, 0, sizeof(*sample));
+    sample->DHT20_Data_Valid = 1;
+
+    if (Trace_From_Flash){
+        Flash_Log_Sample logged;
+        if (!Flash_Log_Iter_Next(&Trace_Flash, &logged))
+            return false;
+        // boots restart the clock, splice them one second apart into one timeline
+        uint32_t step_s = (Trace_Index && logged.boot == Trace_Last_Boot) ? logged.time_s - Trace_Last_s : 1;
+        Trace_Last_Boot = logged.boot;
+        Trace_Last_s = logged.time_s;
+        Trace_Time_us += (uint64_t)step_s * 1000000;
+        Trace_Index++;
+
+        *time_us = Trace_Time_us;
+        sample->DHT20_Data.humidity_centi = logged.humidity_centi;
+        sample->DHT20_Data.temperature_centi_c = logged.temperature_centi_c;
+        sample->ADC_Data = logged.adc;
+        return true;
+    }
+
+    if (Trace_Index == HISTORY_BENCHMARK_SAMPLES)
+        return false;
+    uint32_t i = Trace_Index++;
+    uint32_t phase = i % 86400;
+    int32_t tri = (phase < 43200) ? (int32_t)phase : (int32_t)(86400 - phase); // 0 .. 43200 over a day
+
+    Trace_Seed = Trace_Seed * 1664525u + 1013904223u;
+    int32_t jitter_us = (int32_t)((Trace_Seed >> 8) % 6000) - 3000;
+    int32_t noise = (int32_t)((Trace_Seed >> 20) & 0x7) - 3;
+
+    *time_us = (uint64_t)i * 1000000 + 80000 + jitter_us;
+    sample->DHT20_Data.humidity_centi = (uint16_t)(4000 + tri / 43 + noise);
+    sample->DHT20_Data.temperature_centi_c = (int16_t)(1900 + tri / 72 + noise / 2);
+    sample->ADC_Data = (uint16_t)(((phase > 25200 && phase < 72000) ? 2600 : 150) + noise);
+    return true;
+}
+
+/**
+ * The dead band keeps a stored value within one step of the input
+ */
+static bool Within_Step(int32_t held, int32_t input, int32_t step){
+    return held - input >= -step && held - input <= step;
+}
+
+/**
+ * Compresses the trace, checks every held sample decodes within a step of the input and prints
+ * the ratio and the append / decode cost
+ */
+void History_Benchmark(void){
+    Flash_Log_Iter probe;
+    Flash_Log_Sample first;
+    Flash_Log_Iter_Begin(&probe);
+    Trace_From_Flash = Flash_Log_Iter_Next(&probe, &first);
+
+    History_Init();
+    Trace_Reset();
+
+    // stage the trace in chunks so only the appends are timed
+    static uint64_t times[256];
+    static Payload_Data samples[256];
+    uint32_t appended = 0;
+    uint64_t append_us = 0;
+    bool more = true;
+    while (more){
+        uint32_t n = 0;
+        while (n < 256 && (more = Trace_Next(&times[n], &samples[n])))
+            n++;
+        uint64_t start = time_us_64();
+        for (uint32_t i = 0; i < n; i++)
+            History_Append(times[i], &samples[i]);
+        append_us += time_us_64() - start;
+        appended += n;
+    }
+
+    History_Stats stats;
+    History_Get_Stats(&stats);
+
+    History_Iter it;
+    History_Sample out;
+    uint32_t decoded = 0;
+    uint64_t first_ms = 0, last_ms = 0;
+    uint64_t start = time_us_64();
+    History_Iter_Begin(&it, 0, UINT64_MAX);
+    while (History_Iter_Next(&it, &out)){
+        if (!decoded)
+            first_ms = out.time_ms;
+        last_ms = out.time_ms;
+        decoded++;
+    }
+    uint64_t decode_us = time_us_64() - start;
+
+    // replay the trace and compare against the held samples
+    uint32_t mismatches = 0;
+    uint32_t skip = stats.evicted;
+    uint64_t time_us;
+    Payload_Data sample;
+    Trace_Reset();
+    History_Iter_Begin(&it, 0, UINT64_MAX);
+    while (Trace_Next(&time_us, &sample)){
+        if (!sample.DHT20_Data_Valid)
+            continue;
+        if (skip){
+            skip--;
+            continue;
+        }
+        if (!History_Iter_Next(&it, &out)){
+            mismatches++;
+            break;
+        }
+        uint64_t time_ms = (time_us / 1000 + HISTORY_TIME_RES_MS / 2) / HISTORY_TIME_RES_MS * HISTORY_TIME_RES_MS;
+        if (out.time_ms != time_ms
+            || !Within_Step(out.humidity_centi, sample.DHT20_Data.humidity_centi, HISTORY_CENTI_STEP)
+            || !Within_Step(out.temperature_centi_c, sample.DHT20_Data.temperature_centi_c, HISTORY_CENTI_STEP)
+            || !Within_Step(out.adc, sample.ADC_Data, HISTORY_ADC_STEP))
+            mismatches++;
+    }
+
+    printf("History (%s trace): %lu appended, %lu held, %lu evicted, %lu mismatches\r\n",
+           Trace_From_Flash ? "flash log" : "synthetic", (unsigned long)appended,
+           (unsigned long)stats.samples, (unsigned long)stats.evicted, (unsigned long)mismatches);
+    printf("History: %lu bytes, ratio %lu.%02lu, %lu bits/sample, span %lu min\r\n",
+           (unsigned long)stats.bytes, (unsigned long)(stats.ratio_x100 / 100), (unsigned long)(stats.ratio_x100 % 100),
+           (unsigned long)(stats.samples ? stats.bytes * 8 / stats.samples : 0),
+           (unsigned long)((last_ms - first_ms) / 60000));
+    printf("History: append %lu ns/sample, decode %lu ns/sample\r\n",
+           (unsigned long)(appended ? append_us * 1000 / appended : 0),
+           (unsigned long)(decoded ? decode_us * 1000 / decoded : 0));
+
+    History_Init();
+}
+#endif
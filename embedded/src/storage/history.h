@@ -0,0 +1,64 @@
+#ifndef __HISTORY_H__
+#define __HISTORY_H__
+
+// Standard Library
+#include <stdint.h>
+#include <stdbool.h>
+
+// User Modules
+#include "../config.h"
+#include "../data_flow/data_flow.h"
+#include "sample_codec.h"
+
+/**
+ * Compressed in-RAM sample history, owned by Core1
+ *
+ * Samples are packed into a ring of fixed size blocks as a bit stream (see sample_codec.h),
+ * the first sample of a block stored verbatim in its header. When all blocks are full the
+ * oldest block is dropped.
+ *
+ * Values are stored in steps of HISTORY_CENTI_STEP / HISTORY_ADC_STEP with a dead band of
+ * one step, so a held value is within a step of the sample, and times in HISTORY_TIME_RES_MS.
+ * Stored times are 32 bit counts of HISTORY_TIME_RES_MS, good for 6.8 years of uptime; the
+ * times read back are 64 bit ms, so they do not wrap with the 32 bit ms clock at 49.7 days.
+ * Append and iteration must both run on Core1.
+ */
+
+// One decoded sample
+typedef struct {
+    uint64_t time_ms;             // time since boot, rounded to HISTORY_TIME_RES_MS
+    uint16_t humidity_centi;
+    int16_t temperature_centi_c;
+    uint16_t adc;
+} History_Sample;
+
+typedef struct {
+    uint32_t samples;        // samples currently held
+    uint32_t evicted;        // samples dropped with their block
+    uint32_t bytes;          // compressed bytes held, block headers included
+    uint32_t raw_bytes;      // the same samples stored as Payload_Data
+    uint32_t ratio_x100;     // raw_bytes / bytes * 100
+} History_Stats;
+
+// Decoder state for a range read, oldest sample first
+typedef struct {
+    uint64_t from_ms;
+    uint64_t to_ms;
+    uint16_t block;          // ordinal from the oldest block
+    uint16_t index;          // next sample inside the block
+    uint32_t bit;
+    Codec_State prev;        // previous sample, in stored units
+} History_Iter;
+
+void History_Init(void);
+void History_Append(uint64_t time_us, const Payload_Data *sample);
+void History_Get_Stats(History_Stats *stats);
+
+void History_Iter_Begin(History_Iter *it, uint64_t from_ms, uint64_t to_ms);
+bool History_Iter_Next(History_Iter *it, History_Sample *out);
+
+#if HISTORY_BENCHMARK
+void History_Benchmark(void);
+#endif
+
+#endif
@@ -0,0 +1,161 @@
+#include "sample_codec.h"
+
+static inline uint32_t Zigzag(int32_t v){
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t Unzigzag(uint32_t v){
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/**
+ * Appends the low n bits of value at *bit, most significant first
+ */
+void Codec_Put_Bits(uint8_t *data, uint32_t *bit, uint32_t value, uint32_t n){
+    while (n){
+        uint32_t free = 8 - (*bit & 7);
+        uint32_t take = (n < free) ? n : free;
+        uint32_t chunk = (value >> (n - take)) & ((1u << take) - 1);
+        data[*bit >> 3] |= (uint8_t)(chunk << (free - take));
+        *bit += take;
+        n -= take;
+    }
+}
+
+/**
+ * Reads n bits starting at *bit, most significant first
+ */
+uint32_t Codec_Get_Bits(const uint8_t *data, uint32_t *bit, uint32_t n){
+    uint32_t value = 0;
+    while (n){
+        uint32_t free = 8 - (*bit & 7);
+        uint32_t take = (n < free) ? n : free;
+        uint32_t chunk = (data[*bit >> 3] >> (free - take)) & ((1u << take) - 1);
+        value = (value << take) | chunk;
+        *bit += take;
+        n -= take;
+    }
+    return value;
+}
+
+/**
+ * Timestamp delta-of-delta: 0 | 10+7 | 110+9 | 1110+12 | 1111+32 bits
+ */
+static void Put_Time(uint8_t *data, uint32_t *bit, int32_t dod){
+    if (dod == 0){
+        Codec_Put_Bits(data, bit, 0x0, 1);
+    } else if (dod >= -63 && dod <= 64){
+        Codec_Put_Bits(data, bit, 0x2, 2);
+        Codec_Put_Bits(data, bit, dod + 63, 7);
+    } else if (dod >= -255 && dod <= 256){
+        Codec_Put_Bits(data, bit, 0x6, 3);
+        Codec_Put_Bits(data, bit, dod + 255, 9);
+    } else if (dod >= -2047 && dod <= 2048){
+        Codec_Put_Bits(data, bit, 0xE, 4);
+        Codec_Put_Bits(data, bit, dod + 2047, 12);
+    } else {
+        Codec_Put_Bits(data, bit, 0xF, 4);
+        Codec_Put_Bits(data, bit, (uint32_t)dod, 32);
+    }
+}
+
+static int32_t Get_Time(const uint8_t *data, uint32_t *bit){
+    if (!Codec_Get_Bits(data, bit, 1))
+        return 0;
+    if (!Codec_Get_Bits(data, bit, 1))
+        return (int32_t)Codec_Get_Bits(data, bit, 7) - 63;
+    if (!Codec_Get_Bits(data, bit, 1))
+        return (int32_t)Codec_Get_Bits(data, bit, 9) - 255;
+    if (!Codec_Get_Bits(data, bit, 1))
+        return (int32_t)Codec_Get_Bits(data, bit, 12) - 2047;
+    return (int32_t)Codec_Get_Bits(data, bit, 32);
+}
+
+/**
+ * Value delta: 0 | 10+sign | 110+4 | 1110+7 | 1111+32 bits, the wider codes hold the zigzagged delta
+ * Sensor noise is mostly a single step either way, which costs 3 bits
+ */
+static void Put_Value(uint8_t *data, uint32_t *bit, int32_t delta){
+    uint32_t zz = Zigzag(delta);
+    if (zz == 0){
+        Codec_Put_Bits(data, bit, 0x0, 1);
+    } else if (zz <= 2){
+        Codec_Put_Bits(data, bit, 0x2, 2);
+        Codec_Put_Bits(data, bit, zz - 1, 1);
+    } else if (zz < 16){
+        Codec_Put_Bits(data, bit, 0x6, 3);
+        Codec_Put_Bits(data, bit, zz, 4);
+    } else if (zz < 128){
+        Codec_Put_Bits(data, bit, 0xE, 4);
+        Codec_Put_Bits(data, bit, zz, 7);
+    } else {
+        Codec_Put_Bits(data, bit, 0xF, 4);
+        Codec_Put_Bits(data, bit, zz, 32);
+    }
+}
+
+static int32_t Get_Value(const uint8_t *data, uint32_t *bit){
+    if (!Codec_Get_Bits(data, bit, 1))
+        return 0;
+    if (!Codec_Get_Bits(data, bit, 1))
+        return Unzigzag(Codec_Get_Bits(data, bit, 1) + 1);
+    if (!Codec_Get_Bits(data, bit, 1))
+        return Unzigzag(Codec_Get_Bits(data, bit, 4));
+    if (!Codec_Get_Bits(data, bit, 1))
+        return Unzigzag(Codec_Get_Bits(data, bit, 7));
+    return Unzigzag(Codec_Get_Bits(data, bit, 32));
+}
+
+/**
+ * Sets the state to a sample stored verbatim outside the stream, the first of a block
+ */
+void Codec_Start(Codec_State *state, int32_t time, int32_t humidity, int32_t temperature, int32_t adc){
+    state->time = time;
+    state->delta_time = 0;
+    state->humidity = humidity;
+    state->temperature = temperature;
+    state->adc = adc;
+}
+
+/**
+ * Codes one sample against prev at *bit, then makes it prev
+ * The caller checks CODEC_MAX_SAMPLE_BITS fit
+ */
+void Codec_Put_Sample(uint8_t *data, uint32_t *bit, Codec_State *prev,
+                      int32_t time, int32_t humidity, int32_t temperature, int32_t adc){
+    int32_t delta_time = time - prev->time;
+    int32_t dod = delta_time - prev->delta_time;
+    int32_t d_humidity = humidity - prev->humidity;
+    int32_t d_temperature = temperature - prev->temperature;
+    int32_t d_adc = adc - prev->adc;
+
+    // one bit for a sample identical to the last one on the same cadence
+    if ((dod | d_humidity | d_temperature | d_adc) == 0){
+        Codec_Put_Bits(data, bit, 0, 1);
+    } else {
+        Codec_Put_Bits(data, bit, 1, 1);
+        Put_Time(data, bit, dod);
+        Put_Value(data, bit, d_humidity);
+        Put_Value(data, bit, d_temperature);
+        Put_Value(data, bit, d_adc);
+    }
+
+    prev->time = time;
+    prev->delta_time = delta_time;
+    prev->humidity = humidity;
+    prev->temperature = temperature;
+    prev->adc = adc;
+}
+
+/**
+ * Decodes the sample at *bit into prev
+ */
+void Codec_Get_Sample(const uint8_t *data, uint32_t *bit, Codec_State *prev){
+    if (Codec_Get_Bits(data, bit, 1)){
+        prev->delta_time += Get_Time(data, bit);
+        prev->humidity += Get_Value(data, bit);
+        prev->temperature += Get_Value(data, bit);
+        prev->adc += Get_Value(data, bit);
+    }
+    prev->time += prev->delta_time;
+}
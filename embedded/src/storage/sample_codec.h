@@ -0,0 +1,56 @@
+#ifndef __SAMPLE_CODEC_H__
+#define __SAMPLE_CODEC_H__
+
+// Standard Library
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Bit stream sample codec shared by the RAM history and the flash log
+ *
+ * A sample is a time and three values (humidity, temperature, ADC) in whatever integer
+ * units the caller stores them in. Each sample is coded against the previous one, Gorilla
+ * style: the time as delta-of-delta, the values as zigzag deltas, with short prefix codes.
+ * A sample where every delta is zero costs a single bit. The values are integers, so plain
+ * deltas replace Gorilla's float XOR.
+ *
+ * Streams are written into zeroed buffers, most significant bit first.
+ */
+
+// Worst case bits for one sample: change flag, escaped timestamp and three escaped values
+#define CODEC_MAX_SAMPLE_BITS (1 + (4 + 32) + 3 * (4 + 32))
+
+// The previous sample, both sides of a stream keep one
+typedef struct {
+    int32_t time;
+    int32_t delta_time;
+    int32_t humidity;
+    int32_t temperature;
+    int32_t adc;
+} Codec_State;
+
+/**
+ * Rounds v to the nearest multiple of step and returns the multiple, half away from zero
+ */
+static inline int32_t Codec_Quantize(int32_t v, int32_t step){
+    return (v >= 0) ? (v + step / 2) / step : -((-v + step / 2) / step);
+}
+
+/**
+ * Quantizes v with a dead band: keeps the previous multiple while v stays within one step
+ * of it, so noise around a step boundary does not flip the stored value every sample
+ * The stored value is at most one step from v instead of half a step
+ */
+static inline int32_t Codec_Deadband(int32_t v, int32_t step, int32_t previous){
+    int32_t error = v - previous * step;
+    return (error >= -step && error <= step) ? previous : Codec_Quantize(v, step);
+}
+
+void Codec_Start(Codec_State *state, int32_t time, int32_t humidity, int32_t temperature, int32_t adc);
+void Codec_Put_Bits(uint8_t *data, uint32_t *bit, uint32_t value, uint32_t n);
+uint32_t Codec_Get_Bits(const uint8_t *data, uint32_t *bit, uint32_t n);
+void Codec_Put_Sample(uint8_t *data, uint32_t *bit, Codec_State *prev,
+                      int32_t time, int32_t humidity, int32_t temperature, int32_t adc);
+void Codec_Get_Sample(const uint8_t *data, uint32_t *bit, Codec_State *prev);
+
+#endif
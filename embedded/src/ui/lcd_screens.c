@@ -6,6 +6,7 @@
 #include "config.h"
 #include "hardware/lcd_i2c.h"
 #include "data_flow/data_flow.h"
+#include "data_flow/latency.h"
 
 /**
  * UI screens for a 16x2 I2C LCD.
@@ -27,9 +28,19 @@ static void pad16(char *dst, const char *src) {
 }
 
 /**
- * Writes 2 16-character lines to the LCD
+ * Formats a centi value as a number with one decimal, rounded to nearest (2250 -> "22.5")
  */
-static void write_2lines(const char *l1, const char *l2) {
+static void format_centi(char *dst, size_t size, int32_t centi) {
+    int32_t tenths = centi >= 0 ? (centi + 5) / 10 : (centi - 5) / 10;
+    const char *sign = tenths < 0 ? "-" : "";
+    if (tenths < 0) tenths = -tenths;
+    snprintf(dst, size, "%s%ld.%ld", sign, (long)(tenths / 10), (long)(tenths % 10));
+}
+
+/**
+ * Writes 2 16-character lines to the LCD, blocking until they are on the glass
+ */
+static void write_2lines_blocking(const char *l1, const char *l2) {
     char a[17], b[17];
     pad16(a, l1);
     pad16(b, l2);
@@ -41,6 +52,73 @@ static void write_2lines(const char *l1, const char *l2) {
     lcd_i2c_write_str(&g_lcd, b);
 }
 
+/**
+ * Frame waiting for the bus while a previous flush is still in flight
+ * Only the newest frame is kept, older pending frames are stale by definition
+ */
+static char pending_l1[17], pending_l2[17];
+static bool pending_frame = false;
+
+/**
+ * Flush completion, runs in the DMA interrupt
+ */
+static void flush_done(void *user_data) {
+    Latency_Flush_Done();
+}
+
+/**
+ * Diffs the two lines against the glass and starts the DMA flush of the changed cells
+ */
+static void start_flush(const char *l1, const char *l2) {
+    char frame[32];
+    memcpy(frame, l1, 16);
+    memcpy(frame + 16, l2, 16);
+
+    // only the cells that differ from the glass are queued
+    Latency_Render_Start();
+    lcd_i2c_begin_frame(&g_lcd);
+    if (!lcd_i2c_queue_frame(&g_lcd, frame) || !lcd_i2c_flush_async(&g_lcd, flush_done, NULL))
+        Latency_Flush_Done(); // nothing to send, the glass already shows the frame
+}
+
+/**
+ * Writes 2 16-character lines to the LCD without waiting for the bus
+ * If a flush is still in flight the frame is parked and sent by ui_lcd_service()
+ * p is the sample the frame shows, for latency tracking, or NULL
+ */
+static void write_2lines(const char *l1, const char *l2, const Payload_Data *p) {
+    pad16(pending_l1, l1);
+    pad16(pending_l2, l2);
+    pending_frame = true;
+    Latency_Tag_Frame(p);
+    ui_lcd_service();
+}
+
+/**
+ * Starts the parked frame once the previous flush has left the bus
+ * Call regularly from the main loop
+ */
+void ui_lcd_service(void) {
+    if (!pending_frame || lcd_i2c_flush_busy(&g_lcd))
+        return;
+    pending_frame = false;
+    start_flush(pending_l1, pending_l2);
+}
+
+/**
+ * Returns the shadow framebuffer counters (cells written, bytes sent and saved)
+ */
+const lcd_i2c_stats_t *ui_lcd_stats(void) {
+    return lcd_i2c_get_stats(&g_lcd);
+}
+
+/**
+ * Returns true while a frame is parked or still being sent
+ */
+bool ui_lcd_busy(void) {
+    return pending_frame || lcd_i2c_flush_busy(&g_lcd);
+}
+
 /**
  * Initializes the I2C bus and the LCD module, loads custom characters and shows the loading screen
  */
@@ -62,14 +140,14 @@ void ui_lcd_init(void) {
  * Shows a loading screen while the system is starting.
  */
 void ui_show_loading(void) {
-    write_2lines("Humidity Sensor", "Loading...");
+    write_2lines("Humidity Sensor", "Loading...", NULL);
 }
 
 /**
  * Shows two custom text lines on the LCD
  */
 void ui_show_custom(const char *line1, const char *line2) {
-    write_2lines(line1 ? line1 : "", line2 ? line2 : "");
+    write_2lines(line1 ? line1 : "", line2 ? line2 : "", NULL);
 }
 
 /**
@@ -83,11 +161,14 @@ void ui_show_dht20_c(const Payload_Data *p) {
         snprintf(l1, sizeof(l1), "Temp: --.-%cC",LCD_CHAR_DEGREE);
         snprintf(l2, sizeof(l2), "Humidity: --%%");
     } else {
-        snprintf(l1, sizeof(l1), "Temp: %2.1f%cC", (double)p->DHT20_Data.temperature_c,LCD_CHAR_DEGREE);
-        snprintf(l2, sizeof(l2), "Humidity: %2.1f%%", (double)p->DHT20_Data.humidity);
+        char temp[8], hum[8];
+        format_centi(temp, sizeof(temp), p->DHT20_Data.temperature_centi_c);
+        format_centi(hum, sizeof(hum), p->DHT20_Data.humidity_centi);
+        snprintf(l1, sizeof(l1), "Temp: %s%cC", temp, LCD_CHAR_DEGREE);
+        snprintf(l2, sizeof(l2), "Humidity: %s%%", hum);
     }
 
-    write_2lines(l1, l2);
+    write_2lines(l1, l2, p);
 }
 
 /**
@@ -101,11 +182,14 @@ void ui_show_dht20_f(const Payload_Data *p) {
         snprintf(l1, sizeof(l1), "Temp: --.-%cF",LCD_CHAR_DEGREE);
         snprintf(l2, sizeof(l2), "Humidity: --%%");
     } else {
-        snprintf(l1, sizeof(l1), "Temp: %2.1f%cF", (double)p->DHT20_Data.temperature_f,LCD_CHAR_DEGREE);
-        snprintf(l2, sizeof(l2), "Humidity: %2.1f%%", (double)p->DHT20_Data.humidity);
+        char temp[8], hum[8];
+        format_centi(temp, sizeof(temp), Centi_C_To_Centi_F(p->DHT20_Data.temperature_centi_c));
+        format_centi(hum, sizeof(hum), p->DHT20_Data.humidity_centi);
+        snprintf(l1, sizeof(l1), "Temp: %s%cF", temp, LCD_CHAR_DEGREE);
+        snprintf(l2, sizeof(l2), "Humidity: %s%%", hum);
     }
 
-    write_2lines(l1, l2);
+    write_2lines(l1, l2, p);
 }
 
 /**
@@ -123,7 +207,34 @@ void ui_show_photores(const Payload_Data *p) {
         snprintf(l2, sizeof(l2), "ADC: %4u", (unsigned)p->ADC_Data);
     }
 
-    write_2lines(l1, l2);
+    write_2lines(l1, l2, p);
+}
+
+/**
+ * Displays the temperature and humidity range over one rolling window, e.g. the last 24 h
+ * The summary comes from core1 as it is, nothing is recomputed here
+ * If no sample is in the window yet, shows placeholder
+ */
+void ui_show_stats(const Stats_Summary *s, Stats_Window_Id window) {
+    static const char *const labels[NUM_STATS_WINDOWS] = {"1m", "1h", "24h"};
+    char l1[32], l2[32];
+
+    const Stats_Window *t = s ? &s->window[STATS_TEMPERATURE][window] : NULL;
+    const Stats_Window *h = s ? &s->window[STATS_HUMIDITY][window] : NULL;
+    if (!t || !t->count || !h->count) {
+        snprintf(l1, sizeof(l1), "%s Temp: --", labels[window]);
+        snprintf(l2, sizeof(l2), "%s Humidity: --", labels[window]);
+    } else {
+        char lo[8], hi[8];
+        format_centi(lo, sizeof(lo), t->min);
+        format_centi(hi, sizeof(hi), t->max);
+        snprintf(l1, sizeof(l1), "%s %s-%s%cC", labels[window], lo, hi, LCD_CHAR_DEGREE);
+        format_centi(lo, sizeof(lo), h->min);
+        format_centi(hi, sizeof(hi), h->max);
+        snprintf(l2, sizeof(l2), "%s %s-%s%%", labels[window], lo, hi);
+    }
+
+    write_2lines(l1, l2, NULL);
 }
 
 /**
@@ -134,5 +245,46 @@ void ui_show_error(const char *line1, const char *line2) {
     if (!line1) line1 = "ERROR";
     if (!line2) line2 = "";
 
-    write_2lines(line1, line2);
+    write_2lines(line1, line2, NULL);
+}
+
+#if LCD_BENCHMARK
+/**
+ * Times full-screen redraws with the per-byte transport, burst mode and the
+ * DMA flush and prints the average redraw time of each over stdio
+ * For the DMA flush the time core0 is actually blocked is printed as well
+ */
+void ui_lcd_benchmark(void) {
+    const int runs = 20;
+
+    for (int burst = 0; burst <= 1; burst++) {
+        lcd_i2c_set_burst(&g_lcd, burst);
+
+        uint64_t start = time_us_64();
+        for (int i = 0; i < runs; i++)
+            write_2lines_blocking((i & 1) ? "Temp: 72.5 F" : "Temp: 72.6 F", "Humidity: 41.3%");
+        uint64_t elapsed = time_us_64() - start;
+
+        printf("LCD redraw (%s): %llu us\r\n", burst ? "burst" : "per-byte", elapsed / runs);
+    }
+    lcd_i2c_set_burst(&g_lcd, true);
+
+    uint64_t queued = 0;
+    uint64_t start = time_us_64();
+    for (int i = 0; i < runs; i++) {
+        uint64_t t = time_us_64();
+        write_2lines((i & 1) ? "Temp: 72.5 F" : "Temp: 72.6 F", "Humidity: 41.3%", NULL);
+        queued += time_us_64() - t;
+        while (ui_lcd_busy())
+            ui_lcd_service();
+    }
+    uint64_t elapsed = time_us_64() - start;
+
+    printf("LCD redraw (dma): %llu us, core0 blocked %llu us\r\n", elapsed / runs, queued / runs);
+
+    const lcd_i2c_stats_t *stats = ui_lcd_stats();
+    printf("LCD shadow: %lu frames, %lu cells, %lu bytes sent, %lu bytes saved\r\n",
+           (unsigned long)stats->frames, (unsigned long)stats->cells_written,
+           (unsigned long)stats->bytes_sent, (unsigned long)stats->bytes_saved);
 }
+#endif
@@ -4,13 +4,23 @@
 #include <stdbool.h>
 
 
+#include "config.h"
 #include "data_flow/data_flow.h"  
+#include "hardware/lcd_i2c.h"
+#include "core1/rolling_stats.h"
 
 void ui_lcd_init(void);
+void ui_lcd_service(void);
+bool ui_lcd_busy(void);
+const lcd_i2c_stats_t *ui_lcd_stats(void);
 void ui_show_loading(void);
 void ui_show_custom(const char *line1, const char *line2);
 
 void ui_show_dht20_c(const Payload_Data *p);
 void ui_show_dht20_f(const Payload_Data *p);
 void ui_show_photores(const Payload_Data *p);
-void ui_show_error(const char *line1, const char *line2);
\ No newline at end of file
+void ui_show_stats(const Stats_Summary *s, Stats_Window_Id window);
+void ui_show_error(const char *line1, const char *line2);
+#if LCD_BENCHMARK
+void ui_lcd_benchmark(void);
+#endif
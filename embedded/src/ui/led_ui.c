@@ -1,10 +1,10 @@
 #include "led_ui.h"
 
-uint32_t Scale_Humidity_Data(float humidity_raw){
-  return (uint32_t) (humidity_raw / (HUMIDITY_MAX / (LED_LENGTH + 1)));
+uint32_t Scale_Humidity_Data(uint32_t humidity_centi){
+  return humidity_centi / ((HUMIDITY_MAX * 100) / (LED_LENGTH + 1));
 }
 
-void Display_Humidity_LED(float humidity_raw){
-  uint32_t idx = Scale_Humidity_Data(humidity_raw);
+void Display_Humidity_LED(uint32_t humidity_centi){
+  uint32_t idx = Scale_Humidity_Data(humidity_centi);
   Display_LED_Array(idx);
 }
\ No newline at end of file
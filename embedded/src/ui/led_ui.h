@@ -4,6 +4,6 @@
 #include "../config.h"
 #include <stdint.h>
 
-void Display_Humidity_LED(float humidity_raw);
+void Display_Humidity_LED(uint32_t humidity_centi); // centi-%RH
 
 #endif
\ No newline at end of file
@@ -0,0 +1,124 @@
+// Host benchmark for the DHT20 count conversion (see src/hardware/dht20_sensor.c)
+//
+// Sweeps every 20-bit count through the firmware's fixed point dht20_convert_raw() and through
+// the float path it replaced (raw / pow(2, 20) * 100, raw / pow(2, 20) * 200 - 50, rounded to
+// centi units), and checks both against an exact double precision reference:
+//
+//   fixed  must agree with the reference bit for bit on every count
+//   float  single precision loses the last bit on some counts; it must stay within one
+//          centi unit, and the counts where it differs from the fixed path are reported
+//
+// Then times both paths over the same counts, in ns and, on x86, TSC ticks per conversion.
+// The on-device DHT20_BENCHMARK gives RP2040 cycles, where the float path is soft float.
+//
+// Built by the host build (-DPICO_PLATFORM=host) as dht20_bench:
+//         cmake --build build_host --target dht20_bench
+// Usage:  ./build_host/dht20_bench
+//
+// Exits 1 if the fixed path differs from the reference on any count, or the float path by
+// more than one centi unit.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// the SDK headers first, they bring C++ headers of their own that cannot sit in extern "C"
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/clocks.h"
+#include "hardware/i2c.h"
+#include "hardware/sync.h"
+extern "C" {
+#include "hardware/dht20_sensor.h"
+}
+
+namespace {
+
+constexpr uint32_t kCodes = 1u << 20;
+
+struct Centi {
+    int32_t humidity;
+    int32_t temperature;
+};
+
+// the conversion before the fixed point path, kept here as the baseline
+inline Centi FloatPath(uint32_t raw_humidity, uint32_t raw_temp) {
+    float denominator = pow(2, 20);
+    float humidity = (raw_humidity / denominator) * 100;
+    float temperature_c = (raw_temp / denominator) * 200 - 50;
+    return {static_cast<int32_t>(std::floor(humidity * 100 + 0.5f)),
+            static_cast<int32_t>(std::floor(temperature_c * 100 + 0.5f))};
+}
+
+// doubles hold raw * 20000 exactly, so this is the correctly rounded result
+Centi Exact(uint32_t raw) {
+    return {static_cast<int32_t>(std::floor(raw * 10000.0 / kCodes + 0.5)),
+            static_cast<int32_t>(std::floor(raw * 20000.0 / kCodes + 0.5)) - 5000};
+}
+
+inline uint64_t Ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+struct Timing {
+    double ns;
+    double ticks;
+};
+
+template <typename F> Timing Time(F convert) {
+    const int passes = 8;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t t0 = Ticks();
+    for (int p = 0; p < passes; p++)
+        for (uint32_t raw = 0; raw < kCodes; raw++)
+            convert(raw);
+    uint64_t ticks = Ticks() - t0;
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    double n = static_cast<double>(passes) * kCodes;
+    return {ns / n, ticks / n};
+}
+
+} // namespace
+
+int main() {
+    uint32_t fixed_mismatches = 0, float_mismatches = 0, float_off = 0;
+    DHT20_Reading reading;
+    for (uint32_t raw = 0; raw < kCodes; raw++) {
+        dht20_convert_raw(raw, raw, &reading);
+        Centi exact = Exact(raw);
+        Centi f = FloatPath(raw, raw);
+        if (reading.humidity_centi != exact.humidity || reading.temperature_centi_c != exact.temperature ||
+            reading.raw_humidity != raw || reading.raw_temperature != raw)
+            fixed_mismatches++;
+        if (f.humidity != reading.humidity_centi || f.temperature != reading.temperature_centi_c)
+            float_mismatches++;
+        if (std::abs(f.humidity - exact.humidity) > 1 || std::abs(f.temperature - exact.temperature) > 1)
+            float_off++;
+    }
+
+    volatile int32_t sink = 0;
+    Timing fixed = Time([&](uint32_t raw) {
+        dht20_convert_raw(raw, raw ^ 0x5A5A5, &reading);
+        sink = reading.temperature_centi_c;
+    });
+    Timing flt = Time([&](uint32_t raw) { sink = FloatPath(raw, raw ^ 0x5A5A5).temperature; });
+    (void)sink;
+
+    bool ok = !fixed_mismatches && !float_off;
+    std::printf("fixed: %.2f ns, %.1f ticks per conversion, %u of %u counts differ from exact\n", fixed.ns,
+                fixed.ticks, fixed_mismatches, kCodes);
+    std::printf("float: %.2f ns, %.1f ticks per conversion, %u counts round differently, %u off by more than 0.01\n",
+                flt.ns, flt.ticks, float_mismatches, float_off);
+    std::printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+// Host benchmark for the compressed RAM history (see src/storage/history.h) over a recorded trace
+//
+// Reads the sample rows of a telemetry capture, as written by telemetry_decode, and feeds
+// sensor 0 once, in order, to the firmware's History_Append() with the default config. Once
+// the history evicts, the span it holds is what that data fits at its sample rate, so the
+// trace must be longer than that: days, recorded from the sim's default day run faster than
+// real time with SIM_SPEED. Every held sample is then compared with its input: the time
+// within HISTORY_TIME_RES_MS and the values within one step.
+//
+// Built by the host build (-DPICO_PLATFORM=host) as history_bench:
+//         cmake --build build_host --target history_bench
+// Usage:  SIM_SPEED=500 SIM_RUN_S=172800 SIM_LCD_TRACE=0 ./build_host/humidity-sensor < /dev/null > days.bin
+//         ./telemetry_decode days.bin > days.csv
+//         ./build_host/history_bench --min-days 1 days.csv
+//
+// Exits 1 if a held sample is off by more than a step, or the history spans less than --min-days.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "storage/history.h"
+}
+
+namespace {
+
+struct Input {
+    uint64_t time_ms;
+    uint16_t humidity_centi;
+    int16_t temperature_centi_c;
+    uint16_t adc;
+    bool valid;
+};
+
+std::vector<std::string> SplitCsv(const std::string &line) {
+    std::vector<std::string> fields;
+    std::stringstream in(line);
+    std::string field;
+    while (std::getline(in, field, ','))
+        fields.push_back(field);
+    if (!line.empty() && line.back() == ',')
+        fields.emplace_back();
+    return fields;
+}
+
+int Column(const std::vector<std::string> &header, const char *name) {
+    for (size_t i = 0; i < header.size(); i++)
+        if (header[i] == name)
+            return static_cast<int>(i);
+    return -1;
+}
+
+bool LoadTrace(const char *path, std::vector<Input> &out) {
+    std::ifstream in(path);
+    if (!in) {
+        std::perror(path);
+        return false;
+    }
+    std::string line;
+    if (!std::getline(in, line))
+        return false;
+    std::vector<std::string> header = SplitCsv(line);
+    int kind = Column(header, "kind"), time = Column(header, "time_ms");
+    int humidity = Column(header, "humidity_pct"), temperature = Column(header, "temperature_c");
+    int adc = Column(header, "adc"), valid = Column(header, "valid"), sensor = Column(header, "sensor");
+    if (kind < 0 || time < 0 || humidity < 0 || temperature < 0 || adc < 0 || valid < 0 || sensor < 0) {
+        std::fprintf(stderr, "%s: not a telemetry_decode CSV\n", path);
+        return false;
+    }
+
+    while (std::getline(in, line)) {
+        std::vector<std::string> f = SplitCsv(line);
+        if (f.size() < header.size() || f[kind] != "sample" || std::atoi(f[sensor].c_str()) != 0)
+            continue;
+        Input s;
+        s.time_ms = std::strtoull(f[time].c_str(), nullptr, 10);
+        s.humidity_centi = static_cast<uint16_t>(std::lround(std::atof(f[humidity].c_str()) * 100));
+        s.temperature_centi_c = static_cast<int16_t>(std::lround(std::atof(f[temperature].c_str()) * 100));
+        s.adc = static_cast<uint16_t>(std::atoi(f[adc].c_str()));
+        s.valid = std::atoi(f[valid].c_str()) != 0;
+        out.push_back(s);
+    }
+    return true;
+}
+
+bool WithinStep(int32_t held, int32_t input, int32_t step) {
+    return held - input >= -step && held - input <= step;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    double min_days = 0;
+    const char *path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--min-days") && i + 1 < argc) {
+            min_days = std::atof(argv[++i]);
+        } else if (argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            path = nullptr;
+            break;
+        }
+    }
+    if (!path) {
+        std::fprintf(stderr, "usage: %s [--min-days D] capture.csv\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<Input> trace;
+    if (!LoadTrace(path, trace))
+        return 1;
+    if (trace.size() < 2) {
+        std::fprintf(stderr, "%s: need at least two sensor 0 samples\n", path);
+        return 1;
+    }
+
+    // one pass, keeping every kept input for the check
+    History_Init();
+    auto start = std::chrono::steady_clock::now();
+    for (const Input &in : trace) {
+        Payload_Data sample = {};
+        sample.DHT20_Data.humidity_centi = in.humidity_centi;
+        sample.DHT20_Data.temperature_centi_c = in.temperature_centi_c;
+        sample.ADC_Data = in.adc;
+        sample.DHT20_Data_Valid = in.valid;
+        History_Append(in.time_ms * 1000, &sample);
+    }
+    double append_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::vector<Input> appended;
+    for (const Input &in : trace)
+        if (in.valid)
+            appended.push_back(in);
+    History_Stats stats;
+    History_Get_Stats(&stats);
+
+    // the held samples are the newest stats.samples inputs
+    History_Iter it;
+    History_Sample out;
+    uint32_t mismatches = 0;
+    uint64_t first_ms = 0, last_ms = 0;
+    size_t next = appended.size() - stats.samples;
+    History_Iter_Begin(&it, 0, UINT64_MAX);
+    while (History_Iter_Next(&it, &out)) {
+        if (next == appended.size()) {
+            mismatches++;
+            break;
+        }
+        if (next == appended.size() - stats.samples)
+            first_ms = out.time_ms;
+        last_ms = out.time_ms;
+        const Input &in = appended[next++];
+        uint64_t time_ms = (in.time_ms + HISTORY_TIME_RES_MS / 2) / HISTORY_TIME_RES_MS * HISTORY_TIME_RES_MS;
+        if (out.time_ms != time_ms || !WithinStep(out.humidity_centi, in.humidity_centi, HISTORY_CENTI_STEP) ||
+            !WithinStep(out.temperature_centi_c, in.temperature_centi_c, HISTORY_CENTI_STEP) ||
+            !WithinStep(out.adc, in.adc, HISTORY_ADC_STEP))
+            mismatches++;
+    }
+    mismatches += static_cast<uint32_t>(appended.size() - next);
+
+    double days = (last_ms - first_ms) / 86400e3;
+    double bits = stats.samples ? stats.bytes * 8.0 / stats.samples : 0;
+    bool ok = !mismatches && days >= min_days;
+    std::printf("trace %s: %zu samples over %.2f days\n", path, trace.size(),
+                (trace.back().time_ms - trace.front().time_ms) / 86400e3);
+    std::printf("history: %u samples in %u bytes, %.2f bits/sample, ratio %u.%02u, span %.2f days%s\n",
+                stats.samples, stats.bytes, bits, stats.ratio_x100 / 100, stats.ratio_x100 % 100, days,
+                stats.evicted ? "" : " (not full, the trace is shorter than the history)");
+    std::printf("history: %.0f ns/append, %u samples off by more than a step %s\n",
+                appended.empty() ? 0 : append_s * 1e9 / appended.size(), mismatches, ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+// Host benchmark for the photoresistor decimation kernels (see src/hardware/photores_filter.h)
+//
+// Runs Photo_Filter_Mean() and Photo_Filter_Median() over blocks of PHOTO_OVERSAMPLE samples:
+// random noise around random levels, plus the edge cases (flat, full scale, alternating rails,
+// error flag bits above the 12-bit result). Every result is checked against a reference
+// computed with doubles and std::sort, then both kernels are timed per block. The firmware
+// pairs the median with the variance from Photo_Filter_Mean(), so "median+variance" times both.
+//
+// Built by the host build (-DPICO_PLATFORM=host) as photo_bench:
+//         cmake --build build_host --target photo_bench
+// Usage:  ./build_host/photo_bench
+//         ./build_host/photo_bench --blocks 1000000
+//
+// Exits 1 if a kernel disagrees with the reference on any block.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "config.h"
+extern "C" {
+#include "hardware/photores_filter.h"
+}
+
+namespace {
+
+constexpr uint32_t kN = PHOTO_OVERSAMPLE;
+
+struct Result {
+    uint16_t mean;
+    uint32_t variance;
+    uint16_t median;
+};
+
+// exact mean and population variance rounded to nearest, median of the 12-bit values
+Result Reference(const uint16_t *samples) {
+    std::vector<uint16_t> x(samples, samples + kN);
+    double sum = 0, sum_sq = 0;
+    for (uint16_t &v : x) {
+        v &= 0x0FFF;
+        sum += v;
+        sum_sq += static_cast<double>(v) * v;
+    }
+    double mean = sum / kN;
+    double variance = (kN * sum_sq - sum * sum) / (static_cast<double>(kN) * kN);
+    std::sort(x.begin(), x.end());
+    uint16_t median = (kN & 1) ? x[kN / 2] : static_cast<uint16_t>((x[kN / 2 - 1] + x[kN / 2] + 1) / 2);
+    return {static_cast<uint16_t>(std::floor(mean + 0.5)), static_cast<uint32_t>(std::floor(variance + 0.5)), median};
+}
+
+Result Kernels(const uint16_t *samples, uint16_t *scratch) {
+    Result r;
+    Photo_Filter_Mean(samples, kN, &r.mean, &r.variance);
+    r.median = Photo_Filter_Median(samples, kN, scratch);
+    return r;
+}
+
+void Fill(std::mt19937 &rng, uint16_t *samples, uint32_t block) {
+    switch (block) {
+    case 0: std::fill(samples, samples + kN, 0); return;
+    case 1: std::fill(samples, samples + kN, 4095); return;
+    case 2:
+        for (uint32_t i = 0; i < kN; i++)
+            samples[i] = (i & 1) ? 4095 : 0;
+        return;
+    case 3:
+        for (uint32_t i = 0; i < kN; i++)
+            samples[i] = static_cast<uint16_t>(0x8000 | (rng() & 0x0FFF)); // ADC error flag set
+        return;
+    default: break;
+    }
+    int level = static_cast<int>(rng() % 4096);
+    int spread = 1 << (rng() % 12);
+    for (uint32_t i = 0; i < kN; i++) {
+        int v = level + static_cast<int>(rng() % (2 * spread + 1)) - spread;
+        samples[i] = static_cast<uint16_t>(std::clamp(v, 0, 4095));
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    uint32_t blocks = 200000;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--blocks") && i + 1 < argc) {
+            blocks = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            std::fprintf(stderr, "usage: %s [--blocks N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::mt19937 rng(12345);
+    uint16_t samples[kN];
+    uint16_t scratch[kN];
+    uint32_t mean_errors = 0, median_errors = 0;
+    for (uint32_t b = 0; b < blocks; b++) {
+        Fill(rng, samples, b);
+        Result want = Reference(samples);
+        Result got = Kernels(samples, scratch);
+        mean_errors += got.mean != want.mean || got.variance != want.variance;
+        median_errors += got.median != want.median;
+    }
+
+    // time on a fixed set of noisy blocks so both kernels see the same data
+    const uint32_t set = 256, runs = 2000;
+    std::vector<uint16_t> data(set * kN);
+    for (uint32_t b = 0; b < set; b++)
+        Fill(rng, &data[b * kN], 4 + b);
+    volatile uint32_t sink = 0;
+    uint16_t mean;
+    uint32_t variance;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < runs; r++)
+        for (uint32_t b = 0; b < set; b++) {
+            Photo_Filter_Mean(&data[b * kN], kN, &mean, &variance);
+            sink = sink + mean + variance;
+        }
+    double mean_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < runs; r++)
+        for (uint32_t b = 0; b < set; b++) {
+            Photo_Filter_Mean(&data[b * kN], kN, &mean, &variance);
+            sink = sink + Photo_Filter_Median(&data[b * kN], kN, scratch) + variance;
+        }
+    double median_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    (void)sink;
+
+    bool ok = !mean_errors && !median_errors;
+    std::printf("%u blocks of %u samples: %u mean/variance and %u median results differ from the reference\n",
+                blocks, kN, mean_errors, median_errors);
+    std::printf("mean+variance %.0f ns/block, median+variance %.0f ns/block %s\n", mean_ns / (runs * set),
+                median_ns / (runs * set), ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
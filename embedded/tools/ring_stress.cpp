@@ -0,0 +1,173 @@
+// Host stress test for the core1 -> core0 sample ring (see src/data_flow/ring_buffer.h)
+//
+// A producer and a consumer thread stand in for the two cores and push and pop sequence
+// numbered payloads through a small ring, so it runs full and empty over and over. Two runs:
+//
+//   lossy     the producer moves on when the ring is full, as core1 does; every payload that
+//             arrives is newer than the one before, and pushed - dropped == popped
+//   lossless  the producer retries until the ring takes the payload; every sequence number
+//             arrives exactly once, in order
+//
+// Every field of a payload is derived from its sequence number, so a payload read while the
+// producer was still writing it shows up as a mismatch.
+//
+// Built by the host build (-DPICO_PLATFORM=host) as ring_stress, against the SDK's host
+// hardware_sync fences:
+//         cmake --build build_host --target ring_stress
+// Usage:  ./build_host/ring_stress
+//         ./build_host/ring_stress --samples 10000000 --size 4
+//
+// Exits 1 if a payload arrives out of order, torn or not at all.
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// the SDK headers first, they bring C++ headers of their own that cannot sit in extern "C"
+#include "hardware/sync.h"
+#include "pico/multicore.h"
+extern "C" {
+#include "data_flow/ring_buffer.h"
+}
+
+namespace {
+
+struct Run {
+    Ring_Buffer ring;
+    uint64_t samples;
+    bool retry;                    // lossless: retry a full ring instead of dropping
+    volatile bool producer_done;
+    uint64_t pushed;               // accepted by the ring
+    uint64_t popped;
+    uint64_t out_of_order;
+    uint64_t torn;
+};
+
+void Fill(Payload_Data *p, uint64_t seq) {
+    p->time_stamp = seq;
+    for (int s = 0; s < NUM_STAGES; s++)
+        p->stage_us[s] = static_cast<uint32_t>(seq * 7 + s);
+    p->ADC_Data = static_cast<uint16_t>(seq & 0xFFF);
+    p->ADC_Variance = static_cast<uint32_t>(~seq);
+    p->DHT20_Data.raw_humidity = static_cast<uint32_t>(seq >> 3);
+    p->DHT20_Data.raw_temperature = static_cast<uint32_t>(seq * 3);
+    p->DHT20_Data.humidity_centi = static_cast<uint16_t>(seq * 5);
+    p->DHT20_Data.temperature_centi_c = static_cast<int16_t>(seq * 11);
+    p->DHT20_Data_Valid = static_cast<int>(seq & 1);
+    p->DHT20_Sensor = static_cast<uint8_t>(seq % 3);
+}
+
+bool Intact(const Payload_Data *p) {
+    Payload_Data want;
+    Fill(&want, p->time_stamp);
+    bool same = p->ADC_Data == want.ADC_Data && p->ADC_Variance == want.ADC_Variance &&
+                p->DHT20_Data.raw_humidity == want.DHT20_Data.raw_humidity &&
+                p->DHT20_Data.raw_temperature == want.DHT20_Data.raw_temperature &&
+                p->DHT20_Data.humidity_centi == want.DHT20_Data.humidity_centi &&
+                p->DHT20_Data.temperature_centi_c == want.DHT20_Data.temperature_centi_c &&
+                p->DHT20_Data_Valid == want.DHT20_Data_Valid && p->DHT20_Sensor == want.DHT20_Sensor;
+    for (int s = 0; s < NUM_STAGES; s++)
+        same = same && p->stage_us[s] == want.stage_us[s];
+    return same;
+}
+
+void *Producer(void *arg) {
+    Run *run = static_cast<Run *>(arg);
+    Payload_Data p;
+    for (uint64_t seq = 0; seq < run->samples; seq++) {
+        Fill(&p, seq);
+        bool accepted;
+        // a full ring gives the consumer a turn, as the next sample period would on the board,
+        // and on a single CPU the consumer would not run otherwise
+        while (!(accepted = Ring_Buffer_Push(&run->ring, &p))) {
+            sched_yield();
+            if (!run->retry)
+                break;
+        }
+        run->pushed += accepted;
+    }
+    __atomic_store_n(&run->producer_done, true, __ATOMIC_RELEASE);
+    return nullptr;
+}
+
+void *Consumer(void *arg) {
+    Run *run = static_cast<Run *>(arg);
+    Payload_Data p;
+    uint64_t next = 0; // lowest sequence number that may arrive next
+    for (;;) {
+        if (!Ring_Buffer_Pop(&run->ring, &p)) {
+            // the producer may have pushed between the failed pop and seeing it finish
+            if (__atomic_load_n(&run->producer_done, __ATOMIC_ACQUIRE) && Ring_Buffer_Empty(&run->ring))
+                break;
+            sched_yield();
+            continue;
+        }
+        uint64_t seq = p.time_stamp;
+        if (seq < next || (run->retry && seq != next))
+            run->out_of_order++;
+        if (!Intact(&p))
+            run->torn++;
+        next = seq + 1;
+        run->popped++;
+    }
+    return nullptr;
+}
+
+bool Stress(uint64_t samples, uint16_t size, bool retry) {
+    std::vector<Payload_Data> storage(size);
+    Run run = {};
+    Ring_Buffer_Init(&run.ring, storage.data(), size);
+    run.samples = samples;
+    run.retry = retry;
+
+    auto start = std::chrono::steady_clock::now();
+    pthread_t producer, consumer;
+    pthread_create(&consumer, nullptr, Consumer, &run);
+    pthread_create(&producer, nullptr, Producer, &run);
+    pthread_join(producer, nullptr);
+    pthread_join(consumer, nullptr);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t dropped = run.ring.dropped; // lossless counts each refused retry here
+    bool counted = retry ? run.pushed == samples && run.popped == samples
+                         : run.pushed + dropped == samples && run.popped == samples - dropped;
+    bool ok = counted && !run.out_of_order && !run.torn;
+    std::printf("%-8s %llu samples through %u slots: %llu popped, %llu dropped, %llu out of order, %llu torn,"
+                " %.1f M samples/s %s\n",
+                retry ? "lossless" : "lossy", static_cast<unsigned long long>(samples), size,
+                static_cast<unsigned long long>(run.popped), static_cast<unsigned long long>(dropped),
+                static_cast<unsigned long long>(run.out_of_order), static_cast<unsigned long long>(run.torn),
+                run.popped / seconds / 1e6, ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    uint64_t samples = 4000000;
+    unsigned long size = 8;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--samples") && i + 1 < argc) {
+            samples = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--size") && i + 1 < argc) {
+            size = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            std::fprintf(stderr, "usage: %s [--samples N] [--size SLOTS]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (size < 2 || size > UINT16_MAX) {
+        std::fprintf(stderr, "usage: %s [--samples N] [--size SLOTS]\n", argv[0]);
+        return 2;
+    }
+
+    bool ok = Stress(samples, static_cast<uint16_t>(size), false);
+    ok = Stress(samples, static_cast<uint16_t>(size), true) && ok;
+    return ok ? 0 : 1;
+}
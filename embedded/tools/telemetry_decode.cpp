@@ -0,0 +1,236 @@
+// Host decoder for the firmware's binary telemetry stream (see src/data_flow/telemetry.h)
+//
+// Reads COBS frames from a file, a pipe or the Pico's CDC device, checks the CRC and the
+// per-core sequence numbers, and writes one CSV row per record to stdout. A summary goes to
+// stderr at the end, and every few seconds while reading a live device.
+//
+// Build:  c++ -std=c++17 -O2 -o telemetry_decode telemetry_decode.cpp
+// Usage:  stty -F /dev/ttyACM0 raw && ./telemetry_decode /dev/ttyACM0 > samples.csv
+//         ./telemetry_decode --min-rate 100 capture.bin   exits 1 unless samples arrived at
+//                                                         100 Hz or more with no lost frames
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+enum RecordType : uint8_t { kSample = 1, kEvent = 2, kCounters = 3, kStats = 4 };
+
+const char *const kStatsChannels[] = {"humidity_pct", "temperature_c", "light_adc"};
+const char *const kStatsWindows[] = {"1m", "1h", "24h"};
+
+constexpr size_t kHeaderLen = 7; // type/core, u16 sequence, u32 time_ms
+constexpr size_t kCrcLen = 2;
+
+struct Stats {
+    uint64_t bytes = 0;
+    uint64_t frames = 0;
+    uint64_t cobs_errors = 0;
+    uint64_t crc_errors = 0;
+    uint64_t bad_records = 0;
+    uint64_t lost = 0;             // frames missing from the sequence numbers
+    uint64_t samples = 0;
+    uint32_t first_sample_ms = 0;
+    uint32_t last_sample_ms = 0;
+    bool seq_valid[2] = {false, false};
+    uint16_t next_seq[2] = {0, 0};
+};
+
+uint16_t Crc16(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= static_cast<uint16_t>(data[i]) << 8;
+        for (int b = 0; b < 8; b++)
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+    }
+    return crc;
+}
+
+// Decodes one COBS frame without its delimiter, returns false on a malformed frame
+bool CobsDecode(const std::vector<uint8_t> &in, std::vector<uint8_t> &out) {
+    out.clear();
+    size_t i = 0;
+    while (i < in.size()) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > in.size())
+            return false;
+        out.insert(out.end(), in.begin() + i, in.begin() + i + code - 1);
+        i += code - 1;
+        if (code != 0xFF && i < in.size())
+            out.push_back(0);
+    }
+    return true;
+}
+
+uint16_t U16(const uint8_t *p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+uint32_t U32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24); }
+
+void PrintHeader() {
+    std::printf("kind,core,seq,time_ms,humidity_pct,temperature_c,adc,valid,event,state,"
+                "ring_dropped,telemetry_dropped,idle_ms,e2e_p99_us,flash_errors,uplink_dropped,uplink_failures,"
+                "uplink_batches,sensor,"
+                "channel,window,count,min,max,mean,stddev,ema,rate_per_h\n");
+}
+
+// A partial first frame (attached mid stream) is dropped without counting as an error
+void HandleRecord(const std::vector<uint8_t> &rec, Stats &stats, bool partial) {
+    if (rec.size() < kHeaderLen + kCrcLen) {
+        stats.bad_records += !partial;
+        return;
+    }
+    size_t body = rec.size() - kCrcLen;
+    if (Crc16(rec.data(), body) != U16(&rec[body])) {
+        stats.crc_errors += !partial;
+        return;
+    }
+
+    uint8_t type = rec[0] & 0x7F;
+    int core = rec[0] >> 7;
+    uint16_t seq = U16(&rec[1]);
+    uint32_t time_ms = U32(&rec[3]);
+    const uint8_t *p = &rec[kHeaderLen];
+    size_t len = body - kHeaderLen;
+
+    if (stats.seq_valid[core])
+        stats.lost += static_cast<uint16_t>(seq - stats.next_seq[core]);
+    stats.seq_valid[core] = true;
+    stats.next_seq[core] = static_cast<uint16_t>(seq + 1);
+
+    switch (type) {
+    case kSample:
+        // firmware from before multi-sensor support leaves out the sensor byte
+        if (len != 7 && len != 8)
+            break;
+        if (!stats.samples)
+            stats.first_sample_ms = time_ms;
+        stats.last_sample_ms = time_ms;
+        stats.samples++;
+        std::printf("sample,%d,%u,%u,%.2f,%.2f,%u,%u,,,,,,,,,,,%u,,,,,,,,,\n", core, seq, time_ms, U16(p) / 100.0,
+                    static_cast<int16_t>(U16(p + 2)) / 100.0, U16(p + 4), p[6], len == 8 ? p[7] : 0);
+        return;
+    case kEvent:
+        if (len != 2)
+            break;
+        std::printf("event,%d,%u,%u,,,,,%u,%u,,,,,,,,,,,,,,,,,,\n", core, seq, time_ms, p[0], p[1]);
+        return;
+    case kCounters:
+        // firmware from before the uplink counters sends the first five
+        if (len != 20 && len != 32)
+            break;
+        std::printf("counters,%d,%u,%u,,,,,,,%u,%u,%u,%u,%u,", core, seq, time_ms, U32(p), U32(p + 4), U32(p + 8),
+                    U32(p + 12), U32(p + 16));
+        if (len == 32)
+            std::printf("%u,%u,%u,,,,,,,,,,\n", U32(p + 20), U32(p + 24), U32(p + 28));
+        else
+            std::printf(",,,,,,,,,,,,\n");
+        return;
+    case kStats: {
+        if (len != 20 || p[0] > 2 || p[1] > 2)
+            break;
+        // humidity and temperature are in hundredths, light in ADC counts
+        double scale = p[0] == 2 ? 1.0 : 100.0;
+        std::printf("stats,%d,%u,%u,,,,,,,,,,,,,,,,%s,%s,%u,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f\n", core, seq, time_ms,
+                    kStatsChannels[p[0]], kStatsWindows[p[1]], U32(p + 2), static_cast<int16_t>(U16(p + 6)) / scale,
+                    static_cast<int16_t>(U16(p + 8)) / scale, static_cast<int16_t>(U16(p + 10)) / scale,
+                    U16(p + 12) / scale, static_cast<int16_t>(U16(p + 14)) / scale,
+                    static_cast<int32_t>(U32(p + 16)) / scale);
+        return;
+    }
+    default:
+        break;
+    }
+    stats.bad_records++;
+}
+
+double SampleRate(const Stats &stats) {
+    if (stats.samples < 2 || stats.last_sample_ms == stats.first_sample_ms)
+        return 0.0;
+    return (stats.samples - 1) * 1000.0 / (stats.last_sample_ms - stats.first_sample_ms);
+}
+
+void PrintSummary(const Stats &stats, double wall_s) {
+    std::fprintf(stderr,
+                 "%llu bytes, %llu frames, %llu samples at %.1f Hz (device clock), %llu lost, "
+                 "%llu crc errors, %llu cobs errors, %llu bad records",
+                 (unsigned long long)stats.bytes, (unsigned long long)stats.frames,
+                 (unsigned long long)stats.samples, SampleRate(stats), (unsigned long long)stats.lost,
+                 (unsigned long long)stats.crc_errors, (unsigned long long)stats.cobs_errors,
+                 (unsigned long long)stats.bad_records);
+    if (wall_s > 0)
+        std::fprintf(stderr, ", %.0f B/s", stats.bytes / wall_s);
+    std::fprintf(stderr, "\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    double min_rate = 0.0;
+    const char *path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--min-rate") && i + 1 < argc) {
+            min_rate = std::atof(argv[++i]);
+        } else if (argv[i][0] == '-' && argv[i][1]) {
+            std::fprintf(stderr, "usage: %s [--min-rate HZ] [file|-]\n", argv[0]);
+            return 2;
+        } else {
+            path = argv[i];
+        }
+    }
+
+    FILE *in = (!path || !std::strcmp(path, "-")) ? stdin : std::fopen(path, "rb");
+    if (!in) {
+        std::perror(path);
+        return 2;
+    }
+
+    Stats stats;
+    std::vector<uint8_t> frame, record;
+    uint8_t buf[4096];
+    auto start = std::chrono::steady_clock::now();
+    auto next_report = start + std::chrono::seconds(5);
+    bool first = true;
+
+    PrintHeader();
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), in)) > 0) {
+        stats.bytes += n;
+        for (size_t i = 0; i < n; i++) {
+            if (buf[i]) {
+                frame.push_back(buf[i]);
+                continue;
+            }
+            if (!frame.empty()) {
+                stats.frames++;
+                if (CobsDecode(frame, record))
+                    HandleRecord(record, stats, first);
+                else
+                    stats.cobs_errors += !first;
+            }
+            first = false;
+            frame.clear();
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= next_report) {
+            std::fflush(stdout);
+            PrintSummary(stats, std::chrono::duration<double>(now - start).count());
+            next_report = now + std::chrono::seconds(5);
+        }
+    }
+    if (in != stdin)
+        std::fclose(in);
+
+    PrintSummary(stats, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    if (min_rate > 0.0) {
+        bool ok = SampleRate(stats) >= min_rate && stats.lost == 0 && stats.crc_errors == 0 && stats.cobs_errors == 0;
+        std::fprintf(stderr, "%s: %.1f Hz against %.1f Hz required\n", ok ? "PASS" : "FAIL", SampleRate(stats), min_rate);
+        return ok ? 0 : 1;
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+// Local stand-in for the backend's /ingest, for testing the firmware uplink (see src/network/uplink.h)
+//
+// Accepts one HTTP POST per connection, writes the samples of each batch to stdout as NDJSON
+// lines (binary batches are decoded, see src/data_flow/wire.h) and a line per request to
+// stderr, and answers 204. It can refuse requests or answer slowly so the retry path and the
+// never-blocking queue can be exercised.
+//
+// Build:  c++ -std=c++17 -O2 -o uplink_sink uplink_sink.cpp ../src/data_flow/wire.c
+// Usage:  ./uplink_sink --port 3001 > samples.ndjson
+//         SIM_UPLINK=127.0.0.1:3001 ./build_host/humidity-sensor > /dev/null
+//         ./uplink_sink --fail-every 3 --delay-ms 2000   every third request gets a 503, each
+//                                                        answer comes 2 s late
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "../src/data_flow/wire.h"
+
+namespace {
+
+struct Options {
+    int port = 3001;
+    int fail_every = 0;
+    int delay_ms = 0;
+};
+
+bool ReadRequest(int fd, std::string &head, std::string &body) {
+    std::string data;
+    char buf[4096];
+    size_t header_end = std::string::npos;
+    size_t length = 0;
+
+    while (true) {
+        if (header_end == std::string::npos) {
+            header_end = data.find("\r\n\r\n");
+            if (header_end != std::string::npos) {
+                head = data.substr(0, header_end);
+                const char *cl = strcasestr(head.c_str(), "\r\ncontent-length:");
+                length = cl ? std::strtoul(cl + 17, nullptr, 10) : 0;
+            }
+        }
+        if (header_end != std::string::npos && data.size() >= header_end + 4 + length) {
+            body = data.substr(header_end + 4, length);
+            return true;
+        }
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+            return false;
+        data.append(buf, n);
+    }
+}
+
+void Reply(int fd, const char *status) {
+    std::string r = std::string("HTTP/1.1 ") + status + "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    send(fd, r.data(), r.size(), MSG_NOSIGNAL);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--port") && i + 1 < argc) {
+            opt.port = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--fail-every") && i + 1 < argc) {
+            opt.fail_every = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--delay-ms") && i + 1 < argc) {
+            opt.delay_ms = std::atoi(argv[++i]);
+        } else {
+            std::fprintf(stderr, "usage: %s [--port N] [--fail-every N] [--delay-ms MS]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(opt.port));
+    if (bind(server, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) || listen(server, 4)) {
+        std::perror("listen");
+        return 2;
+    }
+    std::fprintf(stderr, "listening on :%d\n", opt.port);
+
+    uint64_t requests = 0, samples = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (true) {
+        int fd = accept(server, nullptr, nullptr);
+        if (fd < 0)
+            continue;
+
+        std::string head, body;
+        if (!ReadRequest(fd, head, body)) {
+            close(fd);
+            continue;
+        }
+        requests++;
+        if (opt.delay_ms)
+            std::this_thread::sleep_for(std::chrono::milliseconds(opt.delay_ms));
+
+        double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::string request_line = head.substr(0, head.find("\r\n"));
+        if (request_line.rfind("POST /ingest", 0) != 0) {
+            Reply(fd, "404 Not Found");
+            std::fprintf(stderr, "[%8.3f] %s -> 404\n", t, request_line.c_str());
+        } else if (opt.fail_every && requests % opt.fail_every == 0) {
+            Reply(fd, "503 Service Unavailable");
+            std::fprintf(stderr, "[%8.3f] %s, %zu bytes -> 503\n", t, request_line.c_str(), body.size());
+        } else {
+            uint64_t lines = 0;
+            if (strcasestr(head.c_str(), "\r\ncontent-type: application/octet-stream")) {
+                static Wire_Sample batch[UINT16_MAX];
+                int32_t n = Wire_Decode(reinterpret_cast<const uint8_t *>(body.data()), body.size(), batch, UINT16_MAX);
+                if (n < 0) {
+                    Reply(fd, "400 Bad Request");
+                    std::fprintf(stderr, "[%8.3f] %s, %zu bytes -> 400 (bad binary batch)\n", t, request_line.c_str(),
+                                 body.size());
+                    close(fd);
+                    continue;
+                }
+                for (int32_t i = 0; i < n; i++) {
+                    const Wire_Sample &s = batch[i];
+                    std::printf("{\"t\":%u,\"h\":%u,\"tc\":%d,\"adc\":%u,\"ok\":%d,\"sensor\":%d}\n", s.t_ms,
+                                s.humidity_centi, s.temperature_centi_c, s.adc, s.status & WIRE_STATUS_OK, s.status >> 1);
+                }
+                lines = n;
+            } else {
+                for (char c : body)
+                    lines += c == '\n';
+                std::fwrite(body.data(), 1, body.size(), stdout);
+            }
+            samples += lines;
+            std::fflush(stdout);
+            Reply(fd, "204 No Content");
+            std::fprintf(stderr, "[%8.3f] %s, %llu samples, %zu bytes -> 204 (%llu samples in %llu requests)\n", t,
+                         request_line.c_str(), (unsigned long long)lines, body.size(), (unsigned long long)samples,
+                         (unsigned long long)requests);
+        }
+        close(fd);
+    }
+}
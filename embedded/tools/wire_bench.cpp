@@ -0,0 +1,233 @@
+// Golden vector check and throughput benchmark for the binary sample batches (see src/data_flow/wire.h)
+//
+// Encodes every vector of wire_golden.txt with the firmware's encoder and compares the bytes,
+// decodes them back, and checks that the reject vectors are refused. Then encodes and decodes
+// ten days of synthetic 1 Hz samples in uplink sized batches, and compares the size with the
+// NDJSON lines the uplink sends otherwise.
+//
+// Build:  c++ -std=c++17 -O2 -o wire_bench wire_bench.cpp ../src/data_flow/wire.c
+// Usage:  ./wire_bench wire_golden.txt
+//         ./wire_bench --samples 10000000 --batch 30 --min-ratio 5 wire_golden.txt
+//
+// Exits 1 if a vector fails or the binary batches are not --min-ratio times smaller than NDJSON.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/data_flow/wire.h"
+
+namespace {
+
+struct Vector {
+    std::string name;
+    bool reject = false;
+    uint8_t fields = WIRE_ALL;
+    uint32_t period_ms = 0;
+    std::vector<Wire_Sample> samples;
+    std::vector<uint8_t> bytes;
+};
+
+bool LoadVectors(const char *path, std::vector<Vector> &out) {
+    std::ifstream in(path);
+    if (!in) {
+        std::perror(path);
+        return false;
+    }
+    std::string line;
+    Vector v;
+    while (std::getline(in, line)) {
+        std::istringstream words(line);
+        std::string word;
+        if (!(words >> word) || word[0] == '#')
+            continue;
+        if (word == "vector" || word == "reject") {
+            v = Vector();
+            v.reject = word == "reject";
+            words >> v.name;
+        } else if (word == "fields") {
+            unsigned fields;
+            words >> std::hex >> fields;
+            v.fields = static_cast<uint8_t>(fields);
+        } else if (word == "period") {
+            words >> v.period_ms;
+        } else if (word == "sample") {
+            long long t, h, tc, adc, status;
+            words >> t >> h >> tc >> adc >> status;
+            v.samples.push_back({static_cast<uint32_t>(t), static_cast<uint16_t>(h), static_cast<int16_t>(tc),
+                                 static_cast<uint16_t>(adc), static_cast<uint8_t>(status)});
+        } else if (word == "bytes") {
+            unsigned byte;
+            while (words >> std::hex >> byte)
+                v.bytes.push_back(static_cast<uint8_t>(byte));
+        } else if (word == "end") {
+            out.push_back(v);
+        } else {
+            std::fprintf(stderr, "%s: unknown line: %s\n", path, line.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string Hex(const uint8_t *data, size_t len) {
+    std::string s;
+    char byte[4];
+    for (size_t i = 0; i < len; i++) {
+        std::snprintf(byte, sizeof(byte), i ? " %02x" : "%02x", data[i]);
+        s += byte;
+    }
+    return s;
+}
+
+bool SameSample(const Wire_Sample &a, const Wire_Sample &b) {
+    return a.t_ms == b.t_ms && a.humidity_centi == b.humidity_centi && a.temperature_centi_c == b.temperature_centi_c &&
+           a.adc == b.adc && a.status == b.status;
+}
+
+bool CheckVector(const Vector &v) {
+    std::vector<Wire_Sample> decoded(v.samples.size() + 1);
+    int32_t n = Wire_Decode(v.bytes.data(), v.bytes.size(), decoded.data(), decoded.size());
+    if (v.reject) {
+        if (n >= 0)
+            std::printf("reject %s: decoded %d samples FAIL\n", v.name.c_str(), n);
+        return n < 0;
+    }
+
+    std::vector<uint8_t> buf(WIRE_HEADER_MAX + v.samples.size() * WIRE_RECORD_MAX);
+    Wire_Encoder enc;
+    bool ok = Wire_Begin(&enc, buf.data(), buf.size(), v.fields, v.period_ms);
+    for (const Wire_Sample &s : v.samples)
+        ok = ok && Wire_Add(&enc, &s);
+    uint32_t len = ok ? Wire_End(&enc) : 0;
+    if (!ok || len != v.bytes.size() || std::memcmp(buf.data(), v.bytes.data(), len)) {
+        std::printf("vector %s: encoded\n  %s\nexpected\n  %s\nFAIL\n", v.name.c_str(), Hex(buf.data(), len).c_str(),
+                    Hex(v.bytes.data(), v.bytes.size()).c_str());
+        return false;
+    }
+
+    bool same = n == static_cast<int32_t>(v.samples.size());
+    for (int32_t i = 0; same && i < n; i++) {
+        Wire_Sample expected = v.samples[i];
+        if (!(v.fields & WIRE_ADC))
+            expected.adc = 0;
+        if (!(v.fields & WIRE_STATUS))
+            expected.status = WIRE_STATUS_OK;
+        same = SameSample(decoded[i], expected);
+    }
+    if (!same)
+        std::printf("vector %s: decoded %d samples that differ FAIL\n", v.name.c_str(), n);
+    return same;
+}
+
+// Mean reverting random walks around a room's readings, 1 in 1000 readings failed
+std::vector<Wire_Sample> Synthetic(size_t n) {
+    std::vector<Wire_Sample> out(n);
+    uint32_t seed = 20240611;
+    auto random = [&seed]() { return (seed = seed * 1103515245u + 12345u) >> 8 & 0xFFFF; };
+    double h = 4500, tc = 2200, adc = 1500;
+    for (size_t i = 0; i < n; i++) {
+        h += (random() % 11) - 5.0 + (4500 - h) * 0.001;
+        tc += (random() % 3) - 1.0 + (2200 - tc) * 0.001;
+        adc += (random() % 17) - 8.0 + (1500 - adc) * 0.001;
+        out[i] = {static_cast<uint32_t>(1000 * i + random() % 3), static_cast<uint16_t>(h), static_cast<int16_t>(tc),
+                  static_cast<uint16_t>(adc), static_cast<uint8_t>(random() % 1000 ? WIRE_STATUS_OK : 0)};
+    }
+    return out;
+}
+
+double Seconds(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    size_t samples = 86400 * 10;
+    size_t batch = 30;
+    double min_ratio = 5;
+    const char *golden = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--samples") && i + 1 < argc) {
+            samples = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--batch") && i + 1 < argc) {
+            batch = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--min-ratio") && i + 1 < argc) {
+            min_ratio = std::atof(argv[++i]);
+        } else if (argv[i][0] != '-' && !golden) {
+            golden = argv[i];
+        } else {
+            std::fprintf(stderr, "usage: %s [--samples N] [--batch N] [--min-ratio R] wire_golden.txt\n", argv[0]);
+            return 2;
+        }
+    }
+    if (!golden || !batch || batch > UINT16_MAX) {
+        std::fprintf(stderr, "usage: %s [--samples N] [--batch N] [--min-ratio R] wire_golden.txt\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<Vector> vectors;
+    if (!LoadVectors(golden, vectors))
+        return 2;
+    size_t passed = 0;
+    for (const Vector &v : vectors)
+        passed += CheckVector(v);
+    bool ok = passed == vectors.size();
+    std::printf("golden vectors: %zu/%zu %s\n", passed, vectors.size(), ok ? "PASS" : "FAIL");
+
+    // whole batches of synthetic samples, encoded back to back into one buffer
+    std::vector<Wire_Sample> input = Synthetic(samples);
+    size_t batches = (samples + batch - 1) / batch;
+    std::vector<uint8_t> wire(batches * (WIRE_HEADER_MAX + batch * WIRE_RECORD_MAX));
+    std::vector<uint32_t> lengths(batches);
+
+    auto start = std::chrono::steady_clock::now();
+    size_t wire_bytes = 0;
+    for (size_t b = 0; b < batches; b++) {
+        Wire_Encoder enc;
+        Wire_Begin(&enc, wire.data() + wire_bytes, wire.size() - wire_bytes, WIRE_ALL, 1000);
+        for (size_t i = b * batch; i < std::min(samples, (b + 1) * batch); i++)
+            Wire_Add(&enc, &input[i]);
+        lengths[b] = Wire_End(&enc);
+        wire_bytes += lengths[b];
+    }
+    double encode_s = Seconds(start);
+
+    std::vector<Wire_Sample> output(batch);
+    start = std::chrono::steady_clock::now();
+    size_t offset = 0, decoded = 0, wrong = 0;
+    for (size_t b = 0; b < batches; b++) {
+        int32_t n = Wire_Decode(wire.data() + offset, lengths[b], output.data(), batch);
+        for (int32_t i = 0; i < n; i++)
+            wrong += !SameSample(output[i], input[decoded + i]);
+        wrong += n < 0;
+        decoded += n > 0 ? n : 0;
+        offset += lengths[b];
+    }
+    double decode_s = Seconds(start);
+
+    size_t json_bytes = 0;
+    char line[80];
+    for (const Wire_Sample &s : input)
+        json_bytes += std::snprintf(line, sizeof(line), "{\"t\":%u,\"h\":%u,\"tc\":%d,\"adc\":%u,\"ok\":%d}\n", s.t_ms,
+                                    s.humidity_centi, s.temperature_centi_c, s.adc, s.status & WIRE_STATUS_OK);
+
+    double ratio = static_cast<double>(json_bytes) / wire_bytes;
+    ok = ok && !wrong && decoded == samples && ratio >= min_ratio;
+    std::printf("encode %zu samples in batches of %zu: %.1f ns/sample, %.1f M samples/s, %.0f MB/s\n", samples, batch,
+                encode_s * 1e9 / samples, samples / encode_s / 1e6, wire_bytes / encode_s / 1e6);
+    std::printf("decode: %.1f ns/sample, %.1f M samples/s, %.0f MB/s%s\n", decode_s * 1e9 / samples,
+                samples / decode_s / 1e6, wire_bytes / decode_s / 1e6,
+                wrong || decoded != samples ? ", samples differ FAIL" : "");
+    std::printf("size: %.2f bytes/sample binary, %.2f bytes/sample NDJSON, %.1fx smaller %s (target %.1fx)\n",
+                static_cast<double>(wire_bytes) / samples, static_cast<double>(json_bytes) / samples, ratio,
+                ratio >= min_ratio ? "PASS" : "FAIL", min_ratio);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,351 @@
+// Threshold alerts, evaluated as batches are stored
+//
+// A rule watches one channel of one device, or of every device, for a value above or below a
+// threshold. It fires once the condition has held for forMs, and resolves once the value has
+// been back past the clear level (hysteresis, default the threshold) for clearForMs:
+//
+//   ok --over--> pending --held forMs--> firing --under clear--> resolving --held clearForMs--> ok
+//
+// pending falls back to ok as soon as the value is no longer over the threshold, and resolving
+// back to firing as soon as it crosses the clear level again, neither with an event. Durations
+// are measured on sample times, so a device that stops reporting keeps its alerts as they are.
+//
+// Every (rule, device) pair is a binding with a fixed handful of typed array slots, and each
+// stored sample is folded into the bindings of its device in turn: no history is read back,
+// and a sample costs a few comparisons per rule whatever the windows are.
+
+import type { DeviceRing, SampleStore } from "./ingest.js";
+
+export type AlertChannel = "humidity" | "temperature" | "photores";
+const CHANNELS: AlertChannel[] = ["humidity", "temperature", "photores"];
+const SCALE = [100, 100, 1]; // stored centi-%RH and centi-degrees, photores as counts
+const PHOTORES = 2;
+
+export interface AlertRule {
+  id: string;
+  device?: string; // every device when absent
+  channel: AlertChannel;
+  above?: number; // %RH, degrees C or counts, exactly one of above and below
+  below?: number;
+  clear?: number; // resolves only back past this, default the threshold
+  forMs?: number; // how long the condition must hold before firing, default 0
+  clearForMs?: number; // how long it must be clear before resolving, default 0
+}
+
+export type AlertState = "ok" | "pending" | "firing" | "resolving";
+const STATES: AlertState[] = ["ok", "pending", "firing", "resolving"];
+const OK = 0;
+const PENDING = 1;
+const FIRING = 2;
+const RESOLVING = 3;
+
+export interface AlertEvent {
+  rule: string;
+  device: string;
+  state: "firing" | "resolved";
+  ts: number; // time of the sample that caused it
+  value: number; // that sample's value
+  since: number; // when the condition started to hold
+}
+
+export interface ActiveAlert {
+  rule: string;
+  device: string;
+  state: AlertState;
+  since: number;
+  value: number; // newest value seen
+}
+
+export type AlertListener = (event: AlertEvent) => void;
+
+export class AlertRuleError extends Error {}
+
+const RULE_ID = /^[A-Za-z0-9._-]{1,64}$/;
+
+/**
+ * Checks a rule from the outside world, returns it with the defaults filled in
+ */
+export function checkRule(input: unknown): AlertRule {
+  const rule = (input ?? {}) as Record<string, unknown>;
+  const number = (name: string, min = -Infinity) => {
+    const value = rule[name];
+    if (value === undefined) return undefined;
+    if (typeof value !== "number" || !Number.isFinite(value) || value < min) throw new AlertRuleError(`${name} must be a number${min === 0 ? " >= 0" : ""}`);
+    return value;
+  };
+  if (typeof rule.id !== "string" || !RULE_ID.test(rule.id)) throw new AlertRuleError("id must be 1-64 of A-Z a-z 0-9 . _ -");
+  if (rule.device !== undefined && typeof rule.device !== "string") throw new AlertRuleError("device must be a string");
+  if (!CHANNELS.includes(rule.channel as AlertChannel)) throw new AlertRuleError(`channel must be one of ${CHANNELS.join(", ")}`);
+  const above = number("above");
+  const below = number("below");
+  if ((above === undefined) === (below === undefined)) throw new AlertRuleError("exactly one of above and below is required");
+  const threshold = (above ?? below) as number;
+  const clear = number("clear") ?? threshold;
+  if (above !== undefined ? clear > above : clear < threshold) throw new AlertRuleError("clear must not be past the threshold");
+  return {
+    id: rule.id,
+    device: rule.device as string | undefined,
+    channel: rule.channel as AlertChannel,
+    above,
+    below,
+    clear,
+    forMs: number("forMs", 0) ?? 0,
+    clearForMs: number("clearForMs", 0) ?? 0,
+  };
+}
+
+// Binding ids of one device, swap-removed
+interface DeviceBindings {
+  ids: Int32Array;
+  length: number;
+  seen: boolean; // has reported, so holds the bindings of the every-device rules
+}
+
+interface RuleEntry {
+  rule: AlertRule;
+  slot: number;
+  bindings: number[];
+}
+
+function grow<T extends Float64Array | Int32Array | Uint8Array>(array: T, size: number): T {
+  if (array.length >= size) return array;
+  const next = new (array.constructor as new (n: number) => T)(Math.max(size, array.length * 2));
+  next.set(array);
+  return next;
+}
+
+/**
+ * The alert rules and the state of every (rule, device) binding
+ */
+export class AlertEngine {
+  private rules = new Map<string, RuleEntry>();
+  private everyDevice: number[] = []; // rule slots without a device
+  private devices = new Map<string, DeviceBindings>();
+  private listeners: AlertListener[] = [];
+
+  // compiled rules by slot; values are signed so that over means greater for above and below
+  private ruleIds: string[] = [];
+  private channel = new Uint8Array(16);
+  private sign = new Int32Array(16); // 1 above, -1 below
+  private trigger = new Int32Array(16); // sign * threshold, stored units
+  private clearAt = new Int32Array(16); // sign * clear
+  private forMs = new Float64Array(16);
+  private clearForMs = new Float64Array(16);
+  private freeRules: number[] = [];
+  private ruleCount = 0;
+
+  // bindings by id
+  private ruleOf = new Int32Array(16);
+  private deviceOf: string[] = [];
+  private state = new Uint8Array(16);
+  private since = new Float64Array(16); // condition started to hold
+  private phase = new Float64Array(16); // resolving started
+  private value = new Int32Array(16); // newest value, stored units
+  private freeBindings: number[] = [];
+  private bindingCount = 0;
+
+  constructor(store: SampleStore) {
+    store.onAppend((device, ring, first, count) => this.evaluate(device, ring, first, count));
+  }
+
+  onEvent(listener: AlertListener) {
+    this.listeners.push(listener);
+  }
+
+  list(): AlertRule[] {
+    return [...this.rules.values()].map((entry) => entry.rule);
+  }
+
+  get size(): number {
+    return this.rules.size;
+  }
+
+  /**
+   * Adds a rule, or replaces the one with its id, which starts its bindings over
+   * Throws AlertRuleError if the rule is not valid
+   */
+  set(input: unknown): AlertRule {
+    const rule = checkRule(input);
+    this.delete(rule.id);
+
+    const slot = this.freeRules.pop() ?? this.ruleCount++;
+    this.growRules(slot + 1);
+    const sign = rule.above !== undefined ? 1 : -1;
+    const c = CHANNELS.indexOf(rule.channel);
+    this.ruleIds[slot] = rule.id;
+    this.channel[slot] = c;
+    this.sign[slot] = sign;
+    this.trigger[slot] = sign * Math.round(((rule.above ?? rule.below) as number) * SCALE[c]);
+    this.clearAt[slot] = sign * Math.round((rule.clear as number) * SCALE[c]);
+    this.forMs[slot] = rule.forMs ?? 0;
+    this.clearForMs[slot] = rule.clearForMs ?? 0;
+
+    const entry: RuleEntry = { rule, slot, bindings: [] };
+    this.rules.set(rule.id, entry);
+    if (rule.device === undefined) {
+      this.everyDevice.push(slot);
+      for (const [device, list] of this.devices) if (list.seen) this.bind(entry, device, list);
+    } else {
+      this.bind(entry, rule.device, this.deviceBindings(rule.device));
+    }
+    return rule;
+  }
+
+  /**
+   * Removes a rule and its bindings, returns false if there was none
+   */
+  delete(id: string): boolean {
+    const entry = this.rules.get(id);
+    if (!entry) return false;
+    this.rules.delete(id);
+    for (const b of entry.bindings) {
+      const list = this.devices.get(this.deviceOf[b]) as DeviceBindings;
+      const at = list.ids.subarray(0, list.length).indexOf(b);
+      list.ids[at] = list.ids[--list.length];
+      this.freeBindings.push(b);
+    }
+    if (entry.rule.device === undefined) this.everyDevice.splice(this.everyDevice.indexOf(entry.slot), 1);
+    this.freeRules.push(entry.slot);
+    return true;
+  }
+
+  /**
+   * Bindings that are not ok, of one device or all of them
+   */
+  active(device?: string): ActiveAlert[] {
+    const out: ActiveAlert[] = [];
+    const lists = device === undefined ? this.devices.values() : [this.devices.get(device)].filter((l) => l !== undefined);
+    for (const list of lists) {
+      for (let i = 0; i < list.length; i++) {
+        const b = list.ids[i];
+        if (this.state[b] === OK) continue;
+        const r = this.ruleOf[b];
+        out.push({
+          rule: this.ruleIds[r],
+          device: this.deviceOf[b],
+          state: STATES[this.state[b]],
+          since: this.since[b],
+          value: (this.sign[r] * this.value[b]) / SCALE[this.channel[r]],
+        });
+      }
+    }
+    return out;
+  }
+
+  /**
+   * Folds count samples of ring, from slot first on, into device's bindings
+   */
+  evaluate(device: string, ring: DeviceRing, first: number, count: number) {
+    const list = this.deviceBindings(device);
+    if (!list.seen) {
+      list.seen = true;
+      for (const slot of this.everyDevice) this.bind(this.rules.get(this.ruleIds[slot]) as RuleEntry, device, list);
+    }
+
+    const capacity = ring.capacity;
+    for (let k = 0; k < list.length; k++) {
+      const b = list.ids[k];
+      const r = this.ruleOf[b];
+      const c = this.channel[r];
+      const column = c === 0 ? ring.humidity : c === 1 ? ring.temperature : ring.adc;
+      const anyReading = c === PHOTORES;
+      const sign = this.sign[r];
+      const trigger = this.trigger[r];
+      const clearAt = this.clearAt[r];
+      const forMs = this.forMs[r];
+      const clearForMs = this.clearForMs[r];
+      let state = this.state[b];
+      let since = this.since[b];
+      let phase = this.phase[b];
+      let v = this.value[b];
+
+      for (let i = 0, at = first; i < count; i++, at = at + 1 === capacity ? 0 : at + 1) {
+        if (!anyReading && !ring.valid[at]) continue;
+        v = sign * column[at];
+        const ts = ring.ts[at];
+        switch (state) {
+          case OK:
+            if (v <= trigger) break;
+            since = ts;
+            state = PENDING;
+          // falls through, a rule without forMs fires on this sample
+          case PENDING:
+            if (v <= trigger) state = OK;
+            else if (ts - since >= forMs) {
+              state = FIRING;
+              this.emit(r, b, "firing", ts, v, since);
+            }
+            break;
+          case FIRING:
+            if (v > clearAt) break;
+            phase = ts;
+            state = RESOLVING;
+          // falls through
+          case RESOLVING:
+            if (v > clearAt) state = FIRING;
+            else if (ts - phase >= clearForMs) {
+              state = OK;
+              this.emit(r, b, "resolved", ts, v, since);
+            }
+            break;
+        }
+      }
+
+      this.state[b] = state;
+      this.since[b] = since;
+      this.phase[b] = phase;
+      this.value[b] = v;
+    }
+  }
+
+  private emit(r: number, b: number, state: "firing" | "resolved", ts: number, v: number, since: number) {
+    const event: AlertEvent = {
+      rule: this.ruleIds[r],
+      device: this.deviceOf[b],
+      state,
+      ts,
+      value: (this.sign[r] * v) / SCALE[this.channel[r]],
+      since,
+    };
+    for (const listener of this.listeners) listener(event);
+  }
+
+  private deviceBindings(device: string): DeviceBindings {
+    let list = this.devices.get(device);
+    if (!list) {
+      list = { ids: new Int32Array(4), length: 0, seen: false };
+      this.devices.set(device, list);
+    }
+    return list;
+  }
+
+  private bind(entry: RuleEntry, device: string, list: DeviceBindings) {
+    const b = this.freeBindings.pop() ?? this.bindingCount++;
+    if (b >= this.ruleOf.length) {
+      const size = b + 1;
+      this.ruleOf = grow(this.ruleOf, size);
+      this.state = grow(this.state, size);
+      this.since = grow(this.since, size);
+      this.phase = grow(this.phase, size);
+      this.value = grow(this.value, size);
+    }
+    this.ruleOf[b] = entry.slot;
+    this.deviceOf[b] = device;
+    this.state[b] = OK;
+    this.since[b] = 0;
+    this.phase[b] = 0;
+    this.value[b] = 0;
+    entry.bindings.push(b);
+    list.ids = grow(list.ids, list.length + 1);
+    list.ids[list.length++] = b;
+  }
+
+  private growRules(size: number) {
+    this.channel = grow(this.channel, size);
+    this.sign = grow(this.sign, size);
+    this.trigger = grow(this.trigger, size);
+    this.clearAt = grow(this.clearAt, size);
+    this.forMs = grow(this.forMs, size);
+    this.clearForMs = grow(this.clearForMs, size);
+  }
+}
@@ -0,0 +1,171 @@
+// Alert engine benchmark
+//
+// --rules rules spread over --devices devices (device specific, a mix of channels, above and
+// below, hysteresis and windows up to 15 minutes) plus one rule for every device (humidity
+// over 60 %RH for 10 minutes, clear under 58), fed --samples 1 Hz samples per device in
+// batches of --batch as the uplink sends them. Times AlertEngine.evaluate for every batch and
+// reports the cost per sample and per rule evaluated, then replays each binding through a
+// plain reference state machine and checks the engine raised the same events.
+//
+//   npm run bench:alerts -- --devices 1000 --rules 10000 --samples 3600
+//
+// Exits 1 if the events differ or a sample costs more than --target us.
+import { AlertEngine, type AlertEvent, type AlertRule } from "../alerts.js";
+import { SampleStore, createBatch } from "../ingest.js";
+import { percentile, parseArgs } from "./util.js";
+
+const args = parseArgs(process.argv.slice(2), {
+  devices: 1000,
+  rules: 10000,
+  samples: 3600,
+  batch: 30,
+  target: 1, // us per sample
+});
+
+let seed = 20240611;
+const random = () => (seed = (seed * 1103515245 + 12345) & 0x7fffffff) / 0x7fffffff;
+const pick = <T>(items: T[]) => items[Math.floor(random() * items.length)];
+
+interface Room {
+  id: string;
+  humidity: number; // centi-%RH
+  temperature: number; // centi-C
+  light: number;
+}
+
+const rooms: Room[] = [];
+for (let d = 0; d < args.devices; d++)
+  rooms.push({ id: `room-${d}`, humidity: 4000 + random() * 3000, temperature: 1800 + random() * 800, light: 500 + random() * 2000 });
+
+// thresholds close to where each room starts, so rules cross back and forth during the run
+const rules: AlertRule[] = [];
+for (let r = 0; r < args.rules; r++) {
+  const room = rooms[r % args.devices];
+  const channel = pick(["humidity", "humidity", "temperature", "photores"] as const);
+  const start = channel === "humidity" ? room.humidity / 100 : channel === "temperature" ? room.temperature / 100 : room.light;
+  const spread = channel === "photores" ? 100 : 2;
+  const threshold = Math.round((start + (random() - 0.5) * spread) * 10) / 10;
+  const above = random() < 0.7;
+  const hysteresis = random() < 0.5 ? 0 : (spread / 4) * random();
+  rules.push({
+    id: `rule-${r}`,
+    device: room.id,
+    channel,
+    ...(above ? { above: threshold, clear: threshold - hysteresis } : { below: threshold, clear: threshold + hysteresis }),
+    forMs: pick([0, 60_000, 300_000, 600_000, 900_000]),
+    clearForMs: pick([0, 0, 60_000, 120_000]),
+  });
+}
+
+rules.push({ id: "damp", channel: "humidity", above: 60, clear: 58, forMs: 600_000 });
+
+const engine = new AlertEngine(new SampleStore({ ringSamples: 1, maxDevices: 1 }));
+for (const rule of rules) engine.set(rule);
+const events: AlertEvent[] = [];
+engine.onEvent((event) => events.push(event));
+
+// the rings the batches land in; the engine is driven from this store's append listener
+const store = new SampleStore({ ringSamples: args.samples, maxDevices: args.devices });
+const history = new Map<string, { ts: number[]; humidity: number[]; temperature: number[]; adc: number[]; valid: number[] }>();
+const latencies: number[] = [];
+let evaluating = 0;
+store.onAppend((device, ring, first, count) => {
+  const t0 = performance.now();
+  engine.evaluate(device, ring, first, count);
+  const ms = performance.now() - t0;
+  evaluating += ms;
+  latencies.push(ms);
+
+  let h = history.get(device);
+  if (!h) history.set(device, (h = { ts: [], humidity: [], temperature: [], adc: [], valid: [] }));
+  for (let i = 0, at = first; i < count; i++, at = at + 1 === ring.capacity ? 0 : at + 1) {
+    h.ts.push(ring.ts[at]);
+    h.humidity.push(ring.humidity[at]);
+    h.temperature.push(ring.temperature[at]);
+    h.adc.push(ring.adc[at]);
+    h.valid.push(ring.valid[at]);
+  }
+});
+
+const clamp = (v: number, lo: number, hi: number) => Math.min(hi, Math.max(lo, v));
+const batch = createBatch(args.batch);
+const start = Date.UTC(2026, 0, 1);
+for (let s = 0; s < args.samples; s += args.batch) {
+  const n = Math.min(args.batch, args.samples - s);
+  for (const room of rooms) {
+    for (let i = 0; i < n; i++) {
+      room.humidity = clamp(room.humidity + (random() - 0.5) * 20, 0, 10000);
+      room.temperature = clamp(room.temperature + (random() - 0.5) * 4, -4000, 8500);
+      room.light = clamp(room.light + (random() - 0.5) * 30, 0, 4095);
+      batch.t[i] = (s + i) * 1000;
+      batch.humidity[i] = Math.round(room.humidity);
+      batch.temperature[i] = Math.round(room.temperature);
+      batch.adc[i] = Math.round(room.light);
+      batch.valid[i] = random() < 0.001 ? 0 : 1;
+    }
+    batch.count = n;
+    store.append(room.id, batch, start + (s + n - 1) * 1000);
+  }
+}
+
+const samples = args.devices * args.samples;
+const usPerSample = (evaluating * 1000) / samples;
+const nsPerRule = (evaluating * 1e6) / (samples * (args.rules / args.devices + 1));
+const sorted = Float64Array.from(latencies).sort();
+const fired = events.filter((e) => e.state === "firing").length;
+console.log(
+  `${rules.length} rules on ${args.devices} devices, ${samples} samples in batches of ${args.batch}:` +
+    ` evaluated in ${evaluating.toFixed(0)} ms`,
+);
+console.log(
+  `${usPerSample.toFixed(3)} us per sample, ${nsPerRule.toFixed(1)} ns per rule and sample,` +
+    ` batch p50 ${(percentile(sorted, 0.5) * 1000).toFixed(1)} us p99 ${(percentile(sorted, 0.99) * 1000).toFixed(1)} us`,
+);
+console.log(`${fired} alerts fired, ${events.length - fired} resolved, ${engine.active().length} not ok at the end`);
+
+// reference: one rule and device at a time, the state machine spelled out over the whole history
+const expected: string[] = [];
+for (const rule of rules) for (const device of rule.device === undefined ? history.keys() : [rule.device]) {
+  const h = history.get(device);
+  if (!h) continue;
+  const column = rule.channel === "humidity" ? h.humidity : rule.channel === "temperature" ? h.temperature : h.adc;
+  const scale = rule.channel === "photores" ? 1 : 100;
+  const above = rule.above !== undefined;
+  const over = (v: number) => (above ? v > Math.round((rule.above as number) * scale) : v < Math.round((rule.below as number) * scale));
+  const clear = (v: number) => (above ? v <= Math.round((rule.clear as number) * scale) : v >= Math.round((rule.clear as number) * scale));
+  let state = "ok";
+  let since = 0;
+  let clearSince = 0;
+  for (let i = 0; i < h.ts.length; i++) {
+    if (rule.channel !== "photores" && !h.valid[i]) continue;
+    const v = column[i];
+    const ts = h.ts[i];
+    if (state === "ok" && over(v)) {
+      state = "pending";
+      since = ts;
+    }
+    if (state === "pending") {
+      if (!over(v)) state = "ok";
+      else if (ts - since >= (rule.forMs ?? 0)) {
+        state = "firing";
+        expected.push(`${rule.id} ${device} firing ${ts} ${since}`);
+      }
+    } else if (state === "firing" && clear(v)) {
+      state = "resolving";
+      clearSince = ts;
+    }
+    if (state === "resolving") {
+      if (!clear(v)) state = "firing";
+      else if (ts - clearSince >= (rule.clearForMs ?? 0)) {
+        state = "ok";
+        expected.push(`${rule.id} ${device} resolved ${ts} ${since}`);
+      }
+    }
+  }
+}
+const got = events.map((e) => `${e.rule} ${e.device} ${e.state} ${e.ts} ${e.since}`);
+const same = got.length === expected.length && got.sort().join("\n") === expected.sort().join("\n");
+console.log(`${same ? "same" : "different"} events as the reference (${expected.length}) ${same ? "PASS" : "FAIL"}`);
+const fast = usPerSample <= args.target;
+console.log(`${usPerSample.toFixed(3)} us per sample ${fast ? "PASS" : "FAIL"} (target ${args.target} us)`);
+process.exitCode = same && fast ? 0 : 1;
@@ -0,0 +1,257 @@
+// Fleet load generator: how many sensors one backend process can take
+//
+// Simulates --devices boards against a running server. Each one reads --rate samples per
+// second (humidity, temperature and light as random walks around its own baseline) and posts
+// them to /ingest in batches of --batch, as the firmware's uplink does. Posts are spread
+// evenly and sent on schedule whether or not earlier ones have been answered, with at most
+// --concurrency in flight, so a server that falls behind shows up as latency rather than as
+// a slower generator. Latency counts from when a post was due, not when it got a socket.
+//
+//   npm start &                      # or npm run dev
+//   npm run loadgen -- --devices 200 --rate 1 --batch 30 --duration 60
+//
+// The server keeps INGEST_MAX_DEVICES (256) devices by default, raise it for larger fleets.
+// Prints a line a second, then throughput, errors by cause and a latency histogram. Exits 1
+// if more than --max-errors of the posts fail.
+import http from "node:http";
+import { BINARY_TYPE, NDJSON_TYPE, createBatch, encodeBinary, encodeNdjson } from "../ingest.js";
+import { encodeWire } from "../wire.js";
+import { Histogram, parseArgs } from "./util.js";
+
+const args = parseArgs(process.argv.slice(2), {
+  url: "http://localhost:3001",
+  devices: 100,
+  rate: 1, // samples per second per device
+  batch: 30, // samples per post
+  duration: 30, // seconds
+  format: "ndjson",
+  concurrency: 64,
+  timeout: 5000, // ms
+  "max-errors": 0.01,
+});
+if (!["ndjson", "binary", "wire"].includes(args.format)) throw new Error("--format is ndjson, binary or wire");
+const type = args.format === "ndjson" ? NDJSON_TYPE : BINARY_TYPE;
+
+interface Device {
+  id: string;
+  t: number; // ms since boot
+  humidity: number; // centi-%RH
+  humidityBase: number;
+  temperature: number; // centi-C
+  temperatureBase: number;
+  light: number;
+}
+
+let seed = 20240611;
+const random = () => (seed = (seed * 1103515245 + 12345) & 0x7fffffff) / 0x7fffffff;
+const gauss = () => (random() + random() + random() + random() - 2) * 1.7; // about N(0, 1)
+const clamp = (v: number, lo: number, hi: number) => Math.min(hi, Math.max(lo, v));
+
+const devices: Device[] = [];
+for (let i = 0; i < args.devices; i++) {
+  const humidityBase = 3000 + random() * 4000;
+  const temperatureBase = 1800 + random() * 800;
+  devices.push({
+    id: `fleet-${i}`,
+    t: Math.floor(random() * 3600000),
+    humidity: humidityBase,
+    humidityBase,
+    temperature: temperatureBase,
+    temperatureBase,
+    light: 500 + random() * 2000,
+  });
+}
+
+const batch = createBatch(args.batch);
+const periodMs = 1000 / args.rate;
+
+/**
+ * Next batch of a device: mean reverting random walks, 1 in 1000 readings failed
+ */
+function body(device: Device): Uint8Array<ArrayBuffer> | string {
+  for (let i = 0; i < args.batch; i++) {
+    device.t += periodMs;
+    device.humidity = clamp(device.humidity + gauss() * 5 + (device.humidityBase - device.humidity) * 0.001, 0, 10000);
+    device.temperature = clamp(device.temperature + gauss() * 1 + (device.temperatureBase - device.temperature) * 0.001, -4000, 8500);
+    device.light = clamp(device.light + gauss() * 8, 0, 4095);
+    batch.t[i] = Math.floor(device.t) % 0x100000000;
+    batch.humidity[i] = Math.round(device.humidity);
+    batch.temperature[i] = Math.round(device.temperature);
+    batch.adc[i] = Math.round(device.light);
+    batch.valid[i] = random() < 0.001 ? 0 : 1;
+    batch.sensor[i] = 0;
+  }
+  batch.count = args.batch;
+  if (args.format === "wire") return encodeWire(batch, args.batch, Math.round(periodMs));
+  return args.format === "binary" ? encodeBinary(batch) : encodeNdjson(batch);
+}
+
+const url = new URL(args.url);
+const agent = new http.Agent({ keepAlive: true, maxSockets: args.concurrency });
+
+interface Totals {
+  posts: number;
+  ok: number;
+  samples: number;
+  errors: Map<string, number>;
+  latency: Histogram;
+  service: Histogram; // from send to answer
+  skipped: number; // posts due while --concurrency were in flight
+}
+
+const totals: Totals = { posts: 0, ok: 0, samples: 0, errors: new Map(), latency: new Histogram(), service: new Histogram(), skipped: 0 };
+let interval = { posts: 0, ok: 0, errors: 0, latency: new Histogram() };
+let inFlight = 0;
+
+function fail(cause: string) {
+  totals.errors.set(cause, (totals.errors.get(cause) ?? 0) + 1);
+  interval.errors++;
+}
+
+function post(device: Device, due: number): Promise<void> {
+  const data = body(device);
+  const sent = performance.now();
+  inFlight++;
+  totals.posts++;
+  interval.posts++;
+  return new Promise((resolve) => {
+    let settled = false;
+    const finish = (cause?: string) => {
+      if (settled) return;
+      settled = true;
+      const now = performance.now();
+      if (cause) fail(cause);
+      else {
+        totals.ok++;
+        totals.samples += args.batch;
+        interval.ok++;
+      }
+      totals.latency.record(now - due);
+      totals.service.record(now - sent);
+      interval.latency.record(now - due);
+      inFlight--;
+      resolve();
+    };
+
+    const req = http.request(
+      {
+        host: url.hostname,
+        port: url.port,
+        path: `/ingest?device=${device.id}`,
+        method: "POST",
+        agent,
+        timeout: args.timeout,
+        headers: { "content-type": type, "content-length": Buffer.byteLength(data) },
+      },
+      (res) => {
+        res.resume();
+        res.on("end", () => finish(res.statusCode === 204 ? undefined : `HTTP ${res.statusCode}`));
+      },
+    );
+    req.on("timeout", () => req.destroy(new Error("timeout")));
+    req.on("error", (err) => finish(err.message === "timeout" ? "timeout" : (err as NodeJS.ErrnoException).code ?? err.message));
+    req.end(data);
+  });
+}
+
+async function waitForServer() {
+  for (let i = 0; i < 50; i++) {
+    try {
+      const res = await fetch(new URL("/health", url));
+      if (res.ok) return;
+    } catch {
+      // not up yet
+    }
+    await new Promise((resolve) => setTimeout(resolve, 200));
+  }
+  throw new Error(`no answer from ${url.origin}/health`);
+}
+
+/**
+ * One post per device before the clock starts, so the server has made their rings and the
+ * run measures steady state rather than first contact
+ */
+async function register() {
+  const counting = { ...totals, errors: new Map(totals.errors) };
+  for (let i = 0; i < devices.length; i += args.concurrency) {
+    const group: Promise<void>[] = [];
+    for (let j = i; j < Math.min(devices.length, i + args.concurrency); j++) group.push(post(devices[j], performance.now()));
+    await Promise.all(group);
+  }
+  const failed = totals.posts - totals.ok;
+  if (failed) throw new Error(`${failed} of ${devices.length} devices could not register: ${[...totals.errors.keys()].join(", ")}`);
+  Object.assign(totals, counting, { latency: new Histogram(), service: new Histogram() });
+  interval = { posts: 0, ok: 0, errors: 0, latency: new Histogram() };
+}
+
+await waitForServer();
+await register();
+const postsPerSecond = (args.devices * args.rate) / args.batch;
+console.log(
+  `${args.devices} devices x ${args.rate} samples/s in batches of ${args.batch} (${args.format})` +
+    ` = ${postsPerSecond.toFixed(1)} posts/s, ${args.devices * args.rate} samples/s to ${url.origin} for ${args.duration} s`,
+);
+
+// post k is due at start + k / postsPerSecond, from device k mod devices
+const start = performance.now();
+const end = start + args.duration * 1000;
+const pending = new Set<Promise<void>>();
+let next = 0;
+let reported = start;
+
+await new Promise<void>((resolve) => {
+  const tick = () => {
+    const now = performance.now();
+    for (;;) {
+      const due = start + (next * 1000) / postsPerSecond;
+      if (due > now || due >= end) break;
+      const device = devices[next % devices.length];
+      next++;
+      if (inFlight >= args.concurrency) {
+        totals.skipped++;
+        fail("skipped, concurrency full");
+        continue;
+      }
+      const p = post(device, due);
+      pending.add(p);
+      p.then(() => pending.delete(p));
+    }
+
+    if (now - reported >= 1000) {
+      reported = now;
+      console.log(
+        `${((now - start) / 1000).toFixed(0).padStart(4)} s ${String(interval.posts).padStart(6)} posts` +
+          ` ${String(interval.ok).padStart(6)} ok ${String(interval.errors).padStart(5)} errors` +
+          ` p50 ${interval.latency.percentile(0.5).toFixed(2)} ms p99 ${interval.latency.percentile(0.99).toFixed(2)} ms` +
+          ` in flight ${inFlight}`,
+      );
+      interval = { posts: 0, ok: 0, errors: 0, latency: new Histogram() };
+    }
+
+    if (now >= end) resolve();
+    else setTimeout(tick, Math.min(10, Math.max(0, start + (next * 1000) / postsPerSecond - now)));
+  };
+  tick();
+});
+await Promise.all(pending);
+agent.destroy();
+
+const seconds = (performance.now() - start) / 1000;
+let errors = 0;
+for (const count of totals.errors.values()) errors += count;
+const attempted = totals.posts + totals.skipped;
+const errorRate = attempted ? errors / attempted : 0;
+const ok = errorRate <= args["max-errors"];
+console.log(
+  `\n${totals.samples} samples in ${seconds.toFixed(1)} s = ${Math.round(totals.samples / seconds)} samples/s` +
+    `, ${totals.ok}/${attempted} posts ok, error rate ${(errorRate * 100).toFixed(2)}%`,
+);
+for (const [cause, count] of totals.errors) console.log(`  ${cause}: ${count}`);
+console.log(
+  `latency from due: p50 ${totals.latency.percentile(0.5).toFixed(2)} ms p90 ${totals.latency.percentile(0.9).toFixed(2)} ms` +
+    ` p99 ${totals.latency.percentile(0.99).toFixed(2)} ms max ${totals.latency.max.toFixed(2)} ms` +
+    `, service p50 ${totals.service.percentile(0.5).toFixed(2)} ms p99 ${totals.service.percentile(0.99).toFixed(2)} ms`,
+);
+console.log(totals.latency.print());
+console.log(ok ? "PASS" : `FAIL (more than ${args["max-errors"] * 100}% errors)`);
+process.exitCode = ok ? 0 : 1;
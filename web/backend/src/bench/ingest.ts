@@ -0,0 +1,124 @@
+// Ingest throughput benchmark
+//
+// In process (default): parses and stores prebuilt batches through the same Ingestor the
+// server uses, one format at a time, and reports samples/s and per-batch latency.
+// Against a server: --url http://localhost:3001 posts the batches over HTTP instead, with
+// --concurrency requests in flight.
+//
+//   npm run bench:ingest -- --samples 2000000 --batch 100 --devices 16
+//
+// Exits 1 if a format stays under --target samples/s (100000 by default).
+import { BINARY_TYPE, Ingestor, NDJSON_TYPE, SampleStore, createBatch, encodeBinary, encodeNdjson } from "../ingest.js";
+import { encodeWire } from "../wire.js";
+import { percentile, parseArgs } from "./util.js";
+
+const args = parseArgs(process.argv.slice(2), {
+  samples: 2_000_000,
+  batch: 100,
+  devices: 16,
+  target: 100_000,
+  concurrency: 8,
+  url: "",
+});
+
+interface Body {
+  device: string;
+  data: Uint8Array<ArrayBuffer>;
+}
+
+/**
+ * Builds one batch per device, a slow day of readings with a little noise
+ */
+function makeBodies(format: string): Body[] {
+  const bodies: Body[] = [];
+  for (let d = 0; d < args.devices; d++) {
+    const batch = createBatch(args.batch);
+    for (let i = 0; i < args.batch; i++) {
+      batch.t[i] = 1000 * i + d;
+      batch.humidity[i] = 4500 + ((i * 37 + d) % 400);
+      batch.temperature[i] = 2100 + ((i * 13 + d) % 300);
+      batch.adc[i] = 1200 + ((i * 7) % 100);
+      batch.valid[i] = 1;
+    }
+    batch.count = args.batch;
+    let data: Uint8Array<ArrayBuffer>;
+    if (format === "wire") data = encodeWire(batch, args.batch, 1000);
+    else if (format === "binary") data = encodeBinary(batch);
+    else data = new TextEncoder().encode(encodeNdjson(batch));
+    bodies.push({ device: `bench-${d}`, data });
+  }
+  return bodies;
+}
+
+interface Result {
+  samples: number;
+  seconds: number;
+  latencies: Float64Array; // ms per batch
+}
+
+function runInProcess(type: string, bodies: Body[]): Result {
+  const ingestor = new Ingestor(new SampleStore({ ringSamples: 86400, maxDevices: args.devices }));
+  const batches = Math.ceil(args.samples / args.batch);
+  const latencies = new Float64Array(batches);
+
+  // warm up the parser before timing
+  for (let i = 0; i < 200; i++) ingestor.ingest(bodies[i % bodies.length].device, type, bodies[i % bodies.length].data);
+
+  const start = process.hrtime.bigint();
+  let samples = 0;
+  for (let b = 0; b < batches; b++) {
+    const body = bodies[b % bodies.length];
+    const t0 = process.hrtime.bigint();
+    samples += ingestor.ingest(body.device, type, body.data);
+    latencies[b] = Number(process.hrtime.bigint() - t0) / 1e6;
+  }
+  const seconds = Number(process.hrtime.bigint() - start) / 1e9;
+  return { samples, seconds, latencies };
+}
+
+async function runHttp(type: string, bodies: Body[]): Promise<Result> {
+  const batches = Math.ceil(args.samples / args.batch);
+  const latencies = new Float64Array(batches);
+  let next = 0;
+  let samples = 0;
+
+  async function worker() {
+    while (next < batches) {
+      const b = next++;
+      const body = bodies[b % bodies.length];
+      const t0 = process.hrtime.bigint();
+      const res = await fetch(`${args.url}/ingest?device=${body.device}`, {
+        method: "POST",
+        headers: { "content-type": type },
+        body: body.data,
+      });
+      await res.arrayBuffer();
+      latencies[b] = Number(process.hrtime.bigint() - t0) / 1e6;
+      if (res.status !== 204) throw new Error(`POST /ingest returned ${res.status}`);
+      samples += args.batch;
+    }
+  }
+
+  const start = process.hrtime.bigint();
+  await Promise.all(Array.from({ length: args.concurrency }, worker));
+  const seconds = Number(process.hrtime.bigint() - start) / 1e9;
+  return { samples, seconds, latencies };
+}
+
+let failed = false;
+for (const format of ["ndjson", "binary", "wire"]) {
+  const type = format === "ndjson" ? NDJSON_TYPE : BINARY_TYPE;
+  const bodies = makeBodies(format);
+  const result = args.url ? await runHttp(type, bodies) : runInProcess(type, bodies);
+  const rate = result.samples / result.seconds;
+  const sorted = result.latencies.sort();
+  const ok = rate >= args.target;
+  failed ||= !ok;
+  console.log(
+    `${format.padEnd(7)} ${result.samples} samples in ${result.seconds.toFixed(2)} s = ${Math.round(rate)} samples/s` +
+      `, batch of ${args.batch}: p50 ${percentile(sorted, 0.5).toFixed(3)} ms` +
+      ` p99 ${percentile(sorted, 0.99).toFixed(3)} ms max ${sorted[sorted.length - 1].toFixed(3)} ms` +
+      ` ${ok ? "PASS" : "FAIL"} (target ${args.target}/s)`,
+  );
+}
+process.exitCode = failed ? 1 : 0;
@@ -0,0 +1,114 @@
+// Live stream fan-out benchmark
+//
+// Starts an HTTP server around a LiveHub, opens --subscribers local SSE connections to it and
+// stores --events one-sample batches round robin over --devices, --rate per second. Every
+// reading carries the time it was stored, and each subscriber measures the delay to when the
+// event reaches it. A --slow fraction of the subscribers never reads, to show that their
+// queues stay bounded and do not delay the others.
+//
+//   npm run bench:live -- --subscribers 5000 --events 1000 --rate 200
+//
+// Client and server share one process, so the latencies include the client side parsing.
+// Exits 1 if an event is missing on a reading subscriber or p99 goes over --target ms.
+import http from "node:http";
+import type { AddressInfo } from "node:net";
+import { SampleStore, createBatch } from "../ingest.js";
+import { LiveHub } from "../live.js";
+import { percentile, parseArgs } from "./util.js";
+
+const args = parseArgs(process.argv.slice(2), {
+  subscribers: 2000,
+  slow: 0.05,
+  devices: 4,
+  events: 100,
+  rate: 10,
+  target: 250,
+});
+
+const now = () => performance.timeOrigin + performance.now();
+const sleep = (ms: number) => new Promise((resolve) => setTimeout(resolve, ms));
+
+const store = new SampleStore({ ringSamples: 1024, maxDevices: args.devices });
+const hub = new LiveHub(store, { maxSubscribers: args.subscribers, maxPending: 64, maxAlerts: 256, heartbeatMs: 15000 });
+const server = http.createServer((req, res) => hub.attach(req, res));
+server.listen(0, "127.0.0.1");
+await new Promise((resolve) => server.once("listening", resolve));
+const port = (server.address() as AddressInfo).port;
+const agent = new http.Agent({ keepAlive: false, maxSockets: Infinity });
+
+const latencies = new Float64Array(args.subscribers * args.events);
+let received = 0;
+const perClient = new Uint32Array(args.subscribers);
+const slowCount = Math.round(args.subscribers * args.slow);
+const requests: http.ClientRequest[] = [];
+
+function subscribe(index: number): Promise<void> {
+  return new Promise((resolve, reject) => {
+    const req = http.get({ host: "127.0.0.1", port, path: "/live", agent }, (res) => {
+      if (res.statusCode !== 200) reject(new Error(`GET /live returned ${res.statusCode}`));
+      resolve();
+      if (index < slowCount) {
+        res.pause(); // never reads, the kernel buffers fill and the hub has to coalesce
+        return;
+      }
+      res.setEncoding("utf8");
+      let buffered = "";
+      res.on("data", (chunk: string) => {
+        const at = now();
+        buffered += chunk;
+        let end: number;
+        while ((end = buffered.indexOf("\n\n")) !== -1) {
+          const event = buffered.slice(0, end);
+          buffered = buffered.slice(end + 2);
+          const match = /"ts":([0-9.]+)/.exec(event);
+          if (!match) continue;
+          latencies[received++] = at - Number(match[1]);
+          perClient[index]++;
+        }
+      });
+    });
+    req.on("error", reject);
+    requests.push(req);
+  });
+}
+
+// connect in steps so the listen backlog never overflows
+for (let i = 0; i < args.subscribers; i += 200) {
+  const step: Promise<void>[] = [];
+  for (let j = i; j < Math.min(args.subscribers, i + 200); j++) step.push(subscribe(j));
+  await Promise.all(step);
+}
+console.log(`${hub.stats.subscribers} subscribers connected, ${slowCount} of them not reading`);
+
+const batch = createBatch(1);
+batch.count = 1;
+const start = now();
+for (let e = 0; e < args.events; e++) {
+  // wait for this event's slot, so the subscribers get one event per turn
+  const due = start + (e * 1000) / args.rate;
+  await sleep(Math.max(0, due - now()));
+  batch.t[0] = e * 1000;
+  batch.humidity[0] = 4000 + (e % 500);
+  batch.temperature[0] = 2200 + (e % 100);
+  batch.adc[0] = e % 4096;
+  batch.valid[0] = 1;
+  store.append(`bench-${e % args.devices}`, batch, now());
+}
+await sleep(1000); // let the last events land
+
+const expected = (args.subscribers - slowCount) * args.events;
+let missing = 0;
+for (let i = slowCount; i < args.subscribers; i++) missing += Math.max(0, args.events - perClient[i]);
+const sorted = latencies.subarray(0, received).sort();
+const p99 = percentile(sorted, 0.99);
+const ok = missing === 0 && p99 <= args.target;
+console.log(
+  `${args.events} events at ${args.rate}/s to ${args.subscribers} subscribers: ${received}/${expected} delivered` +
+    `, p50 ${percentile(sorted, 0.5).toFixed(2)} ms p90 ${percentile(sorted, 0.9).toFixed(2)} ms` +
+    ` p99 ${p99.toFixed(2)} ms max ${(sorted[sorted.length - 1] ?? 0).toFixed(2)} ms` +
+    `, ${hub.stats.coalesced} coalesced for slow subscribers ${ok ? "PASS" : "FAIL"} (target p99 ${args.target} ms)`,
+);
+
+for (const req of requests) req.destroy();
+server.close();
+process.exitCode = ok ? 0 : 1;
@@ -0,0 +1,95 @@
+// Segment store benchmark
+//
+// Writes --devices x --samples 1 Hz samples through a SampleStore into segment files in a
+// temporary directory, reopens the directory as the server does at startup, then times
+// --queries range reads of a minute, an hour and a day at random places.
+//
+//   npm run bench:segments -- --devices 16 --samples 500000
+//
+// Exits 1 if reopening takes over --target ms or a read returns the wrong number of samples.
+import fs from "node:fs";
+import os from "node:os";
+import path from "node:path";
+import { SampleStore, createBatch } from "../ingest.js";
+import { SegmentStore } from "../segments.js";
+import { percentile, parseArgs } from "./util.js";
+
+const args = parseArgs(process.argv.slice(2), {
+  devices: 16,
+  samples: 500_000,
+  batch: 600,
+  queries: 2000,
+  target: 100,
+});
+
+const dir = fs.mkdtempSync(path.join(os.tmpdir(), "segments-"));
+const start = Date.UTC(2026, 0, 1);
+let failed = false;
+
+try {
+  // write, one sample a second per device, device clock in step with the wall clock
+  const store = new SampleStore({ ringSamples: args.batch, maxDevices: args.devices });
+  const segments = SegmentStore.open(dir);
+  store.onAppend((device, ring, first, count) => segments.append(device, ring, first, count));
+  const batch = createBatch(args.batch);
+  const writing = performance.now();
+  for (let s = 0; s < args.samples; s += args.batch) {
+    const n = Math.min(args.batch, args.samples - s);
+    for (let i = 0; i < n; i++) {
+      batch.t[i] = (s + i) * 1000;
+      batch.humidity[i] = 4000 + ((s + i) % 1000);
+      batch.temperature[i] = 2000 + ((s + i) % 500);
+      batch.adc[i] = (s + i) % 4096;
+      batch.valid[i] = 1;
+    }
+    batch.count = n;
+    for (let d = 0; d < args.devices; d++) store.append(`bench-${d}`, batch, start + (s + n - 1) * 1000);
+  }
+  const written = args.devices * args.samples;
+  const writeSeconds = (performance.now() - writing) / 1000;
+  segments.close();
+
+  const opening = performance.now();
+  const reopened = SegmentStore.open(dir);
+  const openMs = performance.now() - opening;
+  const stats = reopened.stats();
+  const openOk = openMs <= args.target && stats.records === written;
+  failed ||= !openOk;
+  console.log(
+    `wrote ${written} samples in ${writeSeconds.toFixed(2)} s = ${Math.round(written / writeSeconds)} samples/s` +
+      `, ${stats.segments} segments (${(written * 16 / 1e6).toFixed(0)} MB)`,
+  );
+  console.log(
+    `reopened ${stats.segments} segments, ${stats.records} samples in ${openMs.toFixed(1)} ms` +
+      ` ${openOk ? "PASS" : "FAIL"} (target ${args.target} ms)`,
+  );
+
+  let seed = 1;
+  const random = () => (seed = (seed * 1103515245 + 12345) & 0x7fffffff) / 0x7fffffff;
+  for (const [name, span] of [["minute", 60], ["hour", 3600], ["day", 86400]] as const) {
+    const latencies = new Float64Array(args.queries);
+    let wrong = 0;
+    for (let q = 0; q < args.queries; q++) {
+      const first = Math.floor(random() * Math.max(1, args.samples - span));
+      const from = start + first * 1000;
+      const to = from + (span - 1) * 1000;
+      const t0 = performance.now();
+      let sum = 0;
+      const got = reopened.read(`bench-${q % args.devices}`, from, to, (records, count) => {
+        for (let i = 0; i < count; i++) sum += records.readUInt16LE(i * 16 + 8);
+      });
+      latencies[q] = performance.now() - t0;
+      if (got !== Math.min(span, args.samples - first) || !sum) wrong++;
+    }
+    failed ||= wrong > 0;
+    const sorted = latencies.sort();
+    console.log(
+      `read a ${name.padEnd(6)} p50 ${percentile(sorted, 0.5).toFixed(3)} ms p99 ${percentile(sorted, 0.99).toFixed(3)} ms` +
+        `${wrong ? `, ${wrong} reads with the wrong count FAIL` : ""}`,
+    );
+  }
+  reopened.close();
+} finally {
+  fs.rmSync(dir, { recursive: true, force: true });
+}
+process.exitCode = failed ? 1 : 0;
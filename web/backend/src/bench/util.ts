@@ -0,0 +1,77 @@
+// Shared helpers for the benchmarks
+
+/**
+ * Value at fraction q (0..1) of an ascending sorted array, nearest rank
+ */
+export function percentile(sorted: ArrayLike<number>, q: number): number {
+  if (!sorted.length) return 0;
+  const rank = Math.min(sorted.length - 1, Math.max(0, Math.ceil(q * sorted.length) - 1));
+  return sorted[rank];
+}
+
+/**
+ * Reads --name value pairs over defaults, numbers stay numbers
+ */
+export function parseArgs<T extends Record<string, number | string>>(argv: string[], defaults: T): T {
+  const out: Record<string, number | string> = { ...defaults };
+  for (let i = 0; i < argv.length; i++) {
+    const name = argv[i].replace(/^--/, "");
+    if (!(name in defaults) || i + 1 >= argv.length) throw new Error(`unknown option ${argv[i]}`);
+    const value = argv[++i];
+    out[name] = typeof defaults[name] === "number" ? Number(value) : value;
+  }
+  return out as T;
+}
+
+/**
+ * Latency histogram, log-linear: 8 buckets per power of two from 1 us up, so any value is
+ * within 12.5% of its bucket's lower edge and recording costs no allocation
+ */
+export class Histogram {
+  private counts = new Float64Array(8 * 40);
+  count = 0;
+  max = 0;
+
+  record(ms: number) {
+    const us = Math.max(1, ms * 1000);
+    const power = Math.floor(Math.log2(us));
+    const sub = Math.floor((us / 2 ** power - 1) * 8);
+    this.counts[Math.min(this.counts.length - 1, power * 8 + sub)]++;
+    this.count++;
+    if (ms > this.max) this.max = ms;
+  }
+
+  // Lower edge of bucket i, ms
+  private edge(i: number): number {
+    return (2 ** Math.floor(i / 8) * (1 + (i % 8) / 8)) / 1000;
+  }
+
+  percentile(q: number): number {
+    const rank = Math.max(1, Math.ceil(q * this.count));
+    let seen = 0;
+    for (let i = 0; i < this.counts.length; i++) {
+      seen += this.counts[i];
+      if (seen >= rank) return Math.min(this.edge(i + 1), this.max);
+    }
+    return this.max;
+  }
+
+  /**
+   * One line per power of two that has samples, with a bar scaled to the fullest
+   */
+  print(width = 40): string {
+    const rows: { from: number; count: number }[] = [];
+    for (let p = 0; p < this.counts.length / 8; p++) {
+      let count = 0;
+      for (let s = 0; s < 8; s++) count += this.counts[p * 8 + s];
+      if (count) rows.push({ from: this.edge(p * 8), count });
+    }
+    const most = Math.max(1, ...rows.map((r) => r.count));
+    return rows
+      .map((r) => {
+        const range = `${r.from.toFixed(3)}-${(r.from * 2).toFixed(3)} ms`.padStart(22);
+        return `${range} ${String(r.count).padStart(9)} ${"#".repeat(Math.ceil((r.count / most) * width))}`;
+      })
+      .join("\n");
+  }
+}
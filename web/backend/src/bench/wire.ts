@@ -0,0 +1,182 @@
+// Binary sample batch benchmark (see wire.ts)
+//
+// First checks encodeWire and decodeWire against the golden vectors the firmware's encoder
+// is checked against (embedded/tools/wire_golden.txt): each vector must encode to exactly its
+// bytes and decode back, and each reject vector must be refused. Then encodes and decodes
+// --samples synthetic 1 Hz samples in batches of --batch, as the uplink sends them, and
+// compares the bytes and the parse time with the same samples as NDJSON and as version 1.
+//
+//   npm run bench:wire -- --samples 2000000 --batch 30
+//
+// Exits 1 if a vector fails, a batch does not decode to what was encoded, or the batches are
+// not --min-ratio times smaller than NDJSON.
+import fs from "node:fs";
+import { createBatch, encodeBinary, encodeNdjson, parseBinary, parseNdjson, type Batch } from "../ingest.js";
+import { WIRE_ADC, WIRE_ALL, WIRE_STATUS, WireError, decodeWire, encodeWire } from "../wire.js";
+import { parseArgs } from "./util.js";
+
+const args = parseArgs(process.argv.slice(2), {
+  samples: 2_000_000,
+  batch: 30,
+  "min-ratio": 5,
+  golden: new URL("../../../../embedded/tools/wire_golden.txt", import.meta.url).pathname,
+});
+
+interface Vector {
+  name: string;
+  reject: boolean;
+  fields: number;
+  period: number;
+  samples: number[][]; // t h tc adc status
+  bytes: number[];
+}
+
+function loadVectors(path: string): Vector[] {
+  const vectors: Vector[] = [];
+  let v: Vector | undefined;
+  for (const line of fs.readFileSync(path, "utf8").split("\n")) {
+    const [word, ...rest] = line.trim().split(/\s+/);
+    if (!word || word.startsWith("#")) continue;
+    if (word === "vector" || word === "reject") v = { name: rest[0], reject: word === "reject", fields: WIRE_ALL, period: 0, samples: [], bytes: [] };
+    else if (!v) throw new Error(`${path}: ${word} outside a vector`);
+    else if (word === "fields") v.fields = parseInt(rest[0], 16);
+    else if (word === "period") v.period = Number(rest[0]);
+    else if (word === "sample") v.samples.push(rest.map(Number));
+    else if (word === "bytes") v.bytes.push(...rest.map((b) => parseInt(b, 16)));
+    else if (word === "end") vectors.push(v);
+    else throw new Error(`${path}: unknown line: ${line}`);
+  }
+  return vectors;
+}
+
+const hex = (bytes: ArrayLike<number>) => Array.from(bytes, (b) => b.toString(16).padStart(2, "0")).join(" ");
+
+function checkVector(v: Vector): string | undefined {
+  const bytes = new Uint8Array(v.bytes);
+  const out = createBatch(v.samples.length + 1);
+  let count: number;
+  try {
+    count = decodeWire(new DataView(bytes.buffer), out);
+  } catch (err) {
+    if (!(err instanceof WireError)) throw err;
+    return v.reject ? undefined : `decode failed: ${err.message}`;
+  }
+  if (v.reject) return `decoded ${count} samples`;
+
+  const batch = createBatch(v.samples.length);
+  v.samples.forEach(([t, h, tc, adc, status], i) => {
+    batch.t[i] = t;
+    batch.humidity[i] = h;
+    batch.temperature[i] = tc;
+    batch.adc[i] = adc;
+    batch.valid[i] = status & 1;
+    batch.sensor[i] = status >> 1;
+  });
+  const encoded = encodeWire(batch, v.samples.length, v.period, v.fields);
+  if (hex(encoded) !== hex(bytes)) return `encoded\n  ${hex(encoded)}\nexpected\n  ${hex(bytes)}`;
+
+  if (count !== v.samples.length) return `decoded ${count} of ${v.samples.length} samples`;
+  for (let i = 0; i < count; i++) {
+    const [t, h, tc, adc, status] = v.samples[i];
+    const wantAdc = v.fields & WIRE_ADC ? adc : 0;
+    const wantStatus = v.fields & WIRE_STATUS ? status : 1;
+    if (out.t[i] !== t || out.humidity[i] !== h || out.temperature[i] !== tc || out.adc[i] !== wantAdc ||
+        out.valid[i] !== (wantStatus & 1) || out.sensor[i] !== wantStatus >> 1)
+      return `sample ${i} decoded differently`;
+  }
+  return undefined;
+}
+
+let failed = false;
+const vectors = loadVectors(args.golden);
+let passed = 0;
+for (const v of vectors) {
+  const error = checkVector(v);
+  if (error) console.log(`${v.reject ? "reject" : "vector"} ${v.name}: ${error} FAIL`);
+  else passed++;
+}
+failed ||= passed !== vectors.length;
+console.log(`golden vectors: ${passed}/${vectors.length} ${passed === vectors.length ? "PASS" : "FAIL"}`);
+
+// mean reverting random walks, a little jitter on the clock, 1 in 1000 readings failed
+let seed = 20240611;
+const random = () => (seed = (seed * 1103515245 + 12345) & 0x7fffffff) / 0x7fffffff;
+const batches: Batch[] = [];
+let humidity = 4500;
+let temperature = 2200;
+let light = 1500;
+for (let s = 0; s < args.samples; s += args.batch) {
+  const batch = createBatch(Math.min(args.batch, args.samples - s));
+  for (let i = 0; i < batch.t.length; i++) {
+    humidity += Math.round((random() - 0.5) * 10 + (4500 - humidity) * 0.001);
+    temperature += Math.round((random() - 0.5) * 2 + (2200 - temperature) * 0.001);
+    light += Math.round((random() - 0.5) * 16 + (1500 - light) * 0.001);
+    batch.t[i] = ((s + i) * 1000 + Math.floor(random() * 3)) % 0x100000000;
+    batch.humidity[i] = humidity;
+    batch.temperature[i] = temperature;
+    batch.adc[i] = light;
+    batch.valid[i] = random() < 0.001 ? 0 : 1;
+  }
+  batch.count = batch.t.length;
+  batches.push(batch);
+}
+
+function time(run: () => void): number {
+  run(); // warm up
+  const start = performance.now();
+  run();
+  return (performance.now() - start) / 1000;
+}
+
+const wire: Uint8Array[] = [];
+const encodeSeconds = time(() => {
+  wire.length = 0;
+  for (const batch of batches) wire.push(encodeWire(batch, batch.count, 1000));
+});
+
+let out = createBatch(args.batch);
+const decodeSeconds = time(() => {
+  for (const body of wire) decodeWire(new DataView(body.buffer, body.byteOffset, body.byteLength), out);
+});
+
+// every sample back as it was, outside the timing
+let wrong = 0;
+for (let b = 0; b < wire.length; b++) {
+  const batch = batches[b];
+  const count = decodeWire(new DataView(wire[b].buffer, wire[b].byteOffset, wire[b].byteLength), out);
+  let same = count === batch.count;
+  for (let i = 0; same && i < count; i++)
+    same = out.t[i] === batch.t[i] && out.humidity[i] === batch.humidity[i] && out.temperature[i] === batch.temperature[i] &&
+      out.adc[i] === batch.adc[i] && out.valid[i] === batch.valid[i] && out.sensor[i] === batch.sensor[i];
+  if (!same) wrong++;
+}
+failed ||= wrong > 0;
+
+const encoder = new TextEncoder();
+const ndjson = batches.map((batch) => encoder.encode(encodeNdjson(batch)));
+const v1 = batches.map((batch) => encodeBinary(batch));
+const ndjsonSeconds = time(() => {
+  for (const body of ndjson) out = parseNdjson(body, out);
+});
+const v1Seconds = time(() => {
+  for (const body of v1) out = parseBinary(body, out);
+});
+
+const bytes = (bodies: Uint8Array[]) => bodies.reduce((sum, body) => sum + body.length, 0);
+const wireBytes = bytes(wire);
+const ratio = bytes(ndjson) / wireBytes;
+failed ||= ratio < args["min-ratio"];
+
+const rate = (seconds: number) => `${(args.samples / seconds / 1e6).toFixed(1)} M samples/s`;
+const size = (n: number) => `${(n / args.samples).toFixed(2)} bytes/sample`;
+console.log(`${args.samples} samples in batches of ${args.batch}`);
+console.log(`wire encode   ${rate(encodeSeconds)}, ${(wireBytes / encodeSeconds / 1e6).toFixed(0)} MB/s`);
+console.log(
+  `wire decode   ${rate(decodeSeconds)}, ${(wireBytes / decodeSeconds / 1e6).toFixed(0)} MB/s` +
+    `${wrong ? `, ${wrong} batches decoded wrong FAIL` : ""}`,
+);
+console.log(`ndjson parse  ${rate(ndjsonSeconds)}`);
+console.log(`v1 parse      ${rate(v1Seconds)}`);
+console.log(`size: wire ${size(wireBytes)}, v1 ${size(bytes(v1))}, ndjson ${size(bytes(ndjson))}`);
+console.log(`wire is ${ratio.toFixed(1)}x smaller than ndjson ${ratio >= args["min-ratio"] ? "PASS" : "FAIL"} (target ${args["min-ratio"]}x)`);
+process.exitCode = failed ? 1 : 0;
@@ -0,0 +1,494 @@
+// Batched sample ingest: the NDJSON and binary batch parsers, the per-device rings and the
+// latest-value cache behind POST /ingest and GET /latest.
+//
+// Parsers write straight into a reused columnar scratch batch, so a batch of any size costs
+// no objects per sample. A batch is validated whole before anything is stored; a bad line
+// rejects the batch and the device resends it.
+import { WIRE_VERSION, WireError, decodeWire, wireCount } from "./wire.js";
+
+// NDJSON, one sample per line, the firmware's uplink format with UPLINK_WIRE 0:
+//   {"t":123456,"h":4123,"tc":2250,"adc":1365,"ok":1}
+// t device ms since boot, h centi-%RH, tc centi-degrees C, adc photoresistor counts,
+// ok 0 when the DHT20 reading failed (default 1), optional sensor index. Unknown numeric
+// keys are skipped.
+//
+// Binary, little endian, told apart by the first byte:
+//   u8 version (1), u8 reserved, u16 count, then count records of
+//   u32 t, u16 h, i16 tc, u16 adc, u8 ok, u8 sensor
+// or version 2, the firmware's delta coded batches, about 5 bytes a sample (see wire.ts)
+
+export const BINARY_VERSION = 1;
+export const BINARY_HEADER_BYTES = 4;
+export const BINARY_RECORD_BYTES = 12;
+
+export const NDJSON_TYPE = "application/x-ndjson";
+export const BINARY_TYPE = "application/octet-stream";
+
+const HUMIDITY_MAX = 10000;
+const TEMPERATURE_MIN = -4000; // DHT20 range, -40 to 85 C
+const TEMPERATURE_MAX = 8500;
+const ADC_MAX = 4095;
+const DEVICE_ID = /^[A-Za-z0-9._-]{1,64}$/;
+
+export class IngestError extends Error {
+  status: number;
+  line: number | undefined;
+
+  constructor(message: string, line?: number, status = 400) {
+    super(message);
+    this.status = status;
+    this.line = line;
+  }
+}
+
+// Columnar batch, reused between requests
+export interface Batch {
+  count: number;
+  t: Float64Array;
+  humidity: Uint16Array;
+  temperature: Int16Array;
+  adc: Uint16Array;
+  valid: Uint8Array;
+  sensor: Uint8Array;
+}
+
+export function createBatch(capacity: number): Batch {
+  return {
+    count: 0,
+    t: new Float64Array(capacity),
+    humidity: new Uint16Array(capacity),
+    temperature: new Int16Array(capacity),
+    adc: new Uint16Array(capacity),
+    valid: new Uint8Array(capacity),
+    sensor: new Uint8Array(capacity),
+  };
+}
+
+/**
+ * Returns batch if it holds count samples, otherwise a new batch with room to spare
+ */
+export function reserveBatch(batch: Batch, count: number): Batch {
+  if (batch.t.length >= count) return batch;
+  return createBatch(Math.max(count, batch.t.length * 2));
+}
+
+function checkSample(batch: Batch, i: number, line: number) {
+  const t = batch.t[i];
+  if (!Number.isInteger(t) || t < 0 || t > 0xffffffff) throw new IngestError("t out of range", line);
+  if (batch.humidity[i] > HUMIDITY_MAX) throw new IngestError("h out of range", line);
+  const tc = batch.temperature[i];
+  if (tc < TEMPERATURE_MIN || tc > TEMPERATURE_MAX) throw new IngestError("tc out of range", line);
+  if (batch.adc[i] > ADC_MAX) throw new IngestError("adc out of range", line);
+}
+
+const CH_LF = 0x0a;
+const CH_CR = 0x0d;
+const CH_SPACE = 0x20;
+const CH_TAB = 0x09;
+const CH_QUOTE = 0x22;
+const CH_COMMA = 0x2c;
+const CH_COLON = 0x3a;
+const CH_MINUS = 0x2d;
+const CH_0 = 0x30;
+const CH_9 = 0x39;
+const CH_OPEN = 0x7b;
+const CH_CLOSE = 0x7d;
+
+// Keys, matched on bytes so no strings are made
+const KEY_T = 1;
+const KEY_H = 2;
+const KEY_TC = 3;
+const KEY_ADC = 4;
+const KEY_OK = 5;
+const KEY_SENSOR = 6;
+const KEY_OTHER = 0;
+
+function keyId(buf: Uint8Array, start: number, end: number): number {
+  const len = end - start;
+  const c0 = buf[start];
+  if (len === 1) return c0 === 0x74 ? KEY_T : c0 === 0x68 ? KEY_H : KEY_OTHER;
+  if (len === 2) {
+    const c1 = buf[start + 1];
+    if (c0 === 0x74 && c1 === 0x63) return KEY_TC;
+    if (c0 === 0x6f && c1 === 0x6b) return KEY_OK;
+    return KEY_OTHER;
+  }
+  if (len === 3 && c0 === 0x61 && buf[start + 1] === 0x64 && buf[start + 2] === 0x63) return KEY_ADC;
+  if (len === 6 && c0 === 0x73 && buf[start + 1] === 0x65 && buf[start + 5] === 0x72) return KEY_SENSOR;
+  return KEY_OTHER;
+}
+
+/**
+ * Scanner state for one NDJSON body, pos moves forward through buf
+ */
+class Scanner {
+  buf: Uint8Array;
+  pos = 0;
+  end: number;
+  line = 1;
+
+  constructor(buf: Uint8Array) {
+    this.buf = buf;
+    this.end = buf.length;
+  }
+
+  skipSpaces() {
+    const buf = this.buf;
+    while (this.pos < this.end && (buf[this.pos] === CH_SPACE || buf[this.pos] === CH_TAB || buf[this.pos] === CH_CR))
+      this.pos++;
+  }
+
+  expect(ch: number, what: string) {
+    this.skipSpaces();
+    if (this.buf[this.pos] !== ch) throw new IngestError(`expected ${what}`, this.line);
+    this.pos++;
+  }
+
+  // Integer, or true / false as 1 / 0
+  number(): number {
+    this.skipSpaces();
+    const buf = this.buf;
+    if (buf[this.pos] === 0x74 && buf[this.pos + 1] === 0x72 && buf[this.pos + 2] === 0x75 && buf[this.pos + 3] === 0x65) {
+      this.pos += 4;
+      return 1;
+    }
+    if (buf[this.pos] === 0x66 && buf[this.pos + 1] === 0x61 && buf[this.pos + 2] === 0x6c && buf[this.pos + 3] === 0x73 && buf[this.pos + 4] === 0x65) {
+      this.pos += 5;
+      return 0;
+    }
+
+    let negative = false;
+    if (buf[this.pos] === CH_MINUS) {
+      negative = true;
+      this.pos++;
+    }
+    const start = this.pos;
+    let value = 0;
+    while (this.pos < this.end && buf[this.pos] >= CH_0 && buf[this.pos] <= CH_9) {
+      value = value * 10 + (buf[this.pos] - CH_0);
+      this.pos++;
+    }
+    if (this.pos === start || this.pos - start > 10) throw new IngestError("expected an integer", this.line);
+    return negative ? -value : value;
+  }
+}
+
+/**
+ * Parses an NDJSON body into batch, returns the batch used (a larger one if it had to grow)
+ */
+export function parseNdjson(body: Uint8Array, scratch: Batch): Batch {
+  // one sample per newline, plus a last line without one
+  let lines = 1;
+  for (let i = body.indexOf(CH_LF); i !== -1; i = body.indexOf(CH_LF, i + 1)) lines++;
+  const batch = reserveBatch(scratch, lines);
+  batch.count = 0;
+
+  const s = new Scanner(body);
+  const buf = body;
+  while (true) {
+    s.skipSpaces();
+    if (s.pos >= s.end) break;
+    if (buf[s.pos] === CH_LF) {
+      s.pos++;
+      s.line++;
+      continue; // blank line
+    }
+
+    const i = batch.count;
+    let seen = 0;
+    batch.valid[i] = 1;
+    batch.sensor[i] = 0;
+
+    s.expect(CH_OPEN, "{");
+    s.skipSpaces();
+    if (buf[s.pos] !== CH_CLOSE) {
+      while (true) {
+        s.expect(CH_QUOTE, "a key");
+        const keyStart = s.pos;
+        while (s.pos < s.end && buf[s.pos] !== CH_QUOTE && buf[s.pos] !== CH_LF) s.pos++;
+        if (buf[s.pos] !== CH_QUOTE) throw new IngestError("unterminated key", s.line);
+        const key = keyId(buf, keyStart, s.pos);
+        s.pos++;
+        s.expect(CH_COLON, ":");
+        const value = s.number();
+
+        switch (key) {
+          case KEY_T: batch.t[i] = value; break;
+          case KEY_H:
+            if (value < 0 || value > HUMIDITY_MAX) throw new IngestError("h out of range", s.line);
+            batch.humidity[i] = value;
+            break;
+          case KEY_TC:
+            if (value < TEMPERATURE_MIN || value > TEMPERATURE_MAX) throw new IngestError("tc out of range", s.line);
+            batch.temperature[i] = value;
+            break;
+          case KEY_ADC:
+            if (value < 0 || value > ADC_MAX) throw new IngestError("adc out of range", s.line);
+            batch.adc[i] = value;
+            break;
+          case KEY_OK: batch.valid[i] = value ? 1 : 0; break;
+          case KEY_SENSOR:
+            if (value < 0 || value > 255) throw new IngestError("sensor out of range", s.line);
+            batch.sensor[i] = value;
+            break;
+        }
+        seen |= 1 << key;
+
+        s.skipSpaces();
+        if (buf[s.pos] === CH_COMMA) {
+          s.pos++;
+          continue;
+        }
+        break;
+      }
+    }
+    s.expect(CH_CLOSE, "}");
+
+    const required = (1 << KEY_T) | (1 << KEY_H) | (1 << KEY_TC) | (1 << KEY_ADC);
+    if ((seen & required) !== required) throw new IngestError("t, h, tc and adc are required", s.line);
+    checkSample(batch, i, s.line);
+    batch.count++;
+
+    s.skipSpaces();
+    if (s.pos < s.end && buf[s.pos] !== CH_LF) throw new IngestError("one object per line", s.line);
+  }
+  return batch;
+}
+
+/**
+ * Parses a binary batch into batch, returns the batch used
+ */
+export function parseBinary(body: Uint8Array, scratch: Batch): Batch {
+  if (body.length < BINARY_HEADER_BYTES) throw new IngestError("short binary batch");
+  if (body[0] === WIRE_VERSION) return parseWire(body, scratch);
+  if (body[0] !== BINARY_VERSION) throw new IngestError(`unknown binary version ${body[0]}`);
+  const count = body[2] | (body[3] << 8);
+  if (body.length !== BINARY_HEADER_BYTES + count * BINARY_RECORD_BYTES)
+    throw new IngestError("binary length does not match its count");
+
+  const batch = reserveBatch(scratch, count);
+  const view = new DataView(body.buffer, body.byteOffset, body.byteLength);
+  let p = BINARY_HEADER_BYTES;
+  for (let i = 0; i < count; i++, p += BINARY_RECORD_BYTES) {
+    batch.t[i] = view.getUint32(p, true);
+    batch.humidity[i] = view.getUint16(p + 4, true);
+    batch.temperature[i] = view.getInt16(p + 6, true);
+    batch.adc[i] = view.getUint16(p + 8, true);
+    batch.valid[i] = body[p + 10] ? 1 : 0;
+    batch.sensor[i] = body[p + 11];
+    checkSample(batch, i, i + 1);
+  }
+  batch.count = count;
+  return batch;
+}
+
+function parseWire(body: Uint8Array, scratch: Batch): Batch {
+  const view = new DataView(body.buffer, body.byteOffset, body.byteLength);
+  let batch: Batch;
+  try {
+    batch = reserveBatch(scratch, wireCount(view));
+    batch.count = decodeWire(view, batch);
+  } catch (err) {
+    if (err instanceof WireError) throw new IngestError(err.message);
+    throw err;
+  }
+  for (let i = 0; i < batch.count; i++) checkSample(batch, i, i + 1);
+  return batch;
+}
+
+/**
+ * Encodes samples in the binary batch format, used by the benchmark and load tools
+ */
+export function encodeBinary(batch: Batch): Uint8Array<ArrayBuffer> {
+  const out = new Uint8Array(BINARY_HEADER_BYTES + batch.count * BINARY_RECORD_BYTES);
+  const view = new DataView(out.buffer);
+  out[0] = BINARY_VERSION;
+  view.setUint16(2, batch.count, true);
+  let p = BINARY_HEADER_BYTES;
+  for (let i = 0; i < batch.count; i++, p += BINARY_RECORD_BYTES) {
+    view.setUint32(p, batch.t[i], true);
+    view.setUint16(p + 4, batch.humidity[i], true);
+    view.setInt16(p + 6, batch.temperature[i], true);
+    view.setUint16(p + 8, batch.adc[i], true);
+    out[p + 10] = batch.valid[i];
+    out[p + 11] = batch.sensor[i];
+  }
+  return out;
+}
+
+export function encodeNdjson(batch: Batch): string {
+  let out = "";
+  for (let i = 0; i < batch.count; i++)
+    out += `{"t":${batch.t[i]},"h":${batch.humidity[i]},"tc":${batch.temperature[i]},"adc":${batch.adc[i]},"ok":${batch.valid[i]}}\n`;
+  return out;
+}
+
+/**
+ * Fixed capacity ring of one device's samples, columnar, oldest overwritten first
+ * ts is wall clock ms, derived from the device clock when the batch arrives, non-decreasing
+ */
+export class DeviceRing {
+  readonly capacity: number;
+  readonly ts: Float64Array;
+  readonly humidity: Uint16Array;
+  readonly temperature: Int16Array;
+  readonly adc: Uint16Array;
+  readonly valid: Uint8Array;
+  head = 0; // next slot written
+  size = 0;
+  total = 0; // samples ever appended
+
+  constructor(capacity: number) {
+    this.capacity = capacity;
+    this.ts = new Float64Array(capacity);
+    this.humidity = new Uint16Array(capacity);
+    this.temperature = new Int16Array(capacity);
+    this.adc = new Uint16Array(capacity);
+    this.valid = new Uint8Array(capacity);
+  }
+
+  // Slot of the i-th oldest sample held
+  slot(i: number): number {
+    const at = this.head - this.size + i;
+    return at < 0 ? at + this.capacity : at;
+  }
+}
+
+export interface Latest {
+  device: string;
+  ts: number;
+  humidity: number; // %RH
+  temperatureC: number;
+  temperatureF: number;
+  photores: number; // ADC counts
+  valid: boolean;
+}
+
+// Called after a batch is stored, with the slots it landed in
+export type AppendListener = (device: string, ring: DeviceRing, first: number, count: number) => void;
+
+export interface StoreOptions {
+  ringSamples: number;
+  maxDevices: number;
+}
+
+/**
+ * Per-device rings and the latest-value cache
+ */
+export class SampleStore {
+  readonly options: StoreOptions;
+  private rings = new Map<string, DeviceRing>();
+  private latestByDevice = new Map<string, Latest>();
+  private latestAny: Latest | undefined;
+  private listeners: AppendListener[] = [];
+
+  constructor(options: StoreOptions) {
+    this.options = options;
+  }
+
+  onAppend(listener: AppendListener) {
+    this.listeners.push(listener);
+  }
+
+  ring(device: string): DeviceRing | undefined {
+    return this.rings.get(device);
+  }
+
+  devices(): string[] {
+    return [...this.rings.keys()];
+  }
+
+  latest(device?: string): Latest | undefined {
+    return device === undefined ? this.latestAny : this.latestByDevice.get(device);
+  }
+
+  /**
+   * Stores a validated batch. Device times are mapped to wall clock by taking the newest
+   * sample as received at receivedAt, which holds to within the uplink's flush delay, and
+   * never step back, so ring.ts stays sorted and can be binary searched.
+   * The latest entry is replaced by one new object once the whole batch is in, so a
+   * reader never sees a half updated value.
+   */
+  append(device: string, batch: Batch, receivedAt: number): number {
+    const count = batch.count;
+    if (!count) return 0;
+
+    let ring = this.rings.get(device);
+    if (!ring) {
+      if (this.rings.size >= this.options.maxDevices) throw new IngestError("too many devices", undefined, 429);
+      ring = new DeviceRing(this.options.ringSamples);
+      this.rings.set(device, ring);
+    }
+
+    let newest = 0;
+    let newestT = batch.t[0];
+    for (let i = 1; i < count; i++) {
+      if (batch.t[i] >= newestT) {
+        newestT = batch.t[i];
+        newest = i;
+      }
+    }
+
+    // a batch larger than the ring only keeps its tail
+    const skip = count > ring.capacity ? count - ring.capacity : 0;
+    const first = ring.head;
+    let floor = ring.size ? ring.ts[ring.slot(ring.size - 1)] : -Infinity;
+    for (let i = skip; i < count; i++) {
+      const at = ring.head;
+      const ts = receivedAt - (newestT - batch.t[i]);
+      floor = ts > floor ? ts : floor;
+      ring.ts[at] = floor;
+      ring.humidity[at] = batch.humidity[i];
+      ring.temperature[at] = batch.temperature[i];
+      ring.adc[at] = batch.adc[i];
+      ring.valid[at] = batch.valid[i];
+      ring.head = at + 1 === ring.capacity ? 0 : at + 1;
+    }
+    const stored = count - skip;
+    ring.size = Math.min(ring.capacity, ring.size + stored);
+    ring.total += stored;
+
+    const centiC = batch.temperature[newest];
+    const latest: Latest = {
+      device,
+      ts: receivedAt,
+      humidity: batch.humidity[newest] / 100,
+      temperatureC: centiC / 100,
+      temperatureF: Math.round(centiC * 9 / 5 + 3200) / 100,
+      photores: batch.adc[newest],
+      valid: batch.valid[newest] === 1,
+    };
+    this.latestByDevice.set(device, latest);
+    this.latestAny = latest;
+
+    for (const listener of this.listeners) listener(device, ring, first, stored);
+    return stored;
+  }
+}
+
+export function checkDevice(device: unknown): string {
+  if (typeof device !== "string" || !DEVICE_ID.test(device)) throw new IngestError("device must match [A-Za-z0-9._-]{1,64}");
+  return device;
+}
+
+/**
+ * Parses a body by content type and stores it, returns the samples stored
+ */
+export class Ingestor {
+  readonly store: SampleStore;
+  private scratch = createBatch(1024);
+
+  constructor(store: SampleStore) {
+    this.store = store;
+  }
+
+  ingest(device: string, contentType: string | undefined, body: Uint8Array, receivedAt = Date.now()): number {
+    const type = (contentType ?? "").split(";")[0].trim().toLowerCase();
+    let batch: Batch;
+    if (type === NDJSON_TYPE) batch = parseNdjson(body, this.scratch);
+    else if (type === BINARY_TYPE) batch = parseBinary(body, this.scratch);
+    else throw new IngestError(`content type must be ${NDJSON_TYPE} or ${BINARY_TYPE}`, undefined, 415);
+    this.scratch = batch;
+    return this.store.append(device, batch, receivedAt);
+  }
+}
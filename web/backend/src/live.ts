@@ -0,0 +1,219 @@
+// Live readings over Server-Sent Events, GET /live
+//
+// Each stored batch turns into one "sample" event with the device's newest reading, and each
+// alert that fires or resolves into an "alert" event (see alerts.ts). Events
+// go out on the next turn of the event loop, so ingest answers first, and batches arriving
+// in the same turn collapse to the newest per device. A frame is encoded once and the same
+// string is written to every subscriber.
+//
+// A subscriber writes straight to its socket until the socket pushes back. From then on it
+// holds at most one pending sample frame per device, a newer one replacing the older, and
+// writes them out on drain. Alert frames are edge events, so they are never coalesced: they
+// wait in a FIFO of their own, and a subscriber whose FIFO overflows is disconnected, to
+// reconnect and resync through GET /alerts. A slow client so costs a bounded amount of memory
+// and never holds up ingest or the other subscribers.
+
+import type { IncomingMessage, ServerResponse } from "node:http";
+import type { AlertEvent } from "./alerts.js";
+import type { Latest, SampleStore } from "./ingest.js";
+
+export interface LiveOptions {
+  maxSubscribers: number;
+  maxPending: number; // devices a blocked subscriber keeps a sample frame for
+  maxAlerts: number; // alert frames a blocked subscriber queues before it is disconnected
+  heartbeatMs: number;
+}
+
+export interface LiveStats {
+  subscribers: number;
+  published: number; // frames fanned out
+  written: number; // frames written to sockets
+  coalesced: number; // sample frames replaced or dropped before a slow subscriber took them
+  dropped: number; // subscribers disconnected for falling behind on alerts
+}
+
+class Subscriber {
+  readonly res: ServerResponse;
+  readonly maxPending: number;
+  readonly maxAlerts: number;
+  readonly stats: LiveStats;
+  private blocked = false;
+  private closed = false;
+  private pending = new Map<string, string>(); // device -> newest sample frame, oldest first
+  private alerts: string[] = []; // alert frames in order
+
+  constructor(res: ServerResponse, maxPending: number, maxAlerts: number, stats: LiveStats) {
+    this.res = res;
+    this.maxPending = maxPending;
+    this.maxAlerts = maxAlerts;
+    this.stats = stats;
+  }
+
+  send(key: string, frame: string) {
+    if (this.closed) return;
+    if (!this.blocked) {
+      this.write(frame);
+      return;
+    }
+    if (this.pending.delete(key)) {
+      this.stats.coalesced++;
+    } else if (this.pending.size >= this.maxPending) {
+      const oldest = this.pending.keys().next().value as string;
+      this.pending.delete(oldest);
+      this.stats.coalesced++;
+    }
+    this.pending.set(key, frame);
+  }
+
+  // Alert frames are queued whole; a subscriber too far behind is dropped to resync
+  sendAlert(frame: string) {
+    if (this.closed) return;
+    if (!this.blocked) {
+      this.write(frame);
+    } else if (this.alerts.length < this.maxAlerts) {
+      this.alerts.push(frame);
+    } else {
+      this.closed = true;
+      this.alerts.length = 0;
+      this.pending.clear();
+      this.stats.dropped++;
+      this.res.destroy();
+    }
+  }
+
+  // Comment line that keeps proxies from timing the stream out, skipped while blocked
+  ping() {
+    if (!this.blocked) this.res.write(": ping\n\n");
+  }
+
+  private write(frame: string) {
+    this.stats.written++;
+    if (!this.res.write(frame)) {
+      this.blocked = true;
+      this.res.once("drain", this.flush);
+    }
+  }
+
+  private flush = () => {
+    this.blocked = false;
+    if (this.closed) return;
+    let i = 0;
+    while (i < this.alerts.length && !this.blocked) this.write(this.alerts[i++]);
+    this.alerts.splice(0, i);
+    if (this.blocked) return;
+    for (const [key, frame] of this.pending) {
+      this.pending.delete(key);
+      this.write(frame);
+      if (this.blocked) return;
+    }
+  };
+}
+
+/**
+ * Fans the store's new readings out to SSE subscribers, all devices or one
+ */
+export class LiveHub {
+  readonly store: SampleStore;
+  readonly options: LiveOptions;
+  readonly stats: LiveStats = { subscribers: 0, published: 0, written: 0, coalesced: 0, dropped: 0 };
+  private everyDevice = new Set<Subscriber>();
+  private byDevice = new Map<string, Set<Subscriber>>();
+  private queued = new Map<string, Latest>(); // newest reading per device, not yet fanned out
+  private alerts: AlertEvent[] = [];
+  private scheduled = false;
+  private sequence = 0;
+
+  constructor(store: SampleStore, options: LiveOptions) {
+    this.store = store;
+    this.options = options;
+    store.onAppend((device) => this.publish(device));
+    setInterval(() => {
+      for (const s of this.everyDevice) s.ping();
+      for (const set of this.byDevice.values()) for (const s of set) s.ping();
+    }, options.heartbeatMs).unref();
+  }
+
+  private frame(latest: Latest): string {
+    return `id: ${++this.sequence}\nevent: sample\ndata: ${JSON.stringify(latest)}\n\n`;
+  }
+
+  private publish(device: string) {
+    const latest = this.store.latest(device);
+    if (!latest || (!this.everyDevice.size && !this.byDevice.has(device))) return;
+    this.queued.set(device, latest);
+    this.schedule();
+  }
+
+  /**
+   * Queues an alert that fired or resolved for the device's subscribers and the all-device ones
+   */
+  alert(event: AlertEvent) {
+    if (!this.everyDevice.size && !this.byDevice.has(event.device)) return;
+    this.alerts.push(event);
+    this.schedule();
+  }
+
+  private schedule() {
+    if (!this.scheduled) {
+      this.scheduled = true;
+      setImmediate(this.fanOut);
+    }
+  }
+
+  private send(device: string, frame: string, alert: boolean) {
+    this.stats.published++;
+    const deliver = (s: Subscriber) => {
+      if (alert) s.sendAlert(frame);
+      else s.send(device, frame);
+    };
+    this.byDevice.get(device)?.forEach(deliver);
+    this.everyDevice.forEach(deliver);
+  }
+
+  private fanOut = () => {
+    this.scheduled = false;
+    for (const [device, latest] of this.queued) this.send(device, this.frame(latest), false);
+    this.queued.clear();
+    for (const event of this.alerts)
+      this.send(event.device, `id: ${++this.sequence}\nevent: alert\ndata: ${JSON.stringify(event)}\n\n`, true);
+    this.alerts.length = 0;
+  };
+
+  /**
+   * Turns res into an event stream of device's readings, or every device's when undefined
+   * Starts with the newest reading held, answers 503 when the hub is full
+   */
+  attach(req: IncomingMessage, res: ServerResponse, device?: string) {
+    if (this.stats.subscribers >= this.options.maxSubscribers) {
+      res.writeHead(503, { "retry-after": "10" }).end();
+      return;
+    }
+    res.writeHead(200, {
+      "content-type": "text/event-stream",
+      "cache-control": "no-cache",
+      connection: "keep-alive",
+      "x-accel-buffering": "no", // nginx would otherwise buffer the stream
+    });
+    res.write("retry: 2000\n\n");
+
+    const subscriber = new Subscriber(res, this.options.maxPending, this.options.maxAlerts, this.stats);
+    let set = this.everyDevice;
+    if (device !== undefined) {
+      set = this.byDevice.get(device) ?? new Set();
+      this.byDevice.set(device, set);
+    }
+    set.add(subscriber);
+    this.stats.subscribers++;
+
+    for (const d of device === undefined ? this.store.devices() : [device]) {
+      const latest = this.store.latest(d);
+      if (latest) subscriber.send(d, this.frame(latest));
+    }
+
+    req.on("close", () => {
+      set.delete(subscriber);
+      if (device !== undefined && !set.size) this.byDevice.delete(device);
+      this.stats.subscribers--;
+    });
+  }
+}
@@ -0,0 +1,296 @@
+// Rollup tiers behind GET /series: per device, 1 min, 1 h and 1 day buckets with count, min,
+// max and mean of each channel, folded in as batches are stored. The raw tier is the device
+// ring itself.
+//
+// The tiers live in memory only. At startup the server replays the segment files into them
+// (replay()), so after a restart they hold the stored history again; the ring does not, it
+// only fills from new batches.
+//
+// Every tier is a ring sorted by bucket start, so a query finds its range with two binary
+// searches and then only touches the points it returns, whatever the time span.
+
+import type { DeviceRing, SampleStore } from "./ingest.js";
+import { RECORD_BYTES } from "./segments.js";
+
+const HUMIDITY = 0;
+const TEMPERATURE = 1;
+const PHOTORES = 2;
+const NUM_CHANNELS = 3;
+const SCALE = [100, 100, 1]; // stored centi-%RH and centi-degrees, photores as counts
+
+export interface TierSpec {
+  name: string;
+  bucketMs: number;
+  buckets: number;
+}
+
+// Aligned to UTC, finest first
+export const TIERS: TierSpec[] = [
+  { name: "1m", bucketMs: 60 * 1000, buckets: 7 * 24 * 60 }, // a week
+  { name: "1h", bucketMs: 60 * 60 * 1000, buckets: 90 * 24 }, // 90 days
+  { name: "1d", bucketMs: 24 * 60 * 60 * 1000, buckets: 5 * 366 }, // 5 years
+];
+
+/**
+ * Ring of buckets for one device and one bucket size, columnar, oldest overwritten first
+ * Humidity and temperature only fold samples with a good DHT20 reading (validCount),
+ * photores folds every sample (count).
+ */
+export class RollupTier {
+  readonly name: string;
+  readonly bucketMs: number;
+  readonly capacity: number;
+  readonly start: Float64Array; // bucket start, wall clock ms
+  readonly count: Uint32Array;
+  readonly validCount: Uint32Array;
+  readonly min: Int16Array[]; // by channel
+  readonly max: Int16Array[];
+  readonly sum: Float64Array[];
+  head = 0; // next slot written
+  size = 0;
+  wrapped = false; // true once a bucket has been overwritten
+
+  constructor(spec: TierSpec) {
+    this.name = spec.name;
+    this.bucketMs = spec.bucketMs;
+    this.capacity = spec.buckets;
+    this.start = new Float64Array(spec.buckets);
+    this.count = new Uint32Array(spec.buckets);
+    this.validCount = new Uint32Array(spec.buckets);
+    this.min = [];
+    this.max = [];
+    this.sum = [];
+    for (let c = 0; c < NUM_CHANNELS; c++) {
+      this.min.push(new Int16Array(spec.buckets));
+      this.max.push(new Int16Array(spec.buckets));
+      this.sum.push(new Float64Array(spec.buckets));
+    }
+  }
+
+  // Slot of the i-th oldest bucket held
+  slot(i: number): number {
+    const at = this.head - this.size + i;
+    return at < 0 ? at + this.capacity : at;
+  }
+
+  /**
+   * Folds one sample in, ts must not be older than the newest bucket
+   */
+  add(ts: number, valid: boolean, humidity: number, temperature: number, photores: number) {
+    const start = ts - (ts % this.bucketMs);
+    let at = this.head === 0 ? this.capacity - 1 : this.head - 1;
+    if (!this.size || this.start[at] !== start) {
+      at = this.head;
+      this.head = at + 1 === this.capacity ? 0 : at + 1;
+      if (this.size < this.capacity) this.size++;
+      else this.wrapped = true;
+      this.start[at] = start;
+      this.count[at] = 0;
+      this.validCount[at] = 0;
+      for (let c = 0; c < NUM_CHANNELS; c++) {
+        this.min[c][at] = 0x7fff;
+        this.max[c][at] = -0x8000;
+        this.sum[c][at] = 0;
+      }
+    }
+
+    this.count[at]++;
+    this.fold(PHOTORES, at, photores);
+    if (valid) {
+      this.validCount[at]++;
+      this.fold(HUMIDITY, at, humidity);
+      this.fold(TEMPERATURE, at, temperature);
+    }
+  }
+
+  private fold(c: number, at: number, value: number) {
+    if (value < this.min[c][at]) this.min[c][at] = value;
+    if (value > this.max[c][at]) this.max[c][at] = value;
+    this.sum[c][at] += value;
+  }
+}
+
+interface Sorted {
+  size: number;
+  slot(i: number): number;
+}
+
+/**
+ * First index i whose time is at or after value, times ascending
+ */
+function lowerBound(ring: Sorted, times: Float64Array, value: number): number {
+  let lo = 0;
+  let hi = ring.size;
+  while (lo < hi) {
+    const mid = (lo + hi) >>> 1;
+    if (times[ring.slot(mid)] < value) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+export interface SeriesChannel {
+  min: (number | null)[];
+  max: (number | null)[];
+  mean: (number | null)[]; // null where a bucket has no good reading
+}
+
+export interface Series {
+  device: string;
+  tier: string; // "raw" or a TierSpec name
+  bucketMs: number; // 0 for raw, a multiple of the tier's when its buckets were merged
+  t: number[]; // sample time, or bucket start
+  count: number[];
+  humidity: SeriesChannel; // %RH
+  temperature: SeriesChannel; // degrees C
+  photores: SeriesChannel; // ADC counts
+}
+
+function emptySeries(device: string, tier: string, bucketMs: number): Series {
+  const channel = (): SeriesChannel => ({ min: [], max: [], mean: [] });
+  return { device, tier, bucketMs, t: [], count: [], humidity: channel(), temperature: channel(), photores: channel() };
+}
+
+function rawSeries(device: string, ring: DeviceRing, lo: number, hi: number): Series {
+  const out = emptySeries(device, "raw", 0);
+  const channels = [out.humidity, out.temperature, out.photores];
+  for (let i = lo; i < hi; i++) {
+    const at = ring.slot(i);
+    const valid = ring.valid[at] === 1;
+    out.t.push(ring.ts[at]);
+    out.count.push(1);
+    for (let c = 0; c < NUM_CHANNELS; c++) {
+      const stored = c === HUMIDITY ? ring.humidity[at] : c === TEMPERATURE ? ring.temperature[at] : ring.adc[at];
+      const value = c === PHOTORES ? stored : valid ? stored / SCALE[c] : null;
+      channels[c].min.push(value);
+      channels[c].max.push(value);
+      channels[c].mean.push(value);
+    }
+  }
+  return out;
+}
+
+/**
+ * Buckets lo..hi of a tier, merging each run of group buckets into one point
+ */
+function tierSeries(device: string, tier: RollupTier, lo: number, hi: number, group: number): Series {
+  const out = emptySeries(device, tier.name, tier.bucketMs * group);
+  const channels = [out.humidity, out.temperature, out.photores];
+  for (let i = lo; i < hi; i += group) {
+    const end = Math.min(hi, i + group);
+    let count = 0;
+    let validCount = 0;
+    for (let j = i; j < end; j++) {
+      const at = tier.slot(j);
+      count += tier.count[at];
+      validCount += tier.validCount[at];
+    }
+    out.t.push(tier.start[tier.slot(i)]);
+    out.count.push(count);
+
+    for (let c = 0; c < NUM_CHANNELS; c++) {
+      const n = c === PHOTORES ? count : validCount;
+      let min = 0x7fff;
+      let max = -0x8000;
+      let sum = 0;
+      for (let j = i; j < end; j++) {
+        const at = tier.slot(j);
+        if (c !== PHOTORES && !tier.validCount[at]) continue;
+        if (tier.min[c][at] < min) min = tier.min[c][at];
+        if (tier.max[c][at] > max) max = tier.max[c][at];
+        sum += tier.sum[c][at];
+      }
+      const scale = SCALE[c];
+      channels[c].min.push(n ? min / scale : null);
+      channels[c].max.push(n ? max / scale : null);
+      channels[c].mean.push(n ? Math.round((sum / n) * 100 / scale) / 100 : null);
+    }
+  }
+  return out;
+}
+
+/**
+ * Keeps the rollup tiers of every device in a store and answers series queries from them
+ */
+export class Rollups {
+  readonly store: SampleStore;
+  readonly specs: TierSpec[];
+  private tiers = new Map<string, RollupTier[]>();
+  private replayed = new Set<string>(); // devices whose tiers hold data from before the ring
+
+  constructor(store: SampleStore, specs = TIERS) {
+    this.store = store;
+    this.specs = specs;
+    store.onAppend((device, ring, first, count) => this.add(device, ring, first, count));
+  }
+
+  private tiersOf(device: string): RollupTier[] {
+    let tiers = this.tiers.get(device);
+    if (!tiers) {
+      tiers = this.specs.map((spec) => new RollupTier(spec));
+      this.tiers.set(device, tiers);
+    }
+    return tiers;
+  }
+
+  private add(device: string, ring: DeviceRing, first: number, count: number) {
+    const tiers = this.tiersOf(device);
+    for (let i = 0, at = first; i < count; i++, at = at + 1 === ring.capacity ? 0 : at + 1) {
+      const ts = ring.ts[at];
+      const valid = ring.valid[at] === 1;
+      for (const tier of tiers) tier.add(ts, valid, ring.humidity[at], ring.temperature[at], ring.adc[at]);
+    }
+  }
+
+  /**
+   * Folds count stored records of device (the segment layout, see segments.ts) into its
+   * tiers, oldest first and before any newer batch; a SegmentStore.read visitor
+   */
+  replay(device: string, records: Buffer, count: number) {
+    const tiers = this.tiersOf(device);
+    this.replayed.add(device);
+    for (let i = 0, at = 0; i < count; i++, at += RECORD_BYTES) {
+      const ts = records.readDoubleLE(at);
+      const humidity = records.readUInt16LE(at + 8);
+      const temperature = records.readInt16LE(at + 10);
+      const adc = records.readUInt16LE(at + 12);
+      const valid = records[at + 14] === 1;
+      for (const tier of tiers) tier.add(ts, valid, humidity, temperature, adc);
+    }
+  }
+
+  /**
+   * Samples of device between from and to (wall clock ms, inclusive) at the finest
+   * resolution that fits in maxPoints: raw, then each tier in turn, skipping any that has
+   * already dropped data from the start of the range. When even the coarsest tier has too
+   * many buckets, runs of them are merged. Undefined for a device that never reported.
+   */
+  series(device: string, from: number, to: number, maxPoints: number): Series | undefined {
+    const ring = this.store.ring(device);
+    const tiers = this.tiers.get(device);
+    if (!tiers) return undefined;
+
+    // the ring holds everything from its oldest sample on, and all there is unless it has
+    // wrapped or the tiers were replayed from older segments
+    const partial = !ring || ring.total > ring.size || this.replayed.has(device);
+    const rawFrom = !ring?.size ? Infinity : partial ? ring.ts[ring.slot(0)] : -Infinity;
+    if (ring && from >= rawFrom) {
+      const lo = lowerBound(ring, ring.ts, from);
+      const hi = lowerBound(ring, ring.ts, to + 1);
+      if (hi - lo <= maxPoints) return rawSeries(device, ring, lo, hi);
+    }
+
+    let lo = 0;
+    let hi = 0;
+    for (const tier of tiers) {
+      // buckets that overlap the range
+      lo = lowerBound(tier, tier.start, from - tier.bucketMs + 1);
+      hi = lowerBound(tier, tier.start, to + 1);
+      const tierFrom = tier.wrapped ? tier.start[tier.slot(0)] : -Infinity;
+      if (from >= tierFrom && hi - lo <= maxPoints) return tierSeries(device, tier, lo, hi, 1);
+    }
+
+    const coarsest = tiers[tiers.length - 1];
+    return tierSeries(device, coarsest, lo, hi, Math.max(1, Math.ceil((hi - lo) / maxPoints)));
+  }
+}
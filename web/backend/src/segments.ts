@@ -0,0 +1,314 @@
+// Append-only segment files, the durable copy of every stored sample
+//
+// Each device has a directory of segments named by their first timestamp. A segment is a run
+// of fixed width records, little endian:
+//   f64 ts (wall clock ms), u16 humidity, i16 temperature, u16 adc, u8 valid, u8 reserved
+// The newest segment is "<first>.open" and grows with every batch. At SEGMENT_RECORDS it is
+// sealed: a footer goes on the end, the ts of every INDEX_STRIDE-th record and then a fixed
+// trailer (count, stride, first and last ts, index size, magic), and it is renamed "<first>.seg".
+//
+// Opening a store reads only the trailers and indexes of sealed segments, and every
+// INDEX_STRIDE-th record of each open one, so restart time follows the number of segments,
+// not the data. A range read finds the segments by time in memory, narrows each to a few
+// index strides, and reads just those bytes with one positional read per segment into a
+// freshly allocated buffer. That is a copy out of the page cache, but one per segment, and
+// the records are then visited in that buffer without being decoded into objects. Node has
+// no mmap, so this is the closest it gets.
+//
+// Writes are synchronous, one per batch. A crash can lose what the OS had not written back;
+// a torn last record of an open segment is cut off when it is reopened.
+
+import fs from "node:fs";
+import path from "node:path";
+import type { DeviceRing } from "./ingest.js";
+
+export const RECORD_BYTES = 16;
+export const SEGMENT_RECORDS = 65536; // 1 MB, 18 hours at 1 Hz
+export const INDEX_STRIDE = 1024;
+const TRAILER_BYTES = 32;
+const MAGIC = 0x31475348; // "HSG1"
+const DEVICE_PREFIX = "dev-"; // keeps ids such as ".." from naming a parent directory
+
+interface Segment {
+  file: string;
+  first: number; // ts of the first and last record
+  last: number;
+  count: number;
+  index: number[]; // ts of records 0, INDEX_STRIDE, 2 * INDEX_STRIDE, ...
+}
+
+interface OpenSegment extends Segment {
+  fd: number;
+}
+
+interface DeviceSegments {
+  dir: string;
+  sealed: Segment[]; // oldest first
+  open: OpenSegment | undefined;
+}
+
+export interface SegmentStats {
+  devices: number;
+  segments: number;
+  records: number;
+}
+
+// First index i with values[i] >= value, or > value when after is set
+function bound(values: ArrayLike<number>, value: number, after = false): number {
+  let lo = 0;
+  let hi = values.length;
+  while (lo < hi) {
+    const mid = (lo + hi) >>> 1;
+    if (values[mid] < value || (after && values[mid] === value)) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+// Same over the ts of count records in buf
+function recordBound(buf: Buffer, count: number, value: number, after = false): number {
+  let lo = 0;
+  let hi = count;
+  while (lo < hi) {
+    const mid = (lo + hi) >>> 1;
+    const ts = buf.readDoubleLE(mid * RECORD_BYTES);
+    if (ts < value || (after && ts === value)) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+// First ts then the segment's number, so names sort by time and never collide
+function segmentName(first: number, number: number): string {
+  return `${String(Math.max(0, Math.floor(first))).padStart(15, "0")}-${String(number).padStart(6, "0")}`;
+}
+
+/**
+ * Per-device segment files under one directory
+ */
+export class SegmentStore {
+  readonly dir: string;
+  private devices = new Map<string, DeviceSegments>();
+  private scratch = Buffer.alloc(0);
+
+  private constructor(dir: string) {
+    this.dir = dir;
+  }
+
+  /**
+   * Opens or creates a store in dir, rebuilding the in-memory index from segment footers
+   */
+  static open(dir: string): SegmentStore {
+    const store = new SegmentStore(dir);
+    fs.mkdirSync(dir, { recursive: true });
+    for (const entry of fs.readdirSync(dir, { withFileTypes: true })) {
+      if (!entry.isDirectory() || !entry.name.startsWith(DEVICE_PREFIX)) continue;
+      const device = entry.name.slice(DEVICE_PREFIX.length);
+      const segments: DeviceSegments = { dir: path.join(dir, entry.name), sealed: [], open: undefined };
+      for (const file of fs.readdirSync(segments.dir).sort()) {
+        const full = path.join(segments.dir, file);
+        if (file.endsWith(".seg")) segments.sealed.push(SegmentStore.readFooter(full));
+        else if (file.endsWith(".open")) {
+          if (SegmentStore.hasFooter(full)) {
+            // sealed, but a crash came before the rename
+            const sealed = full.replace(/\.open$/, ".seg");
+            fs.renameSync(full, sealed);
+            segments.sealed.push(SegmentStore.readFooter(sealed));
+            continue;
+          }
+          // only the newest can be open, seal any older one a crash left behind
+          if (segments.open) segments.sealed.push(store.seal(segments.open));
+          segments.open = SegmentStore.reopen(full);
+        }
+      }
+      store.devices.set(device, segments);
+    }
+    return store;
+  }
+
+  private static hasFooter(file: string): boolean {
+    const fd = fs.openSync(file, "r");
+    try {
+      const size = fs.fstatSync(fd).size;
+      if (size < TRAILER_BYTES) return false;
+      const trailer = Buffer.alloc(TRAILER_BYTES);
+      fs.readSync(fd, trailer, 0, TRAILER_BYTES, size - TRAILER_BYTES);
+      const expected = trailer.readUInt32LE(0) * RECORD_BYTES + trailer.readUInt32LE(24) + TRAILER_BYTES;
+      return trailer.readUInt32LE(28) === MAGIC && expected === size;
+    } finally {
+      fs.closeSync(fd);
+    }
+  }
+
+  private static readFooter(file: string): Segment {
+    const fd = fs.openSync(file, "r");
+    try {
+      const size = fs.fstatSync(fd).size;
+      const trailer = Buffer.alloc(TRAILER_BYTES);
+      fs.readSync(fd, trailer, 0, TRAILER_BYTES, size - TRAILER_BYTES);
+      if (trailer.readUInt32LE(28) !== MAGIC) throw new Error(`${file}: not a sealed segment`);
+      const count = trailer.readUInt32LE(0);
+      const stride = trailer.readUInt32LE(4);
+      const indexBytes = trailer.readUInt32LE(24);
+      if (stride !== INDEX_STRIDE) throw new Error(`${file}: index stride ${stride}`);
+      const raw = Buffer.alloc(indexBytes);
+      fs.readSync(fd, raw, 0, indexBytes, size - TRAILER_BYTES - indexBytes);
+      const index: number[] = [];
+      for (let i = 0; i < indexBytes; i += 8) index.push(raw.readDoubleLE(i));
+      return { file, count, first: trailer.readDoubleLE(8), last: trailer.readDoubleLE(16), index };
+    } finally {
+      fs.closeSync(fd);
+    }
+  }
+
+  private static reopen(file: string): OpenSegment {
+    const fd = fs.openSync(file, "r+");
+    const size = fs.fstatSync(fd).size;
+    const count = Math.floor(size / RECORD_BYTES);
+    if (size !== count * RECORD_BYTES) fs.ftruncateSync(fd, count * RECORD_BYTES);
+
+    const ts = Buffer.alloc(8);
+    const at = (i: number) => {
+      fs.readSync(fd, ts, 0, 8, i * RECORD_BYTES);
+      return ts.readDoubleLE(0);
+    };
+    const index: number[] = [];
+    for (let i = 0; i < count; i += INDEX_STRIDE) index.push(at(i));
+    return { file, fd, count, index, first: count ? at(0) : 0, last: count ? at(count - 1) : 0 };
+  }
+
+  stats(): SegmentStats {
+    let segments = 0;
+    let records = 0;
+    for (const d of this.devices.values()) {
+      segments += d.sealed.length + (d.open ? 1 : 0);
+      for (const s of d.sealed) records += s.count;
+      records += d.open?.count ?? 0;
+    }
+    return { devices: this.devices.size, segments, records };
+  }
+
+  /**
+   * Ids of the devices with segments
+   */
+  deviceIds(): string[] {
+    return [...this.devices.keys()];
+  }
+
+  /**
+   * Appends the ring slots first..first+count of device, the store's onAppend listener
+   */
+  append(device: string, ring: DeviceRing, first: number, count: number) {
+    let segments = this.devices.get(device);
+    if (!segments) {
+      segments = { dir: path.join(this.dir, DEVICE_PREFIX + device), sealed: [], open: undefined };
+      fs.mkdirSync(segments.dir, { recursive: true });
+      this.devices.set(device, segments);
+    }
+
+    let at = first;
+    while (count > 0) {
+      if (!segments.open || segments.open.count >= SEGMENT_RECORDS) {
+        if (segments.open) segments.sealed.push(this.seal(segments.open));
+        const file = path.join(segments.dir, `${segmentName(ring.ts[at], segments.sealed.length)}.open`);
+        segments.open = { file, fd: fs.openSync(file, "w+"), count: 0, index: [], first: ring.ts[at], last: ring.ts[at] };
+      }
+      const open = segments.open;
+      if (!open.count) open.first = ring.ts[at];
+      const n = Math.min(count, SEGMENT_RECORDS - open.count);
+      const bytes = n * RECORD_BYTES;
+      if (this.scratch.length < bytes) this.scratch = Buffer.alloc(Math.max(bytes, 64 * 1024));
+      const buf = this.scratch;
+      for (let i = 0; i < n; i++) {
+        const p = i * RECORD_BYTES;
+        if ((open.count + i) % INDEX_STRIDE === 0) open.index.push(ring.ts[at]);
+        buf.writeDoubleLE(ring.ts[at], p);
+        buf.writeUInt16LE(ring.humidity[at], p + 8);
+        buf.writeInt16LE(ring.temperature[at], p + 10);
+        buf.writeUInt16LE(ring.adc[at], p + 12);
+        buf[p + 14] = ring.valid[at];
+        buf[p + 15] = 0;
+        open.last = ring.ts[at];
+        at = at + 1 === ring.capacity ? 0 : at + 1;
+      }
+      fs.writeSync(open.fd, buf, 0, bytes, open.count * RECORD_BYTES);
+      open.count += n;
+      count -= n;
+    }
+  }
+
+  // Writes the footer, syncs and renames .open to .seg
+  private seal(open: OpenSegment): Segment {
+    const indexBytes = open.index.length * 8;
+    const footer = Buffer.alloc(indexBytes + TRAILER_BYTES);
+    open.index.forEach((ts, i) => footer.writeDoubleLE(ts, i * 8));
+    footer.writeUInt32LE(open.count, indexBytes);
+    footer.writeUInt32LE(INDEX_STRIDE, indexBytes + 4);
+    footer.writeDoubleLE(open.first, indexBytes + 8);
+    footer.writeDoubleLE(open.last, indexBytes + 16);
+    footer.writeUInt32LE(indexBytes, indexBytes + 24);
+    footer.writeUInt32LE(MAGIC, indexBytes + 28);
+    fs.writeSync(open.fd, footer, 0, footer.length, open.count * RECORD_BYTES);
+    fs.fsyncSync(open.fd);
+    fs.closeSync(open.fd);
+    const file = open.file.replace(/\.open$/, ".seg");
+    fs.renameSync(open.file, file);
+    return { file, first: open.first, last: open.last, count: open.count, index: open.index };
+  }
+
+  /**
+   * Calls visit with the records of device between from and to (ms, inclusive), oldest
+   * first, one buffer per segment touched. records is the buffer as read from the file,
+   * count records of RECORD_BYTES from offset 0, and stays valid after visit returns.
+   * Stops early when visit returns false. Returns the records visited.
+   */
+  read(device: string, from: number, to: number, visit: (records: Buffer, count: number) => boolean | void): number {
+    const segments = this.devices.get(device);
+    if (!segments) return 0;
+    const all: Segment[] = segments.open ? [...segments.sealed, segments.open] : segments.sealed;
+
+    // the first segment that can hold from is the last one starting at or before it
+    let s = 0;
+    for (let hi = all.length; s < hi; ) {
+      const mid = (s + hi) >>> 1;
+      if (all[mid].first <= from) s = mid + 1;
+      else hi = mid;
+    }
+    s = Math.max(0, s - 1);
+
+    let visited = 0;
+    for (; s < all.length && all[s].first <= to; s++) {
+      const seg = all[s];
+      if (!seg.count || seg.last < from) continue;
+
+      // whole strides that can hold the range, then the exact records inside them
+      const lo = Math.max(0, bound(seg.index, from) - 1) * INDEX_STRIDE;
+      const hi = Math.min(seg.count, bound(seg.index, to, true) * INDEX_STRIDE);
+      if (hi <= lo) continue;
+      const buf = Buffer.allocUnsafe((hi - lo) * RECORD_BYTES);
+      const own = !("fd" in seg);
+      const fd = own ? fs.openSync(seg.file, "r") : (seg as OpenSegment).fd;
+      try {
+        fs.readSync(fd, buf, 0, buf.length, lo * RECORD_BYTES);
+      } finally {
+        if (own) fs.closeSync(fd);
+      }
+      const start = recordBound(buf, hi - lo, from);
+      const end = recordBound(buf, hi - lo, to, true);
+      if (end <= start) continue;
+      visited += end - start;
+      if (visit(buf.subarray(start * RECORD_BYTES, end * RECORD_BYTES), end - start) === false) break;
+    }
+    return visited;
+  }
+
+  /**
+   * Closes the open segments' files, they stay open on disk and are picked up again
+   */
+  close() {
+    for (const d of this.devices.values()) {
+      if (d.open) fs.closeSync(d.open.fd);
+      d.open = undefined;
+    }
+  }
+}
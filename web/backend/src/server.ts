@@ -1,28 +1,218 @@
 'use strict'
+import fs from "node:fs";
 import express from "express";
 import cors from "cors";
+import { AlertEngine, AlertRuleError } from "./alerts.js";
+import { BINARY_TYPE, Ingestor, IngestError, NDJSON_TYPE, SampleStore, checkDevice } from "./ingest.js";
+import { LiveHub } from "./live.js";
+import { Rollups, TIERS } from "./rollups.js";
+import { RECORD_BYTES, SegmentStore } from "./segments.js";
 
 const app = express();
 
 app.use(cors());
 app.use(express.json());
 
+const store = new SampleStore({
+  ringSamples: Number(process.env.INGEST_RING_SAMPLES ?? 86400), // a day at 1 Hz per device
+  maxDevices: Number(process.env.INGEST_MAX_DEVICES ?? 256),
+});
+const ingestor = new Ingestor(store);
+
+// every stored sample also goes to the segment files (see segments.ts)
+const opening = performance.now();
+const segments = SegmentStore.open(process.env.STORE_DIR ?? "data");
+const opened = segments.stats();
+console.log(
+  `Opened ${opened.segments} segments of ${opened.devices} devices (${opened.records} samples)` +
+    ` in ${(performance.now() - opening).toFixed(1)} ms`,
+);
+store.onAppend((device, ring, first, count) => segments.append(device, ring, first, count));
+const rollups = new Rollups(store);
+
+// the rollup tiers are in memory, rebuild them from the segments before any batch lands
+const replaying = performance.now();
+let replayed = 0;
+for (const device of segments.deviceIds()) {
+  replayed += segments.read(device, -Infinity, Infinity, (records, count) => rollups.replay(device, records, count));
+}
+console.log(`Replayed ${replayed} samples into the rollups in ${(performance.now() - replaying).toFixed(1)} ms`);
+const live = new LiveHub(store, {
+  maxSubscribers: Number(process.env.LIVE_MAX_SUBSCRIBERS ?? 10000),
+  maxPending: 64,
+  maxAlerts: 256,
+  heartbeatMs: 15000,
+});
+
+// threshold alerts on every stored sample, rules from the JSON array in ALERT_RULES if set
+const alerts = new AlertEngine(store);
+if (process.env.ALERT_RULES) {
+  for (const rule of JSON.parse(fs.readFileSync(process.env.ALERT_RULES, "utf8"))) alerts.set(rule);
+  console.log(`Loaded ${alerts.size} alert rules from ${process.env.ALERT_RULES}`);
+}
+alerts.onEvent((event) => {
+  live.alert(event);
+  console.log(`Alert ${event.rule} ${event.state} on ${event.device}: ${event.value} at ${new Date(event.ts).toISOString()}`);
+});
+
+const SERIES_MAX_POINTS = 10000;
+const RAW_MAX_SAMPLES = 1000000;
+const DAY_MS = 24 * 60 * 60 * 1000;
+
+// Query value as wall clock ms or a count, from a number or a date string
+function numberParam(value: unknown, fallback: number): number {
+  if (value === undefined) return fallback;
+  if (typeof value !== "string") return NaN;
+  const n = Number(value);
+  return Number.isFinite(n) ? n : Date.parse(value);
+}
+
 app.get("/health", (_req, res) => {
   res.json({ ok: true, service: "backend", ts: Date.now() });
 });
 
+// Batches of samples from a device, ?device=<id>, NDJSON or binary (see ingest.ts)
+app.post(
+  "/ingest",
+  express.raw({ type: [NDJSON_TYPE, BINARY_TYPE], limit: process.env.INGEST_BODY_LIMIT ?? "4mb" }),
+  (req, res) => {
+    try {
+      const device = checkDevice(req.query.device ?? req.get("x-device-id"));
+      const body: Uint8Array = Buffer.isBuffer(req.body) ? req.body : new Uint8Array(0);
+      ingestor.ingest(device, req.get("content-type"), body);
+      res.status(204).end();
+    } catch (err) {
+      if (!(err instanceof IngestError)) throw err;
+      res.status(err.status).json({ error: err.message, line: err.line });
+    }
+  },
+);
+
+// Newest sample of ?device=<id>, or of whichever device reported last
+app.get("/latest", (req, res) => {
+  const device = typeof req.query.device === "string" ? req.query.device : undefined;
+  const latest = store.latest(device);
+  if (!latest) {
+    res.json({
+      humidity: 0,
+      temperatureC: 0,
+      temperatureF: 0,
+      photores: 0,
+      ts: Date.now(),
+    });
+    return;
+  }
+  res.json(latest);
+});
 
+// Server-Sent Events stream of new readings, of ?device=<id> or of every device (see live.ts)
+app.get("/live", (req, res) => {
+  let device: string | undefined;
+  try {
+    if (req.query.device !== undefined) device = checkDevice(req.query.device);
+  } catch (err) {
+    if (!(err instanceof IngestError)) throw err;
+    res.status(err.status).json({ error: err.message });
+    return;
+  }
+  live.attach(req, res, device);
+});
 
+// Alert rules and the alerts that are not ok, of ?device=<id> or of every device
+app.get("/alerts", (req, res) => {
+  const device = typeof req.query.device === "string" ? req.query.device : undefined;
+  res.json({ rules: alerts.list(), active: alerts.active(device) });
+});
 
-// test change for triger github ci 
-app.get("/latest", (_req, res) => {
-  res.json({
-    humidity: 0,
-    temperatureC: 0,
-    temperatureF: 0,
-    photores: 0,
-    ts: Date.now(),
+// Adds the rule, or replaces it and starts it over (see alerts.ts)
+app.put("/alerts/rules/:id", (req, res) => {
+  try {
+    res.json(alerts.set({ ...req.body, id: req.params.id }));
+  } catch (err) {
+    if (!(err instanceof AlertRuleError)) throw err;
+    res.status(400).json({ error: err.message });
+  }
+});
+
+app.delete("/alerts/rules/:id", (req, res) => {
+  res.status(alerts.delete(req.params.id) ? 204 : 404).end();
+});
+
+// The /series point cap and the rollup tiers, so clients size their ranges from the backend
+app.get("/series/limits", (_req, res) => {
+  res.json({ maxPoints: SERIES_MAX_POINTS, tiers: TIERS });
+});
+
+// History of ?device=<id> between from and to (ms or ISO dates, default the last day) in at
+// most maxPoints points (default 1000), from the finest rollup tier that fits (see rollups.ts)
+app.get("/series", (req, res) => {
+  const device = typeof req.query.device === "string" ? req.query.device : "";
+  const to = numberParam(req.query.to, Date.now());
+  const from = numberParam(req.query.from, to - DAY_MS);
+  const maxPoints = numberParam(req.query.maxPoints, 1000);
+  if (!device || !Number.isFinite(from) || !Number.isFinite(to) || from > to) {
+    res.status(400).json({ error: "device, and from <= to as ms or dates, are required" });
+    return;
+  }
+  if (!Number.isInteger(maxPoints) || maxPoints < 1 || maxPoints > SERIES_MAX_POINTS) {
+    res.status(400).json({ error: `maxPoints must be 1 to ${SERIES_MAX_POINTS}` });
+    return;
+  }
+
+  const series = rollups.series(device, from, to, maxPoints);
+  if (!series) {
+    res.status(404).json({ error: "unknown device" });
+    return;
+  }
+  res.json(series);
+});
+
+// Stored samples of ?device=<id> between from and to (ms or ISO dates, default the last hour)
+// from the segment files, at most limit (default 10000). JSON columns, or with
+// Accept: application/octet-stream the records as stored (see segments.ts).
+app.get("/raw", (req, res) => {
+  const device = typeof req.query.device === "string" ? req.query.device : "";
+  const to = numberParam(req.query.to, Date.now());
+  const from = numberParam(req.query.from, to - 60 * 60 * 1000);
+  const limit = numberParam(req.query.limit, 10000);
+  if (!device || !Number.isFinite(from) || !Number.isFinite(to) || from > to) {
+    res.status(400).json({ error: "device, and from <= to as ms or dates, are required" });
+    return;
+  }
+  if (!Number.isInteger(limit) || limit < 1 || limit > RAW_MAX_SAMPLES) {
+    res.status(400).json({ error: `limit must be 1 to ${RAW_MAX_SAMPLES}` });
+    return;
+  }
+
+  const chunks: Buffer[] = [];
+  let held = 0;
+  let truncated = false;
+  segments.read(device, from, to, (records, count) => {
+    const take = Math.min(count, limit - held);
+    truncated = take < count;
+    if (take) chunks.push(take === count ? records : records.subarray(0, take * RECORD_BYTES));
+    held += take;
+    return !truncated;
   });
+
+  if (req.accepts(["json", BINARY_TYPE]) === BINARY_TYPE) {
+    res.type(BINARY_TYPE).set("x-truncated", truncated ? "1" : "0");
+    for (const chunk of chunks) res.write(chunk);
+    res.end();
+    return;
+  }
+
+  const out = { device, truncated, t: [] as number[], humidity: [] as number[], temperature: [] as number[], photores: [] as number[], valid: [] as boolean[] };
+  for (const chunk of chunks) {
+    for (let p = 0; p < chunk.length; p += RECORD_BYTES) {
+      out.t.push(chunk.readDoubleLE(p));
+      out.humidity.push(chunk.readUInt16LE(p + 8) / 100);
+      out.temperature.push(chunk.readInt16LE(p + 10) / 100);
+      out.photores.push(chunk.readUInt16LE(p + 12));
+      out.valid.push(chunk[p + 14] === 1);
+    }
+  }
+  res.json(out);
 });
 
 const port = Number(process.env.PORT ?? 3001);
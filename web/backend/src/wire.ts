@@ -0,0 +1,145 @@
+// Compact binary sample batches, version 2 of the binary ingest format, shared with the
+// firmware (embedded/src/data_flow/wire.h has the full description):
+//
+//   u8 version (2), u8 fields, u16 count, varint period_ms, then count records
+//
+// fields is a mask of what each record carries, in this order: t u32 device ms, h centi-%RH,
+// tc centi-degrees C, adc counts (default 0), status ok | sensor << 1 (default ok, sensor 0).
+// Each record field is a zigzag LEB128 varint of its difference from the previous record's,
+// t less period_ms, all taken modulo 2^32. The golden vectors in
+// embedded/tools/wire_golden.txt pin the bytes; bench/wire.ts checks this file against them.
+//
+// No Node APIs, so the frontend can bundle it too. The decoder reads the request body in
+// place through a DataView and writes straight into columns, no objects per sample.
+
+export const WIRE_VERSION = 2;
+export const WIRE_HEADER_MAX = 9; // version, fields, count, 5-byte period
+export const WIRE_RECORD_MAX = 25; // 5 fields, 5 bytes each
+
+export const WIRE_T = 1 << 0;
+export const WIRE_H = 1 << 1;
+export const WIRE_TC = 1 << 2;
+export const WIRE_ADC = 1 << 3;
+export const WIRE_STATUS = 1 << 4;
+export const WIRE_REQUIRED = WIRE_T | WIRE_H | WIRE_TC;
+export const WIRE_ALL = WIRE_REQUIRED | WIRE_ADC | WIRE_STATUS;
+
+export class WireError extends Error {}
+
+// What a batch decodes into, ingest's Batch fits
+export interface WireColumns {
+  t: Float64Array;
+  humidity: Uint16Array;
+  temperature: Int16Array;
+  adc: Uint16Array;
+  valid: Uint8Array;
+  sensor: Uint8Array;
+}
+
+/**
+ * Checks the header and returns the number of samples, so the caller can size the columns
+ */
+export function wireCount(view: DataView): number {
+  if (view.byteLength < 5) throw new WireError("short binary batch");
+  if (view.getUint8(0) !== WIRE_VERSION) throw new WireError(`unknown binary version ${view.getUint8(0)}`);
+  const fields = view.getUint8(1);
+  if ((fields & WIRE_REQUIRED) !== WIRE_REQUIRED) throw new WireError("t, h and tc are required");
+  if (fields & ~WIRE_ALL) throw new WireError(`unknown fields 0x${fields.toString(16)}`);
+  return view.getUint16(2, true);
+}
+
+/**
+ * Decodes a batch into out, which must hold wireCount(view) samples, returns the count
+ */
+export function decodeWire(view: DataView, out: WireColumns): number {
+  const count = wireCount(view);
+  if (out.t.length < count) throw new WireError("batch larger than its columns");
+  const fields = view.getUint8(1);
+  const end = view.byteLength;
+  let pos = 4;
+
+  // LEB128, at most 32 bits
+  const varint = (): number => {
+    let value = 0;
+    for (let shift = 0; shift < 35; shift += 7) {
+      if (pos >= end) throw new WireError("binary batch ends inside a record");
+      const b = view.getUint8(pos++);
+      if (shift === 28 && b > 0x0f) throw new WireError("varint over 32 bits");
+      value = (value | ((b & 0x7f) << shift)) >>> 0;
+      if (!(b & 0x80)) return value;
+    }
+    throw new WireError("varint over 32 bits");
+  };
+  const delta = (): number => {
+    const v = varint();
+    return (v >>> 1) ^ -(v & 1);
+  };
+
+  const period = varint();
+  const hasAdc = (fields & WIRE_ADC) !== 0;
+  const hasStatus = (fields & WIRE_STATUS) !== 0;
+  let t = 0;
+  let h = 0;
+  let tc = 0;
+  let adc = 0;
+  let status = 0;
+  for (let i = 0; i < count; i++) {
+    t = (t + period + delta()) >>> 0;
+    h = (h + delta()) & 0xffff;
+    tc = ((tc + delta()) << 16) >> 16;
+    if (hasAdc) adc = (adc + delta()) & 0xffff;
+    status = hasStatus ? (status + delta()) & 0xff : 1;
+    out.t[i] = t;
+    out.humidity[i] = h;
+    out.temperature[i] = tc;
+    out.adc[i] = adc;
+    out.valid[i] = status & 1;
+    out.sensor[i] = status >> 1;
+  }
+  if (pos !== end) throw new WireError("bytes after the last record");
+  return count;
+}
+
+/**
+ * Encodes count samples of columns, for the benchmarks and load tools
+ */
+export function encodeWire(columns: WireColumns, count: number, periodMs: number, fields = WIRE_ALL): Uint8Array<ArrayBuffer> {
+  if ((fields & WIRE_REQUIRED) !== WIRE_REQUIRED || fields & ~WIRE_ALL) throw new WireError("t, h and tc are required");
+  if (count > 0xffff) throw new WireError("more than 65535 samples");
+  const out = new Uint8Array(WIRE_HEADER_MAX + count * WIRE_RECORD_MAX);
+  let pos = 0;
+  const varint = (v: number) => {
+    while (v >= 0x80) {
+      out[pos++] = (v & 0x7f) | 0x80;
+      v >>>= 7;
+    }
+    out[pos++] = v;
+  };
+  const delta = (d: number) => varint(((d << 1) ^ (d >> 31)) >>> 0);
+
+  out[0] = WIRE_VERSION;
+  out[1] = fields;
+  out[2] = count & 0xff;
+  out[3] = count >> 8;
+  pos = 4;
+  varint(periodMs >>> 0);
+  let t = 0;
+  let h = 0;
+  let tc = 0;
+  let adc = 0;
+  let status = 0;
+  for (let i = 0; i < count; i++) {
+    const s = (columns.valid[i] | (columns.sensor[i] << 1)) & 0xff;
+    delta((columns.t[i] - t - periodMs) | 0);
+    delta(columns.humidity[i] - h);
+    delta(columns.temperature[i] - tc);
+    if (fields & WIRE_ADC) delta(columns.adc[i] - adc);
+    if (fields & WIRE_STATUS) delta(s - status);
+    t = columns.t[i];
+    h = columns.humidity[i];
+    tc = columns.temperature[i];
+    adc = columns.adc[i];
+    status = s;
+  }
+  return out.slice(0, pos);
+}
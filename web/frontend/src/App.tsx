@@ -1,13 +1,148 @@
-export default function App() {
+import { useEffect, useState } from "react";
+import Chart from "./chart/Chart.tsx";
+import type { Trace } from "./chart/draw.ts";
+import { LttbPyramid, appendPoint, createSeries, type Series } from "./chart/lttb.ts";
+import RenderBench from "./bench/RenderBench.tsx";
+
+const API = import.meta.env.VITE_BACKEND_URL ?? "http://localhost:3001";
+
+// GET /series/limits
+interface SeriesLimits {
+  maxPoints: number;
+  tiers: { name: string; bucketMs: number; buckets: number }[]; // finest first
+}
+
+interface Reading {
+  device: string;
+  ts: number;
+  humidity: number;
+  temperatureC: number;
+  valid: boolean;
+}
+
+function trace(series: Series, color: string): Trace[] {
+  return [{ series, pyramid: new LttbPyramid(series), color }];
+}
+
+// Appends a point unless it is not newer than the series' newest
+function extend(series: Series, x: number, y: number | null) {
+  if (y === null || (series.length && x <= series.x[series.length - 1])) return;
+  appendPoint(series, x, y);
+}
+
+// The finest tier's buckets for as long as they fit in one request: a range of n - 1 buckets
+// overlaps at most n, any more and /series falls back to the next tier
+function historyMs(limits: SeriesLimits): number {
+  const finest = limits.tiers[0];
+  return (Math.min(limits.maxPoints, finest.buckets) - 1) * finest.bucketMs;
+}
+
+function Dashboard() {
+  const [data] = useState(() => {
+    const humidity = createSeries();
+    const temperature = createSeries();
+    return { humidity, temperature, humidityTraces: trace(humidity, "#38bdf8"), temperatureTraces: trace(temperature, "#f97316") };
+  });
+  const [version, setVersion] = useState(0);
+  const [latest, setLatest] = useState<Reading | undefined>();
+  const [status, setStatus] = useState("connecting...");
+
+  // about a week of history from /series, then live readings from /live
+  // /live opens first and holds its readings back: its first one is the newest stored, so
+  // /series up to that one and the stream after it leave no gap between them
+  useEffect(() => {
+    let cancelled = false;
+    let source: EventSource | undefined;
+
+    const show = (reading: Reading) => {
+      setLatest(reading);
+      if (!reading.valid) return;
+      extend(data.humidity, reading.ts, reading.humidity);
+      extend(data.temperature, reading.ts, reading.temperatureC);
+    };
+
+    const loadHistory = async (device: string, to: number) => {
+      const limits = (await (await fetch(`${API}/series/limits`)).json()) as SeriesLimits;
+      if (cancelled) return;
+      const query = `device=${encodeURIComponent(device)}&from=${to - historyMs(limits)}&to=${to}&maxPoints=${limits.maxPoints}`;
+      const res = await fetch(`${API}/series?${query}`);
+      if (cancelled) return;
+      if (res.ok) {
+        const series = await res.json();
+        if (cancelled) return;
+        for (let i = 0; i < series.t.length; i++) {
+          extend(data.humidity, series.t[i], series.humidity.mean[i]);
+          extend(data.temperature, series.t[i], series.temperature.mean[i]);
+        }
+      }
+      setStatus(device);
+    };
+
+    (async () => {
+      let device = new URLSearchParams(window.location.search).get("device") ?? undefined;
+      if (!device) device = ((await (await fetch(`${API}/latest`)).json()) as Partial<Reading>).device;
+      if (cancelled) return;
+      if (!device) {
+        setStatus("no device has reported yet");
+        return;
+      }
+
+      const id = device;
+      const buffered: Reading[] = [];
+      let loaded = false;
+      source = new EventSource(`${API}/live?device=${encodeURIComponent(id)}`);
+      source.addEventListener("sample", (e) => {
+        const reading = JSON.parse((e as MessageEvent<string>).data) as Reading;
+        if (loaded) {
+          show(reading);
+          setVersion((v) => v + 1);
+          return;
+        }
+        buffered.push(reading);
+        if (buffered.length > 1) return;
+        loadHistory(id, reading.ts)
+          .catch((err) => setStatus(`backend unreachable: ${err}`))
+          .finally(() => {
+            for (const held of buffered) show(held);
+            loaded = true;
+            setVersion((v) => v + 1);
+          });
+      });
+    })().catch((err) => setStatus(`backend unreachable: ${err}`));
+
+    return () => {
+      cancelled = true;
+      source?.close();
+    };
+  }, [data]);
+
   return (
-    <div className="min-h-screen bg-slate-900 text-slate-100 flex items-center justify-center">
-      <div className="rounded-2xl bg-slate-800 p-8 shadow">
-        <h1 className="text-3xl font-bold">Humidity Sensor UI</h1>
-        <p className="mt-2 text-slate-300">Tailwind v4 is working !!!!!!</p>
-        <button className="mt-6 rounded-xl bg-indigo-500 px-4 py-2 font-medium hover:bg-indigo-400 text-blue-600">
-          Test Button
-        </button>
+    <div className="min-h-screen w-full bg-slate-900 p-6 text-slate-100">
+      <div className="mx-auto max-w-6xl">
+        <div className="flex items-baseline justify-between">
+          <h1 className="text-3xl font-bold">Humidity Sensor</h1>
+          <p className="text-slate-400">{status}</p>
+        </div>
+        <div className="mt-6 grid gap-6">
+          <section className="rounded-2xl bg-slate-800 p-4 shadow">
+            <h2 className="mb-2 font-medium">
+              Humidity <span className="text-sky-400">{latest?.valid ? `${latest.humidity.toFixed(1)} %RH` : ""}</span>
+            </h2>
+            <Chart traces={data.humidityTraces} version={version} />
+          </section>
+          <section className="rounded-2xl bg-slate-800 p-4 shadow">
+            <h2 className="mb-2 font-medium">
+              Temperature <span className="text-orange-400">{latest?.valid ? `${latest.temperatureC.toFixed(1)} °C` : ""}</span>
+            </h2>
+            <Chart traces={data.temperatureTraces} version={version} />
+          </section>
+        </div>
+        <p className="mt-4 text-sm text-slate-500">Scroll to zoom, drag to pan, double click to show everything.</p>
       </div>
     </div>
   );
 }
+
+export default function App() {
+  return new URLSearchParams(window.location.search).has("bench") ? <RenderBench /> : <Dashboard />;
+}
@@ -0,0 +1,68 @@
+import { useEffect, useRef, useState } from "react";
+import { DrawScratch, drawChart, type Trace } from "../chart/draw.ts";
+import { LttbPyramid } from "../chart/lttb.ts";
+import { benchViews, makeSeries, summarize, type FrameStats } from "./scenario.ts";
+
+const POINTS = 1_000_000;
+const FRAMES = 600;
+const HEIGHT = 240;
+const TARGET_MS = 16;
+
+/**
+ * The render benchmark on a real canvas, open the app with ?bench
+ * Draws one view per animation frame and times drawChart; the frame interval shows what the
+ * browser adds for rasterizing.
+ */
+export default function RenderBench() {
+  const canvasRef = useRef<HTMLCanvasElement>(null);
+  const [result, setResult] = useState<{ draw: FrameStats; interval: FrameStats } | undefined>();
+
+  useEffect(() => {
+    const canvas = canvasRef.current;
+    const ctx = canvas?.getContext("2d");
+    if (!canvas || !ctx) return;
+
+    const series = makeSeries(POINTS);
+    const traces: Trace[] = [{ series, pyramid: new LttbPyramid(series), color: "#38bdf8" }];
+    const scratch = new DrawScratch();
+    const views = benchViews(series, FRAMES);
+    const width = canvas.clientWidth;
+    const dpr = window.devicePixelRatio || 1;
+    canvas.width = Math.round(width * dpr);
+    canvas.height = Math.round(HEIGHT * dpr);
+    ctx.setTransform(dpr, 0, 0, dpr, 0, 0);
+
+    const draw: number[] = [];
+    const interval: number[] = [];
+    let frame = 0;
+    let last = 0;
+    let request = 0;
+    const step = (now: number) => {
+      if (last) interval.push(now - last);
+      last = now;
+      const t0 = performance.now();
+      drawChart(ctx, width, HEIGHT, views[frame], traces, scratch);
+      draw.push(performance.now() - t0);
+      if (++frame < views.length) request = requestAnimationFrame(step);
+      else setResult({ draw: summarize(draw), interval: summarize(interval) });
+    };
+    request = requestAnimationFrame(step);
+    return () => cancelAnimationFrame(request);
+  }, []);
+
+  const line = (name: string, s: FrameStats) =>
+    `${name}: p50 ${s.p50.toFixed(2)} ms, p99 ${s.p99.toFixed(2)} ms, max ${s.max.toFixed(2)} ms`;
+
+  return (
+    <div className="min-h-screen w-full bg-slate-900 p-6 text-slate-100">
+      <h1 className="text-xl font-bold">Render benchmark, {POINTS.toLocaleString()} points</h1>
+      <canvas ref={canvasRef} className="mt-4 block w-full rounded-xl bg-slate-800" style={{ height: HEIGHT }} />
+      <pre className="mt-4 text-left text-sm text-slate-300">
+        {result
+          ? `${line("drawChart", result.draw)}\n${line("frame interval", result.interval)}\n` +
+            (result.draw.p99 <= TARGET_MS ? "PASS" : "FAIL") + ` (target p99 ${TARGET_MS} ms)`
+          : `running ${FRAMES} frames...`}
+      </pre>
+    </div>
+  );
+}
@@ -0,0 +1,55 @@
+// Chart render benchmark, 1M points, outside the browser
+//
+//   npm run bench:render
+//
+// Steps drawChart through zooms and pans of a 1M point series on a 1200 px wide chart and
+// reports the time per frame. The canvas is a stub that only takes the calls, so this times
+// the selection and path building, not the browser's rasterizing; open the app with ?bench for
+// the same run on a real canvas. Also times textbook LTTB of the whole series for comparison.
+// Throws, so exits 1, if p99 goes over 16 ms.
+
+import { drawChart, DrawScratch, type Trace } from "../chart/draw.ts";
+import { LttbPyramid, lttb } from "../chart/lttb.ts";
+import { benchViews, makeSeries, summarize } from "./scenario.ts";
+
+const POINTS = 1_000_000;
+const FRAMES = 600;
+const WIDTH = 1200;
+const HEIGHT = 240;
+const TARGET_MS = 16;
+
+let calls = 0;
+const noop = () => {
+  calls++;
+};
+const ctx = new Proxy({}, { get: (_target, name) => (name === "measureText" ? () => ({ width: 0 }) : noop), set: () => true });
+
+const series = makeSeries(POINTS);
+const trace: Trace = { series, pyramid: new LttbPyramid(series), color: "#38bdf8" };
+const scratch = new DrawScratch();
+const views = benchViews(series, FRAMES);
+
+const times: number[] = [];
+let points = 0;
+for (const view of views) {
+  const t0 = performance.now();
+  points += drawChart(ctx as CanvasRenderingContext2D, WIDTH, HEIGHT, view, [trace], scratch);
+  times.push(performance.now() - t0);
+}
+const frames = summarize(times);
+
+const baseline: number[] = [];
+for (let i = 0; i < 5; i++) {
+  const t0 = performance.now();
+  lttb(series, WIDTH);
+  baseline.push(performance.now() - t0);
+}
+
+const ok = frames.p99 <= TARGET_MS;
+console.log(
+  `${FRAMES} frames of ${POINTS} points at ${WIDTH} px: p50 ${frames.p50.toFixed(2)} ms` +
+    ` p99 ${frames.p99.toFixed(2)} ms max ${frames.max.toFixed(2)} ms (first ${times[0].toFixed(2)} ms)` +
+    `, ${Math.round(points / FRAMES)} points per frame ${ok ? "PASS" : "FAIL"} (target p99 ${TARGET_MS} ms)`,
+);
+console.log(`textbook LTTB of all ${POINTS} points per frame: ${summarize(baseline).p50.toFixed(2)} ms`);
+if (!ok) throw new Error(`p99 ${frames.p99.toFixed(2)} ms is over ${TARGET_MS} ms`);
@@ -0,0 +1,69 @@
+// Shared by the render benchmarks: a synthetic series and the views a user would step through
+
+import { appendPoint, createSeries, type Series } from "../chart/lttb.ts";
+import type { View } from "../chart/draw.ts";
+
+/**
+ * points readings stepMs apart: a daily humidity swing, slow drift, noise and a few spikes
+ */
+export function makeSeries(points: number, stepMs = 1000): Series {
+  const series = createSeries(points);
+  let seed = 12345;
+  const random = () => (seed = (seed * 1103515245 + 12345) & 0x7fffffff) / 0x7fffffff;
+  const start = Date.UTC(2026, 0, 1);
+  let drift = 0;
+  for (let i = 0; i < points; i++) {
+    const t = start + i * stepMs;
+    drift += (random() - 0.5) * 0.02;
+    const day = Math.sin((2 * Math.PI * (t % 86400000)) / 86400000);
+    const spike = random() < 0.0002 ? 15 * random() : 0;
+    appendPoint(series, t, 50 + 12 * day + drift + (random() - 0.5) * 0.8 + spike);
+  }
+  return series;
+}
+
+/**
+ * frames views: zooming in from the whole series to ten minutes, panning, zooming back out
+ */
+export function benchViews(series: Series, frames: number): View[] {
+  const first = series.x[0];
+  const last = series.x[series.length - 1];
+  const views: View[] = [];
+  const third = Math.floor(frames / 3);
+  const zoom = (10 * 60000) / (last - first);
+
+  for (let f = 0; f < third; f++) {
+    const span = (last - first) * zoom ** (f / (third - 1));
+    const center = first + (last - first) * 0.7;
+    views.push({ from: center - span / 2, to: center + span / 2 });
+  }
+  const span = 6 * 3600000;
+  for (let f = 0; f < third; f++) {
+    const from = first + ((last - first - span) * f) / third;
+    views.push({ from, to: from + span });
+  }
+  while (views.length < frames) {
+    const f = views.length - 2 * third;
+    const s = span * ((last - first) / span) ** (f / (frames - 2 * third));
+    views.push({ from: last - s, to: last });
+  }
+  return views;
+}
+
+export interface FrameStats {
+  p50: number;
+  p99: number;
+  max: number;
+  mean: number;
+}
+
+export function summarize(times: number[]): FrameStats {
+  const sorted = [...times].sort((a, b) => a - b);
+  const at = (q: number) => sorted[Math.min(sorted.length - 1, Math.max(0, Math.ceil(q * sorted.length) - 1))];
+  return {
+    p50: at(0.5),
+    p99: at(0.99),
+    max: sorted[sorted.length - 1],
+    mean: times.reduce((a, b) => a + b, 0) / times.length,
+  };
+}
@@ -0,0 +1,109 @@
+import { useEffect, useRef } from "react";
+import { DrawScratch, MARGIN, drawChart, fullView, type Trace, type View } from "./draw.ts";
+
+interface ChartProps {
+  traces: Trace[];
+  version: number; // bump after appending to a series to redraw
+  height?: number;
+}
+
+/**
+ * Canvas line chart for long series: wheel to zoom, drag to pan, double click to show all
+ * Until the user zooms or pans the view follows the whole series as points arrive. Drawing
+ * happens on the next animation frame and never goes through React state.
+ */
+export default function Chart({ traces, version, height = 240 }: ChartProps) {
+  const canvasRef = useRef<HTMLCanvasElement>(null);
+  const viewRef = useRef<View | undefined>(undefined); // undefined follows the data
+  const frameRef = useRef(0);
+  const redrawRef = useRef<() => void>(() => {});
+
+  useEffect(() => {
+    const canvas = canvasRef.current;
+    const ctx = canvas?.getContext("2d");
+    if (!canvas || !ctx) return;
+    const scratch = new DrawScratch();
+
+    const draw = () => {
+      frameRef.current = 0;
+      const width = canvas.clientWidth;
+      const dpr = window.devicePixelRatio || 1;
+      if (canvas.width !== Math.round(width * dpr) || canvas.height !== Math.round(height * dpr)) {
+        canvas.width = Math.round(width * dpr);
+        canvas.height = Math.round(height * dpr);
+      }
+      ctx.setTransform(dpr, 0, 0, dpr, 0, 0);
+      const view = viewRef.current ?? fullView(traces);
+      if (view) drawChart(ctx, width, height, view, traces, scratch);
+      else ctx.clearRect(0, 0, width, height);
+    };
+    const redraw = () => {
+      if (!frameRef.current) frameRef.current = requestAnimationFrame(draw);
+    };
+    redrawRef.current = redraw;
+
+    const plotX = (clientX: number) => clientX - canvas.getBoundingClientRect().left - MARGIN.left;
+    const plotWidth = () => Math.max(1, canvas.clientWidth - MARGIN.left - MARGIN.right);
+
+    const onWheel = (e: WheelEvent) => {
+      const view = viewRef.current ?? fullView(traces);
+      if (!view) return;
+      e.preventDefault();
+      const span = view.to - view.from;
+      const at = view.from + (plotX(e.clientX) / plotWidth()) * span;
+      const factor = Math.exp(e.deltaY * 0.002);
+      const next = Math.max(1000, span * factor); // no closer than a second across
+      const from = at - (at - view.from) * (next / span);
+      viewRef.current = { from, to: from + next };
+      redraw();
+    };
+
+    let dragX: number | undefined;
+    const onDown = (e: PointerEvent) => {
+      dragX = e.clientX;
+      canvas.setPointerCapture(e.pointerId);
+    };
+    const onMove = (e: PointerEvent) => {
+      if (dragX === undefined) return;
+      const view = viewRef.current ?? fullView(traces);
+      if (!view) return;
+      const shift = ((dragX - e.clientX) / plotWidth()) * (view.to - view.from);
+      dragX = e.clientX;
+      viewRef.current = { from: view.from + shift, to: view.to + shift };
+      redraw();
+    };
+    const onUp = () => {
+      dragX = undefined;
+    };
+    const onDouble = () => {
+      viewRef.current = undefined;
+      redraw();
+    };
+
+    canvas.addEventListener("wheel", onWheel, { passive: false });
+    canvas.addEventListener("pointerdown", onDown);
+    canvas.addEventListener("pointermove", onMove);
+    canvas.addEventListener("pointerup", onUp);
+    canvas.addEventListener("dblclick", onDouble);
+    const resize = new ResizeObserver(redraw);
+    resize.observe(canvas);
+    redraw();
+
+    return () => {
+      canvas.removeEventListener("wheel", onWheel);
+      canvas.removeEventListener("pointerdown", onDown);
+      canvas.removeEventListener("pointermove", onMove);
+      canvas.removeEventListener("pointerup", onUp);
+      canvas.removeEventListener("dblclick", onDouble);
+      resize.disconnect();
+      cancelAnimationFrame(frameRef.current);
+      frameRef.current = 0;
+    };
+  }, [traces, height]);
+
+  useEffect(() => {
+    redrawRef.current();
+  }, [version]);
+
+  return <canvas ref={canvasRef} className="block w-full touch-none cursor-grab" style={{ height }} />;
+}
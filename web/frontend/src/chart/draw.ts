@@ -0,0 +1,163 @@
+// Canvas drawing of the time series charts, kept apart from React so the benchmark can run
+// it without a DOM
+
+import { LttbPyramid, lowerBound, type Series } from "./lttb.ts";
+
+export interface Trace {
+  series: Series;
+  pyramid: LttbPyramid;
+  color: string;
+}
+
+export interface View {
+  from: number; // ms
+  to: number;
+}
+
+export const MARGIN = { left: 48, right: 8, top: 8, bottom: 22 };
+
+const TIME_STEPS = [
+  1000, 5000, 15000, 60000, 5 * 60000, 15 * 60000, 3600000, 3 * 3600000, 6 * 3600000, 86400000,
+  2 * 86400000, 7 * 86400000,
+];
+
+/**
+ * Reusable buffers for drawChart, one per chart
+ */
+export class DrawScratch {
+  picked = new Int32Array(0);
+
+  ensure(width: number) {
+    if (this.picked.length < width * 2 + 4) this.picked = new Int32Array(width * 2 + 4);
+  }
+}
+
+// Step of about count ticks over span, 1, 2 or 5 times a power of ten
+function niceStep(span: number, count: number): number {
+  const raw = span / count;
+  const power = 10 ** Math.floor(Math.log10(raw));
+  const unit = raw / power;
+  return (unit < 1.5 ? 1 : unit < 3.5 ? 2 : unit < 7.5 ? 5 : 10) * power;
+}
+
+function timeLabel(ms: number, step: number): string {
+  const d = new Date(ms);
+  const pad = (n: number) => String(n).padStart(2, "0");
+  if (step >= 86400000) return `${pad(d.getMonth() + 1)}-${pad(d.getDate())}`;
+  if (step >= 60000) return `${pad(d.getHours())}:${pad(d.getMinutes())}`;
+  return `${pad(d.getHours())}:${pad(d.getMinutes())}:${pad(d.getSeconds())}`;
+}
+
+/**
+ * The whole x range of the traces, undefined while they are empty
+ */
+export function fullView(traces: Trace[]): View | undefined {
+  let from = Infinity;
+  let to = -Infinity;
+  for (const { series } of traces) {
+    if (!series.length) continue;
+    from = Math.min(from, series.x[0]);
+    to = Math.max(to, series.x[series.length - 1]);
+  }
+  if (from > to) return undefined;
+  return from === to ? { from: from - 30000, to: to + 30000 } : { from, to };
+}
+
+/**
+ * Draws traces over view on a width x height (CSS pixels) canvas, with the axes and grid
+ * Each trace is cut to the view with two binary searches and brought down to one point per
+ * pixel column by its pyramid. Returns the points drawn.
+ */
+export function drawChart(
+  ctx: CanvasRenderingContext2D,
+  width: number,
+  height: number,
+  view: View,
+  traces: Trace[],
+  scratch: DrawScratch,
+): number {
+  const plotW = Math.max(1, width - MARGIN.left - MARGIN.right);
+  const plotH = Math.max(1, height - MARGIN.top - MARGIN.bottom);
+  const columns = Math.ceil(plotW);
+  scratch.ensure(columns);
+  ctx.clearRect(0, 0, width, height);
+
+  // picks of every trace first, the y range comes from the points drawn
+  const picks: { trace: Trace; count: number; indices: Int32Array }[] = [];
+  let minY = Infinity;
+  let maxY = -Infinity;
+  for (const trace of traces) {
+    const { series } = trace;
+    // one point either side so the lines run to the edges
+    const start = Math.max(0, lowerBound(series, view.from) - 1);
+    const end = Math.min(series.length, lowerBound(series, view.to) + 1);
+    const count = trace.pyramid.select(start, end, columns, scratch.picked);
+    const indices = scratch.picked.slice(0, count);
+    for (let i = 0; i < count; i++) {
+      const y = series.y[indices[i]];
+      if (y < minY) minY = y;
+      if (y > maxY) maxY = y;
+    }
+    picks.push({ trace, count, indices });
+  }
+  if (minY > maxY) {
+    minY = 0;
+    maxY = 1;
+  }
+  const pad = (maxY - minY) * 0.05 || 1;
+  minY -= pad;
+  maxY += pad;
+
+  const sx = plotW / (view.to - view.from);
+  const sy = plotH / (maxY - minY);
+  const px = (x: number) => MARGIN.left + (x - view.from) * sx;
+  const py = (y: number) => MARGIN.top + plotH - (y - minY) * sy;
+
+  // grid and labels
+  ctx.lineWidth = 1;
+  ctx.strokeStyle = "rgba(148, 163, 184, 0.2)";
+  ctx.fillStyle = "rgb(148, 163, 184)";
+  ctx.font = "11px system-ui, sans-serif";
+  ctx.beginPath();
+  const yStep = niceStep(maxY - minY, 5);
+  ctx.textAlign = "right";
+  ctx.textBaseline = "middle";
+  for (let v = Math.ceil(minY / yStep) * yStep; v <= maxY; v += yStep) {
+    const y = Math.round(py(v)) + 0.5;
+    ctx.moveTo(MARGIN.left, y);
+    ctx.lineTo(MARGIN.left + plotW, y);
+    ctx.fillText(v.toFixed(yStep < 1 ? 1 : 0), MARGIN.left - 6, y);
+  }
+  const tStep = TIME_STEPS.find((s) => s * sx >= 90) ?? TIME_STEPS[TIME_STEPS.length - 1];
+  const offset = new Date(view.from).getTimezoneOffset() * 60000; // ticks on local time
+  ctx.textAlign = "center";
+  ctx.textBaseline = "top";
+  for (let t = Math.ceil((view.from - offset) / tStep) * tStep + offset; t <= view.to; t += tStep) {
+    const x = Math.round(px(t)) + 0.5;
+    ctx.moveTo(x, MARGIN.top);
+    ctx.lineTo(x, MARGIN.top + plotH);
+    ctx.fillText(timeLabel(t, tStep), x, MARGIN.top + plotH + 6);
+  }
+  ctx.stroke();
+
+  // traces, clipped to the plot
+  ctx.save();
+  ctx.beginPath();
+  ctx.rect(MARGIN.left, MARGIN.top, plotW, plotH);
+  ctx.clip();
+  ctx.lineWidth = 1.5;
+  ctx.lineJoin = "round";
+  let drawn = 0;
+  for (const { trace, count, indices } of picks) {
+    if (!count) continue;
+    const { x, y } = trace.series;
+    ctx.strokeStyle = trace.color;
+    ctx.beginPath();
+    ctx.moveTo(px(x[indices[0]]), py(y[indices[0]]));
+    for (let i = 1; i < count; i++) ctx.lineTo(px(x[indices[i]]), py(y[indices[i]]));
+    ctx.stroke();
+    drawn += count;
+  }
+  ctx.restore();
+  return drawn;
+}
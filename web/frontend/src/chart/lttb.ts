@@ -0,0 +1,218 @@
+// Largest-Triangle-Three-Buckets downsampling
+//
+// Plain LTTB splits the visible points into one bucket per pixel and keeps, from each bucket,
+// the point that makes the largest triangle with the point kept before it and the average of
+// the bucket after it. Run from scratch every frame that is O(visible points), and since the
+// buckets move with the view, the picked points shimmer while panning.
+//
+// LttbPyramid instead fixes the buckets to the series: power of two sizes, aligned to index 0,
+// with the chain of picks restarting every 1024 buckets. A view uses the level whose bucket
+// size brings it down to the pixel width and reads the picks of the buckets it covers. Picks
+// are worked out the first time a view needs them and kept, so a pan or zoom costs the points
+// drawn plus, once, the chains it enters. Appending only redoes the last two buckets.
+
+export interface Series {
+  x: Float64Array; // ascending, ms
+  y: Float64Array;
+  length: number; // points in use, the arrays have spare room
+}
+
+export function createSeries(capacity = 1024): Series {
+  return { x: new Float64Array(capacity), y: new Float64Array(capacity), length: 0 };
+}
+
+/**
+ * Appends one point, doubling the arrays when full
+ * x must not be less than the last point's
+ */
+export function appendPoint(series: Series, x: number, y: number) {
+  if (series.length === series.x.length) {
+    const grow = (from: Float64Array) => {
+      const to = new Float64Array(Math.max(1024, from.length * 2));
+      to.set(from);
+      return to;
+    };
+    series.x = grow(series.x);
+    series.y = grow(series.y);
+  }
+  series.x[series.length] = x;
+  series.y[series.length] = y;
+  series.length++;
+}
+
+/**
+ * First index whose x is at or after value
+ */
+export function lowerBound(series: Series, value: number): number {
+  let lo = 0;
+  let hi = series.length;
+  while (lo < hi) {
+    const mid = (lo + hi) >>> 1;
+    if (series.x[mid] < value) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+/**
+ * Textbook LTTB of a whole series down to threshold points, returns the indices kept
+ * The benchmark uses it as the from-scratch baseline.
+ */
+export function lttb(series: Series, threshold: number): Int32Array {
+  const n = series.length;
+  if (threshold >= n || threshold < 3) return Int32Array.from({ length: n }, (_, i) => i);
+  const { x, y } = series;
+  const out = new Int32Array(threshold);
+  const every = (n - 2) / (threshold - 2);
+  let a = 0;
+  out[0] = 0;
+  for (let i = 0; i < threshold - 2; i++) {
+    const nextStart = Math.floor((i + 1) * every) + 1;
+    const nextEnd = Math.min(n, Math.floor((i + 2) * every) + 1);
+    let avgX = 0;
+    let avgY = 0;
+    for (let j = nextStart; j < nextEnd; j++) {
+      avgX += x[j];
+      avgY += y[j];
+    }
+    avgX /= nextEnd - nextStart;
+    avgY /= nextEnd - nextStart;
+
+    let best = -1;
+    let pick = 0;
+    for (let j = Math.floor(i * every) + 1; j < nextStart; j++) {
+      const area = Math.abs((x[a] - avgX) * (y[j] - y[a]) - (x[a] - x[j]) * (avgY - y[a]));
+      if (area > best) {
+        best = area;
+        pick = j;
+      }
+    }
+    out[i + 1] = pick;
+    a = pick;
+  }
+  out[threshold - 1] = n - 1;
+  return out;
+}
+
+// Buckets per chain, a view only works out the chains it touches
+const SEGMENT = 1024;
+
+interface Level {
+  size: number; // points per bucket
+  picked: Int32Array; // index kept from each bucket
+  done: Int32Array; // buckets picked so far in each segment, from its start
+}
+
+export class LttbPyramid {
+  readonly series: Series;
+  private levels = new Map<number, Level>();
+  private seen: number; // series.length the levels were built against
+
+  constructor(series: Series) {
+    this.series = series;
+    this.seen = series.length;
+  }
+
+  /**
+   * Indices of the points to draw for series indices start..end (exclusive) on width
+   * pixels, written to out (which needs width * 2 + 4 room), returns how many
+   */
+  select(start: number, end: number, width: number, out: Int32Array): number {
+    this.sync();
+    const visible = end - start;
+    if (visible <= width) {
+      for (let i = 0; i < visible; i++) out[i] = start + i;
+      return visible;
+    }
+
+    // smallest power of two that brings the view to at most width buckets
+    let size = 2;
+    while (size * width < visible) size *= 2;
+    const level = this.level(size);
+    const first = Math.floor(start / size);
+    const last = Math.floor((end - 1) / size);
+    for (let s = Math.floor(first / SEGMENT); s <= Math.floor(last / SEGMENT); s++)
+      this.pick(level, s, Math.min(SEGMENT, last - s * SEGMENT + 1));
+
+    let count = 0;
+    for (let k = first; k <= last; k++) out[count++] = level.picked[k];
+    return count;
+  }
+
+  // Drops the picks that new points could change: the last bucket and the one before it
+  private sync() {
+    const n = this.series.length;
+    if (n === this.seen) return;
+    for (const level of this.levels.values()) {
+      const lastOld = Math.floor(Math.max(0, this.seen - 1) / level.size);
+      for (let k = Math.max(0, lastOld - 1); k <= lastOld; k++) {
+        const s = Math.floor(k / SEGMENT);
+        if (s < level.done.length) level.done[s] = Math.min(level.done[s], k - s * SEGMENT);
+      }
+    }
+    this.seen = n;
+  }
+
+  private level(size: number): Level {
+    const buckets = Math.ceil(this.series.length / size);
+    const segments = Math.ceil(buckets / SEGMENT);
+    let level = this.levels.get(size);
+    if (!level) {
+      level = { size, picked: new Int32Array(segments * SEGMENT), done: new Int32Array(segments) };
+      this.levels.set(size, level);
+    } else if (level.done.length < segments) {
+      const room = segments * 2;
+      const picked = new Int32Array(room * SEGMENT);
+      picked.set(level.picked);
+      const done = new Int32Array(room);
+      done.set(level.done);
+      level.picked = picked;
+      level.done = done;
+    }
+    return level;
+  }
+
+  /**
+   * Picks the first upTo buckets of segment s, each against the pick before it and the
+   * average of the bucket after it. A segment's chain starts from the point just before it,
+   * which keeps segments independent and differs from one long chain only at that bucket.
+   */
+  private pick(level: Level, s: number, upTo: number) {
+    const { x, y, length } = this.series;
+    const size = level.size;
+    const lastBucket = Math.floor((length - 1) / size);
+
+    for (let k = s * SEGMENT + level.done[s]; k < s * SEGMENT + upTo; k++) {
+      const from = k * size;
+      const to = Math.min(length, from + size);
+      if (k === 0 || k === lastBucket) {
+        // the ends keep the first and the last point, as in plain LTTB
+        level.picked[k] = k === 0 ? 0 : length - 1;
+        continue;
+      }
+
+      const a = k % SEGMENT ? level.picked[k - 1] : from - 1;
+      const nextEnd = Math.min(length, to + size);
+      let cx = 0;
+      let cy = 0;
+      for (let j = to; j < nextEnd; j++) {
+        cx += x[j];
+        cy += y[j];
+      }
+      cx /= nextEnd - to;
+      cy /= nextEnd - to;
+
+      let best = -1;
+      let pick = from;
+      for (let j = from; j < to; j++) {
+        const area = Math.abs((x[a] - cx) * (y[j] - y[a]) - (x[a] - x[j]) * (cy - y[a]));
+        if (area > best) {
+          best = area;
+          pick = j;
+        }
+      }
+      level.picked[k] = pick;
+    }
+    level.done[s] = Math.max(level.done[s], upTo);
+  }
+}